@@ -0,0 +1,57 @@
+// Cannot implicitly shard accessed collections because unsupported use of sharded collection
+// for target collection of $lookup and $graphLookup.
+// @tags: [assumes_unsharded_collection]
+
+// Tests that a $graphLookup followed by an $unwind may discover more documents than fit within its
+// memory limit when disk use is allowed.
+load("jstests/aggregation/extras/utils.js");  // For "assertErrorCode".
+
+(function() {
+    "use strict";
+
+    var local = db.local;
+    var foreign = db.foreign;
+
+    local.drop();
+    assert.writeOK(local.insert({_id: 0}));
+
+    // The visited set exceeds 100MB.
+    foreign.drop();
+    var bulk = foreign.initializeUnorderedBulkOp();
+    var initial = [];
+    for (var i = 0; i < 8; i++) {
+        bulk.insert({_id: i, longString: new Array(14 * 1024 * 1024).join('x')});
+        initial.push(i);
+    }
+    assert.writeOK(bulk.execute());
+
+    var pipeline = [
+        {
+          $graphLookup: {
+              from: "foreign",
+              startWith: {$literal: initial},
+              connectToField: "_id",
+              connectFromField: "notimportant",
+              as: "graph"
+          }
+        },
+        {$unwind: "$graph"},
+        {$project: {_id: 0, graphId: "$graph._id"}},
+        {$sort: {graphId: 1}}
+    ];
+
+    assertErrorCode(local, pipeline, 40099, "maximum memory usage reached");
+
+    var res = local.aggregate(pipeline, {allowDiskUse: true}).toArray();
+    assert.eq(res, initial.map(id => ({graphId: id})));
+
+    // Without an $unwind, the discovered documents are all held in one output document and cannot
+    // be spilled.
+    assert.commandFailedWithCode(db.runCommand({
+        aggregate: local.getName(),
+        pipeline: pipeline.slice(0, 1),
+        allowDiskUse: true,
+        cursor: {}
+    }),
+                                 40099);
+}());
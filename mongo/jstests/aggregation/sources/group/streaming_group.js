@@ -0,0 +1,71 @@
+/**
+ * Tests that a $group whose input is already ordered by its _id fields, and which therefore returns
+ * each group as soon as its input moves past it, produces the same groups as a $group which
+ * consumes its entire input first. This includes null, missing and array values of the _id fields.
+ */
+load("jstests/libs/analyze_plan.js");  // For aggPlanHasStage.
+
+(function() {
+    "use strict";
+
+    const coll = db.streaming_group;
+    coll.drop();
+
+    for (let i = 0; i < 100; i++) {
+        assert.writeOK(coll.insert({a: i % 10, b: i % 3, v: i}));
+    }
+    assert.writeOK(coll.insert({a: null, b: 1, v: 1}));
+    assert.writeOK(coll.insert({b: 1, v: 2}));
+    assert.writeOK(coll.insert({a: null, v: 3}));
+    assert.writeOK(coll.insert({v: 4}));
+    assert.commandWorked(coll.createIndex({a: 1, b: 1}));
+
+    const groupStage = {
+        $group: {_id: {a: "$a", b: "$b"}, count: {$sum: 1}, total: {$sum: "$v"}}
+    };
+
+    function sortedResults(pipeline) {
+        return coll.aggregate(pipeline).toArray().sort(
+            (lhs, rhs) => tojson(lhs) < tojson(rhs) ? -1 : 1);
+    }
+
+    function assertSameGroupsAsBlockingGroup() {
+        const streamed = sortedResults([{$sort: {a: 1, b: 1}}, groupStage]);
+        const blocking =
+            sortedResults([{$sort: {a: 1, b: 1}}, {$_internalInhibitOptimization: {}}, groupStage]);
+        assert.eq(streamed, blocking);
+    }
+
+    // The index provides the sort, so the $group can stream.
+    const explain = coll.explain().aggregate([{$sort: {a: 1, b: 1}}, groupStage]);
+    if (explain.hasOwnProperty("stages")) {
+        assert(aggPlanHasStage(explain, "$streamingGroup"), tojson(explain));
+    }
+    assertSameGroupsAsBlockingGroup();
+
+    // A streaming $group reports its output as sorted on the _id fields which hold the input's
+    // sort fields, even when those are dotted paths.
+    assert.commandWorked(coll.createIndex({"c.d": 1}));
+    for (let i = 0; i < 10; i++) {
+        assert.writeOK(coll.insert({c: {d: i % 4}, v: i}));
+    }
+    const dottedGroups = [
+        [{$sort: {"c.d": 1}}, {$group: {_id: {x: "$c.d"}}}, {$group: {_id: "$_id.x"}}],
+        [{$sort: {"c.d": 1}}, {$group: {_id: "$c.d", vs: {$push: "$v"}}}, {$unwind: "$vs"}],
+    ];
+    for (let pipeline of dottedGroups) {
+        const inhibited = pipeline.slice(0, 1)
+                              .concat([{$_internalInhibitOptimization: {}}])
+                              .concat(pipeline.slice(1));
+        assert.eq(coll.aggregate(pipeline).toArray().length,
+                  coll.aggregate(inhibited).toArray().length);
+    }
+
+    // Once the index is multikey the query system sorts the documents itself, ordering each array
+    // by its smallest element.
+    assert.writeOK(coll.insert({a: [1, 5], b: 1, v: 5}));
+    assert.writeOK(coll.insert({a: [5, 1], b: 1, v: 6}));
+    assert.writeOK(coll.insert({a: [0, 9], b: 2, v: 7}));
+    assert.writeOK(coll.insert({a: [], b: 1, v: 8}));
+    assertSameGroupsAsBlockingGroup();
+}());
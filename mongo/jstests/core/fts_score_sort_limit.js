@@ -0,0 +1,42 @@
+// Test that a limited sort on the text score returns the best scoring documents.
+(function() {
+    "use strict";
+
+    var t = db.getSiblingDB("test").getCollection("fts_score_sort_limit");
+    t.drop();
+
+    var words = ["apple", "banana", "cherry", "grape", "lemon"];
+    for (var i = 0; i < 200; ++i) {
+        var text = [];
+        for (var j = 0; j < words.length; ++j) {
+            for (var n = 0; n < (i * (j + 3)) % 7; ++n) {
+                text.push(words[j]);
+            }
+        }
+        text.push("filler" + i);
+        assert.writeOK(t.insert({_id: i, a: text.join(" "), b: words[i % words.length]}));
+    }
+    assert.commandWorked(t.ensureIndex({a: "text", b: "text"}, {weights: {a: 1, b: 5}}));
+
+    function scores(search, limit, skip) {
+        var cursor = t.find({$text: {$search: search}}, {score: {$meta: "textScore"}})
+                         .sort({score: {$meta: "textScore"}})
+                         .skip(skip || 0);
+        if (limit) {
+            cursor = cursor.limit(limit);
+        }
+        return cursor.toArray().map(function(doc) {
+            return doc.score;
+        });
+    }
+
+    ["apple", "apple cherry", "banana grape lemon", "apple banana cherry grape lemon"].forEach(
+        function(search) {
+            var all = scores(search);
+            assert.gt(all.length, 10, search);
+            [1, 5, 10].forEach(function(limit) {
+                assert.eq(all.slice(0, limit), scores(search, limit), search);
+                assert.eq(all.slice(3, 3 + limit), scores(search, limit, 3), search);
+            });
+        });
+}());
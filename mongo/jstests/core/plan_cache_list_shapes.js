@@ -44,6 +44,8 @@ assert.eq(
 // Number of shapes should match queries executed by multi-plan runner.
 var shapes = getShapes();
 assert.eq(1, shapes.length, 'unexpected number of shapes in planCacheListQueryShapes result');
+assert.gt(shapes[0].estimatedSizeBytes, 0, tojson(shapes[0]));
+delete shapes[0].estimatedSizeBytes;
 assert.eq({query: {a: 1, b: 1}, sort: {a: -1}, projection: {_id: 1, a: 1}},
           shapes[0],
           'unexpected query shape returned from planCacheListQueryShapes');
@@ -0,0 +1,56 @@
+/**
+ * Tests that a findAndModify whose blocking sort spills to disk still updates or removes the
+ * document it returns, and that on storage engines where a sort may not spill the command fails
+ * instead of silently writing nothing.
+ */
+load("jstests/libs/analyze_plan.js");  // For "getPlanStage".
+
+(function() {
+    "use strict";
+
+    const conn = MongoRunner.runMongod({
+        setParameter: {
+            internalQueryExecMaxBlockingSortBytes: 16 * 1024,
+            internalQueryExecBlockingSortAllowDiskUse: true
+        }
+    });
+    assert.neq(null, conn, "mongod was unable to start up");
+
+    const testDB = conn.getDB("test");
+    const coll = testDB.find_and_modify_sort_spill;
+    coll.drop();
+
+    // findAndModify sorts with a limit of one, so each document alone must exceed the limit.
+    const padding = new Array(20 * 1024).join("x");
+    const bulk = coll.initializeUnorderedBulkOp();
+    for (let i = 0; i < 50; i++) {
+        bulk.insert({_id: i, x: i, padding: padding});
+    }
+    assert.writeOK(bulk.execute());
+
+    const storageEngine = jsTest.options().storageEngine || "wiredTiger";
+    if (storageEngine === "mmapv1") {
+        // A spilled result no longer hears about deletions, and its RecordId may be reused.
+        assert.throws(() => coll.findAndModify({sort: {x: -1}, update: {$set: {updated: true}}}));
+        assert.eq(0, coll.find({updated: true}).itcount());
+        MongoRunner.stopMongod(conn);
+        return;
+    }
+
+    const explain = coll.find().sort({x: -1}).explain("executionStats");
+    const sortStage = getPlanStage(explain.executionStats.executionStages, "SORT");
+    assert.neq(null, sortStage, tojson(explain));
+    assert(sortStage.usedDisk, tojson(explain));
+
+    let doc = coll.findAndModify({sort: {x: -1}, update: {$set: {updated: true}}, new: true});
+    assert.eq(49, doc._id, tojson(doc._id));
+    assert.eq(true, doc.updated, tojson(doc._id));
+    assert.eq(1, coll.find({_id: 49, updated: true}).itcount());
+
+    doc = coll.findAndModify({query: {x: {$lt: 40}}, sort: {x: -1}, remove: true});
+    assert.eq(39, doc._id, tojson(doc._id));
+    assert.eq(0, coll.find({_id: 39}).itcount());
+    assert.eq(49, coll.find().itcount());
+
+    MongoRunner.stopMongod(conn);
+}());
@@ -0,0 +1,107 @@
+/**
+ * Tests that a spherical $near search over a 2dsphere index returns the same documents, in the
+ * same order and at the same distances, whether it searches cells best-first or in expanding
+ * annuli.
+ */
+load("jstests/libs/analyze_plan.js");  // For "getPlanStage".
+
+(function() {
+    "use strict";
+
+    const conn = MongoRunner.runMongod();
+    assert.neq(null, conn, "mongod was unable to start up");
+
+    const testDB = conn.getDB("test");
+    const coll = testDB.geo_near_best_first;
+    coll.drop();
+
+    // Points spread over a wide area, plus a dense cluster next to the search point, so that the
+    // best-first search both coarsens and refines the cells it scans.
+    Random.setRandomSeed(20);
+    const center = [1, 1];
+    const types = ["a", "b", "c"];
+    const bulk = coll.initializeUnorderedBulkOp();
+    for (let i = 0; i < 2000; i++) {
+        let loc;
+        if (i < 1500) {
+            loc = [Random.rand() * 20 - 10, Random.rand() * 20 - 10];
+        } else {
+            loc = [center[0] + Random.rand() * 0.1 - 0.05, center[1] + Random.rand() * 0.1 - 0.05];
+        }
+        bulk.insert({_id: i, loc: loc, type: types[i % types.length]});
+    }
+    assert.writeOK(bulk.execute());
+    assert.commandWorked(coll.createIndex({loc: "2dsphere"}));
+
+    function setBestFirst(bestFirst) {
+        assert.commandWorked(
+            testDB.adminCommand({setParameter: 1, internalQueryS2GeoNearBestFirst: bestFirst}));
+    }
+
+    function geoNear(spec) {
+        const stage = {
+            near: {type: "Point", coordinates: center},
+            distanceField: "dist",
+            spherical: true,
+            num: 10000
+        };
+        Object.extend(stage, spec);
+        return coll.aggregate([{$geoNear: stage}, {$project: {_id: 1, dist: 1}}]).toArray();
+    }
+
+    function nearSphere(nearSpec, filter, limit) {
+        const near = {$geometry: {type: "Point", coordinates: center}};
+        Object.extend(near, nearSpec);
+        const query = {loc: {$nearSphere: near}};
+        Object.extend(query, filter);
+        return coll.find(query, {_id: 1}).limit(limit).toArray();
+    }
+
+    function assertSameResults(run) {
+        setBestFirst(true);
+        const bestFirst = run();
+        setBestFirst(false);
+        const annulus = run();
+        assert.eq(bestFirst, annulus);
+        return bestFirst;
+    }
+
+    // Unbounded, limited, and bounded searches, with and without a filter.
+    assert.eq(2000, assertSameResults(() => geoNear({})).length);
+    assert.eq(1, assertSameResults(() => geoNear({num: 1})).length);
+    assert.eq(25, assertSameResults(() => geoNear({num: 25})).length);
+    assert.gt(assertSameResults(() => geoNear({maxDistance: 200 * 1000})).length, 500);
+    assert.gt(assertSameResults(() => geoNear({minDistance: 50 * 1000, maxDistance: 500 * 1000}))
+                  .length,
+              0);
+    assert.gt(assertSameResults(() => geoNear({minDistance: 1000 * 1000})).length, 0);
+    assert.gt(assertSameResults(() => geoNear({query: {type: "a"}})).length, 600);
+    assert.eq(10, assertSameResults(() => geoNear({query: {type: "b"}, num: 10})).length);
+    assert.gt(assertSameResults(() => geoNear({
+                  query: {type: {$ne: "c"}},
+                  minDistance: 2000,
+                  maxDistance: 300 * 1000
+              })).length,
+              0);
+
+    // The find path, whose results carry no distance.
+    assert.eq(5, assertSameResults(() => nearSphere({}, {}, 5)).length);
+    assert.eq(20,
+              assertSameResults(() => nearSphere({$maxDistance: 100 * 1000}, {type: "a"}, 20))
+                  .length);
+    assert.gt(assertSameResults(() => nearSphere({$minDistance: 300 * 1000}, {}, 0)).length, 0);
+
+    // Only the best-first search reports the cells it scanned.
+    function getNearStage(bestFirst) {
+        setBestFirst(bestFirst);
+        const near = {$geometry: {type: "Point", coordinates: center}};
+        const explain = coll.find({loc: {$nearSphere: near}}).limit(10).explain("executionStats");
+        const nearStage = getPlanStage(explain.executionStats.executionStages, "GEO_NEAR_2DSPHERE");
+        assert.neq(null, nearStage, tojson(explain));
+        return nearStage;
+    }
+    assert.gt(getNearStage(true).cellsScanned, 0);
+    assert(!getNearStage(false).hasOwnProperty("cellsScanned"));
+
+    MongoRunner.stopMongod(conn);
+}());
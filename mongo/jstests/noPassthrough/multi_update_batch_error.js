@@ -0,0 +1,36 @@
+/**
+ * Tests that a multi-update which fails part of the way through a batch keeps the documents it
+ * updated before the failing one, just as it would if it updated one document at a time.
+ */
+(function() {
+    "use strict";
+
+    const conn = MongoRunner.runMongod({setParameter: {internalQueryExecMultiWriteBatchSize: 16}});
+    assert.neq(null, conn, "mongod was unable to start up");
+
+    const testDB = conn.getDB("test");
+    const coll = testDB.multi_update_batch_error;
+
+    function runFailingUpdate(batchSize) {
+        assert.commandWorked(testDB.adminCommand(
+            {setParameter: 1, internalQueryExecMultiWriteBatchSize: batchSize}));
+
+        coll.drop();
+        const bulk = coll.initializeUnorderedBulkOp();
+        for (let i = 0; i < 10; i++) {
+            bulk.insert({_id: i, a: i});
+        }
+        assert.writeOK(bulk.execute());
+        assert.commandWorked(coll.createIndex({b: 1}, {unique: true}));
+
+        // The first document updated takes b: 1, and the second fails with a duplicate key.
+        const res = coll.update({}, {$set: {b: 1}}, {multi: true});
+        assert.writeErrorWithCode(res, ErrorCodes.DuplicateKey);
+        return coll.find({b: 1}).itcount();
+    }
+
+    assert.eq(1, runFailingUpdate(1));
+    assert.eq(1, runFailingUpdate(16));
+
+    MongoRunner.stopMongod(conn);
+}());
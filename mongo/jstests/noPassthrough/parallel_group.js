@@ -0,0 +1,104 @@
+/**
+ * Tests that a $group over a collection scan whose first half runs on several threads produces the
+ * same groups, and the same errors, as a $group which runs entirely on the query thread.
+ */
+load("jstests/aggregation/extras/utils.js");  // For "assertErrorCode".
+load("jstests/libs/analyze_plan.js");         // For "aggPlanHasStage".
+
+(function() {
+    "use strict";
+
+    const conn = MongoRunner.runMongod({
+        setParameter: {
+            internalDocumentSourceGroupParallelWorkers: 4,
+            internalDocumentSourceGroupParallelMinRecordsPerWorker: 100
+        }
+    });
+    assert.neq(null, conn, "mongod was unable to start up");
+
+    const testDB = conn.getDB("test");
+    const coll = testDB.parallel_group;
+    coll.drop();
+
+    const bulk = coll.initializeUnorderedBulkOp();
+    for (let i = 0; i < 2000; i++) {
+        bulk.insert({a: i % 7, b: i % 13, v: i, s: "str" + (i % 5), arr: [i % 3, i % 4], one: 1});
+    }
+    assert.writeOK(bulk.execute());
+
+    function setParallelWorkers(numWorkers) {
+        assert.commandWorked(testDB.adminCommand(
+            {setParameter: 1, internalDocumentSourceGroupParallelWorkers: numWorkers}));
+    }
+
+    // The order of the groups, and of the values collected by $addToSet, is unspecified.
+    function normalizedResults(pipeline) {
+        return coll.aggregate(pipeline)
+            .toArray()
+            .map(function(doc) {
+                if (doc.hasOwnProperty("strs")) {
+                    doc.strs.sort();
+                }
+                return doc;
+            })
+            .sort((lhs, rhs) => tojson(lhs) < tojson(rhs) ? -1 : 1);
+    }
+
+    const storageEngine = jsTest.options().storageEngine || "wiredTiger";
+
+    function assertSameGroupsAsSerialGroup(pipeline) {
+        setParallelWorkers(4);
+        if (storageEngine === "wiredTiger") {
+            const explain = coll.explain().aggregate(pipeline);
+            assert(aggPlanHasStage(explain, "$_internalParallelPartialGroup"), tojson(explain));
+        }
+        const parallel = normalizedResults(pipeline);
+
+        setParallelWorkers(1);
+        const serial = normalizedResults(pipeline);
+        assert.eq(parallel, serial);
+    }
+
+    assertSameGroupsAsSerialGroup([{
+        $group: {
+            _id: "$a",
+            count: {$sum: 1},
+            total: {$sum: "$v"},
+            avg: {$avg: "$v"},
+            min: {$min: "$v"},
+            max: {$max: "$v"},
+            strs: {$addToSet: "$s"}
+        }
+    }]);
+    assertSameGroupsAsSerialGroup([
+        {$match: {b: {$lt: 6}}},
+        {$project: {a: 1, v: 1}},
+        {$group: {_id: {a: "$a"}, total: {$sum: "$v"}}}
+    ]);
+    assertSameGroupsAsSerialGroup(
+        [{$unwind: "$arr"}, {$group: {_id: "$arr", count: {$sum: 1}}}, {$sort: {_id: 1}}]);
+    assertSameGroupsAsSerialGroup([{$group: {_id: null, count: {$sum: 1}}}]);
+
+    // A $group which cannot reserve two of the server's worker threads runs on the query thread.
+    if (storageEngine === "wiredTiger") {
+        const pipeline = [{$group: {_id: "$a", count: {$sum: 1}}}];
+        setParallelWorkers(4);
+        assert.commandWorked(testDB.adminCommand(
+            {setParameter: 1, internalDocumentSourceGroupParallelMaxTotalWorkers: 1}));
+        const explain = coll.explain().aggregate(pipeline);
+        assert(!aggPlanHasStage(explain, "$_internalParallelPartialGroup"), tojson(explain));
+        assert.commandWorked(testDB.adminCommand(
+            {setParameter: 1, internalDocumentSourceGroupParallelMaxTotalWorkers: 16}));
+        assertSameGroupsAsSerialGroup(pipeline);
+    }
+
+    // An error raised on one of the threads fails the aggregation.
+    assert.writeOK(coll.insert({a: 0, v: 0, one: 0}));
+    const failingPipeline = [{$group: {_id: "$a", total: {$sum: {$divide: [1, "$one"]}}}}];
+    setParallelWorkers(4);
+    assertErrorCode(coll, failingPipeline, 16608);
+    setParallelWorkers(1);
+    assertErrorCode(coll, failingPipeline, 16608);
+
+    MongoRunner.stopMongod(conn);
+}());
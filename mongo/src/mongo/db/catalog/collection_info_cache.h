@@ -37,6 +37,7 @@
 namespace mongo {
 class Collection;
 class IndexDescriptor;
+class IndexStatistics;
 class OperationContext;
 
 /**
@@ -70,6 +71,12 @@ public:
 
         virtual void notifyOfQuery(OperationContext* opCtx,
                                    const std::set<std::string>& indexesUsed) = 0;
+
+        virtual std::shared_ptr<const IndexStatistics> getIndexStatistics(
+            StringData indexName) const = 0;
+
+        virtual void setIndexStatistics(StringData indexName,
+                                        std::shared_ptr<const IndexStatistics> stats) = 0;
     };
 
 private:
@@ -162,6 +169,24 @@ public:
         return this->_impl().notifyOfQuery(opCtx, indexesUsed);
     }
 
+    /**
+     * Returns the most recently sampled statistics for the index named 'indexName', or null if
+     * the index has not been sampled since it was built.
+     */
+    inline std::shared_ptr<const IndexStatistics> getIndexStatistics(
+        const StringData indexName) const {
+        return this->_impl().getIndexStatistics(indexName);
+    }
+
+    /**
+     * Replaces the statistics of the index named 'indexName'. May be called under an intent lock;
+     * planners holding the previous statistics keep them alive until they are done.
+     */
+    inline void setIndexStatistics(const StringData indexName,
+                                   std::shared_ptr<const IndexStatistics> stats) {
+        return this->_impl().setIndexStatistics(indexName, std::move(stats));
+    }
+
     //explicit inline CollectionInfoCache(Collection* const collection, const NamespaceString& ns)
     //ȷӦ
     std::unique_ptr<Impl> _pimpl;
@@ -39,6 +39,7 @@
 #include "mongo/db/fts/fts_spec.h"
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/index_legacy.h"
+#include "mongo/db/query/index_statistics.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/planner_ixselect.h"
 #include "mongo/db/service_context.h"
@@ -275,6 +276,26 @@ void CollectionInfoCacheImpl::droppedIndex(OperationContext* opCtx, StringData i
 
     rebuildIndexData(opCtx);
     _indexUsageTracker.unregisterIndex(indexName);
+    setIndexStatistics(indexName, nullptr);
+}
+
+std::shared_ptr<const IndexStatistics> CollectionInfoCacheImpl::getIndexStatistics(
+    StringData indexName) const {
+    stdx::lock_guard<stdx::mutex> lk(_indexStatisticsMutex);
+    auto it = _indexStatistics.find(indexName);
+    return it == _indexStatistics.end() ? nullptr : it->second;
+}
+
+void CollectionInfoCacheImpl::setIndexStatistics(StringData indexName,
+                                                 std::shared_ptr<const IndexStatistics> stats) {
+    _planCache->notifyOfIndexStatistics(indexName, stats);
+
+    stdx::lock_guard<stdx::mutex> lk(_indexStatisticsMutex);
+    if (stats) {
+        _indexStatistics[indexName] = std::move(stats);
+    } else {
+        _indexStatistics.erase(indexName);
+    }
 }
 
 //CollectionInfoCacheImpl::init   CollectionInfoCacheImpl::addedIndex   
@@ -34,6 +34,8 @@
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/query_settings.h"
 #include "mongo/db/update_index_data.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/string_map.h"
 
 namespace mongo {
 
@@ -108,6 +110,10 @@ public:
      */
     void notifyOfQuery(OperationContext* opCtx, const std::set<std::string>& indexesUsed);
 
+    std::shared_ptr<const IndexStatistics> getIndexStatistics(StringData indexName) const;
+
+    void setIndexStatistics(StringData indexName, std::shared_ptr<const IndexStatistics> stats);
+
 private:
     void computeIndexKeys(OperationContext* opCtx);
     void updatePlanCacheIndexEntries(OperationContext* opCtx);
@@ -139,6 +145,10 @@ private:
     CollectionIndexUsageTracker _indexUsageTracker;
 
     bool _hasTTLIndex = false;
+
+    // Protects '_indexStatistics', which the sampler updates under an intent lock.
+    mutable stdx::mutex _indexStatisticsMutex;
+    StringMap<std::shared_ptr<const IndexStatistics>> _indexStatistics;
 };
 
 }  // namespace mongo
@@ -266,7 +266,7 @@ Status ClearFilters::clear(OperationContext* opCtx,
         querySettings->removeAllowedIndices(planCache->computeKey(*cq));
 
         // Remove entry from plan cache
-        planCache->remove(*cq).transitional_ignore();
+        planCache->removeQueryShape(*cq).transitional_ignore();
 
         LOG(0) << "Removed index filter on " << ns << " " << redact(cq->toStringShort());
 
@@ -298,9 +298,10 @@ Status ClearFilters::clear(OperationContext* opCtx,
     // non-filtered indexed solutions next time the query is run.
     // Resolve plan cache key from (query, sort, projection) in query settings entry.
     // Concurrency note: There's no harm in removing plan cache entries one at at time.
-    // Only way that PlanCache::remove() can fail is when the query shape has been removed from
-    // the cache by some other means (re-index, collection info reset, ...). This is OK since
-    // that's the intended effect of calling the remove() function with the key from the hint entry.
+    // Only way that PlanCache::removeQueryShape() can fail is when the query shape has been
+    // removed from the cache by some other means (re-index, collection info reset, ...). This is
+    // OK since that's the intended effect of calling removeQueryShape() with the key from the
+    // hint entry.
     for (vector<AllowedIndexEntry>::const_iterator i = entries.begin(); i != entries.end(); ++i) {
         AllowedIndexEntry entry = *i;
 
@@ -321,7 +322,7 @@ Status ClearFilters::clear(OperationContext* opCtx,
         std::unique_ptr<CanonicalQuery> cq = std::move(statusWithCQ.getValue());
 
         // Remove plan cache entry.
-        planCache->remove(*cq).transitional_ignore();
+        planCache->removeQueryShape(*cq).transitional_ignore();
     }
 
     LOG(0) << "Removed all index filters for collection: " << ns;
@@ -399,7 +400,7 @@ Status SetFilter::set(OperationContext* opCtx,
     querySettings->setAllowedIndices(*cq, planCache->computeKey(*cq), indexes, indexNames);
 
     // Remove entry from plan cache.
-    planCache->remove(*cq).transitional_ignore();
+    planCache->removeQueryShape(*cq).transitional_ignore();
 
     LOG(0) << "Index filter set on " << ns << " " << redact(cq->toStringShort()) << " "
            << indexesElt;
@@ -40,6 +40,7 @@
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/client.h"
 #include "mongo/db/commands/plan_cache_commands.h"
+#include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/extensions_callback_real.h"
@@ -292,6 +293,11 @@ MONGO_INITIALIZER_WITH_PREREQUISITES(SetupPlanCacheCommands, MONGO_NO_PREREQUISI
     return Status::OK();
 }
 
+ServerStatusMetricField<Counter64> displayPlanCacheTotalSizeEstimateBytes(
+    "query.planCache.totalSizeEstimateBytes", &planCacheTotalSizeEstimateBytes);
+ServerStatusMetricField<Counter64> displayPlanCacheMemoryEvictions(
+    "query.planCache.memoryEvictions", &planCacheMemoryEvictions);
+
 }  // namespace
 
 namespace mongo {
@@ -510,6 +516,11 @@ Status PlanCacheListQueryShapes::list(const PlanCache& planCache, BSONObjBuilder
         if (!entry->collation.isEmpty()) {
             shapeBuilder.append("collation", entry->collation);
         }
+        if (entry->selectivityBucket) {
+            shapeBuilder.append("selectivityBucket", *entry->selectivityBucket);
+        }
+        shapeBuilder.appendNumber("estimatedSizeBytes",
+                                  static_cast<long long>(entry->estimatedEntrySizeBytes));
         shapeBuilder.doneFast();
 
         // Release resources for cached solution after extracting query shape.
@@ -517,6 +528,11 @@ Status PlanCacheListQueryShapes::list(const PlanCache& planCache, BSONObjBuilder
     }
     arrayBuilder.doneFast();
 
+    // The memory budget is server-wide, so the estimate for this collection alone is reported
+    // next to the shapes that make it up.
+    bob->appendNumber("totalSizeEstimateBytes",
+                      static_cast<long long>(planCache.getSizeEstimateBytes()));
+
     return Status::OK();
 }
 
@@ -560,7 +576,9 @@ Status PlanCacheClear::clear(OperationContext* opCtx,
 
         unique_ptr<CanonicalQuery> cq = std::move(statusWithCQ.getValue());
 
-        if (!planCache->contains(*cq)) {
+        // Clearing a shape drops every parameterized entry stored for it, not only the one
+        // the literals of 'query' would use.
+        if (!planCache->removeQueryShape(*cq).isOK()) {
             // Log if asked to clear non-existent query shape.
             LOG(1) << ns << ": query shape doesn't exist in PlanCache - "
                    << redact(cq->getQueryObj()) << "(sort: " << cq->getQueryRequest().getSort()
@@ -569,11 +587,6 @@ Status PlanCacheClear::clear(OperationContext* opCtx,
             return Status::OK();
         }
 
-        Status result = planCache->remove(*cq);
-        if (!result.isOK()) {
-            return result;
-        }
-
         LOG(1) << ns << ": removed plan cache entry - " << redact(cq->getQueryObj())
                << "(sort: " << cq->getQueryRequest().getSort()
                << "; projection: " << cq->getQueryRequest().getProj()
@@ -619,6 +632,23 @@ Status PlanCacheListPlans::runPlanCacheCommand(OperationContext* opCtx,
     return list(opCtx, *planCache, ns, cmdObj, bob);
 }
 
+namespace {
+
+/**
+ * Appends the accumulated multi-planning trial statistics for 'cq', if any, as a "trialStats"
+ * subobject of 'bob'.
+ */
+void appendTrialStats(const PlanCache& planCache, const CanonicalQuery& cq, BSONObjBuilder* bob) {
+    auto trialStats = planCache.getTrialStats(cq);
+    if (trialStats) {
+        BSONObjBuilder trialBob(bob->subobjStart("trialStats"));
+        trialStats->serialize(&trialBob);
+        trialBob.doneFast();
+    }
+}
+
+}  // namespace
+
 //ݲѯ󣬻ȡÿsolutionscoreֹ
 //db.xx.getPlanCache().getPlansByQuery({"query" : {"create_time" : { "$gte" : "2020-12-27 00:00:00","$lte" : "2021-01-26 23:59:59"}},"sort" : { },"projection" : {}})
 // static
@@ -640,6 +670,7 @@ Status PlanCacheListPlans::list(OperationContext* opCtx,
         // exist in plan cache.
         BSONArrayBuilder plansBuilder(bob->subarrayStart("plans"));
         plansBuilder.doneFast();
+        appendTrialStats(planCache, *cq, bob);
         return Status::OK();
     }
 
@@ -698,6 +729,10 @@ Status PlanCacheListPlans::list(OperationContext* opCtx,
 
     // Append the time the entry was inserted into the plan cache.
     bob->append("timeOfCreation", entry->timeOfCreation);
+    if (entry->selectivityBucket) {
+        bob->append("selectivityBucket", *entry->selectivityBucket);
+    }
+    appendTrialStats(planCache, *cq, bob);
 
     return Status::OK();
 }
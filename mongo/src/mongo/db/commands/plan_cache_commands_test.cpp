@@ -164,6 +164,41 @@ TEST(PlanCacheCommandsTest, planCacheListQueryShapesOneKey) {
     ASSERT_BSONOBJ_EQ(shapes[0].getObjectField("collation"), cq->getCollator()->getSpec().toBSON());
 }
 
+TEST(PlanCacheCommandsTest, planCacheListQueryShapesReportsSizeEstimates) {
+    QueryTestServiceContext serviceContext;
+    auto opCtx = serviceContext.makeOperationContext();
+
+    PlanCache planCache;
+    QuerySolution qs;
+    qs.cacheData.reset(createSolutionCacheData());
+    std::vector<QuerySolution*> solns;
+    solns.push_back(&qs);
+    for (auto&& filter : {"{a: 1}", "{b: 1}"}) {
+        auto qr = stdx::make_unique<QueryRequest>(nss);
+        qr->setFilter(fromjson(filter));
+        auto statusWithCQ = CanonicalQuery::canonicalize(opCtx.get(), std::move(qr));
+        ASSERT_OK(statusWithCQ.getStatus());
+        ASSERT_OK(planCache.add(*statusWithCQ.getValue(),
+                                solns,
+                                createDecision(1U),
+                                opCtx->getServiceContext()->getPreciseClockSource()->now()));
+    }
+
+    BSONObjBuilder bob;
+    ASSERT_OK(PlanCacheListQueryShapes::list(planCache, &bob));
+    BSONObj resultObj = bob.obj();
+
+    // Every shape reports its own estimate, and they add up to the reported total.
+    long long sumSizeBytes = 0;
+    for (auto&& shapeElt : resultObj.getField("shapes").Array()) {
+        const long long sizeBytes = shapeElt.Obj().getField("estimatedSizeBytes").numberLong();
+        ASSERT_GT(sizeBytes, 0LL);
+        sumSizeBytes += sizeBytes;
+    }
+    ASSERT_EQUALS(resultObj.getField("totalSizeEstimateBytes").numberLong(), sumSizeBytes);
+    ASSERT_EQUALS(static_cast<size_t>(sumSizeBytes), planCache.getSizeEstimateBytes());
+}
+
 /**
  * Tests for planCacheClear
  */
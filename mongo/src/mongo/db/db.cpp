@@ -73,6 +73,7 @@
 #include "mongo/db/generic_cursor_manager_mongod.h"
 #include "mongo/db/index_names.h"
 #include "mongo/db/index_rebuilder.h"
+#include "mongo/db/index_statistics_sampler.h"
 #include "mongo/db/initialize_server_global_state.h"
 #include "mongo/db/initialize_snmp.h"
 #include "mongo/db/introspect.h"
@@ -92,6 +93,7 @@
 #include "mongo/db/mongod_options.h"
 #include "mongo/db/op_observer_impl.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/plan_cache_persister.h"
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/repair_database.h"
 #include "mongo/db/repl/drop_pending_collection_reaper.h"
@@ -1001,6 +1003,9 @@ ExitCode _initAndListen(int listenPort) {
             startTTLBackgroundJob();
         }
 
+        startPlanCachePersisterBackgroundJob();
+        startIndexStatisticsSamplerBackgroundJob();
+
         if (replSettings.usingReplSets() || (!replSettings.isMaster() && replSettings.isSlave()) ||
             !internalValidateFeaturesAsMaster) {
             serverGlobalParams.validateFeaturesAsMaster.store(false);
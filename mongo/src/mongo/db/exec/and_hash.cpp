@@ -28,6 +28,8 @@
 
 #include "mongo/db/exec/and_hash.h"
 
+#include <algorithm>
+
 #include "mongo/db/exec/and_common-inl.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set.h"
@@ -79,6 +81,12 @@ void AndHashStage::addChild(PlanStage* child) {
     _children.emplace_back(child);
 }
 
+void AndHashStage::setRecordIdsOnly() {
+    invariant(_lookAheadResults.empty());
+    _recordIdsOnly = true;
+    _specificStats.recordIdsOnly = true;
+}
+
 size_t AndHashStage::getMemUsage() const {
     return _memUsage;
 }
@@ -97,7 +105,7 @@ bool AndHashStage::isEOF() {
     // Or we're streaming in results from the last child.
 
     // If there's nothing to probe against, we're EOF.
-    if (_dataMap.empty()) {
+    if (nothingToProbe()) {
         return true;
     }
 
@@ -188,9 +196,9 @@ PlanStage::StageState AndHashStage::doWork(WorkingSetID* out) {
         }
 
         if (0 == _currentChild) {
-            return readFirstChild(out);
+            return _recordIdsOnly ? readFirstChildRecordIds(out) : readFirstChild(out);
         } else if (_currentChild < _children.size() - 1) {
-            return hashOtherChildren(out);
+            return _recordIdsOnly ? intersectOtherChildRecordIds(out) : hashOtherChildren(out);
         } else {
             _hashingChildren = false;
             // We don't hash our last child.  Instead, we probe the table created from the
@@ -203,11 +211,15 @@ PlanStage::StageState AndHashStage::doWork(WorkingSetID* out) {
     // hash map.
 
     // We should be EOF if we're not hashing results and the dataMap is empty.
-    verify(!_dataMap.empty());
+    verify(!nothingToProbe());
 
     // We probe _dataMap with the last child.
     verify(_currentChild == _children.size() - 1);
 
+    if (_recordIdsOnly) {
+        return probeRecordIds(out);
+    }
+
     // Get the next result for the (_children.size() - 1)-th child.
     StageState childStatus = workChild(_children.size() - 1, out);
     if (PlanStage::ADVANCED != childStatus) {
@@ -433,6 +445,17 @@ void AndHashStage::doInvalidate(OperationContext* opCtx,
         }
     }
 
+    if (_recordIdsOnly) {
+        // With document-level locking, only deletions are invalidated, so the RecordId can simply
+        // be forgotten.
+        if (0 == _currentChild) {
+            _deletedWhileReading.push_back(dl);
+        } else {
+            removeRecordId(dl);
+        }
+        return;
+    }
+
     // If it's a deletion, we have to forget about the RecordId, and since the AND-ing is by
     // RecordId we can't continue processing it even with the object.
     //
@@ -484,4 +507,185 @@ const SpecificStats* AndHashStage::getSpecificStats() const {
     return &_specificStats;
 }
 
+PlanStage::StageState AndHashStage::readFirstChildRecordIds(WorkingSetID* out) {
+    verify(_currentChild == 0);
+
+    WorkingSetID id = WorkingSet::INVALID_ID;
+    StageState childStatus = workChild(0, &id);
+
+    if (PlanStage::ADVANCED == childStatus) {
+        WorkingSetMember* member = _ws->get(id);
+
+        // Maybe the child had an invalidation.  We intersect RecordId(s) so we can't do anything
+        // with this WSM.
+        if (!member->hasRecordId()) {
+            _ws->flagForReview(id);
+            return PlanStage::NEED_TIME;
+        }
+
+        _recordIds.push_back(member->recordId);
+        _memUsage += sizeof(RecordId) + sizeof(uint8_t);
+        _ws->free(id);
+        return PlanStage::NEED_TIME;
+    } else if (PlanStage::IS_EOF == childStatus) {
+        // Done reading child 0.
+        _currentChild = 1;
+
+        // Sort the RecordIds, dropping the duplicates a multikey index may produce.
+        std::sort(_recordIds.begin(), _recordIds.end());
+        _recordIds.erase(std::unique(_recordIds.begin(), _recordIds.end()), _recordIds.end());
+        _recordIdStates.assign(_recordIds.size(), 0);
+        _recordIdsRemaining = _recordIds.size();
+        _memUsage = _recordIds.size() * (sizeof(RecordId) + sizeof(uint8_t));
+
+        for (auto&& recordId : _deletedWhileReading) {
+            removeRecordId(recordId);
+        }
+        _deletedWhileReading.clear();
+
+        // If our first child was empty, don't scan any others, no possible results.
+        if (nothingToProbe()) {
+            _hashingChildren = false;
+            return PlanStage::IS_EOF;
+        }
+
+        _specificStats.mapAfterChild.push_back(_recordIdsRemaining);
+
+        return PlanStage::NEED_TIME;
+    } else if (PlanStage::FAILURE == childStatus || PlanStage::DEAD == childStatus) {
+        *out = id;
+        if (WorkingSet::INVALID_ID == id) {
+            mongoutils::str::stream ss;
+            ss << "hashed AND stage failed to read in results to from first child";
+            Status status(ErrorCodes::InternalError, ss);
+            *out = WorkingSetCommon::allocateStatusMember(_ws, status);
+        }
+        return childStatus;
+    } else {
+        if (PlanStage::NEED_YIELD == childStatus) {
+            *out = id;
+        }
+
+        return childStatus;
+    }
+}
+
+PlanStage::StageState AndHashStage::intersectOtherChildRecordIds(WorkingSetID* out) {
+    verify(_currentChild > 0);
+
+    WorkingSetID id = WorkingSet::INVALID_ID;
+    StageState childStatus = workChild(_currentChild, &id);
+
+    if (PlanStage::ADVANCED == childStatus) {
+        WorkingSetMember* member = _ws->get(id);
+
+        // Maybe the child had an invalidation.  We intersect RecordId(s) so we can't do anything
+        // with this WSM.
+        if (!member->hasRecordId()) {
+            _ws->flagForReview(id);
+            return PlanStage::NEED_TIME;
+        }
+
+        const ptrdiff_t pos = findRecordId(member->recordId);
+        if (pos >= 0) {
+            _recordIdStates[pos] |= kSeen;
+        }
+        _ws->free(id);
+        return PlanStage::NEED_TIME;
+    } else if (PlanStage::IS_EOF == childStatus) {
+        // Finished with a child.
+        ++_currentChild;
+
+        // Keep the RecordIds this child produced which have not been deleted meanwhile.
+        size_t kept = 0;
+        for (size_t i = 0; i < _recordIds.size(); ++i) {
+            if ((_recordIdStates[i] & (kSeen | kRemoved)) == kSeen) {
+                _recordIds[kept++] = _recordIds[i];
+            }
+        }
+        _recordIds.resize(kept);
+        _recordIdStates.assign(kept, 0);
+        _recordIdsRemaining = kept;
+        _memUsage = kept * (sizeof(RecordId) + sizeof(uint8_t));
+
+        _specificStats.mapAfterChild.push_back(_recordIdsRemaining);
+
+        // If we have nothing to AND with after finishing any child, stop.
+        if (nothingToProbe()) {
+            _hashingChildren = false;
+            return PlanStage::IS_EOF;
+        }
+
+        // We've finished scanning all children.  Return results with the next call to work().
+        if (_currentChild == _children.size()) {
+            _hashingChildren = false;
+        }
+
+        return PlanStage::NEED_TIME;
+    } else if (PlanStage::FAILURE == childStatus || PlanStage::DEAD == childStatus) {
+        *out = id;
+        if (WorkingSet::INVALID_ID == id) {
+            mongoutils::str::stream ss;
+            ss << "hashed AND stage failed to read in results from other child " << _currentChild;
+            Status status(ErrorCodes::InternalError, ss);
+            *out = WorkingSetCommon::allocateStatusMember(_ws, status);
+        }
+        return childStatus;
+    } else {
+        if (PlanStage::NEED_YIELD == childStatus) {
+            *out = id;
+        }
+
+        return childStatus;
+    }
+}
+
+PlanStage::StageState AndHashStage::probeRecordIds(WorkingSetID* out) {
+    StageState childStatus = workChild(_children.size() - 1, out);
+    if (PlanStage::ADVANCED != childStatus) {
+        return childStatus;
+    }
+
+    WorkingSetMember* member = _ws->get(*out);
+
+    // Maybe the child had an invalidation.  We intersect RecordId(s) so we can't do anything
+    // with this WSM.
+    if (!member->hasRecordId()) {
+        _ws->flagForReview(*out);
+        return PlanStage::NEED_TIME;
+    }
+
+    const ptrdiff_t pos = findRecordId(member->recordId);
+    if (pos < 0 || (_recordIdStates[pos] & kRemoved)) {
+        // Child's output wasn't in every previous child, or was already returned.
+        _ws->free(*out);
+        return PlanStage::NEED_TIME;
+    }
+
+    // Return the last child's WSM as is, and only once.
+    _recordIdStates[pos] |= kRemoved;
+    --_recordIdsRemaining;
+    return PlanStage::ADVANCED;
+}
+
+void AndHashStage::removeRecordId(const RecordId& recordId) {
+    const ptrdiff_t pos = findRecordId(recordId);
+    if (pos >= 0 && !(_recordIdStates[pos] & kRemoved)) {
+        _recordIdStates[pos] |= kRemoved;
+        --_recordIdsRemaining;
+    }
+}
+
+ptrdiff_t AndHashStage::findRecordId(const RecordId& recordId) const {
+    auto it = std::lower_bound(_recordIds.begin(), _recordIds.end(), recordId);
+    if (it == _recordIds.end() || *it != recordId) {
+        return -1;
+    }
+    return it - _recordIds.begin();
+}
+
+bool AndHashStage::nothingToProbe() const {
+    return _recordIdsOnly ? 0 == _recordIdsRemaining : _dataMap.empty();
+}
+
 }  // namespace mongo
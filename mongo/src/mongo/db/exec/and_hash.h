@@ -110,6 +110,18 @@ public:
 
     void addChild(PlanStage* child);
 
+    /**
+     * Declares that the consumer of this stage only needs the RecordIds it returns, as is the case
+     * when a FETCH sits on top of it. The intersection of the children is then computed on a
+     * sorted array of RecordIds, with a byte of state each, instead of a hash table of
+     * WorkingSetMembers. This is well over an order of magnitude smaller. Results are the last
+     * child's WorkingSetMembers, without the index key data of the other children merged in.
+     *
+     * Must be called before the first call to work(). Only valid on storage engines which support
+     * document-level locking, where a RecordId is invalidated only when its document is deleted.
+     */
+    void setRecordIdsOnly();
+
     /**
      * Returns memory usage.
      * For testing only.
@@ -138,6 +150,21 @@ private:
     StageState hashOtherChildren(WorkingSetID* out);
     StageState workChild(size_t childNo, WorkingSetID* out);
 
+    // The counterparts of readFirstChild(), hashOtherChildren() and the probing done by the last
+    // child, used when '_recordIdsOnly' is set.
+    StageState readFirstChildRecordIds(WorkingSetID* out);
+    StageState intersectOtherChildRecordIds(WorkingSetID* out);
+    StageState probeRecordIds(WorkingSetID* out);
+
+    // Marks 'recordId' as removed from '_recordIds', if it is there.
+    void removeRecordId(const RecordId& recordId);
+
+    // Returns the position of 'recordId' in '_recordIds', or -1 if it is absent.
+    ptrdiff_t findRecordId(const RecordId& recordId) const;
+
+    // Whether there is nothing left for the last child to probe against.
+    bool nothingToProbe() const;
+
     // Not owned by us.
     const Collection* _collection;
 
@@ -162,6 +189,30 @@ private:
     // True if we're still intersecting _children[0..._children.size()-1].
     bool _hashingChildren;
 
+    // See setRecordIdsOnly().
+    bool _recordIdsOnly = false;
+
+    // Used in place of _dataMap when '_recordIdsOnly' is set. Holds the RecordIds in the
+    // intersection of the children read so far. It is appended to while the first child is read
+    // and kept sorted from then on.
+    std::vector<RecordId> _recordIds;
+
+    // Per-RecordId state, parallel to '_recordIds' once it is sorted.
+    enum RecordIdState : uint8_t {
+        // Produced by the child currently being intersected.
+        kSeen = 1,
+        // Deleted or already returned; must not be returned.
+        kRemoved = 2,
+    };
+    std::vector<uint8_t> _recordIdStates;
+
+    // How many RecordIds in '_recordIds' do not have the kRemoved state.
+    size_t _recordIdsRemaining = 0;
+
+    // RecordIds deleted while the first child is still being read, when '_recordIds' is not yet
+    // sorted. They are removed once it is.
+    std::vector<RecordId> _deletedWhileReading;
+
     // Which child are we currently working on?
     size_t _currentChild;
 
@@ -0,0 +1,73 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/batched_child_results.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace mongo {
+
+PlanStage::StageState BatchedChildResults::next(PlanStage* child, WorkingSetID* out) {
+    if (!_results.empty()) {
+        *out = _results.front();
+        _results.pop_front();
+        return PlanStage::ADVANCED;
+    }
+
+    if (_endOfBatch) {
+        const PlanStage::StageState state = _endOfBatch->first;
+        *out = _endOfBatch->second;
+        _endOfBatch = boost::none;
+        return state;
+    }
+
+    if (_worksLeft <= 1U) {
+        _worksLeft = 0;
+        return child->work(out);
+    }
+
+    std::vector<WorkingSetID> batch;
+    const size_t worksBefore = child->getCommonStats()->works;
+    const PlanStage::StageState state = child->workBatch(_worksLeft, &batch, out);
+    _worksLeft -= std::min(_worksLeft, child->getCommonStats()->works - worksBefore);
+    if (batch.empty()) {
+        return state;
+    }
+    if (PlanStage::ADVANCED != state && PlanStage::NEED_TIME != state) {
+        _endOfBatch = std::make_pair(state, *out);
+    }
+
+    _results.assign(batch.begin() + 1, batch.end());
+    *out = batch.front();
+    return PlanStage::ADVANCED;
+}
+
+}  // namespace mongo
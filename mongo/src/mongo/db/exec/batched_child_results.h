@@ -0,0 +1,92 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <deque>
+#include <utility>
+
+#include "mongo/db/exec/plan_stage.h"
+
+namespace mongo {
+
+/**
+ * Lets a stage with a single child consume that child's results one at a time while the child
+ * produces them in batches. Used by stages that implement doWorkBatch() on top of their doWork().
+ */
+class BatchedChildResults {
+public:
+    /**
+     * Lets the child do up to 'maxWorks' units of work, in batches, over the following calls to
+     * next(). Called by the owning stage at the start of doWorkBatch().
+     */
+    void startBatch(size_t maxWorks) {
+        _worksLeft = maxWorks;
+    }
+
+    /**
+     * Returns to handing out one unit of the child's work per call to next(). Called by the
+     * owning stage at the end of doWorkBatch(). Results already buffered are still handed out.
+     */
+    void endBatch() {
+        _worksLeft = 0;
+    }
+
+    /**
+     * Behaves like child->work(out). Between startBatch() and endBatch(), asks the child for a
+     * batch of work whenever no buffered results remain, and hands out its results one per call
+     * followed by the state that ended the batch.
+     */
+    PlanStage::StageState next(PlanStage* child, WorkingSetID* out);
+
+    /**
+     * Returns true if results or a batch-ending state are waiting to be handed out.
+     */
+    bool hasBuffered() const {
+        return !_results.empty() || _endOfBatch;
+    }
+
+    /**
+     * The buffered results, in the order they will be handed out.
+     */
+    const std::deque<WorkingSetID>& buffered() const {
+        return _results;
+    }
+
+private:
+    std::deque<WorkingSetID> _results;
+
+    // The state that ended the last batch, if it has not been handed out yet.
+    boost::optional<std::pair<PlanStage::StageState, WorkingSetID>> _endOfBatch;
+
+    // How many units of work the child may still do in batches.
+    size_t _worksLeft = 0;
+};
+
+}  // namespace mongo
@@ -30,6 +30,7 @@
 
 #include "mongo/db/catalog/index_catalog.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/exec/filter.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/stdx/memory.h"
@@ -71,11 +72,15 @@ using stdx::make_unique;
 // static
 const char* CountScan::kStageType = "COUNT_SCAN";
 
-CountScan::CountScan(OperationContext* opCtx, const CountScanParams& params, WorkingSet* workingSet)
+CountScan::CountScan(OperationContext* opCtx,
+                     const CountScanParams& params,
+                     WorkingSet* workingSet,
+                     const MatchExpression* filter)
     : PlanStage(kStageType, opCtx),
       _workingSet(workingSet),
       _descriptor(params.descriptor),
       _iam(params.descriptor->getIndexCatalog()->getIndex(params.descriptor)),
+      _filter(filter),
       _shouldDedup(params.descriptor->isMultikey(opCtx)),
       _params(params) {
     _specificStats.keyPattern = _params.descriptor->keyPattern();
@@ -91,6 +96,10 @@ CountScan::CountScan(OperationContext* opCtx, const CountScanParams& params, Wor
     _specificStats.isPartial = _params.descriptor->isPartial();
     _specificStats.indexVersion = static_cast<int>(_params.descriptor->version());
 
+    if (_params.bounds) {
+        return;
+    }
+
     // endKey must be after startKey in index order since we only do forward scans.
     dassert(_params.startKey.woCompare(_params.endKey,
                                        Ordering::make(params.descriptor->keyPattern()),
@@ -105,17 +114,30 @@ PlanStage::StageState CountScan::doWork(WorkingSetID* out) {
     boost::optional<IndexKeyEntry> entry;
     const bool needInit = !_cursor;
     try {
-        // We don't care about the keys.
-        const auto kWantLoc = SortedDataInterface::Cursor::kWantLoc;
+        // We only care about the keys if we have to check them against bounds or a filter.
+        const auto parts = (_params.bounds || _filter) ? SortedDataInterface::Cursor::kKeyAndLoc
+                                                      : SortedDataInterface::Cursor::kWantLoc;
 
         if (needInit) {
             // First call to work().  Perform cursor init.
             _cursor = _iam->newCursor(getOpCtx());
-            _cursor->setEndPosition(_params.endKey, _params.endKeyInclusive);
-
-            entry = _cursor->seek(_params.startKey, _params.startKeyInclusive, kWantLoc);
+            if (_params.bounds) {
+                _checker = stdx::make_unique<IndexBoundsChecker>(
+                    _params.bounds.get_ptr(), _descriptor->keyPattern(), 1);
+                if (!_checker->getStartSeekPoint(&_seekPoint)) {
+                    _commonStats.isEOF = true;
+                    _cursor.reset();
+                    return PlanStage::IS_EOF;
+                }
+                entry = _cursor->seek(_seekPoint, parts);
+            } else {
+                _cursor->setEndPosition(_params.endKey, _params.endKeyInclusive);
+                entry = _cursor->seek(_params.startKey, _params.startKeyInclusive, parts);
+            }
+        } else if (_needSeek) {
+            entry = _cursor->seek(_seekPoint, parts);
         } else {
-            entry = _cursor->next(kWantLoc);
+            entry = _cursor->next(parts);
         }
     } catch (const WriteConflictException&) {
         if (needInit) {
@@ -126,14 +148,35 @@ PlanStage::StageState CountScan::doWork(WorkingSetID* out) {
         return PlanStage::NEED_YIELD;
     }
 
+    _needSeek = false;
     ++_specificStats.keysExamined;
 
+    if (entry && _checker) {
+        switch (_checker->checkKey(entry->key, &_seekPoint)) {
+            case IndexBoundsChecker::VALID:
+                break;
+
+            case IndexBoundsChecker::DONE:
+                entry = boost::none;
+                break;
+
+            case IndexBoundsChecker::MUST_ADVANCE:
+                _needSeek = true;
+                return PlanStage::NEED_TIME;
+        }
+    }
+
     if (!entry) {
         _commonStats.isEOF = true;
         _cursor.reset();
         return PlanStage::IS_EOF;
     }
 
+    // Filter before de-duplicating, since another key of a multikey document may still pass.
+    if (!Filter::passes(entry->key, _descriptor->keyPattern(), _filter)) {
+        return PlanStage::NEED_TIME;
+    }
+
     if (_shouldDedup && !_returned.insert(entry->loc).second) {
         // *loc was already in _returned.
         return PlanStage::NEED_TIME;
@@ -150,8 +193,15 @@ bool CountScan::isEOF() {
 }
 
 void CountScan::doSaveState() {
-    if (_cursor)
-        _cursor->save();
+    if (!_cursor)
+        return;
+
+    if (_needSeek) {
+        _cursor->saveUnpositioned();
+        return;
+    }
+
+    _cursor->save();
 }
 
 void CountScan::doRestoreState() {
@@ -189,15 +239,26 @@ void CountScan::doInvalidate(OperationContext* opCtx, const RecordId& dl, Invali
 }
 
 unique_ptr<PlanStageStats> CountScan::getStats() {
+    // Add a BSON representation of the filter to the stats tree, if there is one.
+    if (_filter) {
+        BSONObjBuilder bob;
+        _filter->serialize(&bob);
+        _commonStats.filter = bob.obj();
+    }
+
     unique_ptr<PlanStageStats> ret = make_unique<PlanStageStats>(_commonStats, STAGE_COUNT_SCAN);
 
     unique_ptr<CountScanStats> countStats = make_unique<CountScanStats>(_specificStats);
     countStats->keyPattern = _specificStats.keyPattern.getOwned();
 
-    countStats->startKey = replaceBSONFieldNames(_params.startKey, countStats->keyPattern);
-    countStats->startKeyInclusive = _params.startKeyInclusive;
-    countStats->endKey = replaceBSONFieldNames(_params.endKey, countStats->keyPattern);
-    countStats->endKeyInclusive = _params.endKeyInclusive;
+    if (_params.bounds) {
+        countStats->indexBounds = _params.bounds->toBSON();
+    } else {
+        countStats->startKey = replaceBSONFieldNames(_params.startKey, countStats->keyPattern);
+        countStats->startKeyInclusive = _params.startKeyInclusive;
+        countStats->endKey = replaceBSONFieldNames(_params.endKey, countStats->keyPattern);
+        countStats->endKeyInclusive = _params.endKeyInclusive;
+    }
 
     ret->specific = std::move(countStats);
 
@@ -29,11 +29,14 @@
 #pragma once
 
 
+#include <boost/optional.hpp>
+
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/index/index_access_method.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/query/index_bounds.h"
 #include "mongo/db/record_id.h"
 #include "mongo/platform/unordered_set.h"
 
@@ -54,10 +57,15 @@ struct CountScanParams {
 
     BSONObj endKey;
     bool endKeyInclusive;
+
+    // If set, the scan counts the keys within these bounds rather than the keys between
+    // 'startKey' and 'endKey', which are then ignored. Must be oriented for a forward scan.
+    boost::optional<IndexBounds> bounds;
 };
 
 /**
- * Used by the count command. Scans an index from a start key to an end key. Creates a
+ * Used by the count command. Scans an index from a start key to an end key, or over arbitrary
+ * index bounds, counting the keys that pass an optional filter evaluated on the keys. Creates a
  * WorkingSetMember for each matching index key in RID_AND_OBJ state. It has a null record id and an
  * empty object with a null snapshot id rather than real data. Returning real data is unnecessary
  * since all we need is the count.
@@ -67,7 +75,10 @@ struct CountScanParams {
  */
 class CountScan final : public PlanStage {
 public:
-    CountScan(OperationContext* opCtx, const CountScanParams& params, WorkingSet* workingSet);
+    CountScan(OperationContext* opCtx,
+              const CountScanParams& params,
+              WorkingSet* workingSet,
+              const MatchExpression* filter = nullptr);
 
     StageState doWork(WorkingSetID* out) final;
     bool isEOF() final;
@@ -97,6 +108,15 @@ private:
 
     std::unique_ptr<SortedDataInterface::Cursor> _cursor;
 
+    // Keys that do not pass this filter are not counted. Not owned by us.
+    const MatchExpression* _filter;
+
+    // Only used when the scan is over '_params.bounds'. If '_needSeek' is true, the next key to
+    // examine is at or after '_seekPoint'.
+    std::unique_ptr<IndexBoundsChecker> _checker;
+    IndexSeekPoint _seekPoint;
+    bool _needSeek = false;
+
     // Could our index have duplicates?  If so, we use _returned to dedup.
     bool _shouldDedup;
     unordered_set<RecordId, RecordId::Hasher> _returned;
@@ -83,6 +83,10 @@ DeleteStage::DeleteStage(OperationContext* opCtx,
       _idRetrying(WorkingSet::INVALID_ID),
       _idReturning(WorkingSet::INVALID_ID) {
     _children.emplace_back(child);
+
+    if (_params.isMulti && !_params.returnDeleted && !_params.isExplain) {
+        _batchSize = write_stage_common::getMultiWriteBatchSize();
+    }
 }
 
 bool DeleteStage::isEOF() {
@@ -93,7 +97,7 @@ bool DeleteStage::isEOF() {
         return true;
     }
     return _idRetrying == WorkingSet::INVALID_ID && _idReturning == WorkingSet::INVALID_ID &&
-        child()->isEOF();
+        _batch.empty() && child()->isEOF();
 }
 
 PlanStage::StageState DeleteStage::doWork(WorkingSetID* out) {
@@ -116,6 +120,11 @@ PlanStage::StageState DeleteStage::doWork(WorkingSetID* out) {
         return PlanStage::ADVANCED;
     }
 
+    // Delete, or retry deleting, a full batch, or the last one once the child is out of results.
+    if (_batch.size() >= _batchSize || (!_batch.empty() && child()->isEOF())) {
+        return flushBatch(out);
+    }
+
     // Either retry the last WSM we worked on or get a new one from our child.
     WorkingSetID id;
     if (_idRetrying != WorkingSet::INVALID_ID) {
@@ -149,6 +158,9 @@ PlanStage::StageState DeleteStage::doWork(WorkingSetID* out) {
                 return status;
 
             case PlanStage::IS_EOF:
+                if (!_batch.empty()) {
+                    return flushBatch(out);
+                }
                 return status;
 
             default:
@@ -172,6 +184,14 @@ PlanStage::StageState DeleteStage::doWork(WorkingSetID* out) {
     // a fetch. We should always get fetched data, and never just key data.
     invariant(member->hasObj());
 
+    if (_batchSize > 1) {
+        // The document is checked against the predicate again when its batch is deleted.
+        member->makeObjOwnedIfNeeded();
+        memberFreer.Dismiss();
+        _batch.push_back(id);
+        return _batch.size() < _batchSize ? PlanStage::NEED_TIME : flushBatch(out);
+    }
+
     // Ensure the document still exists and matches the predicate.
     bool docStillMatches;
     try {
@@ -201,9 +221,6 @@ PlanStage::StageState DeleteStage::doWork(WorkingSetID* out) {
         member->obj.setValue(deletedDoc.getOwned());
     }
 
-    // TODO: Do we want to buffer docs and delete them in a group rather than saving/restoring state
-    // repeatedly?
-
     WorkingSetCommon::prepareForSnapshotChange(_ws);
     try {
         child()->saveState();
@@ -307,4 +324,68 @@ PlanStage::StageState DeleteStage::prepareToRetryWSM(WorkingSetID idToRetry, Wor
     return NEED_YIELD;
 }
 
+PlanStage::StageState DeleteStage::flushBatch(WorkingSetID* out) {
+    WorkingSetCommon::prepareForSnapshotChange(_ws);
+    try {
+        child()->saveState();
+    } catch (const WriteConflictException&) {
+        std::terminate();
+    }
+
+    while (!_batch.empty()) {
+        const size_t numToWrite = _writeBatchOneAtATime ? 1U : _batch.size();
+        size_t docsDeleted = 0;
+        try {
+            WriteUnitOfWork wunit(getOpCtx());
+            for (size_t i = 0; i < numToWrite; ++i) {
+                // The document may have been deleted or changed since it was buffered.
+                if (!write_stage_common::ensureStillMatches(
+                        _collection, getOpCtx(), _ws, _batch[i], _params.canonicalQuery)) {
+                    continue;
+                }
+                _collection->deleteDocument(getOpCtx(),
+                                            _params.stmtId,
+                                            _ws->get(_batch[i])->recordId,
+                                            _params.opDebug,
+                                            _params.fromMigrate,
+                                            false,
+                                            Collection::StoreDeletedDoc::Off);
+                ++docsDeleted;
+            }
+            wunit.commit();
+        } catch (const WriteConflictException&) {
+            // Everything since the last commit rolled back. Keep it so it is retried after
+            // yielding.
+            *out = WorkingSet::INVALID_ID;
+            return NEED_YIELD;
+        } catch (...) {
+            if (_writeBatchOneAtATime) {
+                throw;
+            }
+
+            // As in UpdateStage::flushBatch(), keep the deletes an unbatched delete would have
+            // made before the failing document.
+            _writeBatchOneAtATime = true;
+            continue;
+        }
+        _specificStats.docsDeleted += docsDeleted;
+
+        for (size_t i = 0; i < numToWrite; ++i) {
+            _ws->free(_batch[i]);
+        }
+        _batch.erase(_batch.begin(), _batch.begin() + numToWrite);
+    }
+    _writeBatchOneAtATime = false;
+
+    // As with a single delete, restore the child outside of the WriteUnitOfWork.
+    try {
+        child()->restoreState();
+    } catch (const WriteConflictException&) {
+        *out = WorkingSet::INVALID_ID;
+        return NEED_YIELD;
+    }
+
+    return PlanStage::NEED_TIME;
+}
+
 }  // namespace mongo
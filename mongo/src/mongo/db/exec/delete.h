@@ -28,6 +28,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/logical_session_id.h"
@@ -80,6 +82,9 @@ struct DeleteStageParams {
  * document was requested to be returned, then ADVANCED is returned after deleting a document.
  * Otherwise, NEED_TIME is returned after deleting a document.
  *
+ * A multi delete that returns nothing buffers the documents from its child and deletes them in
+ * batches of write_stage_common::getMultiWriteBatchSize(), one WriteUnitOfWork per batch.
+ *
  * Callers of work() must be holding a write lock (and, for replicated deletes, callers must have
  * had the replication coordinator approve the write).
  */
@@ -122,6 +127,14 @@ private:
      */
     StageState prepareToRetryWSM(WorkingSetID idToRetry, WorkingSetID* out);
 
+    /**
+     * Deletes the documents in '_batch' that still match in a single WriteUnitOfWork. On a write
+     * conflict nothing is deleted, the batch is kept to be retried, and NEED_YIELD is returned. On
+     * any other error the batch is written again one document per WriteUnitOfWork, so that the
+     * documents before the failing one are deleted before the error is thrown.
+     */
+    StageState flushBatch(WorkingSetID* out);
+
     DeleteStageParams _params;
 
     // Not owned by us.
@@ -138,6 +151,16 @@ private:
     // If not WorkingSet::INVALID_ID, we return this member to our caller.
     WorkingSetID _idReturning;
 
+    // How many documents are deleted together. One when each is deleted as soon as it is found.
+    size_t _batchSize = 1;
+
+    // Documents buffered for the next batch.
+    std::vector<WorkingSetID> _batch;
+
+    // Set once deleting '_batch' in one WriteUnitOfWork has failed with an error other than a
+    // write conflict, until the rest of the batch has been deleted one document at a time.
+    bool _writeBatchOneAtATime = false;
+
     // Stats
     DeleteStats _specificStats;
 };
@@ -30,6 +30,8 @@
 
 #include "mongo/db/exec/fetch.h"
 
+#include <algorithm>
+
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/exec/filter.h"
@@ -81,14 +83,23 @@ FetchStage::FetchStage(OperationContext* opCtx,
 
 FetchStage::~FetchStage() {}
 
+void FetchStage::setWindowSize(size_t windowSize) {
+    _windowSize = windowSize;
+    _specificStats.windowSize = windowSize;
+}
+
 bool FetchStage::isEOF() {
+    if (!_window.empty()) {
+        return false;
+    }
+
     if (WorkingSet::INVALID_ID != _idRetrying) {
         // We asked the parent for a page-in, but still haven't had a chance to return the
         // paged in document
         return false;
     }
 
-    return child()->isEOF();
+    return !_childResults.hasBuffered() && child()->isEOF();
 }
 
 /*
@@ -127,11 +138,15 @@ PlanStage::StageState FetchStage::doWork(WorkingSetID* out) {
         return PlanStage::IS_EOF;
     }
 
+    if (_windowSize > 0) {
+        return doWorkWindowed(out);
+    }
+
     // Either retry the last WSM we worked on or get a new one from our child.
     WorkingSetID id;
     StageState status;
     if (_idRetrying == WorkingSet::INVALID_ID) {
-        status = child()->work(&id); //ʵǵIndexScan::doWork
+        status = _childResults.next(child().get(), &id); //ʵǵIndexScan::doWork
     } else {
         status = ADVANCED;
         id = _idRetrying;
@@ -202,6 +217,132 @@ PlanStage::StageState FetchStage::doWork(WorkingSetID* out) {
     return status;
 }
 
+PlanStage::StageState FetchStage::doWorkWindowed(WorkingSetID* out) {
+    if (WindowPhase::kFilling == _windowPhase) {
+        WorkingSetID id;
+        StageState status = _childResults.next(child().get(), &id);
+
+        if (PlanStage::ADVANCED == status) {
+            WorkingSetMember* member = _ws->get(id);
+            if (member->hasObj()) {
+                ++_specificStats.alreadyHasObj;
+                _window.push_back(passesOrFree(id) ? id : WorkingSet::INVALID_ID);
+            } else {
+                verify(WorkingSetMember::RID_AND_IDX == member->getState());
+                verify(member->hasRecordId());
+                _fetchOrder.push_back(_window.size());
+                _window.push_back(id);
+            }
+
+            if (_window.size() >= _windowSize) {
+                startFetchingWindow();
+            }
+            return PlanStage::NEED_TIME;
+        } else if (PlanStage::IS_EOF == status) {
+            if (_window.empty()) {
+                return PlanStage::IS_EOF;
+            }
+            startFetchingWindow();
+            return PlanStage::NEED_TIME;
+        } else if (PlanStage::FAILURE == status || PlanStage::DEAD == status) {
+            *out = id;
+            if (WorkingSet::INVALID_ID == id) {
+                mongoutils::str::stream ss;
+                ss << "fetch stage failed to read in results from child";
+                Status status(ErrorCodes::InternalError, ss);
+                *out = WorkingSetCommon::allocateStatusMember(_ws, status);
+            }
+            return status;
+        } else if (PlanStage::NEED_YIELD == status) {
+            *out = id;
+        }
+        return status;
+    }
+
+    if (WindowPhase::kFetching == _windowPhase) {
+        if (_windowPos == _fetchOrder.size()) {
+            _windowPhase = WindowPhase::kReturning;
+            _windowPos = 0;
+            return PlanStage::NEED_TIME;
+        }
+
+        const size_t windowIndex = _fetchOrder[_windowPos];
+        const WorkingSetID id = _window[windowIndex];
+        WorkingSetMember* member = _ws->get(id);
+
+        // An invalidation may have fetched the document already.
+        if (!member->hasObj()) {
+            try {
+                if (!_cursor)
+                    _cursor = _collection->getCursor(getOpCtx());
+
+                if (!WorkingSetCommon::fetch(getOpCtx(), _ws, id, _cursor)) {
+                    _ws->free(id);
+                    _window[windowIndex] = WorkingSet::INVALID_ID;
+                    ++_windowPos;
+                    return PlanStage::NEED_TIME;
+                }
+            } catch (const WriteConflictException&) {
+                *out = WorkingSet::INVALID_ID;
+                return NEED_YIELD;
+            }
+
+            // The next seek may reuse the cursor's buffer, and the document is not returned
+            // until the whole window has been fetched.
+            member->makeObjOwnedIfNeeded();
+        }
+
+        if (!passesOrFree(id)) {
+            _window[windowIndex] = WorkingSet::INVALID_ID;
+        }
+        ++_windowPos;
+        return PlanStage::NEED_TIME;
+    }
+
+    invariant(WindowPhase::kReturning == _windowPhase);
+    while (_windowPos < _window.size()) {
+        const WorkingSetID id = _window[_windowPos++];
+        if (WorkingSet::INVALID_ID != id) {
+            *out = id;
+            return PlanStage::ADVANCED;
+        }
+    }
+
+    _window.clear();
+    _fetchOrder.clear();
+    _windowPos = 0;
+    _windowPhase = WindowPhase::kFilling;
+    return PlanStage::NEED_TIME;
+}
+
+void FetchStage::startFetchingWindow() {
+    std::sort(_fetchOrder.begin(), _fetchOrder.end(), [this](size_t lhs, size_t rhs) {
+        return _ws->get(_window[lhs])->recordId < _ws->get(_window[rhs])->recordId;
+    });
+    ++_specificStats.windows;
+    _windowPhase = WindowPhase::kFetching;
+    _windowPos = 0;
+}
+
+bool FetchStage::passesOrFree(WorkingSetID id) {
+    ++_specificStats.docsExamined;
+    if (Filter::passes(_ws->get(id), _filter)) {
+        return true;
+    }
+    _ws->free(id);
+    return false;
+}
+
+PlanStage::StageState FetchStage::doWorkBatch(size_t maxWorks,
+                                              std::vector<WorkingSetID>* batch,
+                                              WorkingSetID* out) {
+    _childResults.startBatch(maxWorks);
+    const StageState state = workEachInBatch(
+        _ws, maxWorks, batch, out, [this](WorkingSetID* id) { return FetchStage::doWork(id); });
+    _childResults.endBatch();
+    return state;
+}
+
 void FetchStage::doSaveState() {
     if (_cursor)
         _cursor->saveUnpositioned();
@@ -232,6 +373,26 @@ void FetchStage::doInvalidate(OperationContext* opCtx, const RecordId& dl, Inval
             WorkingSetCommon::fetchAndInvalidateRecordId(opCtx, member, _collection);
         }
     }
+
+    // Results buffered from the child have not been fetched yet either.
+    for (auto id : _childResults.buffered()) {
+        WorkingSetMember* member = _ws->get(id);
+        if (member->hasRecordId() && (member->recordId == dl)) {
+            WorkingSetCommon::fetchAndInvalidateRecordId(opCtx, member, _collection);
+        }
+    }
+
+    // Nor have the members of the window still to be returned.
+    const size_t firstUnreturned = WindowPhase::kReturning == _windowPhase ? _windowPos : 0;
+    for (size_t i = firstUnreturned; i < _window.size(); ++i) {
+        if (WorkingSet::INVALID_ID == _window[i]) {
+            continue;
+        }
+        WorkingSetMember* member = _ws->get(_window[i]);
+        if (member->hasRecordId() && (member->recordId == dl)) {
+            WorkingSetCommon::fetchAndInvalidateRecordId(opCtx, member, _collection);
+        }
+    }
 }
 
 //FetchStage::doWork
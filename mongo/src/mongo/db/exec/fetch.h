@@ -29,7 +29,9 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
+#include "mongo/db/exec/batched_child_results.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression.h"
@@ -77,6 +79,9 @@ public:
 
     bool isEOF() final;
     StageState doWork(WorkingSetID* out) final;
+    StageState doWorkBatch(size_t maxWorks,
+                           std::vector<WorkingSetID>* batch,
+                           WorkingSetID* out) final;
 
     void doSaveState() final;
     void doRestoreState() final;
@@ -88,6 +93,16 @@ public:
         return STAGE_FETCH;
     }
 
+    /**
+     * Makes this stage read up to 'windowSize' RecordIds from its child before fetching any of
+     * them, then fetch the window in RecordId order and return it in the order the child produced
+     * it. Turns a scan of a secondary index into ordered rather than random reads of the record
+     * store. Must be called before the first call to work().
+     *
+     * Only for storage engines that do not page in records via fetchers.
+     */
+    void setWindowSize(size_t windowSize);
+
     std::unique_ptr<PlanStageStats> getStats();
 
     const SpecificStats* getSpecificStats() const final;
@@ -101,6 +116,21 @@ private:
      */
     StageState returnIfMatches(WorkingSetMember* member, WorkingSetID memberID, WorkingSetID* out);
 
+    /**
+     * doWork() when a window size is set.
+     */
+    StageState doWorkWindowed(WorkingSetID* out);
+
+    /**
+     * Sorts the unfetched members of the window by RecordId and moves to the fetching phase.
+     */
+    void startFetchingWindow();
+
+    /**
+     * Counts 'id' as examined and frees it, returning false, if it does not pass the filter.
+     */
+    bool passesOrFree(WorkingSetID id);
+
     // Collection which is used by this stage. Used to resolve record ids retrieved by child
     // stages. The lifetime of the collection must supersede that of the stage.
     const Collection* _collection;
@@ -118,6 +148,29 @@ private:
     // If not Null, we use this rather than asking our child what to do next.
     WorkingSetID _idRetrying;
 
+    // Results of the child not yet fetched, when working in batch mode.
+    BatchedChildResults _childResults;
+
+    //
+    // Windowed fetching, used if '_windowSize' is non-zero.
+    //
+
+    enum class WindowPhase { kFilling, kFetching, kReturning };
+
+    size_t _windowSize = 0;
+    WindowPhase _windowPhase = WindowPhase::kFilling;
+
+    // Results of the child in the order it produced them. Entries that were dropped because the
+    // record was deleted or failed the filter are set to INVALID_ID.
+    std::vector<WorkingSetID> _window;
+
+    // Positions in '_window' of the members to fetch, in RecordId order.
+    std::vector<size_t> _fetchOrder;
+
+    // Next position in '_fetchOrder' to fetch while kFetching, or in '_window' to return while
+    // kReturning.
+    size_t _windowPos = 0;
+
     // Stats
     FetchStats _specificStats;
 };
@@ -35,10 +35,12 @@
 #include <vector>
 
 // For s2 search
+#include "third_party/s2/s2edgeutil.h"
 #include "third_party/s2/s2regionintersection.h"
 
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/db/bson/dotted_path_support.h"
+#include "mongo/db/exec/eof.h"
 #include "mongo/db/exec/fetch.h"
 #include "mongo/db/exec/index_scan.h"
 #include "mongo/db/exec/working_set_computed_data.h"
@@ -791,7 +793,12 @@ GeoNear2DSphereStage::GeoNear2DSphereStage(const GeoNearParams& nearParams,
       _s2Index(s2Index),
       _fullBounds(geoNearDistanceBounds(*nearParams.nearQuery)),
       _currBounds(_fullBounds.center(), -1, _fullBounds.getInner()),
-      _boundsIncrement(0.0) {
+      _boundsIncrement(0.0),
+      _bestFirst(SPHERE == nearParams.nearQuery->centroid->crs &&
+                 internalQueryS2GeoNearBestFirst.load()),
+      _centerPoint(
+          S2LatLng::FromDegrees(_fullBounds.center().y, _fullBounds.center().x).ToPoint()),
+      _bestFirstInner(_fullBounds.getInner()) {
     _specificStats.keyPattern = s2Index->keyPattern();
     _specificStats.indexName = s2Index->indexName();
     _specificStats.indexVersion = static_cast<int>(s2Index->version());
@@ -1023,6 +1030,11 @@ PlanStage::StageState GeoNear2DSphereStage::initialize(OperationContext* opCtx,
         _boundsIncrement = 3 * estimatedDistance;
         invariant(_boundsIncrement > 0.0);
 
+        // The best-first search scans cells about as wide as the estimated distance.
+        _scanLevel = S2::kAvgEdge.GetClosestLevel(estimatedDistance / kRadiusOfEarthInMeters);
+        _scanLevel = std::max(_scanLevel, _indexParams.coarsestIndexedLevel);
+        _scanLevel = std::min(_scanLevel, _indexParams.finestIndexedLevel);
+
         // Clean up
         _densityEstimator.reset(NULL);
     }
@@ -1034,6 +1046,10 @@ StatusWith<NearStage::CoveredInterval*>  //
     GeoNear2DSphereStage::nextInterval(OperationContext* opCtx,
                                        WorkingSet* workingSet,
                                        Collection* collection) {
+    if (_bestFirst) {
+        return nextBestFirstInterval(opCtx, workingSet, collection);
+    }
+
     // The search is finished if we searched at least once and all the way to the edge
     if (_currBounds.getInner() >= 0 && _currBounds.getOuter() == _fullBounds.getOuter()) {
         return StatusWith<CoveredInterval*>(NULL);
@@ -1113,6 +1129,136 @@ StatusWith<NearStage::CoveredInterval*>  //
                                                             isLastInterval));
 }
 
+namespace {
+
+// Absorbs the rounding error between the cell distance bound and the distance computed for a
+// document, so that the bound never exceeds the distance of a document inside the cell.
+const double kCellDistanceSlackInMeters = 1e-3;
+
+/**
+ * Returns a lower bound on the distance in meters from 'point' to anything inside 'cell'.
+ */
+double minDistanceToCell(const S2Point& point, const S2Cell& cell) {
+    if (cell.Contains(point)) {
+        return 0.0;
+    }
+
+    S1Angle minAngle = S1Angle::Radians(M_PI);
+    for (int k = 0; k < 4; ++k) {
+        S1Angle edgeAngle =
+            S2EdgeUtil::GetDistance(point, cell.GetVertex(k), cell.GetVertex((k + 1) & 3));
+        minAngle = std::min(minAngle, edgeAngle);
+    }
+
+    return std::max(0.0, minAngle.radians() * kRadiusOfEarthInMeters - kCellDistanceSlackInMeters);
+}
+
+}  // namespace
+
+void GeoNear2DSphereStage::pushCandidateCell(const S2CellId& id) {
+    S2Cell cell(id);
+    if (!_fullRegion->MayIntersect(cell)) {
+        return;
+    }
+
+    double minDistance = minDistanceToCell(_centerPoint, cell);
+    if (minDistance > _fullBounds.getOuter()) {
+        return;
+    }
+
+    _candidateCells.push(CandidateCell{id, minDistance});
+}
+
+StatusWith<NearStage::CoveredInterval*>  //
+    GeoNear2DSphereStage::nextBestFirstInterval(OperationContext* opCtx,
+                                                WorkingSet* workingSet,
+                                                Collection* collection) {
+    if (_bestFirstDone) {
+        return StatusWith<CoveredInterval*>(NULL);
+    }
+
+    // Every cell gets its own interval, so the stages of the cells already scanned are destroyed
+    // rather than kept for explain.
+    releaseSearchedIntervals();
+
+    if (!_candidateCellsInitialized) {
+        _fullRegion.reset(buildS2Region(_fullBounds));
+        for (const S2CellId& cellId : ExpressionMapping::get2dsphereCovering(*_fullRegion)) {
+            pushCandidateCell(cellId);
+        }
+        _candidateCellsInitialized = true;
+    } else if (!_specificStats.intervalStats.empty()) {
+        // Scan coarser cells while they come up empty, and finer ones if they hold too much.
+        const IntervalStats& lastIntervalStats = _specificStats.intervalStats.back();
+        if (lastIntervalStats.numResultsBuffered == 0)
+            _scanLevel = std::max(_scanLevel - 1, _indexParams.coarsestIndexedLevel);
+        else if (lastIntervalStats.numResultsBuffered > 600)
+            _scanLevel = std::min(_scanLevel + 1, _indexParams.finestIndexedLevel);
+    }
+
+    // Subdivide the closest cells until the closest one is fine enough to scan
+    while (!_candidateCells.empty() && _candidateCells.top().id.level() < _scanLevel) {
+        const S2CellId cellId = _candidateCells.top().id;
+        _candidateCells.pop();
+        ++_specificStats.cellsVisited;
+
+        for (S2CellId child = cellId.child_begin(); child != cellId.child_end();
+             child = child.next()) {
+            pushCandidateCell(child);
+        }
+    }
+
+    if (_candidateCells.empty()) {
+        // Everything is scanned, return what is left in the buffer
+        _bestFirstDone = true;
+        _children.emplace_back(new EOFStage(opCtx));
+        return StatusWith<CoveredInterval*>(new CoveredInterval(
+            _children.back().get(), true, _bestFirstInner, _fullBounds.getOuter(), true));
+    }
+
+    const S2CellId cellId = _candidateCells.top().id;
+    _candidateCells.pop();
+    ++_specificStats.cellsVisited;
+    ++_specificStats.cellsScanned;
+
+    // Every document closer than the nearest unscanned cell has been buffered by now
+    const bool isLastInterval = _candidateCells.empty();
+    const double minDistance = _bestFirstInner;
+    double maxDistance = _fullBounds.getOuter();
+    if (!isLastInterval) {
+        maxDistance = std::min(_candidateCells.top().minDistance, maxDistance);
+        maxDistance = std::max(minDistance, maxDistance);
+    }
+    _bestFirstInner = maxDistance;
+    _bestFirstDone = isLastInterval;
+
+    //
+    // Setup the stages scanning this cell
+    //
+
+    IndexScanParams scanParams;
+    scanParams.descriptor = _s2Index;
+    scanParams.direction = 1;
+
+    // Documents indexed under the parent cells are seen once per child cell.
+    scanParams.doNotDedup = true;
+    scanParams.bounds = _nearParams.baseBounds;
+
+    const int s2FieldPosition = getFieldPosition(_s2Index, _nearParams.nearQuery->field);
+    fassert(40708, s2FieldPosition >= 0);
+    OrderedIntervalList* coveredIntervals = &scanParams.bounds.fields[s2FieldPosition];
+    coveredIntervals->intervals.clear();
+    ExpressionMapping::S2CellIdsToIntervalsWithParents({cellId}, _indexParams, coveredIntervals);
+
+    IndexScan* scan = new IndexScan(opCtx, scanParams, workingSet, nullptr);
+
+    // FetchStage owns index scan
+    _children.emplace_back(new FetchStage(opCtx, workingSet, scan, _nearParams.filter, collection));
+
+    return StatusWith<CoveredInterval*>(new CoveredInterval(
+        _children.back().get(), true, minDistance, maxDistance, isLastInterval));
+}
+
 StatusWith<double> GeoNear2DSphereStage::computeDistance(WorkingSetMember* member) {
     return computeGeoNearDistance(_nearParams, member);
 }
@@ -28,6 +28,8 @@
 
 #pragma once
 
+#include <queue>
+
 #include "mongo/db/exec/near.h"
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/exec/working_set.h"
@@ -38,7 +40,9 @@
 #include "mongo/db/matcher/expression.h"
 #include "mongo/db/matcher/expression_geo.h"
 #include "mongo/db/query/index_bounds.h"
+#include "third_party/s2/s2cellid.h"
 #include "third_party/s2/s2cellunion.h"
+#include "third_party/s2/s2region.h"
 
 namespace mongo {
 
@@ -108,6 +112,12 @@ private:
 
 /**
  * Implementation of GeoNear on top of a 2DSphere (S2) index
+ *
+ * Spherical queries search best-first when internalQueryS2GeoNearBestFirst is set: the cells
+ * covering the search annulus are kept in a priority queue ordered by their distance from the
+ * search point, and each interval scans the closest cell, subdividing coarser cells down to a
+ * level picked from the estimated data density. A result is returned once no unscanned cell is
+ * closer than it, so a query with a small limit scans only the cells it needs.
  */
 class GeoNear2DSphereStage final : public NearStage {
 public:
@@ -154,6 +164,57 @@ private:
 
     class DensityEstimator;
     std::unique_ptr<DensityEstimator> _densityEstimator;
+
+    //
+    // Best-first search.
+    //
+
+    /**
+     * A cell not searched yet, with a lower bound on the distance in meters from the search point
+     * to anything inside it.
+     */
+    struct CandidateCell {
+        S2CellId id;
+        double minDistance;
+
+        // Orders the priority queue closest cell first.
+        bool operator<(const CandidateCell& other) const {
+            return minDistance > other.minDistance;
+        }
+    };
+
+    /**
+     * nextInterval() for the best-first search. Only the stages scanning the current cell are
+     * kept alive; the work done on earlier cells is reported through cellsScanned.
+     */
+    StatusWith<CoveredInterval*> nextBestFirstInterval(OperationContext* opCtx,
+                                                       WorkingSet* workingSet,
+                                                       Collection* collection);
+
+    /**
+     * Queues the cell 'id' if it may contain results.
+     */
+    void pushCandidateCell(const S2CellId& id);
+
+    // Whether this stage searches best-first.
+    const bool _bestFirst;
+
+    // The full search annulus and the search point, on the sphere.
+    std::unique_ptr<S2Region> _fullRegion;
+    S2Point _centerPoint;
+
+    // Cells not searched yet, closest first. Built by the first call to nextInterval().
+    std::priority_queue<CandidateCell> _candidateCells;
+    bool _candidateCellsInitialized = false;
+
+    // Cells coarser than this are subdivided rather than scanned.
+    int _scanLevel = 0;
+
+    // The lower distance bound of the next interval.
+    double _bestFirstInner = 0.0;
+
+    // Whether the interval reaching the outer bound of the search has been handed out.
+    bool _bestFirstDone = false;
 };
 
 }  // namespace mongo
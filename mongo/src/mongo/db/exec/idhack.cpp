@@ -30,6 +30,9 @@
 
 #include "mongo/db/exec/idhack.h"
 
+#include <algorithm>
+
+#include "mongo/bson/bsonobj_comparator.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/catalog/index_catalog.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
@@ -38,8 +41,11 @@
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/exec/working_set_computed_data.h"
 #include "mongo/db/index/btree_access_method.h"
+#include "mongo/db/query/collation/collator_interface.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/storage/record_fetcher.h"
 #include "mongo/stdx/memory.h"
+#include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
 
@@ -60,9 +66,26 @@ IDHackStage::IDHackStage(OperationContext* opCtx,
     : PlanStage(kStageType, opCtx),
       _collection(collection),
       _workingSet(ws),
-      _key(query->getQueryObj()["_id"].wrap()),
       _done(false),
       _idBeingPagedIn(WorkingSet::INVALID_ID) {
+    BSONElement idElt = query->getQueryObj()["_id"];
+    if (idElt.type() == Object && str::equals("$in", idElt.Obj().firstElementFieldName())) {
+        for (auto&& value : idElt.Obj().firstElement().Obj()) {
+            _keys.push_back(value.wrap("_id"));
+        }
+
+        // Look the values up in the order of the _id index, which has the query's collation, and
+        // only once each.
+        BSONObjComparator comparator(
+            BSONObj(), BSONObjComparator::FieldNamesMode::kIgnore, query->getCollator());
+        std::sort(_keys.begin(), _keys.end(), comparator.makeLessThan());
+        _keys.erase(std::unique(_keys.begin(), _keys.end(), comparator.makeEqualTo()),
+                    _keys.end());
+        _done = _keys.empty();
+    } else {
+        _keys.push_back(idElt.wrap());
+    }
+
     const IndexCatalog* catalog = _collection->getIndexCatalog();
     _specificStats.indexName = descriptor->indexName();
     _accessMethod = catalog->getIndex(descriptor);
@@ -82,7 +105,7 @@ IDHackStage::IDHackStage(OperationContext* opCtx,
     : PlanStage(kStageType, opCtx),
       _collection(collection),
       _workingSet(ws),
-      _key(key),
+      _keys{key},
       _done(false),
       _addKeyMetadata(false),
       _idBeingPagedIn(WorkingSet::INVALID_ID) {
@@ -122,12 +145,11 @@ PlanStage::StageState IDHackStage::doWork(WorkingSetID* out) {
     WorkingSetID id = WorkingSet::INVALID_ID;
     try {
         // Look up the key by going directly to the index.
-        RecordId recordId = _accessMethod->findSingle(getOpCtx(), _key);
+        RecordId recordId = _accessMethod->findSingle(getOpCtx(), _keys[_nextKey]);
 
         // Key not found.
         if (recordId.isNull()) {
-            _done = true;
-            return PlanStage::IS_EOF;
+            return skipKey();
         }
 
         ++_specificStats.keysExamined;
@@ -157,9 +179,7 @@ PlanStage::StageState IDHackStage::doWork(WorkingSetID* out) {
             // _id is immutable so the index would return the only record that could
             // possibly match the query.
             _workingSet->free(id);
-            _commonStats.isEOF = true;
-            _done = true;
-            return IS_EOF;
+            return skipKey();
         }
 
         return advance(id, member, out);
@@ -182,15 +202,25 @@ PlanStage::StageState IDHackStage::advance(WorkingSetID id,
     if (_addKeyMetadata) {
         BSONObjBuilder bob;
         BSONObj ownedKeyObj = member->obj.value()["_id"].wrap().getOwned();
-        bob.appendKeys(_key, ownedKeyObj);
+        bob.appendKeys(_keys[_nextKey], ownedKeyObj);
         member->addComputed(new IndexKeyComputedData(bob.obj()));
     }
 
-    _done = true;
+    _done = ++_nextKey == _keys.size();
     *out = id;
     return PlanStage::ADVANCED;
 }
 
+PlanStage::StageState IDHackStage::skipKey() {
+    if (++_nextKey < _keys.size()) {
+        return PlanStage::NEED_TIME;
+    }
+
+    _commonStats.isEOF = true;
+    _done = true;
+    return PlanStage::IS_EOF;
+}
+
 void IDHackStage::doSaveState() {
     if (_recordCursor)
         _recordCursor->saveUnpositioned();
@@ -230,12 +260,23 @@ void IDHackStage::doInvalidate(OperationContext* opCtx, const RecordId& dl, Inva
 
 // static   prepareExecutionã ѯûhintǿơûskipͨidѯȣֱidȻtrue
 bool IDHackStage::supportsQuery(Collection* collection, const CanonicalQuery& query) {
-    return !query.getQueryRequest().showRecordId() && query.getQueryRequest().getHint().isEmpty() &&
-        !query.getQueryRequest().getSkip() &&
-        //_idѯ
-        CanonicalQuery::isSimpleIdQuery(query.getQueryRequest().getFilter()) &&
-        !query.getQueryRequest().isTailable() &&
-        CollatorInterface::collatorsMatch(query.getCollator(), collection->getDefaultCollator());
+    const QueryRequest& qr = query.getQueryRequest();
+    if (qr.showRecordId() || !qr.getHint().isEmpty() || qr.getSkip() || qr.isTailable() ||
+        !CollatorInterface::collatorsMatch(query.getCollator(), collection->getDefaultCollator())) {
+        return false;
+    }
+
+    //_idѯ
+    if (CanonicalQuery::isSimpleIdQuery(qr.getFilter())) {
+        return true;
+    }
+
+    // A list of _ids is returned in _id index order and in full, so the query may not ask for
+    // another order, for fewer documents or for index bounds.
+    const int maxInValues = internalQueryExecIdHackMaxInValues.load();
+    return maxInValues > 0 && qr.getSort().isEmpty() && !qr.getLimit() && !qr.getNToReturn() &&
+        qr.getMin().isEmpty() && qr.getMax().isEmpty() &&
+        CanonicalQuery::isSimpleIdInQuery(qr.getFilter(), maxInValues);
 }
 
 unique_ptr<PlanStageStats> IDHackStage::getStats() {
@@ -29,6 +29,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/exec/plan_stage.h"
@@ -44,6 +45,9 @@ class RecordCursor;
  * A standalone stage implementing the fast path for key-value retrievals via the _id index. Since
  * the _id index always has the collection default collation, the IDHackStage can only be used when
  * the query's collation is equal to the collection default.
+ *
+ * A query of the form {_id: {$in: [...]}} looks up each distinct value in turn, in _id index
+ * order, and returns the documents found in that order.
  */
 //ֵѯIDHackֱӲѯ  //IDοprepareExecution
 class IDHackStage final : public PlanStage {
@@ -95,6 +99,12 @@ private:
      */
     StageState advance(WorkingSetID id, WorkingSetMember* member, WorkingSetID* out);
 
+    /**
+     * Moves on to the next value to look up after the current one matched nothing. Returns
+     * IS_EOF if there are no more values, or NEED_TIME.
+     */
+    StageState skipKey();
+
     // Not owned here.
     const Collection* _collection;
 
@@ -106,10 +116,14 @@ private:
     // Not owned here.
     const IndexAccessMethod* _accessMethod;
 
-    // The value to match against the _id field.
-    BSONObj _key;
+    // The values to match against the _id field, each wrapped as {_id: <value>}. Sorted and
+    // without duplicates if there is more than one.
+    std::vector<BSONObj> _keys;
+
+    // The position in '_keys' of the value being looked up.
+    size_t _nextKey = 0;
 
-    // Have we returned our one document?
+    // Have we looked up every value?
     bool _done;
 
     // Do we need to add index key metadata for returnKey?
@@ -312,6 +312,14 @@ PlanStage::StageState IndexScan::doWork(WorkingSetID* out) { //PlanStage::work
     return PlanStage::ADVANCED;
 }
 
+PlanStage::StageState IndexScan::doWorkBatch(size_t maxWorks,
+                                             std::vector<WorkingSetID>* batch,
+                                             WorkingSetID* out) {
+    return workEachInBatch(_workingSet, maxWorks, batch, out, [this](WorkingSetID* id) {
+        return IndexScan::doWork(id);
+    });
+}
+
 bool IndexScan::isEOF() {
     return _commonStats.isEOF;
 }
@@ -49,6 +49,7 @@
 #include "mongo/stdx/memory.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -254,6 +255,16 @@ Status MultiPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
 	//ȡNToReturn  limit internalQueryPlanEvaluationMaxResultsСֵ
     size_t numResults = getTrialPeriodNumToReturn(*_query);
 
+    Timer trialTimer;
+    const size_t minCandidatesToHalve = static_cast<size_t>(
+        std::max(2, internalQueryPlanEvaluationHalvingMinCandidates.load()));
+    if (internalQueryPlanEvaluationSuccessiveHalving.load() &&
+        _candidates.size() >= minCandidatesToHalve) {
+        workPlansWithSuccessiveHalving(numWorks, numResults, yieldPolicy);
+        // Skip the regular trial period below.
+        numWorks = 0;
+    }
+
     // Work the plans, stopping when a plan hits EOF or returns some
     // fixed number of results.
     for (size_t ix = 0; ix < numWorks; ++ix) {
@@ -286,6 +297,16 @@ Status MultiPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
     // after transferring ownership of 'ranking' to plan cache.
     std::vector<size_t> candidateOrder = ranking->candidateOrder;
 
+    if (PlanCache::shouldCacheQuery(*_query)) {
+        PlanTrialStats trial;
+        trial.trials = 1;
+        trial.candidates = _candidates.size();
+        trial.candidatesEliminated = _specificStats.candidatesEliminated;
+        trial.works = _specificStats.trialWorks;
+        trial.micros = trialTimer.micros();
+        _collection->infoCache()->getPlanCache()->recordTrial(*_query, trial);
+    }
+
 	//ŵĲѯƻMultiPlanStage::doWorkִ
     CandidatePlan& bestCandidate = _candidates[_bestPlanIdx];
     std::list<WorkingSetID>& alreadyProduced = bestCandidate.results;
@@ -301,12 +322,22 @@ Status MultiPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
         LOG(2) << "Winner has blocking stage, looking for backup plan...";
         for (size_t ix = 0; ix < _candidates.size(); ++ix) {
 			//Ӻѡplanѡ
-            if (!_candidates[ix].solution->hasBlockingStage) {
-                LOG(2) << "Candidate " << ix << " is backup child";
+            // Prefer a plan which ran for the whole trial period. One which successive halving
+            // dropped is only the backup if no surviving plan avoids blocking.
+            if (_candidates[ix].solution->hasBlockingStage) {
+                continue;
+            }
+            if (kNoSuchPlan == _backupPlanIdx ||
+                (_candidates[_backupPlanIdx].eliminated && !_candidates[ix].eliminated)) {
                 _backupPlanIdx = ix;
+            }
+            if (!_candidates[ix].eliminated) {
                 break;
             }
         }
+        if (kNoSuchPlan != _backupPlanIdx) {
+            LOG(2) << "Candidate " << _backupPlanIdx << " is backup child";
+        }
     }
 
     // Even if the query is of a cacheable shape, the caller might have indicated that we shouldn't
@@ -396,6 +427,66 @@ Status MultiPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
     return Status::OK();
 }
 
+void MultiPlanStage::workPlansWithSuccessiveHalving(size_t numWorks,
+                                                    size_t numResults,
+                                                    PlanYieldPolicy* yieldPolicy) {
+    size_t roundWorks = std::max(static_cast<size_t>(1), numWorks / _candidates.size());
+    size_t worksSoFar = 0;
+    while (worksSoFar < numWorks) {
+        const size_t works = std::min(roundWorks, numWorks - worksSoFar);
+        for (size_t ix = 0; ix < works; ++ix) {
+            if (!workAllPlans(numResults, yieldPolicy)) {
+                return;
+            }
+        }
+        worksSoFar += works;
+        ++_specificStats.trialRounds;
+
+        if (eliminateLosingCandidates() <= 1U) {
+            return;
+        }
+        roundWorks *= 2;
+    }
+}
+
+size_t MultiPlanStage::eliminateLosingCandidates() {
+    std::vector<std::pair<double, size_t>> scores;
+    for (size_t ix = 0; ix < _candidates.size(); ++ix) {
+        const CandidatePlan& candidate = _candidates[ix];
+        if (candidate.failed || candidate.eliminated) {
+            continue;
+        }
+        std::unique_ptr<PlanStageStats> stats = candidate.root->getStats();
+        scores.push_back(std::make_pair(PlanRanker::scoreTree(stats.get()), ix));
+    }
+    if (scores.size() <= 1U) {
+        return scores.size();
+    }
+
+    std::stable_sort(scores.begin(),
+                     scores.end(),
+                     [](const std::pair<double, size_t>& lhs,
+                        const std::pair<double, size_t>& rhs) { return lhs.first > rhs.first; });
+
+    // Keep the better half, along with any candidate tied with the worst of it: only plans which
+    // are clearly losing are dropped.
+    const size_t half = (scores.size() + 1) / 2;
+    const double cutoff = scores[half - 1].first;
+    const double epsilon = 1e-10;
+    size_t survivors = scores.size();
+    for (size_t i = half; i < scores.size(); ++i) {
+        if (scores[i].first >= cutoff - epsilon) {
+            continue;
+        }
+        LOG(2) << "Eliminating candidate " << scores[i].second << " with score "
+               << scores[i].first << " from the trial period";
+        _candidates[scores[i].second].eliminated = true;
+        ++_specificStats.candidatesEliminated;
+        --survivors;
+    }
+    return survivors;
+}
+
 //MultiPlanStage::pickBestPlan   https://segmentfault.com/a/1190000015236644  https://yq.aliyun.com/articles/74635
 //workAllPlansִеĲѯƻMultiPlanStage::pickBestPlannumWorksΣPlanRanker::pickBestPlanиworkѡŵ
 bool MultiPlanStage::workAllPlans(size_t numResults, PlanYieldPolicy* yieldPolicy) {
@@ -404,7 +495,7 @@ bool MultiPlanStage::workAllPlans(size_t numResults, PlanYieldPolicy* yieldPolic
 	//ѡĲѯƻ_candidatesе
     for (size_t ix = 0; ix < _candidates.size(); ++ix) {
         CandidatePlan& candidate = _candidates[ix];
-        if (candidate.failed) {
+        if (candidate.failed || candidate.eliminated) {
             continue;
         }
 
@@ -418,6 +509,7 @@ bool MultiPlanStage::workAllPlans(size_t numResults, PlanYieldPolicy* yieldPolic
 		//ִжӦPlanStage::work ͬPlanStageԲοbuildStages
 		//CollectionScanIndexScanȣCollectionScan::work  IndexScan::work
         PlanStage::StageState state = candidate.root->work(&id); //PlanStage::work
+        ++_specificStats.trialWorks;
 
 		//
         if (PlanStage::ADVANCED == state) {
@@ -473,6 +565,17 @@ bool MultiPlanStage::workAllPlans(size_t numResults, PlanYieldPolicy* yieldPolic
                 _failure = true;
                 return false;
             }
+
+            // If every candidate left in a successive-halving trial has failed, fall back on the
+            // ones eliminated earlier.
+            if (std::none_of(_candidates.begin(),
+                             _candidates.end(),
+                             [](const CandidatePlan& c) { return !c.failed && !c.eliminated; })) {
+                for (auto&& c : _candidates) {
+                    c.eliminated = false;
+                }
+                _specificStats.candidatesEliminated = 0;
+            }
         }
     }
 
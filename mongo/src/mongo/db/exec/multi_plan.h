@@ -171,6 +171,22 @@ private:
      */
     bool workAllPlans(size_t numResults, PlanYieldPolicy* yieldPolicy);
 
+    /**
+     * Runs the trial period in rounds. After each round the lower-scoring half of the remaining
+     * candidates is eliminated, and the survivors are worked twice as long in the next round, so
+     * every round costs about as much as the first. The trial ends early under the same
+     * conditions as workAllPlans(), or once a single candidate remains.
+     */
+    void workPlansWithSuccessiveHalving(size_t numWorks,
+                                        size_t numResults,
+                                        PlanYieldPolicy* yieldPolicy);
+
+    /**
+     * Scores the candidates which are neither failed nor eliminated, and eliminates those below
+     * the median score. Returns the number of candidates left.
+     */
+    size_t eliminateLosingCandidates();
+
     /**
      * Checks whether we need to perform either a timing-based yield or a yield for a document
      * fetch. If so, then uses 'yieldPolicy' to actually perform the yield.
@@ -30,6 +30,8 @@
 
 #include "mongo/db/exec/near.h"
 
+#include <algorithm>
+
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/stdx/memory.h"
@@ -280,6 +282,19 @@ PlanStage::StageState NearStage::advanceNext(WorkingSetID* toReturn) {
     return PlanStage::ADVANCED;
 }
 
+void NearStage::releaseSearchedIntervals() {
+    invariant(!_nextInterval);
+    for (auto&& interval : _childrenIntervals) {
+        auto it = std::find_if(
+            _children.begin(), _children.end(), [&](const std::unique_ptr<PlanStage>& child) {
+                return child.get() == interval->covering;
+            });
+        invariant(it != _children.end());
+        _children.erase(it);
+    }
+    _childrenIntervals.clear();
+}
+
 bool NearStage::isEOF() {
     return SearchState_Finished == _searchState;
 }
@@ -153,6 +153,14 @@ protected:
                                   Collection* collection,
                                   WorkingSetID* out) = 0;
 
+    /**
+     * Destroys the intervals searched so far and their covering stages. May only be called from
+     * nextInterval(), when every interval handed out before is exhausted. Subclasses which hand
+     * out many small intervals call this to keep their memory bounded; explain then reports
+     * only the coverings of the intervals which are still alive.
+     */
+    void releaseSearchedIntervals();
+
     // Filled in by subclasses.
     NearStats _specificStats;
 
@@ -0,0 +1,392 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/parallel_collection_scan.h"
+
+#include "mongo/base/init.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/expression_leaf.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/storage/record_fetcher.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/exit.h"
+#include "mongo/util/log.h"
+
+namespace mongo {
+
+using std::unique_ptr;
+using stdx::make_unique;
+
+// static
+const char* ParallelCollectionScan::kStageType = "PARALLEL_COLLSCAN";
+
+namespace {
+
+/**
+ * The workers shared by every parallel collection scan in the process. The pool is created once
+ * the startup options are stored, and is never deleted: after it is shut down, schedule() fails
+ * and partitions are filtered on the query thread.
+ */
+ThreadPool* filterPool = nullptr;
+
+MONGO_INITIALIZER(ParallelCollectionScanFilterPool)(InitializerContext*) {
+    ThreadPool::Options options;
+    options.poolName = "ParallelCollectionScan";
+    options.minThreads = 0;
+    options.maxThreads = static_cast<size_t>(std::max(1, internalQueryExecCollScanMaxParallelism));
+    filterPool = new ThreadPool(options);
+    filterPool->startup();
+
+    registerShutdownTask([] {
+        filterPool->shutdown();
+        filterPool->join();
+    });
+    return Status::OK();
+}
+
+/**
+ * Only expressions which read nothing but the document being matched may be evaluated on a worker.
+ * That rules out $where and $expr, which share state with the rest of the query, $text and the geo
+ * expressions, and regular expressions, whose matching we do not rely on being reentrant.
+ */
+bool isSafeToEvaluateConcurrently(const MatchExpression* expr) {
+    switch (expr->matchType()) {
+        case MatchExpression::AND:
+        case MatchExpression::OR:
+        case MatchExpression::NOT:
+        case MatchExpression::NOR:
+        case MatchExpression::ELEM_MATCH_OBJECT:
+        case MatchExpression::ELEM_MATCH_VALUE:
+        case MatchExpression::SIZE:
+        case MatchExpression::EQ:
+        case MatchExpression::LTE:
+        case MatchExpression::LT:
+        case MatchExpression::GT:
+        case MatchExpression::GTE:
+        case MatchExpression::MOD:
+        case MatchExpression::EXISTS:
+        case MatchExpression::BITS_ALL_SET:
+        case MatchExpression::BITS_ALL_CLEAR:
+        case MatchExpression::BITS_ANY_SET:
+        case MatchExpression::BITS_ANY_CLEAR:
+        case MatchExpression::TYPE_OPERATOR:
+        case MatchExpression::ALWAYS_FALSE:
+        case MatchExpression::ALWAYS_TRUE:
+            break;
+        case MatchExpression::MATCH_IN:
+            if (!static_cast<const InMatchExpression*>(expr)->getRegexes().empty()) {
+                return false;
+            }
+            break;
+        default:
+            return false;
+    }
+    for (size_t i = 0; i < expr->numChildren(); ++i) {
+        if (!isSafeToEvaluateConcurrently(expr->getChild(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+ParallelCollectionScan::ParallelCollectionScan(OperationContext* opCtx,
+                                               const CollectionScanParams& params,
+                                               size_t parallelism,
+                                               WorkingSet* workingSet,
+                                               const MatchExpression* filter)
+    : PlanStage(kStageType, opCtx),
+      _workingSet(workingSet),
+      _filter(filter),
+      _params(params),
+      _parallelism(parallelism),
+      _partitionSize(
+          static_cast<size_t>(std::max(1, internalQueryExecCollScanPartitionSize.load()))),
+      _wsidForFetch(_workingSet->allocate()) {
+    invariant(canRunInParallel(params, filter, nullptr));
+    invariant(_parallelism > 1U);
+    _specificStats.direction = params.direction;
+    _specificStats.parallelism = _parallelism;
+}
+
+ParallelCollectionScan::~ParallelCollectionScan() {
+    stdx::unique_lock<stdx::mutex> lk(_mutex);
+    for (auto&& partition : _inFlight) {
+        _partitionDone.wait(lk, [&partition] { return partition->done; });
+    }
+}
+
+// static
+bool ParallelCollectionScan::canRunInParallel(const CollectionScanParams& params,
+                                              const MatchExpression* filter,
+                                              const CollatorInterface* collator) {
+    if (!params.collection || !filter || collator || !isSafeToEvaluateConcurrently(filter)) {
+        return false;
+    }
+    return !params.tailable && params.start.isNull() && !params.maxTs &&
+        !params.shouldTrackLatestOplogTimestamp && !params.stopApplyingFilterAfterFirstMatch &&
+        0 == params.maxScan && !params.collection->ns().isOplog();
+}
+
+PlanStage::StageState ParallelCollectionScan::doWork(WorkingSetID* out) {
+    if (_isDead) {
+        Status status(ErrorCodes::CappedPositionLost,
+                      "ParallelCollectionScan died due to position in capped collection being "
+                      "deleted.");
+        *out = WorkingSetCommon::allocateStatusMember(_workingSet, status);
+        return PlanStage::DEAD;
+    }
+
+    if (_commonStats.isEOF) {
+        return PlanStage::IS_EOF;
+    }
+
+    // Results come from the oldest partition. While it is still being filtered we would rather
+    // read ahead than wait, as long as fewer than '_parallelism' partitions are in flight.
+    if (!_inFlight.empty()) {
+        Partition* front = _inFlight.front().get();
+        bool mustWait = _cursorExhausted || _inFlight.size() >= _parallelism;
+        {
+            stdx::unique_lock<stdx::mutex> lk(_mutex);
+            if (mustWait) {
+                _partitionDone.wait(lk, [front] { return front->done; });
+            } else {
+                mustWait = front->done;
+            }
+        }
+
+        if (mustWait) {
+            if (!front->status.isOK()) {
+                *out = WorkingSetCommon::allocateStatusMember(_workingSet, front->status);
+                return PlanStage::FAILURE;
+            }
+
+            while (front->next < front->size()) {
+                const size_t i = front->next++;
+                if (!front->matches[i]) {
+                    continue;
+                }
+
+                WorkingSetID id = _workingSet->allocate();
+                WorkingSetMember* member = _workingSet->get(id);
+                member->obj = Snapshotted<BSONObj>(front->snapshotIds[i], front->doc(i).getOwned());
+                if (front->ids[i].isNull()) {
+                    _workingSet->transitionToOwnedObj(id);
+                } else {
+                    member->recordId = front->ids[i];
+                    _workingSet->transitionToRecordIdAndObj(id);
+                }
+                *out = id;
+                return PlanStage::ADVANCED;
+            }
+
+            _inFlight.pop_front();
+            return PlanStage::NEED_TIME;
+        }
+    }
+
+    if (_cursorExhausted) {
+        invariant(_inFlight.empty());
+        _commonStats.isEOF = true;
+        return PlanStage::IS_EOF;
+    }
+
+    return fillPartition(out);
+}
+
+PlanStage::StageState ParallelCollectionScan::fillPartition(WorkingSetID* out) {
+    try {
+        if (!_cursor) {
+            _cursor = _params.collection->getCursor(
+                getOpCtx(), _params.direction == CollectionScanParams::FORWARD);
+            return PlanStage::NEED_TIME;
+        }
+
+        if (!_filling) {
+            _filling = std::make_shared<Partition>();
+            _filling->offsets.reserve(_partitionSize);
+            _filling->snapshotIds.reserve(_partitionSize);
+            _filling->ids.reserve(_partitionSize);
+        }
+
+        while (_filling->size() < _partitionSize) {
+            // See if the record we're about to access is in memory. If not, pass a fetch request
+            // up. The records read so far stay in '_filling'.
+            if (auto fetcher = _cursor->fetcherForNext()) {
+                WorkingSetMember* member = _workingSet->get(_wsidForFetch);
+                member->setFetcher(fetcher.release());
+                *out = _wsidForFetch;
+                return PlanStage::NEED_YIELD;
+            }
+
+            auto record = _cursor->next();
+            if (!record) {
+                _cursorExhausted = true;
+                break;
+            }
+
+            // The bytes must be copied, since the cursor will move on before a worker reads them.
+            auto& buffer = _filling->buffer;
+            _filling->offsets.push_back(buffer.size());
+            buffer.insert(
+                buffer.end(), record->data.data(), record->data.data() + record->data.size());
+            _filling->snapshotIds.push_back(getOpCtx()->recoveryUnit()->getSnapshotId());
+            _filling->ids.push_back(record->id);
+        }
+    } catch (const WriteConflictException&) {
+        *out = WorkingSet::INVALID_ID;
+        return PlanStage::NEED_YIELD;
+    }
+
+    if (0U == _filling->size()) {
+        _filling.reset();
+    } else {
+        schedulePartition();
+    }
+    return PlanStage::NEED_TIME;
+}
+
+void ParallelCollectionScan::schedulePartition() {
+    std::shared_ptr<Partition> partition = std::move(_filling);
+    partition->matches.resize(partition->size());
+    _specificStats.docsTested += partition->size();
+    ++_specificStats.partitions;
+    _inFlight.push_back(partition);
+
+    const MatchExpression* filter = _filter;
+    Status status = filterPool->schedule(
+        [this, filter, partition] { filterPartition(filter, partition.get()); });
+    if (!status.isOK()) {
+        LOG(1) << "Filtering a collection scan partition on the query thread: " << status;
+        filterPartition(filter, partition.get());
+    }
+}
+
+void ParallelCollectionScan::filterPartition(const MatchExpression* filter,
+                                             Partition* partition) {
+    Status status = Status::OK();
+    try {
+        for (size_t i = 0; i < partition->size(); ++i) {
+            partition->matches[i] = filter->matchesBSON(partition->doc(i));
+        }
+    } catch (const DBException& ex) {
+        status = ex.toStatus();
+    }
+
+    // Notify while holding the lock: once 'done' is visible the stage may be destroyed.
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    partition->status = std::move(status);
+    partition->done = true;
+    _partitionDone.notify_all();
+}
+
+bool ParallelCollectionScan::isEOF() {
+    return _commonStats.isEOF || _isDead;
+}
+
+void ParallelCollectionScan::doInvalidate(OperationContext* opCtx,
+                                          const RecordId& id,
+                                          InvalidationType type) {
+    // Like CollectionScan, we don't care about mutations: we hold a copy of the document and the
+    // filter has been, or will be, applied to that copy.
+    if (INVALIDATION_DELETION != type) {
+        return;
+    }
+
+    if (_cursor) {
+        _cursor->invalidate(opCtx, id);
+    }
+
+    // A deleted record we have already copied is returned without its RecordId.
+    auto forget = [&id](Partition* partition, size_t start) {
+        for (size_t i = start; i < partition->ids.size(); ++i) {
+            if (partition->ids[i] == id) {
+                partition->ids[i] = RecordId();
+                return;
+            }
+        }
+    };
+    if (_filling) {
+        forget(_filling.get(), 0);
+    }
+    for (auto&& partition : _inFlight) {
+        forget(partition.get(), partition->next);
+    }
+}
+
+void ParallelCollectionScan::doSaveState() {
+    if (_cursor) {
+        _cursor->save();
+    }
+}
+
+void ParallelCollectionScan::doRestoreState() {
+    if (_cursor) {
+        if (!_cursor->restore()) {
+            _isDead = true;
+        }
+    }
+}
+
+void ParallelCollectionScan::doDetachFromOperationContext() {
+    if (_cursor)
+        _cursor->detachFromOperationContext();
+}
+
+void ParallelCollectionScan::doReattachToOperationContext() {
+    if (_cursor)
+        _cursor->reattachToOperationContext(getOpCtx());
+}
+
+unique_ptr<PlanStageStats> ParallelCollectionScan::getStats() {
+    BSONObjBuilder bob;
+    _filter->serialize(&bob);
+    _commonStats.filter = bob.obj();
+
+    unique_ptr<PlanStageStats> ret =
+        make_unique<PlanStageStats>(_commonStats, STAGE_PARALLEL_COLLSCAN);
+    ret->specific = make_unique<CollectionScanStats>(_specificStats);
+    return ret;
+}
+
+const SpecificStats* ParallelCollectionScan::getSpecificStats() const {
+    return &_specificStats;
+}
+
+}  // namespace mongo
@@ -0,0 +1,188 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/exec/collection_scan_common.h"
+#include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/record_id.h"
+#include "mongo/db/storage/snapshot.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+
+namespace mongo {
+
+class CollatorInterface;
+class MatchExpression;
+class SeekableRecordCursor;
+class WorkingSet;
+
+/**
+ * A collection scan which evaluates its filter on a pool of worker threads.
+ *
+ * The record cursor belongs to the operation's recovery unit, so records are still read in order
+ * on the query thread. Their bytes are copied into partitions, each covering a contiguous range of
+ * RecordIds, and each partition is handed to a worker to be filtered while the query thread reads
+ * the next one. Up to 'parallelism' partitions are in flight at once. Only the documents which
+ * match are copied out of a partition, and they are returned in the order of the scan.
+ *
+ * The planner only offers this stage for read-only plans, and canRunInParallel() only accepts
+ * filters whose evaluation touches nothing but the document being matched. The workers come from
+ * a single pool, sized by internalQueryExecCollScanMaxParallelism at startup and joined when the
+ * server shuts down.
+ */
+class ParallelCollectionScan final : public PlanStage {
+public:
+    ParallelCollectionScan(OperationContext* opCtx,
+                           const CollectionScanParams& params,
+                           size_t parallelism,
+                           WorkingSet* workingSet,
+                           const MatchExpression* filter);
+
+    /**
+     * Waits for any partitions still being filtered, since the workers refer to the filter.
+     */
+    ~ParallelCollectionScan();
+
+    /**
+     * Returns true if a collection scan with 'params' and 'filter' may be replaced by this stage:
+     * there must be a filter, made only of comparisons, type checks and logical operators over
+     * them, which does not use a collator, and the scan must not be tailable, bounded by
+     * 'maxScan', or reading the oplog.
+     */
+    static bool canRunInParallel(const CollectionScanParams& params,
+                                 const MatchExpression* filter,
+                                 const CollatorInterface* collator);
+
+    StageState doWork(WorkingSetID* out) final;
+    bool isEOF() final;
+
+    void doInvalidate(OperationContext* opCtx, const RecordId& dl, InvalidationType type) final;
+    void doSaveState() final;
+    void doRestoreState() final;
+    void doDetachFromOperationContext() final;
+    void doReattachToOperationContext() final;
+
+    StageType stageType() const final {
+        return STAGE_PARALLEL_COLLSCAN;
+    }
+
+    std::unique_ptr<PlanStageStats> getStats() final;
+
+    const SpecificStats* getSpecificStats() const final;
+
+    static const char* kStageType;
+
+private:
+    /**
+     * A run of consecutive records copied out of the record store. A worker fills in 'matches',
+     * then sets 'status' and 'done' under '_mutex'. Nothing else about a partition is touched off
+     * the query thread.
+     */
+    struct Partition {
+        size_t size() const {
+            return offsets.size();
+        }
+
+        BSONObj doc(size_t i) const {
+            return BSONObj(buffer.data() + offsets[i]);
+        }
+
+        // The bytes of every record, back to back. Only the matching ones are copied again.
+        std::vector<char> buffer;
+        std::vector<size_t> offsets;
+        std::vector<SnapshotId> snapshotIds;
+
+        // A null RecordId means the record was deleted after we copied it.
+        std::vector<RecordId> ids;
+
+        std::vector<char> matches;
+        Status status = Status::OK();
+        bool done = false;
+
+        // Index of the next record to consider returning.
+        size_t next = 0;
+    };
+
+    /**
+     * Reads up to a partition's worth of records from the cursor into '_filling', and schedules
+     * it once it is full or the cursor is exhausted.
+     */
+    StageState fillPartition(WorkingSetID* out);
+
+    /**
+     * Schedules '_filling' to be filtered, or filters it inline if the pool refuses the task.
+     */
+    void schedulePartition();
+
+    /**
+     * Evaluates 'filter' against every document of 'partition', then marks it done.
+     */
+    void filterPartition(const MatchExpression* filter, Partition* partition);
+
+    // Not owned by us.
+    WorkingSet* _workingSet;
+
+    // Not owned by us. Must outlive any scheduled partition.
+    const MatchExpression* _filter;
+
+    const CollectionScanParams _params;
+
+    const size_t _parallelism;
+
+    const size_t _partitionSize;
+
+    std::unique_ptr<SeekableRecordCursor> _cursor;
+
+    bool _cursorExhausted = false;
+
+    bool _isDead = false;
+
+    // The partition being read from the cursor, if any.
+    std::shared_ptr<Partition> _filling;
+
+    // Scheduled partitions, in scan order.
+    std::deque<std::shared_ptr<Partition>> _inFlight;
+
+    // Protects the 'matches', 'status' and 'done' members of scheduled partitions.
+    stdx::mutex _mutex;
+    stdx::condition_variable _partitionDone;
+
+    // We allocate a working set member with this id on construction of the stage. It gets used for
+    // all fetch requests.
+    const WorkingSetID _wsidForFetch;
+
+    CollectionScanStats _specificStats;
+};
+
+}  // namespace mongo
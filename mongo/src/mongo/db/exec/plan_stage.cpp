@@ -122,6 +122,42 @@ PlanStage::StageState PlanStage::work(WorkingSetID* out) {   //
     return workResult;
 }
 
+PlanStage::StageState PlanStage::workBatch(size_t maxWorks,
+                                           std::vector<WorkingSetID>* batch,
+                                           WorkingSetID* out) {
+    invariant(_opCtx);
+    invariant(maxWorks > 0U);
+    ScopedTimer timer(getClock(), &_commonStats.executionTimeMillis);
+    ++_commonStats.batches;
+
+    const size_t batchStart = batch->size();
+    const StageState state = doWorkBatch(maxWorks, batch, out);
+    _commonStats.batchedResults += batch->size() - batchStart;
+    return state;
+}
+
+PlanStage::StageState PlanStage::doWorkBatch(size_t maxWorks,
+                                             std::vector<WorkingSetID>* batch,
+                                             WorkingSetID* out) {
+    for (size_t i = 0; i < maxWorks; ++i) {
+        ++_commonStats.works;
+        const StageState state = doWork(out);
+        if (ADVANCED == state) {
+            ++_commonStats.advanced;
+            batch->push_back(*out);
+            return ADVANCED;
+        } else if (NEED_TIME == state) {
+            ++_commonStats.needTime;
+        } else {
+            if (NEED_YIELD == state) {
+                ++_commonStats.needYield;
+            }
+            return state;
+        }
+    }
+    return NEED_TIME;
+}
+
 void PlanStage::saveState() {
     ++_commonStats.yields;
     for (auto&& child : _children) {
@@ -189,6 +189,21 @@ public:
      */
     StageState work(WorkingSetID* out);
 
+    /**
+     * Performs up to 'maxWorks' units of work in a single call, appending the WorkingSetID of
+     * every result produced to 'batch'. This amortizes the per-call overhead of work() when the
+     * caller wants many results at once; the stage's stats are maintained as if work() had been
+     * called once per unit of work.
+     *
+     * Returns ADVANCED if the budget was used up after producing results, and NEED_TIME if it was
+     * used up without producing any. Otherwise returns the first state other than ADVANCED or
+     * NEED_TIME, setting '*out' as work() would; any results appended to 'batch' before that state
+     * was reached are still valid and owned by the caller.
+     *
+     * Stages that do not override doWorkBatch() return after their first result.
+     */
+    StageState workBatch(size_t maxWorks, std::vector<WorkingSetID>* batch, WorkingSetID* out);
+
     /**
      * Returns true if no more work can be done on the query / out of results.
      */
@@ -348,6 +363,48 @@ protected:
      */ //Ӧ//IndexScan::doWork()  CollectionScan::doWork(ȫɨ)  
     virtual StageState doWork(WorkingSetID* out) = 0;
 
+    /**
+     * Performs a batch of work.  See comment at workBatch() above.
+     *
+     * The default implementation performs units of work until the first result, since only the
+     * stage itself knows whether a result stays valid while it does further work.
+     */
+    virtual StageState doWorkBatch(size_t maxWorks,
+                                   std::vector<WorkingSetID>* batch,
+                                   WorkingSetID* out);
+
+    /**
+     * Helper for implementing doWorkBatch() in stages whose results may be buffered: performs up
+     * to 'maxWorks' units of work by calling 'workOne', which must behave like doWork(). Each
+     * result's document is made owned before the next unit of work so that it survives cursor
+     * advances.
+     */
+    template <typename WorkOne>
+    StageState workEachInBatch(WorkingSet* ws,
+                               size_t maxWorks,
+                               std::vector<WorkingSetID>* batch,
+                               WorkingSetID* out,
+                               const WorkOne& workOne) {
+        const size_t batchStart = batch->size();
+        for (size_t i = 0; i < maxWorks; ++i) {
+            ++_commonStats.works;
+            const StageState state = workOne(out);
+            if (ADVANCED == state) {
+                ++_commonStats.advanced;
+                ws->get(*out)->makeObjOwnedIfNeeded();
+                batch->push_back(*out);
+            } else if (NEED_TIME == state) {
+                ++_commonStats.needTime;
+            } else {
+                if (NEED_YIELD == state) {
+                    ++_commonStats.needYield;
+                }
+                return state;
+            }
+        }
+        return batch->size() > batchStart ? ADVANCED : NEED_TIME;
+    }
+
     /**
      * Saves any stage-specific state required to resume where it was if the underlying data
      * changes.
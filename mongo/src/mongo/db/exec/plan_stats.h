@@ -142,6 +142,8 @@ struct CommonStats { //
           advanced(0),
           needTime(0),
           needYield(0),
+          batches(0),
+          batchedResults(0),
           executionTimeMillis(0),
           isEOF(false) {}
     // String giving the type of the stage. Not owned.
@@ -161,6 +163,13 @@ struct CommonStats { //
     size_t needTime;//ֵPlanStage::work
     size_t needYield; //ֵPlanStage::work
 
+    // Number of calls to workBatch(). Zero unless the stage ran in batch mode.
+    size_t batches;
+
+    // Number of results returned through workBatch(). Unlike 'advanced', this leaves out the
+    // results returned by plain calls to work().
+    size_t batchedResults;
+
     // BSON representation of a MatchExpression affixed to this node. If there
     // is no filter affixed, then 'filter' should be an empty BSONObj.
     BSONObj filter;
@@ -231,7 +240,12 @@ private:
 };
 
 struct AndHashStats : public SpecificStats {
-    AndHashStats() : flaggedButPassed(0), flaggedInProgress(0), memUsage(0), memLimit(0) {}
+    AndHashStats()
+        : flaggedButPassed(0),
+          flaggedInProgress(0),
+          memUsage(0),
+          memLimit(0),
+          recordIdsOnly(false) {}
 
     SpecificStats* clone() const final {
         AndHashStats* specific = new AndHashStats(*this);
@@ -258,6 +272,9 @@ struct AndHashStats : public SpecificStats {
 
     // What's our memory limit?
     size_t memLimit;
+
+    // Did we intersect bare RecordIds rather than WorkingSetMembers?
+    bool recordIdsOnly;
 };
 
 
@@ -307,6 +324,11 @@ struct CollectionScanStats : public SpecificStats {
     // sees a document that does not pass the filter and has a "ts" Timestamp field greater than
     // 'maxTs'.
     boost::optional<Timestamp> maxTs;
+
+    // The following are only set by ParallelCollectionScan: how many partitions it may have in
+    // flight at once, and how many it filtered.
+    size_t parallelism = 1;
+    size_t partitions = 0;
 };
 
 struct CountStats : public SpecificStats {
@@ -343,6 +365,7 @@ struct CountScanStats : public SpecificStats {
         specific->collation = collation.getOwned();
         specific->startKey = startKey.getOwned();
         specific->endKey = endKey.getOwned();
+        specific->indexBounds = indexBounds.getOwned();
         return specific;
     }
 
@@ -363,6 +386,9 @@ struct CountScanStats : public SpecificStats {
     bool startKeyInclusive;
     bool endKeyInclusive;
 
+    // Set instead of the keys above when the scan is over arbitrary index bounds.
+    BSONObj indexBounds;
+
     int indexVersion;
 
     // Set to true if the index used for the count scan is multikey.
@@ -464,6 +490,13 @@ struct FetchStats : public SpecificStats {
     // The total number of full documents touched by the fetch stage.
     //size_t docsExamined; FetchStage::returnIfMatches     keysExaminedIndexScan::doWork
     size_t docsExamined; //FetchStage::returnIfMatches
+
+    // The most RecordIds read from the child before fetching any of them, or zero if records
+    // are fetched one at a time.
+    size_t windowSize = 0;
+
+    // The number of windows fetched in RecordId order.
+    size_t windows = 0;
 };
 
 struct GroupStats : public SpecificStats {
@@ -590,6 +623,16 @@ struct MultiPlanStats : public SpecificStats {
     SpecificStats* clone() const final {
         return new MultiPlanStats(*this);
     }
+
+    // How many times work() was called on candidate plans during the trial period.
+    size_t trialWorks = 0;
+
+    // How many successive-halving rounds the trial period ran. Zero if every candidate was
+    // worked for the whole trial period.
+    size_t trialRounds = 0;
+
+    // How many candidates successive halving dropped before the end of the trial period.
+    size_t candidatesEliminated = 0;
 };
 
 struct OrStats : public SpecificStats {
@@ -620,7 +663,13 @@ struct ProjectionStats : public SpecificStats {
 };
 
 struct SortStats : public SpecificStats {
-    SortStats() : forcedFetches(0), memUsage(0), memLimit(0) {}
+    SortStats()
+        : forcedFetches(0),
+          memUsage(0),
+          memLimit(0),
+          usedDisk(false),
+          spills(0),
+          normalizedKeys(false) {}
 
     SpecificStats* clone() const final {
         SortStats* specific = new SortStats(*this);
@@ -636,6 +685,15 @@ struct SortStats : public SpecificStats {
     // What's our memory limit?
     size_t memLimit;
 
+    // Did the sort exceed 'memLimit' and hand its data over to an external sorter?
+    bool usedDisk;
+
+    // How many sorted runs the external sorter wrote to disk.
+    size_t spills;
+
+    // Were sort keys compared as KeyString-encoded bytes?
+    bool normalizedKeys;
+
     // The number of results to return from the sort.
     size_t limit;
 
@@ -709,6 +767,11 @@ struct NearStats : public SpecificStats {
     // btree index version, not geo index version
     int indexVersion;
     BSONObj keyPattern;
+
+    // Best-first 2dsphere search only: cells taken off the candidate queue, and cells whose index
+    // keys were scanned.
+    size_t cellsVisited = 0;
+    size_t cellsScanned = 0;
 };
 
 struct UpdateStats : public SpecificStats {
@@ -789,6 +852,9 @@ struct TextOrStats : public SpecificStats {
     }
 
     size_t fetches;
+
+    // Nonzero if only this many of the highest scoring documents were wanted.
+    size_t topK = 0;
 };
 
 }  // namespace mongo
@@ -189,12 +189,12 @@ Status ProjectionStage::transform(WorkingSetMember* member) {
 }
 
 bool ProjectionStage::isEOF() {
-    return child()->isEOF();
+    return !_childResults.hasBuffered() && child()->isEOF();
 }
 
 PlanStage::StageState ProjectionStage::doWork(WorkingSetID* out) {
     WorkingSetID id = WorkingSet::INVALID_ID;
-    StageState status = child()->work(&id);
+    StageState status = _childResults.next(child().get(), &id);
 
     // Note that we don't do the normal if isEOF() return EOF thing here.  Our child might be a
     // tailable cursor and isEOF() would be true even if it had more data...
@@ -227,6 +227,31 @@ PlanStage::StageState ProjectionStage::doWork(WorkingSetID* out) {
     return status;
 }
 
+PlanStage::StageState ProjectionStage::doWorkBatch(size_t maxWorks,
+                                                   std::vector<WorkingSetID>* batch,
+                                                   WorkingSetID* out) {
+    _childResults.startBatch(maxWorks);
+    const StageState state = workEachInBatch(_ws, maxWorks, batch, out, [this](WorkingSetID* id) {
+        return ProjectionStage::doWork(id);
+    });
+    _childResults.endBatch();
+    return state;
+}
+
+void ProjectionStage::doInvalidate(OperationContext* opCtx,
+                                   const RecordId& dl,
+                                   InvalidationType type) {
+    // Our child no longer knows about the results we have buffered, so keep them valid here.
+    for (auto id : _childResults.buffered()) {
+        WorkingSetMember* member = _ws->get(id);
+        if (member->hasRecordId() && member->hasObj() && member->recordId == dl) {
+            member->obj.setValue(member->obj.value().getOwned());
+            member->recordId = RecordId();
+            member->transitionToOwnedObj();
+        }
+    }
+}
+
 unique_ptr<PlanStageStats> ProjectionStage::getStats() {
     _commonStats.isEOF = isEOF();
     unique_ptr<PlanStageStats> ret = make_unique<PlanStageStats>(_commonStats, STAGE_PROJECTION);
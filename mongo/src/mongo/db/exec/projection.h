@@ -29,6 +29,7 @@
 #pragma once
 
 
+#include "mongo/db/exec/batched_child_results.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/projection_exec.h"
 #include "mongo/db/jsobj.h"
@@ -84,6 +85,10 @@ public:
 
     bool isEOF() final;
     StageState doWork(WorkingSetID* out) final;
+    StageState doWorkBatch(size_t maxWorks,
+                           std::vector<WorkingSetID>* batch,
+                           WorkingSetID* out) final;
+    void doInvalidate(OperationContext* opCtx, const RecordId& dl, InvalidationType type) final;
 
     StageType stageType() const final {
         return STAGE_PROJECTION;
@@ -122,6 +127,9 @@ private:
     // _ws is not owned by us.
     WorkingSet* _ws;
 
+    // Results of the child not yet projected, when working in batch mode.
+    BatchedChildResults _childResults;
+
     // Stats
     ProjectionStats _specificStats;
 
@@ -181,6 +181,8 @@ ProjectionExec::ProjectionExec(OperationContext* opCtx,
             _arrayOpType = ARRAY_OP_POSITIONAL;
         }
     }
+
+    compile(true);
 }
 
 ProjectionExec::~ProjectionExec() {
@@ -234,6 +236,53 @@ void ProjectionExec::add(const string& field, int skip, int limit) {
     }
 }
 
+void ProjectionExec::compile(bool topLevel) {
+    if (topLevel) {
+        _plan["_id"].isId = true;
+    }
+
+    for (MetaMap::const_iterator it = _meta.begin(); it != _meta.end(); ++it) {
+        _plan[it->first].isMeta = true;
+        _metaList.emplace_back(it->first, it->second);
+    }
+
+    for (FieldMap::const_iterator it = _fields.begin(); it != _fields.end(); ++it) {
+        _plan[it->first].sub = it->second;
+        it->second->compile(false);
+    }
+
+    for (Matchers::const_iterator it = _matchers.begin(); it != _matchers.end(); ++it) {
+        _plan[it->first].matcher = it->second;
+    }
+
+    if (!topLevel) {
+        return;
+    }
+
+    for (auto&& specElt : _source) {
+        if (mongoutils::str::equals("_id", specElt.fieldName())) {
+            continue;
+        }
+
+        // $meta sortKey is the only meta-projection which is allowed to operate on index keys
+        // rather than the full document.
+        auto metaIt = _meta.find(specElt.fieldName());
+        if (metaIt != _meta.end()) {
+            _coverable = _coverable && metaIt->second == META_SORT_KEY;
+            continue;
+        }
+
+        // $meta sortKey is also the only element with an Object value in the projection spec
+        // that can operate on index keys rather than the full document.
+        if (BSONType::Object == specElt.type()) {
+            _coverable = false;
+            continue;
+        }
+
+        _coveredPaths.emplace_back(new CoveredPath(specElt.fieldNameStringData()));
+    }
+}
+
 //
 // Execution
 //
@@ -264,7 +313,11 @@ Status ProjectionExec::transform(WorkingSetMember* member) const {
         return Status::OK();
     }
 
-    BSONObjBuilder bob;
+    // Unless it includes specific fields, the output is at most the input document plus any $meta
+    // fields, so reserve that much space once instead of letting the builder grow repeatedly.
+    const int kMetaSpaceHint = 64;
+    BSONObjBuilder bob(member->hasObj() && _include ? member->obj.value().objsize() + kMetaSpaceHint
+                                                    : 512);
     if (member->hasObj()) {
         MatchDetails matchDetails;
 
@@ -281,6 +334,7 @@ Status ProjectionExec::transform(WorkingSetMember* member) const {
         }
     } else {
         invariant(!_include);
+        invariant(_coverable);
         // Go field by field.
         if (_includeID) {
             BSONElement elt;
@@ -292,29 +346,12 @@ Status ProjectionExec::transform(WorkingSetMember* member) const {
 
         mmb::Document projectedDoc;
 
-        for (auto&& specElt : _source) {
-            if (mongoutils::str::equals("_id", specElt.fieldName())) {
-                continue;
-            }
-
-            // $meta sortKey is the only meta-projection which is allowed to operate on index keys
-            // rather than the full document.
-            auto metaIt = _meta.find(specElt.fieldName());
-            if (metaIt != _meta.end()) {
-                invariant(metaIt->second == META_SORT_KEY);
-                continue;
-            }
-
-            // $meta sortKey is also the only element with an Object value in the projection spec
-            // that can operate on index keys rather than the full document.
-            invariant(BSONType::Object != specElt.type());
-
+        for (auto&& coveredPath : _coveredPaths) {
             BSONElement keyElt;
             // We can project a field that doesn't exist.  We just ignore it.
-            if (member->getFieldDotted(specElt.fieldName(), &keyElt) && !keyElt.eoo()) {
-                FieldRef projectedFieldPath{specElt.fieldNameStringData()};
+            if (member->getFieldDotted(coveredPath->path, &keyElt) && !keyElt.eoo()) {
                 auto setElementStatus =
-                    pathsupport::setElementAtPath(projectedFieldPath, keyElt, &projectedDoc);
+                    pathsupport::setElementAtPath(coveredPath->fieldRef, keyElt, &projectedDoc);
                 if (!setElementStatus.isOK()) {
                     return setElementStatus;
                 }
@@ -324,7 +361,7 @@ Status ProjectionExec::transform(WorkingSetMember* member) const {
         bob.appendElements(projectedDoc.getObject());
     }
 
-    for (MetaMap::const_iterator it = _meta.begin(); it != _meta.end(); ++it) {
+    for (auto it = _metaList.begin(); it != _metaList.end(); ++it) {
         if (META_GEONEAR_DIST == it->second) {
             if (member->hasComputed(WSM_COMPUTED_GEO_DISTANCE)) {
                 const GeoDistanceComputedData* dist = static_cast<const GeoDistanceComputedData*>(
@@ -385,8 +422,10 @@ Status ProjectionExec::transform(const BSONObj& in,
     while (it.more()) {
         BSONElement elt = it.next();
 
+        const FieldPlan* plan = findPlan(elt.fieldNameStringData());
+
         // Case 1: _id
-        if (mongoutils::str::equals("_id", elt.fieldName())) {
+        if (plan && plan->isId) {
             if (_includeID) {
                 bob->append(elt);
             }
@@ -394,9 +433,8 @@ Status ProjectionExec::transform(const BSONObj& in,
         }
 
         // Case 2: no array projection for this field.
-        Matchers::const_iterator matcher = _matchers.find(elt.fieldName());
-        if (_matchers.end() == matcher) {
-            Status s = append(bob, elt, details, arrayOpType);
+        if (!plan || !plan->matcher) {
+            Status s = appendField(bob, elt, plan, details, arrayOpType);
             if (!s.isOK()) {
                 return s;
             }
@@ -411,9 +449,8 @@ Status ProjectionExec::transform(const BSONObj& in,
         MatchDetails arrayDetails;
         arrayDetails.requestElemMatchKey();
 
-        if (matcher->second->matchesBSON(in, &arrayDetails)) {
-            FieldMap::const_iterator fieldIt = _fields.find(elt.fieldName());
-            if (_fields.end() == fieldIt) {
+        if (plan->matcher->matchesBSON(in, &arrayDetails)) {
+            if (!plan->sub) {
                 return Status(ErrorCodes::BadValue,
                               "$elemMatch specified, but projection field not found.");
             }
@@ -433,8 +470,9 @@ Status ProjectionExec::transform(const BSONObj& in,
 
             arrBuilder.append(
                 in.getField(elt.fieldName()).Obj().getField(arrayDetails.elemMatchKey()));
-            subBob.appendArray(matcher->first, arrBuilder.arr());
-            Status status = append(bob, subBob.done().firstElement(), details, arrayOpType);
+            subBob.appendArray(elt.fieldNameStringData(), arrBuilder.arr());
+            Status status =
+                appendField(bob, subBob.done().firstElement(), plan, details, arrayOpType);
             if (!status.isOK()) {
                 return status;
             }
@@ -494,22 +532,29 @@ Status ProjectionExec::append(BSONObjBuilder* bob,
                               const BSONElement& elt,
                               const MatchDetails* details,
                               const ArrayOpType arrayOpType) const {
+    return appendField(bob, elt, findPlan(elt.fieldNameStringData()), details, arrayOpType);
+}
+
+Status ProjectionExec::appendField(BSONObjBuilder* bob,
+                                   const BSONElement& elt,
+                                   const FieldPlan* plan,
+                                   const MatchDetails* details,
+                                   const ArrayOpType arrayOpType) const {
     // Skip if the field name matches a computed $meta field.
     // $meta projection fields can exist at the top level of
     // the result document and the field names cannot be dotted.
-    if (_meta.find(elt.fieldName()) != _meta.end()) {
+    if (plan && plan->isMeta) {
         return Status::OK();
     }
 
-    FieldMap::const_iterator field = _fields.find(elt.fieldName());
-    if (field == _fields.end()) {
+    if (!plan || !plan->sub) {
         if (_include) {
             bob->append(elt);
         }
         return Status::OK();
     }
 
-    ProjectionExec& subfm = *field->second;
+    const ProjectionExec& subfm = *plan->sub;
     if ((subfm._fields.empty() && !subfm._special) ||
         !(elt.type() == Object || elt.type() == Array)) {
         // field map empty, or element is not an array/object
@@ -28,7 +28,13 @@
 
 #pragma once
 
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "mongo/db/exec/working_set.h"
+#include "mongo/db/field_ref.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression.h"
 #include "mongo/db/matcher/expression_parser.h"
@@ -66,6 +72,25 @@ public:
     typedef StringMap<MatchExpression*> Matchers;
     typedef StringMap<MetaProjection> MetaMap;
 
+    /**
+     * Everything a level of the projection needs to know about a field name, gathered from the
+     * maps above by compile() so that each input field costs a single lookup.
+     */
+    struct FieldPlan {
+        // True for the top-level _id field, which is governed by '_includeID'.
+        bool isId = false;
+
+        // True if the field is the target of a $meta projection. Its input value is dropped.
+        bool isMeta = false;
+
+        // The sub-projection for this field, if any. Owned by '_fields'.
+        const ProjectionExec* sub = nullptr;
+
+        // The $elemMatch matcher for this field, if any. Owned by '_matchers'.
+        const MatchExpression* matcher = nullptr;
+    };
+    typedef StringMap<FieldPlan> FieldPlanMap;
+
     ProjectionExec(OperationContext* opCtx,
                    const BSONObj& spec,
                    const MatchExpression* queryExpression,
@@ -95,6 +120,13 @@ private:
      */
     void add(const std::string& field, int skip, int limit);
 
+    /**
+     * Flattens the parsed projection into the lookup structures used at execution time: a
+     * FieldPlan per field name at this level, the list of $meta projections and the paths read
+     * when projecting from index keys. Recurses into the sub-projections in '_fields'.
+     */
+    void compile(bool topLevel);
+
     //
     // Execution
     //
@@ -128,6 +160,24 @@ private:
                   const MatchDetails* details = NULL,
                   const ArrayOpType arrayOpType = ARRAY_OP_NORMAL) const;
 
+    /**
+     * Like append, but with the FieldPlan for 'elt' already looked up. 'plan' is null if this
+     * level of the projection says nothing about the field.
+     */
+    Status appendField(BSONObjBuilder* bob,
+                       const BSONElement& elt,
+                       const FieldPlan* plan,
+                       const MatchDetails* details,
+                       const ArrayOpType arrayOpType) const;
+
+    /**
+     * Returns the FieldPlan for 'fieldName' at this level, or null if there is none.
+     */
+    const FieldPlan* findPlan(StringData fieldName) const {
+        FieldPlanMap::const_iterator it = _plan.find(fieldName);
+        return _plan.end() == it ? nullptr : &it->second;
+    }
+
     /**
      * Like append, but for arrays.
      * Deals with slice and calls appendArray to preserve the array-ness.
@@ -184,6 +234,31 @@ private:
     // that perform matching (e.g. elemMatch projection). If null, the collation is a simple binary
     // compare.
     const CollatorInterface* _collator = nullptr;
+
+    //
+    // Built by compile().
+    //
+
+    // One entry per field name that '_fields', '_matchers', '_meta' or the _id rule applies to.
+    FieldPlanMap _plan;
+
+    // The contents of '_meta', in the order in which the fields are appended to the output.
+    std::vector<std::pair<std::string, MetaProjection>> _metaList;
+
+    // A path read out of the index keys when the member has no document.
+    struct CoveredPath {
+        explicit CoveredPath(StringData path) : path(path.toString()), fieldRef(path) {}
+
+        std::string path;
+        FieldRef fieldRef;
+    };
+
+    // The non-_id inclusions, in spec order, applied when projecting from index keys.
+    std::vector<std::unique_ptr<CoveredPath>> _coveredPaths;
+
+    // False if the spec has something other than inclusions and sortKey $meta projections, in
+    // which case it can only be applied to a member with a document.
+    bool _coverable = true;
 };
 
 }  // namespace mongo
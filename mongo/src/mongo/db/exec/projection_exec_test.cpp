@@ -276,6 +276,29 @@ TEST(ProjectionExecTest, TransformCoveredDottedProjection) {
     ASSERT_BSONOBJ_EQ(result, fromjson("{b: {c: 2, d: 3, f: {g: 4, h: 5}}}"));
 }
 
+TEST(ProjectionExecTest, TransformReusesProjectionAcrossDocuments) {
+    // The same compiled projection is applied to documents of different shapes, including ones
+    // where the projected path is a scalar or an array rather than an object.
+    BSONObj spec = fromjson("{_id: 0, 'a.b': 1, c: 1}");
+    QueryTestServiceContext serviceCtx;
+    auto opCtx = serviceCtx.makeOperationContext();
+    ProjectionExec exec(opCtx.get(), spec, nullptr, nullptr);
+
+    const char* inputs[] = {"{_id: 1, a: {b: 1, x: 1}, c: 1, d: 1}",
+                            "{_id: 2, d: 1, c: 2, a: 5}",
+                            "{_id: 3, a: [{b: 3}, {x: 3}], z: 3}",
+                            "{_id: 4}"};
+    const char* outputs[] = {"{a: {b: 1}, c: 1}", "{c: 2}", "{a: [{b: 3}, {}]}", "{}"};
+
+    for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); ++i) {
+        WorkingSetMember wsm;
+        wsm.obj = Snapshotted<BSONObj>(SnapshotId(), fromjson(inputs[i]));
+        wsm.transitionToOwnedObj();
+        ASSERT_OK(exec.transform(&wsm));
+        ASSERT_BSONOBJ_EQ(wsm.obj.value(), fromjson(outputs[i]));
+    }
+}
+
 TEST(ProjectionExecTest, TransformNonCoveredDottedProjection) {
     testTransform("{'b.c': 1, 'b.d': 1, 'b.f.g': 1, 'b.f.h': 1}",
                   "{}",
@@ -34,6 +34,7 @@
 
 #include <boost/optional.hpp>
 
+#include "mongo/db/exec/batched_child_results.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/operation_context_noop.h"
 #include "mongo/db/service_context.h"
@@ -139,4 +140,69 @@ TEST_F(QueuedDataStageTest, validateStats) {
     unique_ptr<PlanStageStats> allStats(mock->getStats());
     ASSERT_TRUE(stats->isEOF);
 }
+
+//
+// A stage without a batch implementation returns from workBatch() after its first result.
+//
+TEST_F(QueuedDataStageTest, defaultWorkBatchStopsAfterFirstResult) {
+    WorkingSet ws;
+    WorkingSetID wsID;
+    auto mock = make_unique<QueuedDataStage>(getOpCtx(), &ws);
+
+    mock->pushBack(PlanStage::NEED_TIME);
+    WorkingSetID first = ws.allocate();
+    mock->pushBack(first);
+    mock->pushBack(ws.allocate());
+
+    std::vector<WorkingSetID> batch;
+    ASSERT_EQUALS(PlanStage::ADVANCED, mock->workBatch(10, &batch, &wsID));
+    ASSERT_EQUALS(batch.size(), 1U);
+    ASSERT_EQUALS(batch[0], first);
+
+    const CommonStats* stats = mock->getCommonStats();
+    ASSERT_EQUALS(stats->works, 2U);
+    ASSERT_EQUALS(stats->needTime, 1U);
+    ASSERT_EQUALS(stats->advanced, 1U);
+    ASSERT_EQUALS(stats->batches, 1U);
+
+    // The work budget runs out before the stage hits EOF.
+    batch.clear();
+    ASSERT_EQUALS(PlanStage::ADVANCED, mock->workBatch(1, &batch, &wsID));
+    ASSERT_EQUALS(batch.size(), 1U);
+    batch.clear();
+    ASSERT_EQUALS(PlanStage::IS_EOF, mock->workBatch(10, &batch, &wsID));
+    ASSERT_TRUE(batch.empty());
+    ASSERT_EQUALS(stats->batches, 3U);
+}
+
+//
+// BatchedChildResults hands out the child's results in order, followed by the state ending
+// the batch.
+//
+TEST_F(QueuedDataStageTest, batchedChildResultsPreservesOrder) {
+    WorkingSet ws;
+    WorkingSetID wsID;
+    auto mock = make_unique<QueuedDataStage>(getOpCtx(), &ws);
+
+    std::vector<WorkingSetID> ids;
+    for (int i = 0; i < 3; ++i) {
+        ids.push_back(ws.allocate());
+        mock->pushBack(ids.back());
+        mock->pushBack(PlanStage::NEED_TIME);
+    }
+
+    BatchedChildResults results;
+    results.startBatch(100);
+    for (auto&& id : ids) {
+        ASSERT_EQUALS(PlanStage::ADVANCED, results.next(mock.get(), &wsID));
+        ASSERT_EQUALS(wsID, id);
+    }
+    results.endBatch();
+
+    while (results.hasBuffered() || !mock->isEOF()) {
+        PlanStage::StageState state = results.next(mock.get(), &wsID);
+        ASSERT_NOT_EQUALS(PlanStage::ADVANCED, state);
+    }
+    ASSERT_EQUALS(PlanStage::IS_EOF, results.next(mock.get(), &wsID));
+}
 }
@@ -41,6 +41,7 @@
 #include "mongo/db/query/find_common.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
+#include "mongo/db/storage/key_string.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/log.h"
 
@@ -54,10 +55,39 @@ using stdx::make_unique;
 // static
 const char* SortStage::kStageType = "SORT";
 
+namespace {
+
+Status exceededMemoryLimitStatus(size_t maxBytes) {
+    mongoutils::str::stream ss;
+    ss << "Sort operation used more than the maximum " << maxBytes
+       << " bytes of RAM. Add an index, or specify a smaller limit.";
+    return Status(ErrorCodes::OperationFailed, ss);
+}
+
+// Ordering can describe the direction of at most this many fields.
+const int kMaxNormalizedKeyFields = 31;
+
+int compareBytes(const char* lhs, size_t lhsLen, const char* rhs, size_t rhsLen) {
+    int result = memcmp(lhs, rhs, std::min(lhsLen, rhsLen));
+    if (0 != result) {
+        return result;
+    }
+    return lhsLen < rhsLen ? -1 : (lhsLen > rhsLen ? 1 : 0);
+}
+
+}  // namespace
+
 SortStage::WorkingSetComparator::WorkingSetComparator(BSONObj p) : pattern(p) {}
 
 bool SortStage::WorkingSetComparator::operator()(const SortableDataItem& lhs,
                                                  const SortableDataItem& rhs) const {
+    if (!lhs.normalizedKey.empty() && !rhs.normalizedKey.empty()) {
+        // The RecordId is encoded in the normalized key, so it also breaks ties here.
+        return compareBytes(lhs.normalizedKey.data(),
+                            lhs.normalizedKey.size(),
+                            rhs.normalizedKey.data(),
+                            rhs.normalizedKey.size()) < 0;
+    }
     // False means ignore field names.
     int result = lhs.sortKey.woCompare(rhs.sortKey, pattern, false);
     if (0 != result) {
@@ -67,6 +97,25 @@ bool SortStage::WorkingSetComparator::operator()(const SortableDataItem& lhs,
     return lhs.recordId < rhs.recordId;
 }
 
+int SortStage::SpillComparator::operator()(const SpillSorter::Data& lhs,
+                                           const SpillSorter::Data& rhs) const {
+    if (normalizedKeys) {
+        int lhsLen;
+        int rhsLen;
+        const char* lhsData = lhs.first.firstElement().binData(lhsLen);
+        const char* rhsData = rhs.first.firstElement().binData(rhsLen);
+        return compareBytes(lhsData, lhsLen, rhsData, rhsLen);
+    }
+    int result = lhs.first.woCompare(rhs.first, pattern, false);
+    if (0 != result) {
+        return result;
+    }
+    // The RecordId is the first field of the value.
+    const long long lhsRecordId = lhs.second.firstElement().numberLong();
+    const long long rhsRecordId = rhs.second.firstElement().numberLong();
+    return lhsRecordId < rhsRecordId ? -1 : (lhsRecordId > rhsRecordId ? 1 : 0);
+}
+
 SortStage::SortStage(OperationContext* opCtx,
                      const SortStageParams& params,
                      WorkingSet* ws,
@@ -76,6 +125,8 @@ SortStage::SortStage(OperationContext* opCtx,
       _ws(ws),
       _pattern(params.pattern),
       _limit(params.limit),
+      _allowDiskUse(params.allowDiskUse),
+      _tempDir(params.tempDir),
       _sorted(false),
       _resultIterator(_data.end()),
       _memUsage(0) {
@@ -84,6 +135,11 @@ SortStage::SortStage(OperationContext* opCtx,
     BSONObj sortComparator = FindCommon::transformSortSpec(_pattern);
     _sortKeyComparator = stdx::make_unique<WorkingSetComparator>(sortComparator);
 
+    if (internalQueryExecSortUseNormalizedKeys.load() &&
+        sortComparator.nFields() <= kMaxNormalizedKeyFields) {
+        _normalizedKeyOrdering = Ordering::make(sortComparator);
+    }
+
     // If limit > 1, we need to initialize _dataSet here to maintain ordered set of data items while
     // fetching from the child stage.
     if (_limit > 1) {
@@ -97,18 +153,17 @@ SortStage::~SortStage() {}
 bool SortStage::isEOF() {
     // We're done when our child has no more results, we've sorted the child's results, and
     // we've returned all sorted results.
+    if (_spilledIterator) {
+        return child()->isEOF() && _sorted && !_spilledIterator->more();
+    }
     return child()->isEOF() && _sorted && (_data.end() == _resultIterator);
 }
 
 PlanStage::StageState SortStage::doWork(WorkingSetID* out) {
     const size_t maxBytes = static_cast<size_t>(internalQueryExecMaxBlockingSortBytes.load());
 	//һѯĵڴ
-	if (_memUsage > maxBytes) {
-        mongoutils::str::stream ss;
-        ss << "Sort operation used more than the maximum " << maxBytes
-           << " bytes of RAM. Add an index, or specify a smaller limit.";
-        Status status(ErrorCodes::OperationFailed, ss);
-        *out = WorkingSetCommon::allocateStatusMember(_ws, status);
+	if (!_sorter && _memUsage > maxBytes && !spillBuffer()) {
+        *out = WorkingSetCommon::allocateStatusMember(_ws, exceededMemoryLimitStatus(maxBytes));
         return PlanStage::FAILURE;
     }
 
@@ -151,12 +206,34 @@ PlanStage::StageState SortStage::doWork(WorkingSetID* out) {
                 item.recordId = member->recordId;
             }
 
+            if (_normalizedKeyOrdering) {
+                KeyString normalizedKey(KeyString::Version::V1,
+                                        item.sortKey,
+                                        *_normalizedKeyOrdering,
+                                        item.recordId);
+                item.normalizedKey.assign(normalizedKey.getBuffer(), normalizedKey.getSize());
+            }
+
+            if (_sorter) {
+                if (!addToSorter(item)) {
+                    *out = WorkingSetCommon::allocateStatusMember(
+                        _ws, exceededMemoryLimitStatus(maxBytes));
+                    return PlanStage::FAILURE;
+                }
+                return PlanStage::NEED_TIME;
+            }
+
             addToBuffer(item);
 
             return PlanStage::NEED_TIME;
         } else if (PlanStage::IS_EOF == code) {
             // TODO: We don't need the lock for this.  We could ask for a yield and do this work
             // unlocked.  Also, this is performing a lot of work for one call to work(...)
+            if (_sorter) {
+                _spilledIterator.reset(_sorter->done());
+                _sorted = true;
+                return PlanStage::NEED_TIME;
+            }
             sortBuffer();
             _resultIterator = _data.begin();
             _sorted = true;
@@ -181,6 +258,27 @@ PlanStage::StageState SortStage::doWork(WorkingSetID* out) {
     }
 
     // Returning results.
+    if (_spilledIterator) {
+        SpillSorter::Data data = _spilledIterator->next();
+        *out = _ws->allocate();
+        WorkingSetMember* member = _ws->get(*out);
+
+        // The document may have changed since it was spilled, so it is given no snapshot. An
+        // update or delete above us then fetches it again and checks that it still matches.
+        member->obj = Snapshotted<BSONObj>(SnapshotId(), data.second["o"].Obj().getOwned());
+        const RecordId recordId(data.second["r"].numberLong());
+        if (recordId.isNull()) {
+            member->transitionToOwnedObj();
+        } else {
+            member->recordId = recordId;
+            _ws->transitionToRecordIdAndObj(*out);
+        }
+        // Stages above may still need the sort key, e.g. to return it to mongos for merging.
+        member->addComputed(new SortKeyComputedData(
+            _normalizedKeyOrdering ? data.second["k"].Obj() : data.first));
+        return PlanStage::ADVANCED;
+    }
+
     verify(_resultIterator != _data.end());
     verify(_sorted);
     *out = _resultIterator->wsid;
@@ -225,6 +323,8 @@ unique_ptr<PlanStageStats> SortStage::getStats() {
     const size_t maxBytes = static_cast<size_t>(internalQueryExecMaxBlockingSortBytes.load());
     _specificStats.memLimit = maxBytes;
     _specificStats.memUsage = _memUsage;
+    _specificStats.spills = _sorter ? _sorter->numFiles() : 0;
+    _specificStats.normalizedKeys = static_cast<bool>(_normalizedKeyOrdering);
     _specificStats.limit = _limit;
     _specificStats.sortPattern = _pattern.getOwned();
 
@@ -267,12 +367,12 @@ void SortStage::addToBuffer(const SortableDataItem& item) {
         // Ensure that the BSONObj underlying the WorkingSetMember is owned in case we yield.
         member->makeObjOwnedIfNeeded();
         _data.push_back(item);
-        _memUsage += member->getMemUsage();
+        _memUsage += getMemUsage(item);
     } else if (_limit == 1) {
         if (_data.empty()) {
             member->makeObjOwnedIfNeeded();
             _data.push_back(item);
-            _memUsage = member->getMemUsage();
+            _memUsage = getMemUsage(item);
             return;
         }
         wsidToFree = item.wsid;
@@ -282,7 +382,7 @@ void SortStage::addToBuffer(const SortableDataItem& item) {
             wsidToFree = _data[0].wsid;
             member->makeObjOwnedIfNeeded();
             _data[0] = item;
-            _memUsage = member->getMemUsage();
+            _memUsage = getMemUsage(item);
         }
     } else {
         // Update data item set instead of vector
@@ -291,7 +391,7 @@ void SortStage::addToBuffer(const SortableDataItem& item) {
         if (_dataSet->size() < limit) {
             member->makeObjOwnedIfNeeded();
             _dataSet->insert(item);
-            _memUsage += member->getMemUsage();
+            _memUsage += getMemUsage(item);
             return;
         }
         // Limit will be exceeded - compare with item with lowest key
@@ -302,8 +402,8 @@ void SortStage::addToBuffer(const SortableDataItem& item) {
         const SortableDataItem& lastItem = *lastItemIt;
         const WorkingSetComparator& cmp = *_sortKeyComparator;
         if (cmp(item, lastItem)) {
-            _memUsage -= _ws->get(lastItem.wsid)->getMemUsage();
-            _memUsage += member->getMemUsage();
+            _memUsage -= getMemUsage(lastItem);
+            _memUsage += getMemUsage(item);
             wsidToFree = lastItem.wsid;
             // According to std::set iterator validity rules,
             // it does not matter which of erase()/insert() happens first.
@@ -344,4 +444,90 @@ void SortStage::sortBuffer() {
     }
 }
 
+bool SortStage::spillBuffer() {
+    if (!_allowDiskUse || _tempDir.empty()) {
+        return false;
+    }
+
+    // Check the whole buffer up front so that a failure leaves it untouched.
+    auto isSpillable = [this](const SortableDataItem& item) {
+        return canSpill(_ws->get(item.wsid));
+    };
+    if (_dataSet ? !std::all_of(_dataSet->begin(), _dataSet->end(), isSpillable)
+                 : !std::all_of(_data.begin(), _data.end(), isSpillable)) {
+        return false;
+    }
+
+    const size_t maxBytes = static_cast<size_t>(internalQueryExecMaxBlockingSortBytes.load());
+    SortOptions opts;
+    opts.Limit(_limit).MaxMemoryUsageBytes(maxBytes).ExtSortAllowed().TempDir(_tempDir);
+    _sorter.reset(SpillSorter::make(
+        opts,
+        SpillComparator(_sortKeyComparator->pattern, static_cast<bool>(_normalizedKeyOrdering))));
+
+    LOG(1) << "Sort of " << (_dataSet ? _dataSet->size() : _data.size())
+           << " buffered results exceeded " << maxBytes << " bytes, spilling to " << _tempDir;
+
+    if (_dataSet) {
+        for (auto&& item : *_dataSet) {
+            invariant(addToSorter(item));
+        }
+        _dataSet.reset();
+    } else {
+        for (auto&& item : _data) {
+            invariant(addToSorter(item));
+        }
+    }
+    _data.clear();
+    _specificStats.usedDisk = true;
+    return true;
+}
+
+bool SortStage::addToSorter(const SortableDataItem& item) {
+    WorkingSetMember* member = _ws->get(item.wsid);
+    if (!canSpill(member)) {
+        return false;
+    }
+
+    BSONObjBuilder valueBuilder;
+    valueBuilder.append("r", static_cast<long long>(item.recordId.repr()));
+    valueBuilder.append("o", member->obj.value());
+    if (item.normalizedKey.empty()) {
+        _sorter->add(item.sortKey, valueBuilder.obj());
+    } else {
+        valueBuilder.append("k", item.sortKey);
+        BSONObjBuilder keyBuilder;
+        keyBuilder.appendBinData("",
+                                 static_cast<int>(item.normalizedKey.size()),
+                                 BinDataGeneral,
+                                 item.normalizedKey.data());
+        _sorter->add(keyBuilder.obj(), valueBuilder.obj());
+    }
+    _memUsage = _sorter->memUsed();
+
+    if (member->hasRecordId()) {
+        _wsidByRecordId.erase(member->recordId);
+    }
+    _ws->free(item.wsid);
+    return true;
+}
+
+size_t SortStage::getMemUsage(const SortableDataItem& item) const {
+    return _ws->get(item.wsid)->getMemUsage() + item.normalizedKey.size();
+}
+
+// static
+bool SortStage::canSpill(const WorkingSetMember* member) {
+    for (int i = 0; i < WSM_COMPUTED_NUM_TYPES; ++i) {
+        const auto type = static_cast<WorkingSetComputedDataType>(i);
+        if (type != WSM_SORT_KEY && member->hasComputed(type)) {
+            return false;
+        }
+    }
+    return member->hasObj();
+}
+
 }  // namespace mongo
+
+#include "mongo/db/sorter/sorter.cpp"
+// Explicit instantiation unneeded since we aren't exposing Sorter outside of this file.
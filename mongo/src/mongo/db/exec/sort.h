@@ -29,14 +29,17 @@
 #pragma once
 
 #include <set>
+#include <string>
 #include <vector>
 
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/sort_key_generator.h"
 #include "mongo/db/exec/working_set.h"
+#include "mongo/bson/ordering.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/query/index_bounds.h"
 #include "mongo/db/record_id.h"
+#include "mongo/db/sorter/sorter.h"
 #include "mongo/platform/unordered_map.h"
 
 namespace mongo {
@@ -46,7 +49,7 @@ class BtreeKeyGenerator;
 // Parameters that must be provided to a SortStage
 class SortStageParams {
 public:
-    SortStageParams() : collection(NULL), limit(0) {}
+    SortStageParams() : collection(NULL), limit(0), allowDiskUse(false) {}
 
     // Used for resolving RecordIds to BSON
     const Collection* collection;
@@ -56,6 +59,12 @@ public:
 
     // Equal to 0 for no limit.
     size_t limit;
+
+    // If true, the stage spills to files under 'tempDir' instead of failing once the buffered
+    // data exceeds internalQueryExecMaxBlockingSortBytes.
+    bool allowDiskUse;
+
+    std::string tempDir;
 };
 
 /**
@@ -65,6 +74,16 @@ public:
  *   -- For each field in 'pattern', all inputs in the child must handle a getFieldDotted for that
  *   field.
  *   -- All WSMs produced by the child stage must have the sort key available as WSM computed data.
+ *
+ * Unless disabled by internalQueryExecSortUseNormalizedKeys, each sort key is encoded once, along
+ * with the RecordId, into a KeyString whose bytes sort in the same order as the keys. Comparisons
+ * during the sort are then plain memcmp()s instead of BSON comparisons of every field.
+ *
+ * If disk use is allowed, results which do not fit in memory are handed over to an external
+ * Sorter, whose run files are compressed. Spilled results keep their RecordIds but not their
+ * snapshot, since they no longer receive invalidations. Results which carry computed data other
+ * than the sort key (text score, geo distance, index key) cannot be spilled, and the sort fails as
+ * if disk use were not allowed.
  */
 class SortStage final : public PlanStage {
 public:
@@ -106,6 +125,10 @@ private:
     // Equal to 0 for no limit.
     size_t _limit;
 
+    bool _allowDiskUse;
+
+    std::string _tempDir;
+
     //
     // Data storage
     //
@@ -122,11 +145,14 @@ private:
         // RecordId to break sortKey ties.
         // See sorta.js.
         RecordId recordId;
+        // KeyString encoding of (sortKey, recordId), or empty if normalized keys are not in use.
+        std::string normalizedKey;
     };
 
     // Comparison object for data buffers (vector and set). Items are compared on (sortKey, loc).
     // This is also how the items are ordered in the indices. Keys are compared using
-    // BSONObj::woCompare() with RecordId as a tie-breaker.
+    // BSONObj::woCompare() with RecordId as a tie-breaker, or bytewise when both items carry a
+    // normalized key.
     //
     // We are comparing keys generated by the SortKeyGenerator, which are already ordered with
     // respect the collation. Therefore, we explicitly avoid comparing using a collator here.
@@ -152,10 +178,50 @@ private:
      */
     void sortBuffer();
 
+    /**
+     * Returns the memory accounted to 'item' while it is buffered.
+     */
+    size_t getMemUsage(const SortableDataItem& item) const;
+
+    /**
+     * Moves the buffered data into '_sorter', creating it on first use. Returns false, leaving
+     * the buffer untouched, if some buffered result cannot be spilled.
+     */
+    bool spillBuffer();
+
+    /**
+     * Adds the result held by 'item' to '_sorter' and frees its working set member. Returns false
+     * if the result cannot be spilled.
+     */
+    bool addToSorter(const SortableDataItem& item);
+
+    /**
+     * Returns whether 'member' carries only data which survives a round trip through '_sorter'.
+     */
+    static bool canSpill(const WorkingSetMember* member);
+
+    // The spilled data is keyed by sort key. The value holds the RecordId, which breaks ties as in
+    // the in-memory sort, and the document. With normalized keys, the key is instead a single
+    // BinData element holding the normalized key, and the sort key moves into the value.
+    using SpillSorter = Sorter<BSONObj, BSONObj>;
+
+    struct SpillComparator {
+        SpillComparator(BSONObj p, bool normalized)
+            : pattern(std::move(p)), normalizedKeys(normalized) {}
+
+        int operator()(const SpillSorter::Data& lhs, const SpillSorter::Data& rhs) const;
+
+        BSONObj pattern;
+        bool normalizedKeys;
+    };
+
     // Comparator for data buffer
     // Initialization follows sort key generator
     std::unique_ptr<WorkingSetComparator> _sortKeyComparator;
 
+    // Set if sort keys are encoded into normalized keys, to the ordering used to encode them.
+    boost::optional<Ordering> _normalizedKeyOrdering;
+
     // The data we buffer and sort.
     // _data will contain sorted data when all data is gathered
     // and sorted.
@@ -178,6 +244,13 @@ private:
 
     // The usage in bytes of all buffered data that we're sorting.
     size_t _memUsage;
+
+    // Non-null once the buffered data has exceeded the memory limit and disk use is allowed.
+    // From then on every result read from the child goes to the sorter.
+    std::unique_ptr<SpillSorter> _sorter;
+
+    // Iterates through the sorter's output once the child is exhausted.
+    std::unique_ptr<SpillSorter::Iterator> _spilledIterator;
 };
 
 }  // namespace mongo
@@ -124,6 +124,10 @@ unique_ptr<PlanStage> TextStage::buildTextTree(OperationContext* opCtx,
         auto textScorer = make_unique<TextOrStage>(opCtx, _params.spec, ws, filter, _params.index);
 
         textScorer->addChildren(std::move(indexScanList));
+        if (_params.topK > 0) {
+            const auto& terms = _params.query.getTermsForBounds();
+            textScorer->setTopK(_params.topK, std::vector<std::string>(terms.begin(), terms.end()));
+        }
 
         textMatchStage = make_unique<TextMatchStage>(
             opCtx, std::move(textScorer), _params.query, _params.spec, ws);
@@ -67,6 +67,10 @@ struct TextStageParams {
     // True if we need the text score in the output, because the projection includes the 'textScore'
     // metadata field.
     bool wantTextScore = true;
+
+    // If nonzero, only this many of the highest scoring documents are needed. Nothing above the
+    // text stage may filter its output, and the text query must not need a TEXT_MATCH check.
+    size_t topK = 0;
 };
 
 /**
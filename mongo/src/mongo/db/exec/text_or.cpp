@@ -28,6 +28,9 @@
 
 #include "mongo/db/exec/text_or.h"
 
+#include <algorithm>
+#include <functional>
+#include <limits>
 #include <map>
 #include <vector>
 
@@ -78,6 +81,16 @@ void TextOrStage::addChildren(Children childrenToAdd) {
                      std::make_move_iterator(childrenToAdd.end()));
 }
 
+void TextOrStage::setTopK(size_t k, std::vector<std::string> terms) {
+    invariant(k > 0);
+    invariant(terms.size() == _children.size());
+    _topK = k;
+    _terms = std::move(terms);
+    _termBounds.assign(_children.size(), std::numeric_limits<double>::infinity());
+    _childDone.assign(_children.size(), false);
+    _specificStats.topK = k;
+}
+
 bool TextOrStage::isEOF() {
     return _internalState == State::kDone;
 }
@@ -197,8 +210,15 @@ PlanStage::StageState TextOrStage::readFromChildren(WorkingSetID* out) {
     }
 
     if (PlanStage::ADVANCED == childState) {
-        return addTerm(id, out);
+        return _topK ? addTopKCandidate(id, out) : addTerm(id, out);
     } else if (PlanStage::IS_EOF == childState) {
+        if (_topK) {
+            // No document not seen yet has this child's term.
+            _childDone[_currentChild] = true;
+            _termBounds[_currentChild] = 0.0;
+            return advanceTopK();
+        }
+
         // Done with this child.
         ++_currentChild;
 
@@ -233,6 +253,18 @@ PlanStage::StageState TextOrStage::readFromChildren(WorkingSetID* out) {
 }
 
 PlanStage::StageState TextOrStage::returnResults(WorkingSetID* out) {
+    if (_topK) {
+        if (_nextTopDoc == _topDocs.size()) {
+            _internalState = State::kDone;
+            return PlanStage::IS_EOF;
+        }
+
+        const auto& topDoc = _topDocs[_nextTopDoc++];
+        _ws->get(topDoc.second)->addComputed(new TextScoreComputedData(topDoc.first));
+        *out = topDoc.second;
+        return PlanStage::ADVANCED;
+    }
+
     if (_scoreIterator == _scores.end()) {
         _internalState = State::kDone;
         return PlanStage::IS_EOF;
@@ -310,8 +342,116 @@ PlanStage::StageState TextOrStage::addTerm(WorkingSetID wsid, WorkingSetID* out)
         wsm = _ws->get(textRecordData->wsid);
     }
 
+    // Aggregate relevance score, term keys.
+    textRecordData->score += getTermScore(newKeyData.keyData);
+    return NEED_TIME;
+}
+
+PlanStage::StageState TextOrStage::addTopKCandidate(WorkingSetID wsid, WorkingSetID* out) {
+    WorkingSetMember* wsm = _ws->get(wsid);
+    invariant(wsm->getState() == WorkingSetMember::RID_AND_IDX);
+    invariant(1 == wsm->keyData.size());
+    const IndexKeyDatum newKeyData = wsm->keyData.back();  // copy to keep it around.
+
+    // The child scans in descending order of score, so documents it has not produced yet score
+    // at most this much for its term.
+    _termBounds[_currentChild] = getTermScore(newKeyData.keyData);
+
+    TextRecordData* textRecordData = &_scores[wsm->recordId];
+    if (textRecordData->score != 0) {
+        // The document was already scored, or rejected, when it was seen under another term.
+        _ws->free(wsid);
+        return advanceTopK();
+    }
+
+    if (!Filter::passes(newKeyData.keyData, newKeyData.indexKeyPattern, _filter)) {
+        _ws->free(wsid);
+        textRecordData->score = -1;
+        return advanceTopK();
+    }
+
+    try {
+        if (!WorkingSetCommon::fetch(getOpCtx(), _ws, wsid, _recordCursor)) {
+            _ws->free(wsid);
+            textRecordData->score = -1;
+            return advanceTopK();
+        }
+        ++_specificStats.fetches;
+    } catch (const WriteConflictException&) {
+        wsm->makeObjOwnedIfNeeded();
+        _idRetrying = wsid;
+        *out = WorkingSet::INVALID_ID;
+        return NEED_YIELD;
+    }
+    wsm->makeObjOwnedIfNeeded();
+
+    // Score the document for every term rather than only the ones read so far, so that its score
+    // is final.
+    fts::TermFrequencyMap termScores;
+    _ftsSpec.scoreDocument(wsm->obj.value(), &termScores);
+    double score = 0;
+    for (const auto& term : _terms) {
+        auto termScore = termScores.find(term);
+        if (termScore != termScores.end()) {
+            score += termScore->second;
+        }
+    }
+    // Keep the document marked as seen even if its terms' weights were all zero.
+    textRecordData->score = std::max(score, std::numeric_limits<double>::min());
+
+    typedef std::greater<std::pair<double, WorkingSetID>> MinHeapOrder;
+    if (_topDocs.size() == _topK && textRecordData->score <= _topDocs.front().first) {
+        _ws->free(wsid);
+        return advanceTopK();
+    }
+
+    textRecordData->wsid = wsid;
+    _topDocs.emplace_back(textRecordData->score, wsid);
+    std::push_heap(_topDocs.begin(), _topDocs.end(), MinHeapOrder());
+
+    if (_topDocs.size() > _topK) {
+        std::pop_heap(_topDocs.begin(), _topDocs.end(), MinHeapOrder());
+        WorkingSetID droppedId = _topDocs.back().second;
+        _topDocs.pop_back();
+        _scores[_ws->get(droppedId)->recordId].wsid = WorkingSet::INVALID_ID;
+        _ws->free(droppedId);
+    }
+
+    return advanceTopK();
+}
+
+PlanStage::StageState TextOrStage::advanceTopK() {
+    if (!haveTopK()) {
+        // Read from the children in turn so that all the term bounds come down together.
+        for (size_t i = 1; i <= _children.size(); ++i) {
+            size_t nextChild = (_currentChild + i) % _children.size();
+            if (!_childDone[nextChild]) {
+                _currentChild = nextChild;
+                return PlanStage::NEED_TIME;
+            }
+        }
+    }
+
+    _nextTopDoc = 0;
+    _internalState = State::kReturningResults;
+    return PlanStage::NEED_TIME;
+}
+
+bool TextOrStage::haveTopK() const {
+    if (_topDocs.size() < _topK) {
+        return false;
+    }
+
+    double unseenBound = 0;
+    for (double termBound : _termBounds) {
+        unseenBound += termBound;
+    }
+    return _topDocs.front().first >= unseenBound;
+}
+
+double TextOrStage::getTermScore(const BSONObj& keyData) const {
     // Locate score within possibly compound key: {prefix,term,score,suffix}.
-    BSONObjIterator keyIt(newKeyData.keyData);
+    BSONObjIterator keyIt(keyData);
     for (unsigned i = 0; i < _ftsSpec.numExtraBefore(); i++) {
         keyIt.next();
     }
@@ -319,11 +459,7 @@ PlanStage::StageState TextOrStage::addTerm(WorkingSetID wsid, WorkingSetID* out)
     keyIt.next();  // Skip past 'term'.
 
     BSONElement scoreElement = keyIt.next();
-    double documentTermScore = scoreElement.number();
-
-    // Aggregate relevance score, term keys.
-    textRecordData->score += documentTermScore;
-    return NEED_TIME;
+    return scoreElement.number();
 }
 
 }  // namespace mongo
@@ -52,6 +52,10 @@ class OperationContext;
  * the positive terms in the search query, as well as their scores.
  *
  * The WorkingSetMembers returned are fetched and in the LOC_AND_OBJ state.
+ *
+ * When only the k highest scoring documents are wanted (see setTopK()), the stage instead reads
+ * its children a key at a time in turn, scores each new document in full from the fetched object,
+ * and stops once no unseen document can beat the k-th best score so far.
  */
 class TextOrStage final : public PlanStage {
 public:
@@ -83,6 +87,16 @@ public:
 
     void addChildren(Children childrenToAdd);
 
+    /**
+     * Only the 'k' highest scoring documents are wanted, in no particular order. Must be called
+     * after the children are added. Child i must scan the index keys of the term 'terms[i]' in
+     * descending order of score. Ties with the k-th score may be broken either way.
+     *
+     * Requires a storage engine with document-level locking, because the documents kept aside are
+     * not invalidated.
+     */
+    void setTopK(size_t k, std::vector<std::string> terms);
+
     bool isEOF() final;
 
     StageState doWork(WorkingSetID* out) final;
@@ -122,6 +136,28 @@ private:
      */
     StageState addTerm(WorkingSetID wsid, WorkingSetID* out);
 
+    /**
+     * Helper for readFromChildren when reading for the top k documents. Fetches and scores a
+     * document seen for the first time, keeping it if it is among the k best so far.
+     */
+    StageState addTopKCandidate(WorkingSetID wsid, WorkingSetID* out);
+
+    /**
+     * Moves on to the next child that still has keys, or to returning results once the top k
+     * documents are known.
+     */
+    StageState advanceTopK();
+
+    /**
+     * Returns whether no document not seen yet can score higher than the k-th best one.
+     */
+    bool haveTopK() const;
+
+    /**
+     * Returns the score of the term in the text index key 'keyData'.
+     */
+    double getTermScore(const BSONObj& keyData) const;
+
     /**
      * Worker for kReturningResults. Returns a wsm with RecordID and Score.
      */
@@ -154,6 +190,25 @@ private:
     ScoreMap _scores;
     ScoreMap::const_iterator _scoreIterator;
 
+    //
+    // Top k mode.
+    //
+
+    // Zero unless only the 'k' highest scoring documents are wanted.
+    size_t _topK = 0;
+
+    // The term scanned by each child.
+    std::vector<std::string> _terms;
+
+    // Score of the last key read from each child, an upper bound on what any document not seen
+    // yet scores for that child's term. Infinite until the child produces its first key.
+    std::vector<double> _termBounds;
+    std::vector<bool> _childDone;
+
+    // The best documents so far as a min-heap on score, and the next one to return.
+    std::vector<std::pair<double, WorkingSetID>> _topDocs;
+    size_t _nextTopDoc = 0;
+
     TextOrStats _specificStats;
 
     // Members needed only for using the TextMatchableDocument.
@@ -179,6 +179,11 @@ UpdateStage::UpdateStage(OperationContext* opCtx,
     // Before we even start executing, we know whether or not this is a replacement
     // style or $mod style update.
     _specificStats.isDocReplacement = params.driver->isDocReplacement();
+
+    if (params.request->isMulti() && !params.request->shouldReturnAnyDocs() &&
+        !params.request->isExplain()) {
+        _batchSize = write_stage_common::getMultiWriteBatchSize();
+    }
 }
 
 BSONObj UpdateStage::transformAndUpdate(const Snapshotted<BSONObj>& oldObj, RecordId& recordId) {
@@ -354,8 +359,13 @@ BSONObj UpdateStage::transformAndUpdate(const Snapshotted<BSONObj>& oldObj, Reco
         // updatedRecordIds.
         //
         // This must be done after the wunit commits so we are sure we won't be rolling back.
+        // In a batch that is when the batch's enclosing wunit commits.
         if (_updatedRecordIds && (newRecordId != recordId || driver->modsAffectIndices())) {
-            _updatedRecordIds->insert(newRecordId);
+            if (_batchSize > 1) {
+                _batchUpdatedRecordIds.push_back(newRecordId);
+            } else {
+                _updatedRecordIds->insert(newRecordId);
+            }
         }
     }
 
@@ -494,6 +504,7 @@ bool UpdateStage::doneUpdating() {
     // We're done updating if either the child has no more results to give us, or we've
     // already gotten a result back and we're not a multi-update.
     return _idRetrying == WorkingSet::INVALID_ID && _idReturning == WorkingSet::INVALID_ID &&
+        _batch.empty() &&
         (child()->isEOF() || (_specificStats.nMatched > 0 && !_params.request->isMulti()));
 }
 
@@ -563,6 +574,11 @@ PlanStage::StageState UpdateStage::doWork(WorkingSetID* out) {
         return PlanStage::ADVANCED;
     }
 
+    // Update, or retry updating, a full batch, or the last one once the child is out of results.
+    if (_batch.size() >= _batchSize || (!_batch.empty() && child()->isEOF())) {
+        return flushBatch(out);
+    }
+
     // Either retry the last WSM we worked on or get a new one from our child.
     WorkingSetID id;
     StageState status;
@@ -603,6 +619,21 @@ PlanStage::StageState UpdateStage::doWork(WorkingSetID* out) {
             return PlanStage::NEED_TIME;
         }
 
+        if (_batchSize > 1) {
+            // The document is checked against the predicate again when its batch is updated.
+            const bool alreadyBuffered =
+                std::any_of(_batch.begin(), _batch.end(), [&](WorkingSetID bufferedId) {
+                    return _ws->get(bufferedId)->recordId == recordId;
+                });
+            if (alreadyBuffered) {
+                return PlanStage::NEED_TIME;
+            }
+            member->makeObjOwnedIfNeeded();
+            memberFreer.Dismiss();
+            _batch.push_back(id);
+            return _batch.size() < _batchSize ? PlanStage::NEED_TIME : flushBatch(out);
+        }
+
         bool docStillMatches;
         try {
             docStillMatches = write_stage_common::ensureStillMatches(
@@ -780,6 +811,75 @@ UpdateResult UpdateStage::makeUpdateResult(const UpdateStats* updateStats) {
                         updateStats->objInserted);
 };
 
+PlanStage::StageState UpdateStage::flushBatch(WorkingSetID* out) {
+    WorkingSetCommon::prepareForSnapshotChange(_ws);
+    try {
+        child()->saveState();
+    } catch (const WriteConflictException&) {
+        std::terminate();
+    }
+
+    while (!_batch.empty()) {
+        const size_t numToWrite = _writeBatchOneAtATime ? 1U : _batch.size();
+        const size_t nModified = _specificStats.nModified;
+        size_t nMatched = 0;
+        try {
+            WriteUnitOfWork wunit(getOpCtx());
+            for (size_t i = 0; i < numToWrite; ++i) {
+                // The document may have been deleted or changed since it was buffered.
+                if (!write_stage_common::ensureStillMatches(
+                        _collection, getOpCtx(), _ws, _batch[i], _params.canonicalQuery)) {
+                    continue;
+                }
+                WorkingSetMember* member = _ws->get(_batch[i]);
+                RecordId recordId = member->recordId;
+                transformAndUpdate(member->obj, recordId);
+                ++nMatched;
+            }
+            wunit.commit();
+        } catch (const WriteConflictException&) {
+            // Everything since the last commit rolled back. Keep it so it is retried after
+            // yielding.
+            _specificStats.nModified = nModified;
+            _batchUpdatedRecordIds.clear();
+            *out = WorkingSet::INVALID_ID;
+            return NEED_YIELD;
+        } catch (...) {
+            _specificStats.nModified = nModified;
+            _batchUpdatedRecordIds.clear();
+            if (_writeBatchOneAtATime) {
+                throw;
+            }
+
+            // Any other error rolled back the documents before the failing one, which an unbatched
+            // update would have kept. Write them again one at a time, so that they are updated and
+            // counted, and the error is raised again by the document that caused it.
+            _writeBatchOneAtATime = true;
+            continue;
+        }
+        _specificStats.nMatched += nMatched;
+
+        _updatedRecordIds->insert(_batchUpdatedRecordIds.begin(), _batchUpdatedRecordIds.end());
+        _batchUpdatedRecordIds.clear();
+
+        for (size_t i = 0; i < numToWrite; ++i) {
+            _ws->free(_batch[i]);
+        }
+        _batch.erase(_batch.begin(), _batch.begin() + numToWrite);
+    }
+    _writeBatchOneAtATime = false;
+
+    // As with a single update, restore the child outside of the WriteUnitOfWork.
+    try {
+        child()->restoreState();
+    } catch (const WriteConflictException&) {
+        *out = WorkingSet::INVALID_ID;
+        return NEED_YIELD;
+    }
+
+    return PlanStage::NEED_TIME;
+}
+
 PlanStage::StageState UpdateStage::prepareToRetryWSM(WorkingSetID idToRetry, WorkingSetID* out) {
     _idRetrying = idToRetry;
     *out = WorkingSet::INVALID_ID;
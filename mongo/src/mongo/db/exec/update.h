@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <vector>
 
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/exec/plan_stage.h"
@@ -175,6 +176,14 @@ private:
      */
     StageState prepareToRetryWSM(WorkingSetID idToRetry, WorkingSetID* out);
 
+    /**
+     * Updates the documents in '_batch' that still match in a single WriteUnitOfWork. On a write
+     * conflict nothing is updated, the batch is kept to be retried, and NEED_YIELD is returned. On
+     * any other error the batch is written again one document per WriteUnitOfWork, so that the
+     * documents before the failing one are updated before the error is thrown.
+     */
+    StageState flushBatch(WorkingSetID* out);
+
     UpdateStageParams _params;
 
     // Not owned by us.
@@ -207,6 +216,20 @@ private:
     typedef unordered_set<RecordId, RecordId::Hasher> RecordIdSet;
     const std::unique_ptr<RecordIdSet> _updatedRecordIds;
 
+    // A multi-update that returns nothing buffers this many documents from its child and updates
+    // them in one WriteUnitOfWork. One when each is updated as soon as it is found.
+    size_t _batchSize = 1;
+
+    // Documents buffered for the next batch.
+    std::vector<WorkingSetID> _batch;
+
+    // Set once writing '_batch' in one WriteUnitOfWork has failed with an error other than a write
+    // conflict, until the rest of the batch has been written one document at a time.
+    bool _writeBatchOneAtATime = false;
+
+    // RecordIds written by the batch being flushed, added to '_updatedRecordIds' once it commits.
+    std::vector<RecordId> _batchUpdatedRecordIds;
+
     // These get reused for each update.
     mutablebson::Document& _doc;
     mutablebson::DamageVector _damages;
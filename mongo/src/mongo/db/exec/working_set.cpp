@@ -28,6 +28,8 @@
 
 #include "mongo/db/exec/working_set.h"
 
+#include <algorithm>
+
 #include "mongo/db/bson/dotted_path_support.h"
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/service_context.h"
@@ -42,13 +44,12 @@ namespace dps = ::mongo::dotted_path_support;
 WorkingSet::MemberHolder::MemberHolder() : member(NULL) {}
 WorkingSet::MemberHolder::~MemberHolder() {}
 
+const size_t WorkingSet::kMinSlabSize;
+const size_t WorkingSet::kMaxSlabSize;
+
 WorkingSet::WorkingSet() : _freeList(INVALID_ID) {}
 
-WorkingSet::~WorkingSet() {
-    for (size_t i = 0; i < _data.size(); i++) {
-        delete _data[i].member;
-    }
-}
+WorkingSet::~WorkingSet() {}
 
 WorkingSetID WorkingSet::allocate() {
 	//_dataпÿռˣ´μһһĿռ
@@ -59,17 +60,32 @@ WorkingSetID WorkingSet::allocate() {
         WorkingSetID id = _data.size();
         _data.resize(_data.size() + 1);
         _data.back().nextFreeOrSelf = id;
-        _data.back().member = new WorkingSetMember();
+        _data.back().member = allocateMemberFromSlab();
+        ++_stats.allocations;
         return id;
     }
 
     // Pop the head off the free list and return it.
+    ++_stats.allocations;
+    ++_stats.recycled;
     WorkingSetID id = _freeList;
     _freeList = _data[id].nextFreeOrSelf;
     _data[id].nextFreeOrSelf = id;  // set to self to mark as in-use
     return id;
 }
 
+WorkingSetMember* WorkingSet::allocateMemberFromSlab() {
+    if (_slabs.empty() || _lastSlabUsed == _lastSlabSize) {
+        _lastSlabSize = _slabs.empty() ? kMinSlabSize : std::min(_lastSlabSize * 2, kMaxSlabSize);
+        _lastSlabUsed = 0;
+        _slabs.emplace_back(new WorkingSetMember[_lastSlabSize]);
+        ++_stats.slabs;
+    }
+
+    ++_stats.membersCreated;
+    return &_slabs.back()[_lastSlabUsed++];
+}
+
 void WorkingSet::free(WorkingSetID i) {
     MemberHolder& holder = _data[i];
     verify(i < _data.size());            // ID has been allocated.
@@ -97,10 +113,10 @@ bool WorkingSet::isFlagged(WorkingSetID id) const {
 }
 
 void WorkingSet::clear() {
-    for (size_t i = 0; i < _data.size(); i++) {
-        delete _data[i].member;
-    }
     _data.clear();
+    _slabs.clear();
+    _lastSlabSize = 0;
+    _lastSlabUsed = 0;
 
     // Since working set is now empty, the free list pointer should
     // point to nothing.
@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include "mongo/base/disallow_copying.h"
@@ -71,6 +72,24 @@ class WorkingSet { //ͨ
 public:
     static const WorkingSetID INVALID_ID = WorkingSetID(-1);
 
+    /**
+     * Counters describing how the members handed out by allocate() were obtained. Reported in
+     * the "workingSet" section of explain's executionStats.
+     */
+    struct Stats {
+        // Number of calls to allocate().
+        size_t allocations = 0;
+
+        // Number of allocate() calls served by a member that had been released with free().
+        size_t recycled = 0;
+
+        // Number of members constructed. Each one lives in a slab.
+        size_t membersCreated = 0;
+
+        // Number of slabs of members requested from the heap.
+        size_t slabs = 0;
+    };
+
     WorkingSet();
     ~WorkingSet();
 
@@ -149,7 +168,23 @@ public:
      */
     std::vector<WorkingSetID> getAndClearYieldSensitiveIds();
 
+    const Stats& getStats() const {
+        return _stats;
+    }
+
 private:
+    // Members are constructed in slabs rather than one at a time. The first slab holds
+    // kMinSlabSize members and each subsequent slab doubles in size, up to kMaxSlabSize, so that
+    // short queries pay for very few members while large ones make few trips to the heap.
+    static const size_t kMinSlabSize = 8;
+    static const size_t kMaxSlabSize = 1024;
+
+    /**
+     * Returns a default-constructed member from the current slab, starting a new slab if the
+     * current one is exhausted. The returned pointer remains valid until clear() or destruction.
+     */
+    WorkingSetMember* allocateMemberFromSlab();
+
     //WorkingSet._dataΪ
     struct MemberHolder { 
         MemberHolder();
@@ -181,6 +216,15 @@ private:
 
     // Contains ids of WSMs that may need to be adjusted when we next yield.
     std::vector<WorkingSetID> _yieldSensitiveIds;
+
+    // Owns every WorkingSetMember referenced from '_data'.
+    std::vector<std::unique_ptr<WorkingSetMember[]>> _slabs;
+
+    // Capacity of, and number of members handed out from, the last slab in '_slabs'.
+    size_t _lastSlabSize = 0;
+    size_t _lastSlabUsed = 0;
+
+    Stats _stats;
 };
 
 /**
@@ -32,6 +32,10 @@
 
 
 #include "mongo/db/exec/working_set.h"
+
+#include <set>
+#include <vector>
+
 #include "mongo/db/jsobj.h"
 #include "mongo/db/json.h"
 #include "mongo/db/storage/snapshot.h"
@@ -154,4 +158,44 @@ TEST_F(WorkingSetFixture, getDottedFieldFromIndex) {
     ASSERT_FALSE(member->getFieldDotted("y", &elt));
 }
 
+TEST(WorkingSetStatsTest, MembersAreCarvedFromSlabsAndRecycled) {
+    WorkingSet ws;
+
+    // Allocate enough members to need more than one slab.
+    std::vector<WorkingSetID> ids;
+    std::set<WorkingSetMember*> members;
+    for (size_t i = 0; i < 20; ++i) {
+        ids.push_back(ws.allocate());
+        members.insert(ws.get(ids.back()));
+    }
+    ASSERT_EQUALS(20U, members.size());
+    ASSERT_EQUALS(20U, ws.getStats().allocations);
+    ASSERT_EQUALS(20U, ws.getStats().membersCreated);
+    ASSERT_EQUALS(0U, ws.getStats().recycled);
+    ASSERT_GREATER_THAN(ws.getStats().slabs, 1U);
+    ASSERT_LESS_THAN(ws.getStats().slabs, 20U);
+
+    // Members released with free() are handed out again without constructing new ones, and come
+    // back cleared.
+    WorkingSetMember* freed = ws.get(ids[3]);
+    freed->obj = Snapshotted<BSONObj>(SnapshotId(), BSON("a" << 1));
+    ws.transitionToOwnedObj(ids[3]);
+    ws.free(ids[3]);
+
+    WorkingSetID reusedId = ws.allocate();
+    ASSERT_EQUALS(ids[3], reusedId);
+    ASSERT_EQUALS(freed, ws.get(reusedId));
+    ASSERT_EQUALS(WorkingSetMember::INVALID, freed->getState());
+    ASSERT_TRUE(freed->obj.value().isEmpty());
+    ASSERT_EQUALS(21U, ws.getStats().allocations);
+    ASSERT_EQUALS(1U, ws.getStats().recycled);
+    ASSERT_EQUALS(20U, ws.getStats().membersCreated);
+
+    // Clearing the working set releases the slabs; new members come from fresh ones.
+    ws.clear();
+    WorkingSetID id = ws.allocate();
+    ASSERT(NULL != ws.get(id));
+    ASSERT_EQUALS(21U, ws.getStats().membersCreated);
+}
+
 }  // namespace
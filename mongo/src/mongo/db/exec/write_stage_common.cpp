@@ -35,6 +35,8 @@
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/service_context.h"
 
 namespace mongo {
 namespace write_stage_common {
@@ -68,5 +70,13 @@ bool ensureStillMatches(const Collection* collection,
     return true;
 }
 
+size_t getMultiWriteBatchSize() {
+    const int batchSize = internalQueryExecMultiWriteBatchSize.load();
+    if (batchSize <= 1 || !supportsDocLocking()) {
+        return 1;
+    }
+    return static_cast<size_t>(batchSize);
+}
+
 }  // namespace write_stage_common
 }  // namespace mongo
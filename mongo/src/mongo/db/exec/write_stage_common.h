@@ -54,5 +54,14 @@ bool ensureStillMatches(const Collection* collection,
                         WorkingSet* ws,
                         WorkingSetID id,
                         const CanonicalQuery* cq);
+
+/**
+ * Returns how many matching documents a multi-document update or delete may buffer and then write
+ * in a single WriteUnitOfWork. Returns 1 if each document must be written as soon as it is found.
+ *
+ * Buffered documents are only revalidated through ensureStillMatches(), so batching requires a
+ * storage engine with document-level locking.
+ */
+size_t getMultiWriteBatchSize();
 }
 }
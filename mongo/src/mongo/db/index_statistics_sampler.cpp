@@ -0,0 +1,221 @@
+// index_statistics_sampler.cpp
+
+/**
+*    Copyright (C) 2017 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/index_statistics_sampler.h"
+
+#include "mongo/base/counter.h"
+#include "mongo/bson/simple_bsonobj_comparator.h"
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/catalog/index_catalog_entry.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/index/index_access_method.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/index_names.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/db/query/index_statistics.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/repl/replication_coordinator_global.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage/record_store.h"
+#include "mongo/db/storage/storage_engine.h"
+#include "mongo/util/background.h"
+#include "mongo/util/concurrency/idle_thread_block.h"
+#include "mongo/util/exit.h"
+#include "mongo/util/log.h"
+
+namespace mongo {
+
+Counter64 indexStatisticsSamplerPasses;
+Counter64 indexStatisticsSampledIndexes;
+
+ServerStatusMetricField<Counter64> indexStatisticsSamplerPassesDisplay(
+    "query.indexStatistics.passes", &indexStatisticsSamplerPasses);
+ServerStatusMetricField<Counter64> indexStatisticsSampledIndexesDisplay(
+    "query.indexStatistics.sampledIndexes", &indexStatisticsSampledIndexes);
+
+MONGO_EXPORT_SERVER_PARAMETER(indexStatisticsSamplerEnabled, bool, false);
+MONGO_EXPORT_SERVER_PARAMETER(indexStatisticsSamplerIntervalSecs, int, 600);
+
+namespace {
+
+class IndexStatisticsSampler : public BackgroundJob {
+public:
+    std::string name() const override {
+        return "IndexStatisticsSampler";
+    }
+
+    void run() override {
+        Client::initThread(name().c_str());
+        AuthorizationSession::get(cc())->grantInternalAuthorization();
+
+        while (!globalInShutdownDeprecated()) {
+            {
+                MONGO_IDLE_THREAD_BLOCK;
+                sleepsecs(indexStatisticsSamplerIntervalSecs.load());
+            }
+
+            if (!indexStatisticsSamplerEnabled.load()) {
+                continue;
+            }
+
+            // If part of replSet but not in a readable state (e.g. during initial sync), skip.
+            auto replCoord = repl::getGlobalReplicationCoordinator();
+            if (replCoord->getReplicationMode() == repl::ReplicationCoordinator::modeReplSet &&
+                !replCoord->getMemberState().readable()) {
+                continue;
+            }
+
+            doSamplingPass();
+        }
+    }
+
+private:
+    void doSamplingPass() {
+        const ServiceContext::UniqueOperationContext opCtxPtr = cc().makeOperationContext();
+        OperationContext* opCtx = opCtxPtr.get();
+
+        std::vector<std::string> dbNames;
+        getGlobalServiceContext()->getGlobalStorageEngine()->listDatabases(&dbNames);
+
+        indexStatisticsSamplerPasses.increment();
+
+        for (const std::string& dbName : dbNames) {
+            std::vector<NamespaceString> collectionNames;
+            {
+                AutoGetDb autoDb(opCtx, dbName, MODE_IS);
+                if (!autoDb.getDb()) {
+                    continue;
+                }
+                for (auto&& collection : *autoDb.getDb()) {
+                    collectionNames.push_back(collection->ns());
+                }
+            }
+
+            for (const NamespaceString& nss : collectionNames) {
+                try {
+                    sampleCollection(opCtx, nss);
+                } catch (const DBException& ex) {
+                    LOG(1) << "failed to sample index statistics for " << nss << ": "
+                           << redact(ex);
+                }
+            }
+        }
+    }
+
+    /**
+     * Reads a random sample of the collection's documents and rebuilds the statistics of each of
+     * its btree and hashed indexes from the keys those documents generate. Sampling documents
+     * rather than walking the indexes keeps each pass bounded regardless of collection size.
+     */
+    void sampleCollection(OperationContext* opCtx, const NamespaceString& nss) {
+        AutoGetCollection autoColl(opCtx, nss, MODE_IS);
+        Collection* collection = autoColl.getCollection();
+        if (!collection) {
+            return;
+        }
+
+        // Not every storage engine can produce random cursors.
+        auto cursor = collection->getRecordStore()->getRandomCursor(opCtx);
+        if (!cursor) {
+            return;
+        }
+
+        std::vector<const IndexDescriptor*> descriptors;
+        std::vector<const MatchExpression*> filters;
+        std::vector<IndexStatistics::Builder> builders;
+        const size_t numBuckets =
+            static_cast<size_t>(std::max(1, internalQueryStatsHistogramBuckets.load()));
+        IndexCatalog::IndexIterator ii =
+            collection->getIndexCatalog()->getIndexIterator(opCtx, false);
+        while (ii.more()) {
+            const IndexDescriptor* desc = ii.next();
+            const IndexType type = IndexNames::nameToType(desc->getAccessMethodName());
+            if (type != INDEX_BTREE && type != INDEX_HASHED) {
+                continue;
+            }
+            descriptors.push_back(desc);
+            filters.push_back(ii.catalogEntry(desc)->getFilterExpression());
+            builders.emplace_back(numBuckets);
+        }
+        if (descriptors.empty()) {
+            return;
+        }
+
+        const long long numRecords = static_cast<long long>(collection->numRecords(opCtx));
+        const long long sampleSize =
+            std::min(numRecords, static_cast<long long>(internalQueryStatsSampleSize.load()));
+        for (long long i = 0; i < sampleSize; ++i) {
+            auto record = cursor->next();
+            if (!record) {
+                break;
+            }
+            const BSONObj doc = record->data.releaseToBson();
+            for (size_t j = 0; j < descriptors.size(); ++j) {
+                // A document outside the filter of a partial index has no keys in it, but still
+                // counts towards the sample.
+                BSONObjSet keys = SimpleBSONObjComparator::kInstance.makeBSONObjSet();
+                if (!filters[j] || filters[j]->matchesBSON(doc)) {
+                    collection->getIndexCatalog()->getIndex(descriptors[j])->getKeys(
+                        doc, IndexAccessMethod::GetKeysMode::kRelaxConstraints, &keys, nullptr);
+                }
+                builders[j].addSampledDocument(keys);
+            }
+        }
+
+        for (size_t j = 0; j < descriptors.size(); ++j) {
+            auto stats = builders[j].build(numRecords);
+            LOG(2) << "sampled index statistics for " << nss << " index "
+                   << descriptors[j]->indexName() << ": " << redact(stats->toBSON());
+            collection->infoCache()->setIndexStatistics(descriptors[j]->indexName(),
+                                                        std::move(stats));
+            indexStatisticsSampledIndexes.increment();
+        }
+    }
+};
+
+}  // namespace
+
+void startIndexStatisticsSamplerBackgroundJob() {
+    IndexStatisticsSampler* sampler = new IndexStatisticsSampler();
+    sampler->go();
+}
+
+}  // namespace mongo
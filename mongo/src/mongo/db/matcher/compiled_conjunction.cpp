@@ -0,0 +1,159 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/matcher/compiled_conjunction.h"
+
+#include <algorithm>
+
+#include "mongo/db/matcher/expression_leaf.h"
+#include "mongo/stdx/memory.h"
+
+namespace mongo {
+
+namespace {
+
+/**
+ * Returns 'expr' as a comparison if it is one and it tests a non-empty top-level field.
+ */
+const ComparisonMatchExpression* asTopLevelComparison(const MatchExpression* expr) {
+    if (!ComparisonMatchExpression::isComparisonMatchExpression(expr)) {
+        return nullptr;
+    }
+
+    const auto* comparison = static_cast<const ComparisonMatchExpression*>(expr);
+    const StringData path = comparison->path();
+    if (path.empty() || path.find('.') != std::string::npos) {
+        return nullptr;
+    }
+    return comparison;
+}
+
+}  // namespace
+
+// static
+std::unique_ptr<CompiledConjunction> CompiledConjunction::compile(const MatchExpression* expr) {
+    if (!expr) {
+        return nullptr;
+    }
+
+    std::vector<const ComparisonMatchExpression*> comparisons;
+    if (MatchExpression::AND == expr->matchType()) {
+        for (size_t i = 0; i < expr->numChildren(); ++i) {
+            comparisons.push_back(asTopLevelComparison(expr->getChild(i)));
+            if (!comparisons.back()) {
+                return nullptr;
+            }
+        }
+    } else {
+        comparisons.push_back(asTopLevelComparison(expr));
+        if (!comparisons.back()) {
+            return nullptr;
+        }
+    }
+
+    if (comparisons.empty()) {
+        return nullptr;
+    }
+
+    std::unique_ptr<CompiledConjunction> compiled(new CompiledConjunction());
+    for (auto&& comparison : comparisons) {
+        const StringData path = comparison->path();
+        auto it = std::find(compiled->_fields.begin(), compiled->_fields.end(), path);
+        if (it == compiled->_fields.end()) {
+            it = compiled->_fields.insert(it, path);
+        }
+
+        Predicate predicate;
+        predicate.expr = comparison;
+        predicate.field = it - compiled->_fields.begin();
+        compiled->_predicates.push_back(predicate);
+    }
+    compiled->_elements.resize(compiled->_fields.size());
+    return compiled;
+}
+
+bool CompiledConjunction::matches(const BSONObj& doc) {
+    // Find every referenced field in a single pass. Like BSONObj::getField(), the first
+    // occurrence of a duplicated field name wins.
+    std::fill(_elements.begin(), _elements.end(), BSONElement());
+    size_t fieldsLeft = _fields.size();
+    BSONObjIterator it(doc);
+    while (fieldsLeft > 0 && it.more()) {
+        const BSONElement elem = it.next();
+        const StringData name = elem.fieldNameStringData();
+        for (size_t i = 0; i < _fields.size(); ++i) {
+            if (_elements[i].eoo() && _fields[i] == name) {
+                _elements[i] = elem;
+                --fieldsLeft;
+                break;
+            }
+        }
+    }
+
+    if (++_docsSinceReorder >= kReorderInterval) {
+        reorder();
+    }
+
+    for (auto&& predicate : _predicates) {
+        ++predicate.tested;
+
+        const BSONElement& elem = _elements[predicate.field];
+        const bool matched = (elem.eoo() || Array == elem.type())
+            ? predicate.expr->matchesBSON(doc)
+            : predicate.expr->matchesSingleElement(elem);
+        if (!matched) {
+            ++predicate.rejected;
+            return false;
+        }
+    }
+    return true;
+}
+
+void CompiledConjunction::reorder() {
+    // Compare rejection rates rejected/tested without dividing. Predicates never evaluated since
+    // the last re-ordering keep their relative position at the end.
+    std::stable_sort(_predicates.begin(),
+                     _predicates.end(),
+                     [](const Predicate& lhs, const Predicate& rhs) {
+                         if (lhs.tested == 0 || rhs.tested == 0) {
+                             return lhs.tested > rhs.tested;
+                         }
+                         return static_cast<double>(lhs.rejected) * rhs.tested >
+                             static_cast<double>(rhs.rejected) * lhs.tested;
+                     });
+
+    for (auto&& predicate : _predicates) {
+        predicate.tested = 0;
+        predicate.rejected = 0;
+    }
+    _docsSinceReorder = 0;
+}
+
+}  // namespace mongo
@@ -0,0 +1,107 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/bson/bsonobj.h"
+
+namespace mongo {
+
+class ComparisonMatchExpression;
+class MatchExpression;
+
+/**
+ * Evaluates a conjunction of comparisons ($eq, $lt, $lte, $gt, $gte) on top-level fields, such as
+ * {a: 1, b: {$gt: 5}}, with a single pass over each document instead of one path walk per
+ * predicate. The predicates are re-ordered as documents are matched so that the ones rejecting
+ * the most documents are tried first.
+ *
+ * Gives the same answer as MatchExpression::matchesBSON() on the expression it was compiled from.
+ * A field holding an array, or missing from the document, is handed back to the original
+ * predicate so that array and null semantics are unchanged.
+ *
+ * Not thread-safe: the selectivity counters are updated by matches().
+ */
+class CompiledConjunction {
+    MONGO_DISALLOW_COPYING(CompiledConjunction);
+
+public:
+    /**
+     * Returns nullptr unless 'expr' is a comparison on a top-level field, or an AND whose children
+     * all are. 'expr' must outlive the returned object.
+     */
+    static std::unique_ptr<CompiledConjunction> compile(const MatchExpression* expr);
+
+    /**
+     * Returns true if 'doc' satisfies every predicate of the conjunction.
+     */
+    bool matches(const BSONObj& doc);
+
+    size_t numPredicates() const {
+        return _predicates.size();
+    }
+
+private:
+    // How many documents are matched between re-orderings of '_predicates'.
+    static const uint64_t kReorderInterval = 1024;
+
+    struct Predicate {
+        const ComparisonMatchExpression* expr;
+
+        // Index into '_fields' of the field this predicate tests.
+        size_t field;
+
+        // How many documents this predicate was evaluated on, and how many it rejected, since the
+        // last re-ordering.
+        uint64_t tested = 0;
+        uint64_t rejected = 0;
+    };
+
+    CompiledConjunction() = default;
+
+    void reorder();
+
+    // The distinct top-level field names referenced by the predicates.
+    std::vector<StringData> _fields;
+
+    // The predicates, in the order they are evaluated.
+    std::vector<Predicate> _predicates;
+
+    // Scratch space holding the element found for each of '_fields' in the current document.
+    std::vector<BSONElement> _elements;
+
+    uint64_t _docsSinceReorder = 0;
+};
+
+}  // namespace mongo
@@ -0,0 +1,130 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/matcher/compiled_conjunction.h"
+
+#include "mongo/db/json.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/matcher/extensions_callback_noop.h"
+#include "mongo/db/pipeline/expression_context_for_test.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+std::unique_ptr<MatchExpression> parse(const char* json) {
+    boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    auto expr = unittest::assertGet(MatchExpressionParser::parse(fromjson(json), expCtx));
+    return MatchExpression::optimize(std::move(expr));
+}
+
+/**
+ * Asserts that the compiled form of 'query' agrees with matchesBSON() on each of 'docs'.
+ */
+void assertAgrees(const char* query, const std::vector<BSONObj>& docs) {
+    auto expr = parse(query);
+    auto compiled = CompiledConjunction::compile(expr.get());
+    ASSERT(compiled);
+    for (auto&& doc : docs) {
+        ASSERT_EQ(expr->matchesBSON(doc), compiled->matches(doc)) << query << " on " << doc;
+    }
+}
+
+TEST(CompiledConjunctionTest, CompilesConjunctionOfTopLevelComparisons) {
+    auto expr = parse("{a: 1, b: {$gt: 2, $lte: 10}, c: {$lt: 'x'}}");
+    auto compiled = CompiledConjunction::compile(expr.get());
+    ASSERT(compiled);
+    ASSERT_EQ(compiled->numPredicates(), 4U);
+}
+
+TEST(CompiledConjunctionTest, CompilesSingleComparison) {
+    auto expr = parse("{a: {$gte: 5}}");
+    auto compiled = CompiledConjunction::compile(expr.get());
+    ASSERT(compiled);
+    ASSERT_EQ(compiled->numPredicates(), 1U);
+}
+
+TEST(CompiledConjunctionTest, DoesNotCompileOtherExpressions) {
+    ASSERT_FALSE(CompiledConjunction::compile(nullptr));
+    ASSERT_FALSE(CompiledConjunction::compile(parse("{}").get()));
+    ASSERT_FALSE(CompiledConjunction::compile(parse("{'a.b': 1, c: 1}").get()));
+    ASSERT_FALSE(CompiledConjunction::compile(parse("{a: 1, b: {$in: [1, 2]}}").get()));
+    ASSERT_FALSE(CompiledConjunction::compile(parse("{$or: [{a: 1}, {b: 1}]}").get()));
+    ASSERT_FALSE(CompiledConjunction::compile(parse("{a: 1, b: {$exists: true}}").get()));
+}
+
+TEST(CompiledConjunctionTest, AgreesWithMatchesBSON) {
+    const std::vector<BSONObj> docs = {fromjson("{a: 1, b: 5, c: 'a'}"),
+                                       fromjson("{a: 1, b: 2, c: 'a'}"),
+                                       fromjson("{a: 2, b: 5, c: 'a'}"),
+                                       fromjson("{a: 1, b: 5, c: 'z'}"),
+                                       fromjson("{c: 'a', b: 5, a: 1}"),
+                                       fromjson("{a: 1, b: 5}"),
+                                       fromjson("{a: 1, b: '5', c: 'a'}"),
+                                       fromjson("{a: 1, b: null, c: 'a'}"),
+                                       fromjson("{}")};
+    assertAgrees("{a: 1, b: {$gt: 2, $lte: 10}, c: {$lt: 'x'}}", docs);
+    assertAgrees("{a: {$gte: 1}}", docs);
+    assertAgrees("{b: null, a: 1}", docs);
+}
+
+TEST(CompiledConjunctionTest, ArraysAndMissingFieldsKeepTheirSemantics) {
+    const std::vector<BSONObj> docs = {fromjson("{a: [1, 5], b: 3}"),
+                                       fromjson("{a: [0, 1], b: 3}"),
+                                       fromjson("{a: [[4]], b: 3}"),
+                                       fromjson("{a: [], b: 3}"),
+                                       fromjson("{b: 3}"),
+                                       fromjson("{a: null, b: 3}")};
+    assertAgrees("{a: {$gt: 4}, b: 3}", docs);
+    assertAgrees("{a: [4], b: {$lt: 4}}", docs);
+    assertAgrees("{a: null, b: 3}", docs);
+    assertAgrees("{a: {$lte: []}}", docs);
+}
+
+TEST(CompiledConjunctionTest, FirstOfDuplicateFieldsWins) {
+    BSONObj doc = BSON("a" << 1 << "a" << 2);
+    assertAgrees("{a: 1}", {doc});
+    assertAgrees("{a: 2}", {doc});
+}
+
+TEST(CompiledConjunctionTest, StillCorrectAfterReordering) {
+    auto expr = parse("{a: {$gte: 0}, b: 1}");
+    auto compiled = CompiledConjunction::compile(expr.get());
+    ASSERT(compiled);
+
+    // Only 'b' rejects documents, so it moves ahead of 'a'. Answers must not change.
+    for (int i = 0; i < 5000; ++i) {
+        BSONObj doc = BSON("a" << i % 7 - 3 << "b" << i % 3);
+        ASSERT_EQ(expr->matchesBSON(doc), compiled->matches(doc)) << doc;
+    }
+}
+
+}  // namespace
+}  // namespace mongo
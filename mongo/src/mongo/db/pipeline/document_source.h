@@ -728,6 +728,19 @@ public:
             bool forceInjectMongoProcessInterface = false;
         };
 
+        /**
+         * Describes a foreign collection to a joining stage such as $lookup, so that it can decide
+         * whether to query the collection once per input document or to read it just once.
+         */
+        struct JoinCollectionStats {
+            long long numRecords = 0;
+            long long dataSizeBytes = 0;
+
+            // True if the collection has a btree index, usable under the join's collation, whose
+            // first field is the join field.
+            bool hasJoinFieldIndex = false;
+        };
+
         virtual ~MongoProcessInterface(){};
 
         /**
@@ -776,6 +789,16 @@ public:
         virtual Status appendRecordCount(const NamespaceString& nss,
                                          BSONObjBuilder* builder) const = 0;
 
+        /**
+         * Returns the size of the collection 'nss' and whether it is indexed on 'joinField' under
+         * 'collator'. Returns boost::none if the collection does not exist, is sharded, or its
+         * statistics are not available on this process.
+         */
+        virtual boost::optional<JoinCollectionStats> getJoinCollectionStats(
+            const NamespaceString& nss,
+            const FieldPath& joinField,
+            const CollatorInterface* collator) = 0;
+
         /**
          * Gets the collection options for the collection given by 'nss'.
          */
@@ -39,6 +39,7 @@
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/value.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner_common.h"
 #include "mongo/stdx/memory.h"
 
@@ -48,6 +49,19 @@ using boost::intrusive_ptr;
 
 namespace dps = ::mongo::dotted_path_support;
 
+namespace {
+// The most BSON the frontier values may add to the $in of a single query.
+const int kMaxFrontierQueryBytes = BSONObjMaxUserSize / 2;
+
+/**
+ * Returns how much of 'maxMemoryUsageBytes' the spilled documents may take up in memory before
+ * being written to disk.
+ */
+size_t getSpillBufferBytes(size_t maxMemoryUsageBytes) {
+    return maxMemoryUsageBytes / 4;
+}
+}  // namespace
+
 std::unique_ptr<LiteParsedDocumentSourceForeignCollections> DocumentSourceGraphLookUp::liteParse(
     const AggregationRequest& request, const BSONElement& spec) {
     uassert(ErrorCodes::FailedToParse,
@@ -127,7 +141,7 @@ DocumentSource::GetNextResult DocumentSourceGraphLookUp::getNextUnwound() {
     // If the unwind is not preserving empty arrays, we might have to process multiple inputs before
     // we get one that will produce an output.
     while (true) {
-        if (_visited.empty()) {
+        if (!hasNextDiscovered()) {
             // No results are left for the current input, so we should move on to the next one and
             // perform a new search.
 
@@ -143,7 +157,7 @@ DocumentSource::GetNextResult DocumentSourceGraphLookUp::getNextUnwound() {
         }
         MutableDocument unwound(*_input);
 
-        if (_visited.empty()) {
+        if (!hasNextDiscovered()) {
             if ((*_unwind)->preserveNullAndEmptyArrays()) {
                 // Since "preserveNullAndEmptyArrays" was specified, output a document even though
                 // we had no result.
@@ -157,23 +171,38 @@ DocumentSource::GetNextResult DocumentSourceGraphLookUp::getNextUnwound() {
                 continue;
             }
         } else {
-            auto it = _visited.begin();
-            unwound.setNestedField(_as, Value(it->second));
+            unwound.setNestedField(_as, Value(getNextDiscovered()));
             if (indexPath) {
                 unwound.setNestedField(*indexPath, Value(_outputIndex));
                 ++_outputIndex;
             }
-            _visited.erase(it);
         }
 
         return unwound.freeze();
     }
 }
 
+bool DocumentSourceGraphLookUp::hasNextDiscovered() const {
+    return _spilledOutput ? _spilledOutput->more() : !_visited.empty();
+}
+
+Document DocumentSourceGraphLookUp::getNextDiscovered() {
+    if (_spilledOutput) {
+        return _spilledOutput->next().second;
+    }
+
+    auto it = _visited.begin();
+    Document next = std::move(it->second);
+    _visited.erase(it);
+    return next;
+}
+
 void DocumentSourceGraphLookUp::doDispose() {
     _cache.clear();
     _frontier.clear();
     _visited.clear();
+    _spilledVisited.reset();
+    _spilledOutput.reset();
 }
 
 void DocumentSourceGraphLookUp::doBreadthFirstSearch() {
@@ -184,7 +213,7 @@ void DocumentSourceGraphLookUp::doBreadthFirstSearch() {
 
         // Check whether each key in the frontier exists in the cache or needs to be queried.
         auto cached = pExpCtx->getDocumentComparator().makeUnorderedDocumentSet();
-        auto matchStage = makeMatchStageFromFrontier(&cached);
+        takeCachedFromFrontier(&cached);
 
         ValueUnorderedSet queried = pExpCtx->getValueComparator().makeUnorderedValueSet();
         _frontier.swap(queried);
@@ -199,12 +228,12 @@ void DocumentSourceGraphLookUp::doBreadthFirstSearch() {
             checkMemoryUsage();
         }
 
-        if (matchStage) {
-            // Query for all keys that were in the frontier and not in the cache, populating
-            // '_frontier' for the next iteration of search.
-
+        // Query for all keys that were in the frontier and not in the cache, a batch of keys at a
+        // time, populating '_frontier' for the next iteration of search.
+        ValueUnorderedSet returnedIds = pExpCtx->getValueComparator().makeUnorderedValueSet();
+        for (auto it = queried.cbegin(); it != queried.cend();) {
             // We've already allocated space for the trailing $match stage in '_fromPipeline'.
-            _fromPipeline.back() = *matchStage;
+            _fromPipeline.back() = makeMatchStageFromFrontier(&it, queried.cend());
             auto pipeline =
                 uassertStatusOK(_mongoProcessInterface->makePipeline(_fromPipeline, _fromExpCtx));
             while (auto next = pipeline->getNext()) {
@@ -215,11 +244,20 @@ void DocumentSourceGraphLookUp::doBreadthFirstSearch() {
                             << "' namespace must contain an _id for de-duplication in $graphLookup",
                         !(*next)["_id"].missing());
 
+                // A document may match keys from more than one batch. The first batch to return it
+                // has already visited and cached it under every key in 'queried'.
+                if (!returnedIds.insert((*next)["_id"]).second) {
+                    continue;
+                }
+
                 shouldPerformAnotherQuery =
                     addToVisitedAndFrontier(*next, depth) || shouldPerformAnotherQuery;
                 addToCache(std::move(*next), queried);
+
+                // Check as each document arrives, so that the discovered documents can be spilled
+                // before a single large query takes up too much memory.
+                checkMemoryUsage();
             }
-            checkMemoryUsage();
         }
 
         ++depth;
@@ -255,8 +293,15 @@ bool DocumentSourceGraphLookUp::addToVisitedAndFrontier(Document result, long lo
             _frontierUsageBytes += nextFrontierValue.getApproximateSize();
         });
 
-    // Add the object to our '_visited' list and update the size of '_visited' appropriately.
+    // Add the object to our '_visited' list and update the size of '_visited' appropriately. Once
+    // spilling, only its '_id' is kept in memory.
     _visitedUsageBytes += id.getApproximateSize();
+    if (_spilledVisited) {
+        _spilledVisited->add(Value(_numSpilled++), result);
+        _visited[id] = Document();
+        return true;
+    }
+
     _visitedUsageBytes += result.getApproximateSize();
 
     _visited[id] = std::move(result);
@@ -280,8 +325,7 @@ void DocumentSourceGraphLookUp::addToCache(const Document& result,
         });
 }
 
-boost::optional<BSONObj> DocumentSourceGraphLookUp::makeMatchStageFromFrontier(
-    DocumentUnorderedSet* cached) {
+void DocumentSourceGraphLookUp::takeCachedFromFrontier(DocumentUnorderedSet* cached) {
     // Add any cached values to 'cached' and remove them from '_frontier'.
     for (auto it = _frontier.begin(); it != _frontier.end();) {
         if (auto entry = _cache[*it]) {
@@ -297,6 +341,12 @@ boost::optional<BSONObj> DocumentSourceGraphLookUp::makeMatchStageFromFrontier(
             ++it;
         }
     }
+}
+
+BSONObj DocumentSourceGraphLookUp::makeMatchStageFromFrontier(
+    ValueUnorderedSet::const_iterator* it, ValueUnorderedSet::const_iterator end) {
+    invariant(*it != end);
+    const int batchSize = std::max(1, internalDocumentSourceGraphLookupFrontierBatchSize.load());
 
     // Create a query of the form {$and: [_additionalFilter, {_connectToField: {$in: [...]}}]}.
     //
@@ -317,8 +367,10 @@ boost::optional<BSONObj> DocumentSourceGraphLookUp::makeMatchStageFromFrontier(
                     BSONObjBuilder subObj(connectToObj.subobjStart(_connectToField.fullPath()));
                     {
                         BSONArrayBuilder in(subObj.subarrayStart("$in"));
-                        for (auto&& value : _frontier) {
-                            in << value;
+                        for (int numValues = 0; *it != end && numValues < batchSize &&
+                             in.len() < kMaxFrontierQueryBytes;
+                             ++*it, ++numValues) {
+                            in << **it;
                         }
                     }
                 }
@@ -326,13 +378,16 @@ boost::optional<BSONObj> DocumentSourceGraphLookUp::makeMatchStageFromFrontier(
         }
     }
 
-    return _frontier.empty() ? boost::none : boost::optional<BSONObj>(match.obj());
+    return match.obj();
 }
 
 void DocumentSourceGraphLookUp::performSearch() {
     // Make sure _input is set before calling performSearch().
     invariant(_input);
 
+    _spilledOutput.reset();
+    _numSpilled = 0;
+
     Value startingValue = _startWith->evaluate(*_input);
 
     // If _startWith evaluates to an array, treat each value as a separate starting point.
@@ -347,6 +402,14 @@ void DocumentSourceGraphLookUp::performSearch() {
     }
 
     doBreadthFirstSearch();
+
+    if (_spilledVisited) {
+        // Only the '_id's of the spilled documents remain in '_visited', which were needed just to
+        // de-duplicate the search.
+        _visited.clear();
+        _spilledOutput.reset(_spilledVisited->done());
+        _spilledVisited.reset();
+    }
 }
 
 DocumentSource::GetModPathsReturn DocumentSourceGraphLookUp::getModifiedPaths() const {
@@ -388,11 +451,37 @@ BSONObjSet DocumentSourceGraphLookUp::getOutputSorts() {
 }
 
 void DocumentSourceGraphLookUp::checkMemoryUsage() {
-    // TODO SERVER-23980: Implement spilling to disk if allowDiskUse is specified.
+    // Without a $unwind, the discovered documents all end up in one output document, so they would
+    // be brought back into memory anyway.
+    if (!_spilledVisited && _unwind && pExpCtx->allowDiskUse && !pExpCtx->inMongos &&
+        (_visitedUsageBytes + _frontierUsageBytes) >= _maxMemoryUsageBytes) {
+        spillVisited();
+    }
+
+    // Once spilling, part of the memory allowance is set aside for the documents buffered for the
+    // next write to disk.
+    const size_t maxMemoryUsageBytes = _spilledVisited
+        ? _maxMemoryUsageBytes - getSpillBufferBytes(_maxMemoryUsageBytes)
+        : _maxMemoryUsageBytes;
     uassert(40099,
             "$graphLookup reached maximum memory consumption",
-            (_visitedUsageBytes + _frontierUsageBytes) < _maxMemoryUsageBytes);
-    _cache.evictDownTo(_maxMemoryUsageBytes - _frontierUsageBytes - _visitedUsageBytes);
+            (_visitedUsageBytes + _frontierUsageBytes) < maxMemoryUsageBytes);
+    _cache.evictDownTo(maxMemoryUsageBytes - _frontierUsageBytes - _visitedUsageBytes);
+}
+
+void DocumentSourceGraphLookUp::spillVisited() {
+    SortOptions opts;
+    opts.maxMemoryUsageBytes = getSpillBufferBytes(_maxMemoryUsageBytes);
+    opts.extSortAllowed = true;
+    opts.tempDir = pExpCtx->tempDir;
+    _spilledVisited.reset(SpilledVisited::make(opts, DiscoveryOrderComparator()));
+
+    _visitedUsageBytes = 0;
+    for (auto&& entry : _visited) {
+        _spilledVisited->add(Value(_numSpilled++), entry.second);
+        entry.second = Document();
+        _visitedUsageBytes += entry.first.getApproximateSize();
+    }
 }
 
 void DocumentSourceGraphLookUp::serializeToArray(
@@ -607,3 +696,6 @@ intrusive_ptr<DocumentSource> DocumentSourceGraphLookUp::createFromBson(
     return std::move(newSource);
 }
 }  // namespace mongo
+
+#include "mongo/db/sorter/sorter.cpp"
+// Explicit instantiation unneeded since we aren't exposing Sorter outside of this file.
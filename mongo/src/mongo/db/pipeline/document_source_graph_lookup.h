@@ -33,6 +33,7 @@
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/lookup_set_cache.h"
 #include "mongo/db/pipeline/value_comparator.h"
+#include "mongo/db/sorter/sorter.h"
 
 namespace mongo {
 
@@ -54,10 +55,12 @@ public:
     GetModPathsReturn getModifiedPaths() const final;
 
     StageConstraints constraints(Pipeline::SplitState pipeState) const final {
+        // With an absorbed $unwind, the discovered documents may be spilled to disk.
         StageConstraints constraints(StreamType::kStreaming,
                                      PositionRequirement::kNone,
                                      HostTypeRequirement::kPrimaryShard,
-                                     DiskUseRequirement::kNoDiskUse,
+                                     _unwind ? DiskUseRequirement::kWritesTmpData
+                                             : DiskUseRequirement::kNoDiskUse,
                                      FacetRequirement::kAllowed);
 
         constraints.canSwapWithMatch = true;
@@ -119,16 +122,32 @@ private:
         MONGO_UNREACHABLE;
     }
 
+    using SpilledVisited = Sorter<Value, Document>;
+
+    // For SpilledVisited. Orders documents by the sequence number they were discovered with.
+    class DiscoveryOrderComparator {
+    public:
+        int operator()(const SpilledVisited::Data& lhs, const SpilledVisited::Data& rhs) const {
+            const long long lhsSeq = lhs.first.getLong();
+            const long long rhsSeq = rhs.first.getLong();
+            return lhsSeq < rhsSeq ? -1 : (lhsSeq > rhsSeq ? 1 : 0);
+        }
+    };
+
     /**
-     * Prepares the query to execute on the 'from' collection wrapped in a $match by using the
-     * contents of '_frontier'.
-     *
-     * Fills 'cached' with any values that were retrieved from the cache.
-     *
-     * Returns boost::none if no query is necessary, i.e., all values were retrieved from the cache.
-     * Otherwise, returns a query object.
+     * Removes from '_frontier' every value whose results are cached, and fills 'cached' with those
+     * results.
+     */
+    void takeCachedFromFrontier(DocumentUnorderedSet* cached);
+
+    /**
+     * Prepares the query to execute on the 'from' collection wrapped in a $match, using the
+     * frontier values from '*it' up to 'end'. A query takes at most
+     * 'internalDocumentSourceGraphLookupFrontierBatchSize' values, so that a large frontier is
+     * searched by several queries. Advances '*it' past the values used.
      */
-    boost::optional<BSONObj> makeMatchStageFromFrontier(DocumentUnorderedSet* cached);
+    BSONObj makeMatchStageFromFrontier(ValueUnorderedSet::const_iterator* it,
+                                       ValueUnorderedSet::const_iterator end);
 
     /**
      * If we have internalized a $unwind, getNext() dispatches to this function.
@@ -156,10 +175,24 @@ private:
 
     /**
      * Assert that '_visited' and '_frontier' have not exceeded the maximum meory usage, and then
-     * evict from '_cache' until this source is using less than '_maxMemoryUsageBytes'.
+     * evict from '_cache' until this source is using less than '_maxMemoryUsageBytes'. If they
+     * have exceeded it and the discovered documents may be spilled, spills them first.
      */
     void checkMemoryUsage();
 
+    /**
+     * Moves the documents in '_visited' into '_spilledVisited', leaving only their '_id's in
+     * memory. Every document discovered for the current input from now on is added there too.
+     */
+    void spillVisited();
+
+    /**
+     * Used when a $unwind has been absorbed to return the documents discovered for the current
+     * input one at a time, whether they were spilled or not.
+     */
+    bool hasNextDiscovered() const;
+    Document getNextDiscovered();
+
     /**
      * Process 'result', adding it to '_visited' with the given 'depth', and updating '_frontier'
      * with the object's 'connectTo' values.
@@ -203,6 +236,14 @@ private:
     // to getNext().
     LookupSetCache _cache;
 
+    // Once '_visited' outgrows '_maxMemoryUsageBytes' while a $unwind is absorbed and disk use is
+    // allowed, the discovered documents are added to '_spilledVisited' instead, keyed by discovery
+    // order, and '_visited' maps their '_id's to empty documents. After the search, the documents
+    // are returned from '_spilledOutput'.
+    std::unique_ptr<SpilledVisited> _spilledVisited;
+    std::unique_ptr<SpilledVisited::Iterator> _spilledOutput;
+    long long _numSpilled = 0;
+
     // When we have internalized a $unwind, we must keep track of the input document, since we will
     // need it for multiple "getNext()" calls.
     boost::optional<Document> _input;
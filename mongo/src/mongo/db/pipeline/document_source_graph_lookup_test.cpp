@@ -37,9 +37,11 @@
 #include "mongo/db/pipeline/document_source_mock.h"
 #include "mongo/db/pipeline/document_value_test_util.h"
 #include "mongo/db/pipeline/stub_mongo_process_interface.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
@@ -65,6 +67,7 @@ public:
         const std::vector<BSONObj>& rawPipeline,
         const boost::intrusive_ptr<ExpressionContext>& expCtx,
         const MakePipelineOptions opts) final {
+        ++_numPipelinesMade;
         auto pipeline = Pipeline::parse(rawPipeline, expCtx);
         if (!pipeline.isOK()) {
             return pipeline.getStatus();
@@ -87,8 +90,17 @@ public:
         return Status::OK();
     }
 
+    /**
+     * Returns how many times makePipeline() has been called, that is, how many queries have been
+     * made against the 'from' collection.
+     */
+    int numPipelinesMade() const {
+        return _numPipelinesMade;
+    }
+
 private:
     std::deque<DocumentSource::GetNextResult> _results;
+    int _numPipelinesMade = 0;
 };
 
 TEST_F(DocumentSourceGraphLookUpTest,
@@ -624,5 +636,67 @@ TEST_F(DocumentSourceGraphLookUpTest, ShouldNotExpandArraysWithinArraysAtEndOfCo
     ASSERT(graphLookupStage->getNext().isEOF());
 }
 
+TEST_F(DocumentSourceGraphLookUpTest, ShouldSearchFrontierInBatches) {
+    const int originalBatchSize = internalDocumentSourceGraphLookupFrontierBatchSize.load();
+    internalDocumentSourceGraphLookupFrontierBatchSize.store(1);
+    ON_BLOCK_EXIT(
+        [&] { internalDocumentSourceGraphLookupFrontierBatchSize.store(originalBatchSize); });
+
+    auto expCtx = getExpCtx();
+
+    std::deque<DocumentSource::GetNextResult> inputs{Document{{"_id", 0}, {"startVal", 0}}};
+    auto inputMock = DocumentSourceMock::create(std::move(inputs));
+
+    // The second level of the search has three frontier values, which are each queried for alone.
+    Document startDoc{{"_id", 0}, {"to", std::vector<Value>{Value(1), Value(2), Value(3)}}};
+    Document middle1{{"_id", 1}, {"to", 4}};
+    Document middle2{{"_id", 2}, {"to", 4}};
+    Document middle3{{"_id", 3}, {"to", 4}};
+    Document sinkDoc{{"_id", 4}};
+
+    std::deque<DocumentSource::GetNextResult> fromContents{Document(startDoc),
+                                                           Document(middle1),
+                                                           Document(middle2),
+                                                           Document(middle3),
+                                                           Document(sinkDoc)};
+
+    NamespaceString fromNs("test", "graph_lookup");
+    expCtx->setResolvedNamespace(fromNs, {fromNs, std::vector<BSONObj>{}});
+    auto graphLookupStage =
+        DocumentSourceGraphLookUp::create(expCtx,
+                                          fromNs,
+                                          "results",
+                                          "to",
+                                          "_id",
+                                          ExpressionFieldPath::create(expCtx, "startVal"),
+                                          boost::none,
+                                          boost::none,
+                                          boost::none,
+                                          boost::none);
+    graphLookupStage->setSource(inputMock.get());
+    auto processInterface =
+        std::make_shared<MockMongoProcessInterfaceImplementation>(std::move(fromContents));
+    graphLookupStage->injectMongoProcessInterface(processInterface);
+
+    auto next = graphLookupStage->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+
+    // One query for the start value, one for each of the three values at the second level, and one
+    // for the shared value at the third level.
+    ASSERT_EQ(5, processInterface->numPipelinesMade());
+
+    auto resultsValue = next.getDocument().getField("results");
+    ASSERT(resultsValue.isArray());
+    auto resultsArray = resultsValue.getArray();
+    ASSERT_EQ(5U, resultsArray.size());
+
+    ASSERT(arrayContains(expCtx, resultsArray, Value(startDoc)));
+    ASSERT(arrayContains(expCtx, resultsArray, Value(middle1)));
+    ASSERT(arrayContains(expCtx, resultsArray, Value(middle2)));
+    ASSERT(arrayContains(expCtx, resultsArray, Value(middle3)));
+    ASSERT(arrayContains(expCtx, resultsArray, Value(sinkDoc)));
+    ASSERT(graphLookupStage->getNext().isEOF());
+}
+
 }  // namespace
 }  // namespace mongo
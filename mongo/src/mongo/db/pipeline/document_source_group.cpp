@@ -32,12 +32,14 @@
 #include "mongo/db/pipeline/accumulation_statement.h"
 #include "mongo/db/pipeline/accumulator.h"
 #include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/document_path_support.h"
 #include "mongo/db/pipeline/document_source_group.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/lite_parsed_document_source.h"
 #include "mongo/db/pipeline/value.h"
 #include "mongo/db/pipeline/value_comparator.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/stdx/memory.h"
 
 namespace mongo {
@@ -127,41 +129,56 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNextStandard() {
 }
 
 DocumentSource::GetNextResult DocumentSourceGroup::getNextStreaming() {
-    // Streaming optimization is active.
-    if (!_firstDocOfNextGroup) {
-        auto nextInput = pSource->getNext();
-        if (!nextInput.isAdvanced()) {
-            return nextInput;
+    // Streaming optimization is active. Documents with equal sort keys are adjacent in the input,
+    // so the groups built from them are complete as soon as a document with a different sort key
+    // arrives. One sort key can still cover several groups, e.g. a null and a missing _id field, or
+    // arrays sorted by their smallest element, so they are collected in '_groups' until then.
+    while (true) {
+        if (_flushingGroups) {
+            Document out =
+                makeDocument(groupsIterator->first, groupsIterator->second, pExpCtx->needsMerge);
+            if (++groupsIterator == _groups->end()) {
+                _flushingGroups = false;
+                _groups->clear();
+                _memoryUsageBytes = 0;
+            }
+            return std::move(out);
         }
-        _firstDocOfNextGroup = nextInput.releaseDocument();
-    }
 
-    Value id;
-    do {
-        // Add to the current accumulator(s).
-        for (size_t i = 0; i < _currentAccumulators.size(); i++) {
-            _currentAccumulators[i]->process(
-                _accumulatedFields[i].expression->evaluate(*_firstDocOfNextGroup), _doingMerge);
-        }
+        if (!_firstDocOfNextGroup) {
+            if (_inputExhausted) {
+                return GetNextResult::makeEOF();
+            }
 
-        // Retrieve the next document.
-        auto nextInput = pSource->getNext();
-        if (!nextInput.isAdvanced()) {
-            return nextInput;
+            auto nextInput = pSource->getNext();
+            if (nextInput.isPaused()) {
+                return nextInput;
+            }
+            if (nextInput.isEOF()) {
+                _inputExhausted = true;
+                if (_groups->empty()) {
+                    return nextInput;
+                }
+                _flushingGroups = true;
+                groupsIterator = _groups->begin();
+                continue;
+            }
+            _firstDocOfNextGroup = nextInput.releaseDocument();
         }
 
-        _firstDocOfNextGroup = nextInput.releaseDocument();
-
-
-        // Compute the id. If it does not match _currentId, we will exit the loop, leaving
-        // _firstDocOfNextGroup set for the next time getNext() is called.
-        id = computeId(*_firstDocOfNextGroup);
-    } while (pExpCtx->getValueComparator().evaluate(_currentId == id));
-
-    Document out = makeDocument(_currentId, _currentAccumulators, pExpCtx->needsMerge);
-    _currentId = std::move(id);
+        Value sortKey = computeSortKey(*_firstDocOfNextGroup);
+        if (!_groups->empty() && ValueComparator().evaluate(_currentSortKey != sortKey)) {
+            // The input has moved past every group in '_groups'. Return them, keeping
+            // '_firstDocOfNextGroup' to start the next batch of groups afterwards.
+            _flushingGroups = true;
+            groupsIterator = _groups->begin();
+            continue;
+        }
 
-    return std::move(out);
+        _currentSortKey = std::move(sortKey);
+        processDocument(*_firstDocOfNextGroup);
+        _firstDocOfNextGroup = boost::none;
+    }
 }
 
 void DocumentSourceGroup::doDispose() {
@@ -171,6 +188,8 @@ void DocumentSourceGroup::doDispose() {
 
     // Make us look done.
     groupsIterator = _groups->end();
+    _flushingGroups = false;
+    _inputExhausted = true;
 
     _firstDocOfNextGroup = boost::none;
 }
@@ -453,26 +472,19 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
 
     boost::optional<BSONObj> inputSort = findRelevantInputSort();
     if (inputSort) {
-        // We can convert to streaming.
+        // We can convert to streaming. Documents are only requested from 'pSource' as groups are
+        // returned, in getNextStreaming().
         _streaming = true;
         _inputSort = *inputSort;
 
-        // Set up accumulators.
-        _currentAccumulators.reserve(numAccumulators);
-        for (auto&& accumulatedField : _accumulatedFields) {
-            _currentAccumulators.push_back(accumulatedField.makeAccumulator(pExpCtx));
+        for (auto&& sortField : _inputSort) {
+            _inputSortPaths.emplace_back(sortField.fieldName());
+            _inputSortPathSet.insert(sortField.fieldName());
         }
-
-        // We only need to load the first document.
-        auto firstInput = pSource->getNext();
-        if (!firstInput.isAdvanced()) {
-            // Leave '_firstDocOfNextGroup' uninitialized and return.
-            return firstInput;
+        if (!_inputSort.isEmpty()) {
+            _sortKeyGen.emplace(_inputSort, pExpCtx->getCollator());
         }
-        _firstDocOfNextGroup = firstInput.releaseDocument();
 
-        // Compute the _id value.
-        _currentId = computeId(*_firstDocOfNextGroup);
         _initialized = true;
         return DocumentSource::GetNextResult::makeEOF();
     }
@@ -493,39 +505,7 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
         // We release the result document here so that it does not outlive the end of this loop
         // iteration. Not releasing could lead to an array copy when this group follows an unwind.
         auto rootDocument = input.releaseDocument();
-        Value id = computeId(rootDocument);
-
-        // Look for the _id value in the map. If it's not there, add a new entry with a blank
-        // accumulator. This is done in a somewhat odd way in order to avoid hashing 'id' and
-        // looking it up in '_groups' multiple times.
-        const size_t oldSize = _groups->size();
-        vector<intrusive_ptr<Accumulator>>& group = (*_groups)[id];
-        const bool inserted = _groups->size() != oldSize;
-
-        if (inserted) {
-            _memoryUsageBytes += id.getApproximateSize();
-
-            // Add the accumulators
-            group.reserve(numAccumulators);
-            for (auto&& accumulatedField : _accumulatedFields) {
-                group.push_back(accumulatedField.makeAccumulator(pExpCtx));
-            }
-        } else {
-            for (auto&& groupObj : group) {
-                // subtract old mem usage. New usage added back after processing.
-                _memoryUsageBytes -= groupObj->memUsageForSorter();
-            }
-        }
-
-        /* tickle all the accumulators for the group we found */
-        dassert(numAccumulators == group.size());
-
-        for (size_t i = 0; i < numAccumulators; i++) {
-            group[i]->process(_accumulatedFields[i].expression->evaluate(rootDocument),
-                              _doingMerge);
-
-            _memoryUsageBytes += group[i]->memUsageForSorter();
-        }
+        const bool inserted = processDocument(rootDocument);
 
         if (kDebugBuild && !storageGlobalParams.readOnly) {
             // In debug mode, spill every time we have a duplicate id to stress merge logic.
@@ -582,6 +562,80 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
     MONGO_UNREACHABLE;
 }
 
+bool DocumentSourceGroup::processDocument(const Document& root) {
+    const size_t numAccumulators = _accumulatedFields.size();
+    Value id = computeId(root);
+
+    // Look for the _id value in the map. If it's not there, add a new entry with a blank
+    // accumulator. This is done in a somewhat odd way in order to avoid hashing 'id' and
+    // looking it up in '_groups' multiple times.
+    const size_t oldSize = _groups->size();
+    vector<intrusive_ptr<Accumulator>>& group = (*_groups)[id];
+    const bool inserted = _groups->size() != oldSize;
+
+    if (inserted) {
+        _memoryUsageBytes += id.getApproximateSize();
+
+        // Add the accumulators
+        group.reserve(numAccumulators);
+        for (auto&& accumulatedField : _accumulatedFields) {
+            group.push_back(accumulatedField.makeAccumulator(pExpCtx));
+        }
+    } else {
+        for (auto&& groupObj : group) {
+            // subtract old mem usage. New usage added back after processing.
+            _memoryUsageBytes -= groupObj->memUsageForSorter();
+        }
+    }
+
+    /* tickle all the accumulators for the group we found */
+    dassert(numAccumulators == group.size());
+
+    for (size_t i = 0; i < numAccumulators; i++) {
+        group[i]->process(_accumulatedFields[i].expression->evaluate(root), _doingMerge);
+
+        _memoryUsageBytes += group[i]->memUsageForSorter();
+    }
+
+    return inserted;
+}
+
+Value DocumentSourceGroup::computeSortKey(const Document& root) const {
+    if (_inputSortPaths.empty()) {
+        // The _id is constant, so the whole input forms a single group.
+        return Value();
+    }
+
+    vector<Value> keys;
+    keys.reserve(_inputSortPaths.size());
+
+    // Under the simple collation the sort key of a document without arrays along the sort fields
+    // is just the values of those fields.
+    if (!pExpCtx->getCollator()) {
+        for (auto&& path : _inputSortPaths) {
+            auto key = document_path_support::extractElementAlongNonArrayPath(root, path);
+            if (!key.isOK()) {
+                break;
+            }
+            keys.push_back(key.getValue().nullish() ? Value(BSONNULL) : key.getValue());
+        }
+        if (keys.size() == _inputSortPaths.size()) {
+            return Value(std::move(keys));
+        }
+        keys.clear();
+    }
+
+    // Otherwise generate the key the way $sort and the query system do, which orders an array by
+    // its smallest or largest element and compares strings by their collation keys.
+    auto bsonKey = uassertStatusOK(_sortKeyGen->getSortKey(
+        document_path_support::documentToBsonWithPaths(root, _inputSortPathSet), nullptr));
+    for (auto&& elt : bsonKey) {
+        Value key(elt);
+        keys.push_back(key.nullish() ? Value(BSONNULL) : key);
+    }
+    return Value(std::move(keys));
+}
+
 shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill() {
     vector<const GroupsMap::value_type*> ptrs;  // using pointers to speed sorting
     ptrs.reserve(_groups->size());
@@ -623,9 +677,7 @@ shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill() {
 }
 
 boost::optional<BSONObj> DocumentSourceGroup::findRelevantInputSort() const {
-    if (true) {
-        // Until streaming $group correctly handles nullish values, the streaming behavior is
-        // disabled. See SERVER-23318.
+    if (!internalDocumentSourceGroupStreaming.load()) {
         return boost::none;
     }
 
@@ -708,11 +760,9 @@ BSONObjSet DocumentSourceGroup::getOutputSorts() {
             // We have an expression like {_id: "$a"}. Check if this is a FieldPath, and if it is,
             // get the sort order out of it.
             if (auto obj = dynamic_cast<ExpressionFieldPath*>(_idExpressions[0].get())) {
-                FieldPath _idSort = obj->getFieldPath();
-
-                sortOrder.append(
-                    "_id",
-                    _inputSort.getIntField(_idSort.getFieldName(_idSort.getPathLength() - 1)));
+                // The first component of the path is the variable, usually CURRENT.
+                sortOrder.append("_id",
+                                 _inputSort.getIntField(obj->getFieldPath().tail().fullPath()));
             }
         }
     } else if (_streaming) {
@@ -730,9 +780,7 @@ BSONObjSet DocumentSourceGroup::getOutputSorts() {
                 // _id is an object containing a nested document, such as: {_id: {x: {y: "$b"}}}.
                 getFieldPathMap(obj, "_id." + _idFieldNames[i], &fieldMap);
             } else if (auto fieldPath = dynamic_cast<ExpressionFieldPath*>(exp.get())) {
-                FieldPath _idSort = fieldPath->getFieldPath();
-                fieldMap[_idSort.getFieldName(_idSort.getPathLength() - 1)] =
-                    "_id." + _idFieldNames[i];
+                fieldMap[fieldPath->getFieldPath().tail().fullPath()] = "_id." + _idFieldNames[i];
             }
         }
 
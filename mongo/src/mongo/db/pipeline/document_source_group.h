@@ -29,11 +29,15 @@
 #pragma once
 
 #include <memory>
+#include <set>
+#include <string>
 #include <utility>
 
+#include "mongo/db/index/sort_key_generator.h"
 #include "mongo/db/pipeline/accumulation_statement.h"
 #include "mongo/db/pipeline/accumulator.h"
 #include "mongo/db/pipeline/document_source.h"
+#include "mongo/db/pipeline/field_path.h"
 #include "mongo/db/sorter/sorter.h"
 
 namespace mongo {
@@ -126,9 +130,9 @@ private:
 
     /**
      * Before returning anything, this source must prepare itself. In a streaming $group,
-     * initialize() requests the first document from the previous source, and uses it to prepare the
-     * accumulators. In an unsorted $group, initialize() exhausts the previous source before
-     * returning. The '_initialized' boolean indicates that initialize() has finished.
+     * initialize() only records the input sort order, and documents are pulled as groups are
+     * returned. In an unsorted $group, initialize() exhausts the previous source before returning.
+     * The '_initialized' boolean indicates that initialize() has finished.
      *
      * This method may not be able to finish initialization in a single call if 'pSource' returns a
      * DocumentSource::GetNextResult::kPauseExecution, so it returns the last GetNextResult
@@ -145,6 +149,19 @@ private:
 
     Document makeDocument(const Value& id, const Accumulators& accums, bool mergeableOutput);
 
+    /**
+     * Adds 'root' to the group it belongs to in '_groups', creating the group if necessary. Returns
+     * true if a new group was created.
+     */
+    bool processDocument(const Document& root);
+
+    /**
+     * Computes the key that the input of a streaming $group is ordered by: the values of the
+     * '_inputSort' fields, extracted the same way $sort would extract them, with nullish values
+     * collapsed into null. All documents with equal keys are adjacent in the input.
+     */
+    Value computeSortKey(const Document& root) const;
+
     /**
      * Computes the internal representation of the group key.
      */
@@ -168,6 +185,18 @@ private:
     bool _streaming;
     bool _initialized;
 
+    // Only used when '_streaming' is true. The fields of '_inputSort', and a generator used to
+    // compute the sort key of documents which have an array along one of those fields.
+    std::vector<FieldPath> _inputSortPaths;
+    std::set<std::string> _inputSortPathSet;
+    boost::optional<SortKeyGenerator> _sortKeyGen;
+
+    // Only used when '_streaming' is true. The sort key shared by every document in '_groups',
+    // whether '_groups' is currently being returned, and whether 'pSource' has been exhausted.
+    Value _currentSortKey;
+    bool _flushingGroups = false;
+    bool _inputExhausted = false;
+
     Value _currentId;
     Accumulators _currentAccumulators;
 
@@ -187,7 +216,8 @@ private:
     const bool _allowDiskUse;
 
     std::pair<Value, Value> _firstPartOfNextGroup;
-    // Only used when '_sorted' is true.
+    // Only used when '_streaming' is true. Holds the first document with a new sort key until the
+    // groups for the previous sort key have been returned.
     boost::optional<Document> _firstDocOfNextGroup;
 };
 
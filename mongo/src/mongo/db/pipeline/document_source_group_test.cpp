@@ -189,6 +189,38 @@ TEST_F(DocumentSourceGroupTest, ShouldCorrectlyTrackMemoryUsageBetweenPauses) {
     ASSERT_THROWS_CODE(group->getNext(), AssertionException, 16945);
 }
 
+TEST_F(DocumentSourceGroupTest, ShouldBeAbleToPauseWhileStreaming) {
+    auto expCtx = getExpCtx();
+    AccumulationStatement countStatement{"count",
+                                         ExpressionConstant::create(expCtx, Value(1)),
+                                         AccumulationStatement::getFactory("$sum")};
+    VariablesParseState vps = expCtx->variablesParseState;
+    auto group = DocumentSourceGroup::create(
+        expCtx, ExpressionFieldPath::parse(expCtx, "$a", vps), {countStatement});
+    auto mock = DocumentSourceMock::create({Document{{"a", 1}},
+                                            DocumentSource::GetNextResult::makePauseExecution(),
+                                            Document{{"a", 1}},
+                                            Document{{"a", 2}},
+                                            DocumentSource::GetNextResult::makePauseExecution()});
+    mock->sorts = {BSON("a" << 1)};
+    group->setSource(mock.get());
+
+    // The pause in the middle of the first group should not lose or repeat any documents.
+    ASSERT_TRUE(group->getNext().isPaused());
+    ASSERT_TRUE(group->isStreaming());
+    auto result = group->getNext();
+    ASSERT_TRUE(result.isAdvanced());
+    ASSERT_DOCUMENT_EQ(result.releaseDocument(), (Document{{"_id", 1}, {"count", 2}}));
+
+    // The last group can't be returned until the input is known to be exhausted.
+    ASSERT_TRUE(group->getNext().isPaused());
+    result = group->getNext();
+    ASSERT_TRUE(result.isAdvanced());
+    ASSERT_DOCUMENT_EQ(result.releaseDocument(), (Document{{"_id", 2}, {"count", 1}}));
+    ASSERT_TRUE(group->getNext().isEOF());
+    ASSERT_TRUE(group->getNext().isEOF());
+}
+
 BSONObj toBson(const intrusive_ptr<DocumentSource>& source) {
     vector<Value> arr;
     source->serializeToArray(arr);
@@ -1005,6 +1037,77 @@ public:
     }
 };
 
+class StreamingWithNullishValues : public Base {
+public:
+    void run() {
+        auto source = DocumentSourceMock::create(
+            {"{a: null, b: 1}", "{b: 1}", "{a: null, b: 1}", "{a: 1, b: 1}", "{a: 1, b: 1}"});
+        source->sorts = {BSON("a" << 1 << "b" << 1)};
+
+        createGroup(fromjson("{_id: {x: '$a', y: '$b'}, count: {$sum: 1}}"));
+        group()->setSource(source.get());
+
+        // A null and a missing 'a' are sorted together, so both groups are returned, in either
+        // order, before the group for 'a: 1'.
+        auto first = group()->getNext();
+        ASSERT_TRUE(first.isAdvanced());
+        ASSERT_TRUE(group()->isStreaming());
+        auto second = group()->getNext();
+        ASSERT_TRUE(second.isAdvanced());
+
+        Document nullGroup = first.getDocument();
+        Document missingGroup = second.getDocument();
+        if (nullGroup["_id"]["x"].missing()) {
+            std::swap(nullGroup, missingGroup);
+        }
+        ASSERT_VALUE_EQ(nullGroup["_id"]["x"], Value(BSONNULL));
+        ASSERT_VALUE_EQ(nullGroup["count"], Value(2));
+        ASSERT_TRUE(missingGroup["_id"]["x"].missing());
+        ASSERT_VALUE_EQ(missingGroup["count"], Value(1));
+
+        auto res = group()->getNext();
+        ASSERT_TRUE(res.isAdvanced());
+        ASSERT_DOCUMENT_EQ(res.getDocument(), Document(fromjson("{_id: {x: 1, y: 1}, count: 2}")));
+
+        assertEOF(group());
+    }
+};
+
+class StreamingWithArrayValues : public Base {
+public:
+    void run() {
+        // $sort orders an array by its smallest element, so arrays can be interleaved with the
+        // scalars they tie with.
+        auto source = DocumentSourceMock::create(
+            {"{a: [1, 5]}", "{a: 1}", "{a: [1, 5]}", "{a: [2]}", "{a: 2}", "{a: [2]}"});
+        source->sorts = {BSON("a" << 1)};
+
+        createGroup(fromjson("{_id: '$a', count: {$sum: 1}}"));
+        group()->setSource(source.get());
+
+        std::vector<Document> results;
+        for (auto res = group()->getNext(); res.isAdvanced(); res = group()->getNext()) {
+            results.push_back(res.releaseDocument());
+        }
+        ASSERT_TRUE(group()->isStreaming());
+
+        // Each distinct _id is returned exactly once.
+        ASSERT_EQUALS(results.size(), 4U);
+        auto countFor = [&](const Value& id) {
+            for (auto&& result : results) {
+                if (ValueComparator().evaluate(result["_id"] == id)) {
+                    return result["count"];
+                }
+            }
+            return Value();
+        };
+        ASSERT_VALUE_EQ(countFor(Value(BSON_ARRAY(1 << 5))), Value(2));
+        ASSERT_VALUE_EQ(countFor(Value(1)), Value(1));
+        ASSERT_VALUE_EQ(countFor(Value(BSON_ARRAY(2))), Value(2));
+        ASSERT_VALUE_EQ(countFor(Value(2)), Value(1));
+    }
+};
+
 class NoOptimizationIfMissingDoubleSort : public Base {
 public:
     void run() {
@@ -1118,6 +1221,51 @@ public:
     }
 };
 
+class StreamingWithDottedIdFieldPath : public Base {
+public:
+    void run() {
+        auto source = DocumentSourceMock::create(
+            {"{a: {b: 3}}", "{a: {b: 2}}", "{a: {b: 2}}", "{a: {b: 1}}"});
+        source->sorts = {BSON("a.b" << -1)};
+
+        createGroup(fromjson("{_id: '$a.b'}"));
+        group()->setSource(source.get());
+
+        group()->getNext();
+        ASSERT_TRUE(group()->isStreaming());
+
+        BSONObjSet outputSort = group()->getOutputSorts();
+        ASSERT_EQUALS(outputSort.size(), 1U);
+
+        BSONObj correctSort = fromjson("{_id: -1}");
+        ASSERT_EQUALS(outputSort.count(correctSort), 1U);
+    }
+};
+
+class StreamingWithDottedTopLevelIdFields : public Base {
+public:
+    void run() {
+        auto source = DocumentSourceMock::create(
+            {"{a: {b: 1}, c: {d: 1}}", "{a: {b: 1}, c: {d: 2}}", "{a: {b: 2}, c: {d: 1}}"});
+        source->sorts = {BSON("a.b" << 1 << "c.d" << -1)};
+
+        createGroup(fromjson("{_id: {x: '$a.b', y: '$c.d'}}"));
+        group()->setSource(source.get());
+
+        group()->getNext();
+        ASSERT_TRUE(group()->isStreaming());
+
+        BSONObjSet outputSort = group()->getOutputSorts();
+        ASSERT_EQUALS(outputSort.size(), 2U);
+
+        BSONObj correctSort = fromjson("{'_id.x': 1, '_id.y': -1}");
+        ASSERT_EQUALS(outputSort.count(correctSort), 1U);
+
+        BSONObj prefixSort = fromjson("{'_id.x': 1}");
+        ASSERT_EQUALS(outputSort.count(prefixSort), 1U);
+    }
+};
+
 class All : public Suite {
 public:
     All() : Suite("DocumentSourceGroupTests") {}
@@ -1157,8 +1305,6 @@ public:
         add<Dependencies>();
         add<StringConstantIdAndAccumulatorExpressions>();
         add<ArrayConstantAccumulatorExpression>();
-#if 0
-        // Disabled tests until SERVER-23318 is implemented.
         add<StreamingOptimization>();
         add<StreamingWithMultipleIdFields>();
         add<NoOptimizationIfMissingDoubleSort>();
@@ -1168,9 +1314,12 @@ public:
         add<StreamingWithConstant>();
         add<StreamingWithEmptyId>();
         add<StreamingWithRootSubfield>();
+        add<StreamingWithDottedIdFieldPath>();
+        add<StreamingWithDottedTopLevelIdFields>();
         add<StreamingWithConstantAndFieldPath>();
         add<StreamingWithFieldRepeated>();
-#endif
+        add<StreamingWithNullishValues>();
+        add<StreamingWithArrayValues>();
     }
 };
 
@@ -30,6 +30,8 @@
 
 #include "mongo/db/pipeline/document_source_lookup.h"
 
+#include <algorithm>
+
 #include "mongo/base/init.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression_algo.h"
@@ -40,6 +42,7 @@
 #include "mongo/db/pipeline/value.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/stdx/memory.h"
+#include "mongo/util/stringutils.h"
 
 namespace mongo {
 
@@ -63,6 +66,40 @@ std::string pipelineToString(const vector<BSONObj>& pipeline) {
     sb << "]";
     return sb.str();
 }
+
+/**
+ * Returns true if the documents joining with local value 'joinValue' are exactly those holding a
+ * value equal to it at the foreignField path. Null, missing and undefined values also join with
+ * foreign documents lacking the field, arrays can match a foreign array as a whole, and regular
+ * expressions are left to the query system, so none of these are hashed.
+ */
+bool isHashJoinValue(const Value& joinValue) {
+    switch (joinValue.getType()) {
+        case BSONType::jstNULL:
+        case BSONType::Undefined:
+        case BSONType::EOO:
+        case BSONType::Array:
+        case BSONType::RegEx:
+            return false;
+        default:
+            return true;
+    }
+}
+
+// The most BSON a batch of local values may add to the $in of a batched foreign query.
+const int kMaxBatchedJoinValueBytes = BSONObjMaxUserSize / 2;
+
+/**
+ * Returns true if 'path' has a component which the query system could treat as an array position.
+ */
+bool hasNumericPathComponent(const FieldPath& path) {
+    for (size_t i = 0; i < path.getPathLength(); ++i) {
+        if (parseUnsignedBase10Integer(path.getFieldName(i))) {
+            return true;
+        }
+    }
+    return false;
+}
 }  // namespace
 
 constexpr size_t DocumentSourceLookUp::kMaxSubPipelineDepth;
@@ -210,7 +247,8 @@ DocumentSource::GetNextResult DocumentSourceLookUp::getNext() {
         return unwindResult();
     }
 
-    auto nextInput = pSource->getNext();
+    boost::optional<std::vector<Value>> knownMatches;
+    auto nextInput = getNextInput(&knownMatches);
     if (!nextInput.isAdvanced()) {
         return nextInput;
     }
@@ -221,27 +259,43 @@ DocumentSource::GetNextResult DocumentSourceLookUp::getNext() {
     // '_unwindSrc' would be non-null, and we would not have made it here.
     invariant(!_matchSrc);
 
-    if (!wasConstructedWithPipelineSyntax()) {
-        auto matchStage =
-            makeMatchStageFromInput(inputDoc, *_localField, _foreignField->fullPath(), BSONObj());
-        // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
-        _resolvedPipeline.back() = matchStage;
-    }
-
-    auto pipeline = buildPipeline(inputDoc);
-
     std::vector<Value> results;
     int objsize = 0;
 
-    while (auto result = pipeline->getNext()) {
-        objsize += result->getApproximateSize();
-        uassert(4568,
-                str::stream() << "Total size of documents in " << _fromNs.coll()
-                              << " matching pipeline "
-                              << getUserPipelineDefinition()
-                              << " exceeds maximum document size",
-                objsize <= BSONObjMaxInternalSize);
-        results.emplace_back(std::move(*result));
+    if (knownMatches) {
+        for (auto&& match : *knownMatches) {
+            objsize += match.getApproximateSize();
+            uassert(4568,
+                    str::stream() << "Total size of documents in " << _fromNs.coll()
+                                  << " matching "
+                                  << makeMatchStageFromInput(inputDoc,
+                                                             *_localField,
+                                                             _foreignField->fullPath(),
+                                                             BSONObj())
+                                  << " exceeds maximum document size",
+                    objsize <= BSONObjMaxInternalSize);
+        }
+        results = std::move(*knownMatches);
+    } else {
+        if (!wasConstructedWithPipelineSyntax()) {
+            auto matchStage = makeMatchStageFromInput(
+                inputDoc, *_localField, _foreignField->fullPath(), BSONObj());
+            // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
+            _resolvedPipeline.back() = matchStage;
+        }
+
+        auto pipeline = buildPipeline(inputDoc);
+
+        while (auto result = pipeline->getNext()) {
+            objsize += result->getApproximateSize();
+            uassert(4568,
+                    str::stream() << "Total size of documents in " << _fromNs.coll()
+                                  << " matching pipeline "
+                                  << getUserPipelineDefinition()
+                                  << " exceeds maximum document size",
+                    objsize <= BSONObjMaxInternalSize);
+            results.emplace_back(std::move(*result));
+        }
     }
 
     MutableDocument output(std::move(inputDoc));
@@ -436,6 +490,174 @@ void DocumentSourceLookUp::doDispose() {
         _pipeline->dispose(pExpCtx->opCtx);
         _pipeline.reset();
     }
+    _hashTable.reset();
+    _hashTableBytes = 0;
+    _foreignDocs.clear();
+    _firstInput = boost::none;
+    _inputBatch.clear();
+    _knownMatches.clear();
+}
+
+// static
+StringData DocumentSourceLookUp::joinStrategyName(JoinStrategy strategy) {
+    switch (strategy) {
+        case JoinStrategy::kQueryPerInput:
+            return "queryPerInput"_sd;
+        case JoinStrategy::kBatchedQuery:
+            return "batchedQuery"_sd;
+        case JoinStrategy::kHashJoin:
+            return "hashJoin"_sd;
+    }
+    MONGO_UNREACHABLE;
+}
+
+DocumentSourceLookUp::JoinStrategy DocumentSourceLookUp::pickJoinStrategy() const {
+    // Views and positional foreignField paths are left to the query system.
+    if (wasConstructedWithPipelineSyntax() || _resolvedPipeline.size() != 1 ||
+        hasNumericPathComponent(*_foreignField)) {
+        return JoinStrategy::kQueryPerInput;
+    }
+
+    const int maxBytes = internalDocumentSourceLookupHashJoinMaxBytes.load();
+    bool canHashJoin = internalDocumentSourceLookupHashJoin.load() && maxBytes > 0;
+
+    // A $lookup inside another $lookup's pipeline is rebuilt for every outer document, so a hash
+    // table would be rebuilt just as often.
+    if (pExpCtx->subPipelineDepth > 0) {
+        canHashJoin = false;
+    }
+
+    if (canHashJoin) {
+        auto stats = _mongoProcessInterface->getJoinCollectionStats(
+            _resolvedNs, *_foreignField, _fromExpCtx->getCollator());
+
+        // An index on the foreign field answers each input document with a few index probes,
+        // which beats reading the whole collection unless it is small.
+        if (stats && stats->dataSizeBytes <= maxBytes &&
+            (!stats->hasJoinFieldIndex ||
+             stats->numRecords <= internalDocumentSourceLookupHashJoinMaxIndexedDocs.load())) {
+            return JoinStrategy::kHashJoin;
+        }
+    }
+
+    // Otherwise query the foreign collection once for each batch of input documents.
+    return internalDocumentSourceLookupBatchSize.load() > 1 ? JoinStrategy::kBatchedQuery
+                                                            : JoinStrategy::kQueryPerInput;
+}
+
+void DocumentSourceLookUp::startJoin() {
+    _joinStrategy = pickJoinStrategy();
+    if (JoinStrategy::kHashJoin == *_joinStrategy) {
+        buildHashTable(static_cast<size_t>(
+            std::max(0, internalDocumentSourceLookupHashJoinMaxBytes.load())));
+        if (_hashTable) {
+            return;
+        }
+
+        // The collection outgrew its statistics. Join by querying it instead.
+        _joinStrategy = internalDocumentSourceLookupBatchSize.load() > 1
+            ? JoinStrategy::kBatchedQuery
+            : JoinStrategy::kQueryPerInput;
+    }
+
+    if (JoinStrategy::kBatchedQuery == *_joinStrategy) {
+        _inputBatchSize =
+            static_cast<size_t>(std::max(1, internalDocumentSourceLookupBatchSize.load()));
+    }
+}
+
+DocumentSource::GetNextResult DocumentSourceLookUp::getNextSourceInput() {
+    if (_firstInput) {
+        Document firstInput = std::move(*_firstInput);
+        _firstInput = boost::none;
+        return std::move(firstInput);
+    }
+    return pSource->getNext();
+}
+
+void DocumentSourceLookUp::buildHashTable(size_t maxBytes) {
+    auto pipeline = uassertStatusOK(_mongoProcessInterface->makePipeline(
+        {BSON("$match" << _additionalFilter.value_or(BSONObj()))}, _fromExpCtx));
+
+    _hashTable.emplace(
+        _fromExpCtx->getValueComparator().makeUnorderedValueMap<std::vector<size_t>>());
+
+    _hashTableBytes = 0;
+    while (auto foreignDoc = pipeline->getNext()) {
+        const size_t position = _foreignDocs.size();
+        bool hashed = false;
+        document_path_support::visitAllValuesAtPath(
+            *foreignDoc, *_foreignField, [&](const Value& joinValue) {
+                if (!isHashJoinValue(joinValue)) {
+                    return;
+                }
+                auto& positions = (*_hashTable)[joinValue];
+                if (positions.empty()) {
+                    // The value was not in the table yet.
+                    _hashTableBytes += joinValue.getApproximateSize() + sizeof(positions);
+                }
+                // A document holding the same value more than once is recorded only once.
+                if (positions.empty() || positions.back() != position) {
+                    positions.push_back(position);
+                    _hashTableBytes += sizeof(size_t);
+                }
+                hashed = true;
+            });
+
+        // Documents without a hashable foreign value can only be found by querying.
+        if (!hashed) {
+            continue;
+        }
+
+        _hashTableBytes += foreignDoc->getApproximateSize();
+        if (_hashTableBytes > maxBytes) {
+            _hashTable.reset();
+            _hashTableBytes = 0;
+            _foreignDocs = std::vector<Document>();
+            return;
+        }
+        _foreignDocs.push_back(std::move(*foreignDoc));
+    }
+}
+
+boost::optional<std::vector<Value>> DocumentSourceLookUp::probeHashTable(
+    const Document& inputDoc) {
+    if (!_hashTable) {
+        return boost::none;
+    }
+
+    std::vector<size_t> positions;
+    size_t numJoinValues = 0;
+    bool canProbe = true;
+    document_path_support::visitAllValuesAtPath(
+        inputDoc, *_localField, [&](const Value& joinValue) {
+            ++numJoinValues;
+            if (!canProbe || !isHashJoinValue(joinValue)) {
+                canProbe = false;
+                return;
+            }
+            auto it = _hashTable->find(joinValue);
+            if (it != _hashTable->end()) {
+                positions.insert(positions.end(), it->second.begin(), it->second.end());
+            }
+        });
+
+    // A missing local value is treated as null, which the table does not hold.
+    if (!canProbe || numJoinValues == 0) {
+        return boost::none;
+    }
+
+    if (numJoinValues > 1) {
+        std::sort(positions.begin(), positions.end());
+        positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+    }
+
+    std::vector<Value> matches;
+    matches.reserve(positions.size());
+    for (auto position : positions) {
+        matches.emplace_back(_foreignDocs[position]);
+    }
+    return matches;
 }
 
 BSONObj DocumentSourceLookUp::makeMatchStageFromInput(const Document& input,
@@ -528,35 +750,45 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
     // Loop until we get a document that has at least one match.
     // Note we may return early from this loop if our source stage is exhausted or if the unwind
     // source was asked to return empty arrays and we get a document without a match.
-    while (!_pipeline || !_nextValue) {
-        auto nextInput = pSource->getNext();
+    while (!_nextValue) {
+        boost::optional<std::vector<Value>> knownMatches;
+        auto nextInput = getNextInput(&knownMatches);
         if (!nextInput.isAdvanced()) {
             return nextInput;
         }
 
         _input = nextInput.releaseDocument();
 
-        if (!wasConstructedWithPipelineSyntax()) {
-            BSONObj filter = _additionalFilter.value_or(BSONObj());
-            auto matchStage =
-                makeMatchStageFromInput(*_input, *_localField, _foreignField->fullPath(), filter);
-            // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
-            _resolvedPipeline.back() = matchStage;
-        }
-
         if (_pipeline) {
             _pipeline->dispose(pExpCtx->opCtx);
+            _pipeline.reset();
         }
 
-        _pipeline = buildPipeline(*_input);
+        if (knownMatches) {
+            _knownMatches = std::move(*knownMatches);
+        } else {
+            _knownMatches.clear();
+
+            if (!wasConstructedWithPipelineSyntax()) {
+                BSONObj filter = _additionalFilter.value_or(BSONObj());
+                auto matchStage = makeMatchStageFromInput(
+                    *_input, *_localField, _foreignField->fullPath(), filter);
+                // We've already allocated space for the trailing $match stage in
+                // '_resolvedPipeline'.
+                _resolvedPipeline.back() = matchStage;
+            }
 
-        // The $lookup stage takes responsibility for disposing of its Pipeline, since it will
-        // potentially be used by multiple OperationContexts, and the $lookup stage is part of an
-        // outer Pipeline that will propagate dispose() calls before being destroyed.
-        _pipeline.get_deleter().dismissDisposal();
+            _pipeline = buildPipeline(*_input);
 
+            // The $lookup stage takes responsibility for disposing of its Pipeline, since it will
+            // potentially be used by multiple OperationContexts, and the $lookup stage is part of
+            // an outer Pipeline that will propagate dispose() calls before being destroyed.
+            _pipeline.get_deleter().dismissDisposal();
+        }
+
+        _knownMatchIndex = 0;
         _cursorIndex = 0;
-        _nextValue = _pipeline->getNext();
+        _nextValue = getNextUnwindMatch();
 
         if (_unwindSrc->preserveNullAndEmptyArrays() && !_nextValue) {
             // There were no results for this cursor, but the $unwind was asked to preserve empty
@@ -574,7 +806,7 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
 
     invariant(bool(_input) && bool(_nextValue));
     auto currentValue = *_nextValue;
-    _nextValue = _pipeline->getNext();
+    _nextValue = getNextUnwindMatch();
 
     // Move input document into output if this is the last or only result, otherwise perform a copy.
     MutableDocument output(_nextValue ? *_input : std::move(*_input));
@@ -588,6 +820,145 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
     return output.freeze();
 }
 
+DocumentSource::GetNextResult DocumentSourceLookUp::getNextInput(
+    boost::optional<std::vector<Value>>* knownMatches) {
+    if (!_joinStrategy) {
+        // Nothing is read from the foreign collection until there is an input document to join.
+        auto firstInput = pSource->getNext();
+        if (!firstInput.isAdvanced()) {
+            return firstInput;
+        }
+        _firstInput = firstInput.releaseDocument();
+        startJoin();
+    }
+
+    if (_inputBatchSize <= 1) {
+        auto nextInput = getNextSourceInput();
+        *knownMatches =
+            nextInput.isAdvanced() ? probeHashTable(nextInput.getDocument()) : boost::none;
+        return nextInput;
+    }
+
+    if (_inputBatch.empty() && !_inputBatchEnd) {
+        fillInputBatch();
+    }
+
+    if (_inputBatch.empty()) {
+        auto batchEnd = std::move(*_inputBatchEnd);
+        _inputBatchEnd = boost::none;
+        return batchEnd;
+    }
+
+    auto next = std::move(_inputBatch.front());
+    _inputBatch.pop_front();
+    *knownMatches = std::move(next.matches);
+    return std::move(next.doc);
+}
+
+void DocumentSourceLookUp::fillInputBatch() {
+    invariant(_inputBatch.empty());
+
+    // Maps each local value in the batch to the positions in '_inputBatch' of the documents
+    // holding it.
+    auto joiningInputs =
+        _fromExpCtx->getValueComparator().makeUnorderedValueMap<std::vector<size_t>>();
+    BSONArrayBuilder joinValues;
+
+    while (_inputBatch.size() < _inputBatchSize && joinValues.len() < kMaxBatchedJoinValueBytes) {
+        auto nextInput = getNextSourceInput();
+        if (!nextInput.isAdvanced()) {
+            _inputBatchEnd = std::move(nextInput);
+            break;
+        }
+
+        const size_t position = _inputBatch.size();
+        _inputBatch.push_back({nextInput.releaseDocument(), boost::none});
+
+        std::vector<Value> localValues;
+        bool canBatch = true;
+        document_path_support::visitAllValuesAtPath(
+            _inputBatch.back().doc, *_localField, [&](const Value& joinValue) {
+                if (!isHashJoinValue(joinValue)) {
+                    canBatch = false;
+                } else if (canBatch) {
+                    localValues.push_back(joinValue);
+                }
+            });
+
+        // Documents with a local value that is not a plain equality, including a missing one, are
+        // joined by their own query.
+        if (!canBatch || localValues.empty()) {
+            continue;
+        }
+
+        _inputBatch.back().matches.emplace();
+        for (auto&& joinValue : localValues) {
+            auto& positions = joiningInputs[joinValue];
+            if (positions.empty()) {
+                joinValues << joinValue;
+            }
+            if (positions.empty() || positions.back() != position) {
+                positions.push_back(position);
+            }
+        }
+    }
+
+    if (joiningInputs.empty()) {
+        return;
+    }
+
+    // {$match: {$and: [{<foreignField>: {$in: [<value>, <value>, ...]}}, <additionalFilter>]}}
+    _resolvedPipeline.back() = BSON(
+        "$match" << BSON("$and" << BSON_ARRAY(
+                             BSON(_foreignField->fullPath() << BSON("$in" << joinValues.arr()))
+                             << _additionalFilter.value_or(BSONObj()))));
+
+    auto pipeline = buildPipeline(_inputBatch.front().doc);
+
+    // The position plus one of the last foreign document added to each input's matches, so that a
+    // foreign document joining through several local values is added once.
+    std::vector<size_t> lastMatch(_inputBatch.size(), 0);
+    size_t numMatches = 0;
+    int objsize = 0;
+    while (auto result = pipeline->getNext()) {
+        objsize += result->getApproximateSize();
+        if (objsize > BSONObjMaxInternalSize) {
+            // The batch joins with more data than a single document could. Join each of its
+            // documents by its own query, which enforces the limit per document.
+            for (auto&& input : _inputBatch) {
+                input.matches = boost::none;
+            }
+            return;
+        }
+
+        ++numMatches;
+        const Value foreignDoc(std::move(*result));
+        document_path_support::visitAllValuesAtPath(
+            foreignDoc.getDocument(), *_foreignField, [&](const Value& joinValue) {
+                auto it = joiningInputs.find(joinValue);
+                if (it == joiningInputs.end()) {
+                    return;
+                }
+                for (auto position : it->second) {
+                    if (lastMatch[position] != numMatches) {
+                        lastMatch[position] = numMatches;
+                        _inputBatch[position].matches->push_back(foreignDoc);
+                    }
+                }
+            });
+    }
+}
+
+boost::optional<Document> DocumentSourceLookUp::getNextUnwindMatch() {
+    if (_pipeline) {
+        return _pipeline->getNext();
+    }
+    if (_knownMatchIndex < _knownMatches.size()) {
+        return _knownMatches[_knownMatchIndex++].getDocument();
+    }
+    return boost::none;
+}
+
 void DocumentSourceLookUp::copyVariablesToExpCtx(const Variables& vars,
                                                  const VariablesParseState& vps,
                                                  ExpressionContext* expCtx) {
@@ -665,6 +1036,13 @@ void DocumentSourceLookUp::serializeToArray(
             output[getSourceName()]["matching"] = Value(*_additionalFilter);
         }
 
+        // The strategy is only settled once the first input document is read. Until then, report
+        // the one the statistics of the foreign collection point to.
+        if (_joinStrategy || _mongoProcessInterface) {
+            const JoinStrategy strategy = _joinStrategy ? *_joinStrategy : pickJoinStrategy();
+            output[getSourceName()]["joinStrategy"] = Value(joinStrategyName(strategy));
+        }
+
         array.push_back(Value(output.freeze()));
     } else {
         array.push_back(Value(output.freeze()));
@@ -29,6 +29,7 @@
 #pragma once
 
 #include <boost/optional.hpp>
+#include <deque>
 
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/document_source_match.h"
@@ -244,6 +245,73 @@ private:
 
     GetNextResult unwindResult();
 
+    /**
+     * Returns the next foreign document joining with '_input' when '_unwindSrc' is not null, or
+     * boost::none once they have all been returned.
+     */
+    boost::optional<Document> getNextUnwindMatch();
+
+    /**
+     * Returns the next input document. If the foreign documents joining with it are already known,
+     * from '_hashTable' or from a batched query, stores them in 'knownMatches'. Otherwise sets
+     * 'knownMatches' to boost::none, and the foreign collection must be queried for the document.
+     */
+    GetNextResult getNextInput(boost::optional<std::vector<Value>>* knownMatches);
+
+    /**
+     * Reads up to '_inputBatchSize' input documents into '_inputBatch', and joins all those with
+     * plain equality local values through a single $in query on the foreign collection. Stops
+     * early at a pause or EOF from the source, which is saved in '_inputBatchEnd' to be returned
+     * once the batch has been consumed.
+     */
+    void fillInputBatch();
+
+    /**
+     * How input documents are joined with the foreign collection.
+     */
+    enum class JoinStrategy {
+        // Run the foreign pipeline once per input document.
+        kQueryPerInput,
+        // Join each batch of input documents through one $in query on the foreign collection.
+        kBatchedQuery,
+        // Read the foreign collection just once into '_hashTable'.
+        kHashJoin,
+    };
+
+    static StringData joinStrategyName(JoinStrategy strategy);
+
+    /**
+     * Decides how a $lookup specified with localField/foreignField syntax should join, from the
+     * statistics of the foreign collection. Reads nothing from the collection itself.
+     */
+    JoinStrategy pickJoinStrategy() const;
+
+    /**
+     * Sets '_joinStrategy', and builds '_hashTable' if it is a hash join. Called once the first
+     * input document has been read, so that an empty input never reads the foreign collection.
+     */
+    void startJoin();
+
+    /**
+     * Returns the input document read before the join started, if it has not been returned yet,
+     * and otherwise the next result from 'pSource'.
+     */
+    GetNextResult getNextSourceInput();
+
+    /**
+     * Reads every foreign document which passes '_additionalFilter' into '_hashTable'. If the
+     * documents and the table indexing them take up more than 'maxBytes', releases the table so
+     * that input documents are joined by querying the foreign collection instead.
+     */
+    void buildHashTable(size_t maxBytes);
+
+    /**
+     * Returns the foreign documents joining with 'inputDoc', looked up in '_hashTable'. Returns
+     * boost::none if there is no table, or if 'inputDoc' has a local value the table cannot answer
+     * for, in which case the foreign collection must be queried.
+     */
+    boost::optional<std::vector<Value>> probeHashTable(const Document& inputDoc);
+
     /**
      * Copies 'vars' and 'vps' to the Variables and VariablesParseState objects in 'expCtx'. These
      * copies provide access to 'let' defined variables in sub-pipeline execution.
@@ -323,6 +391,29 @@ private:
 
     std::vector<LetVariable> _letVariables;
 
+    // Set by startJoin(), once the first input document has been read.
+    boost::optional<JoinStrategy> _joinStrategy;
+    boost::optional<Document> _firstInput;
+
+    // For use when $lookup is specified with localField/foreignField syntax and joins through a
+    // hash table. '_hashTable' maps each value at the foreignField path to the positions in
+    // '_foreignDocs' of the documents holding it, in ascending order. '_hashTableBytes' is the
+    // approximate memory held by both.
+    std::vector<Document> _foreignDocs;
+    boost::optional<ValueUnorderedMap<std::vector<size_t>>> _hashTable;
+    size_t _hashTableBytes = 0;
+
+    // For use when $lookup is specified with localField/foreignField syntax and joins each batch
+    // of input documents through one foreign query. A batched document's 'matches' are boost::none
+    // if it must be joined by its own query.
+    struct BatchedInput {
+        Document doc;
+        boost::optional<std::vector<Value>> matches;
+    };
+    size_t _inputBatchSize = 1;
+    std::deque<BatchedInput> _inputBatch;
+    boost::optional<GetNextResult> _inputBatchEnd;
+
     boost::intrusive_ptr<DocumentSourceMatch> _matchSrc;
     boost::intrusive_ptr<DocumentSourceUnwind> _unwindSrc;
 
@@ -330,6 +421,8 @@ private:
     // not null.
     long long _cursorIndex = 0;
     std::unique_ptr<Pipeline, Pipeline::Deleter> _pipeline;
+    std::vector<Value> _knownMatches;
+    size_t _knownMatchIndex = 0;
     boost::optional<Document> _input;
     boost::optional<Document> _nextValue;
 };
@@ -76,6 +76,35 @@ private:
     const Version _origVersion;
 };
 
+// Allow tests to temporarily change how many input documents $lookup joins with one query.
+class EnsureLookupBatchSize {
+public:
+    EnsureLookupBatchSize(int batchSize)
+        : _origBatchSize(internalDocumentSourceLookupBatchSize.load()) {
+        internalDocumentSourceLookupBatchSize.store(batchSize);
+    }
+    ~EnsureLookupBatchSize() {
+        internalDocumentSourceLookupBatchSize.store(_origBatchSize);
+    }
+
+private:
+    const int _origBatchSize;
+};
+
+class EnsureLookupHashJoinMaxBytes {
+public:
+    EnsureLookupHashJoinMaxBytes(int maxBytes)
+        : _origMaxBytes(internalDocumentSourceLookupHashJoinMaxBytes.load()) {
+        internalDocumentSourceLookupHashJoinMaxBytes.store(maxBytes);
+    }
+    ~EnsureLookupHashJoinMaxBytes() {
+        internalDocumentSourceLookupHashJoinMaxBytes.store(_origMaxBytes);
+    }
+
+private:
+    const int _origMaxBytes;
+};
+
 // For tests which need to run in a replica set context.
 class ReplDocumentSourceLookUpTest : public DocumentSourceLookUpTest {
 public:
@@ -519,10 +548,30 @@ public:
         return false;
     }
 
+    /**
+     * Reports 'stats' for the foreign collection, allowing $lookup to choose a hash join. By
+     * default no statistics are available and $lookup queries the foreign collection per input.
+     */
+    void setJoinCollectionStats(JoinCollectionStats stats) {
+        _joinCollectionStats = stats;
+    }
+
+    boost::optional<JoinCollectionStats> getJoinCollectionStats(
+        const NamespaceString& nss,
+        const FieldPath& joinField,
+        const CollatorInterface* collator) final {
+        return _joinCollectionStats;
+    }
+
+    int numPipelinesMade() const {
+        return _numPipelinesMade;
+    }
+
     StatusWith<std::unique_ptr<Pipeline, Pipeline::Deleter>> makePipeline(
         const std::vector<BSONObj>& rawPipeline,
         const boost::intrusive_ptr<ExpressionContext>& expCtx,
         const MakePipelineOptions opts) final {
+        ++_numPipelinesMade;
         auto pipeline = Pipeline::parse(rawPipeline, expCtx);
         if (!pipeline.isOK()) {
             return pipeline.getStatus();
@@ -557,6 +606,8 @@ public:
 private:
     deque<DocumentSource::GetNextResult> _mockResults;
     bool _removeLeadingQueryStages = false;
+    boost::optional<JoinCollectionStats> _joinCollectionStats;
+    int _numPipelinesMade = 0;
 };
 
 TEST_F(DocumentSourceLookUpTest, ShouldPropagatePauses) {
@@ -1127,5 +1178,264 @@ TEST_F(DocumentSourceLookUpTest, ShouldNotCacheIfCorrelatedStageIsAbsorbedIntoPl
     ASSERT_VALUE_EQ(Value(subPipeline->writeExplainOps(kExplain)), Value(BSONArray(expectedPipe)));
 }
 
+TEST_F(DocumentSourceLookUpTest, ShouldHashJoinSmallUnindexedForeignCollection) {
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespace(fromNs, {fromNs, std::vector<BSONObj>{}});
+
+    auto docSource = DocumentSourceLookUp::createFromBson(
+        fromjson("{$lookup: {from: 'foreign', localField: 'fk', foreignField: 'x', as: 'as'}}")
+            .firstElement(),
+        expCtx);
+    auto lookupStage = static_cast<DocumentSourceLookUp*>(docSource.get());
+
+    auto mockLocalSource = DocumentSourceMock::create({Document{fromjson("{_id: 0, fk: 1}")},
+                                                       Document{fromjson("{_id: 1, fk: [2, 3]}")},
+                                                       Document{fromjson("{_id: 2, fk: 4}")}});
+    lookupStage->setSource(mockLocalSource.get());
+
+    deque<DocumentSource::GetNextResult> mockForeignContents{
+        Document{fromjson("{_id: 0, x: 1}")},
+        Document{fromjson("{_id: 1, x: [1, 2]}")},
+        Document{fromjson("{_id: 2, x: 3}")},
+        Document{fromjson("{_id: 3}")}};
+    auto mongoProcessInterface = std::make_shared<MockMongoProcessInterface>(mockForeignContents);
+    mongoProcessInterface->setJoinCollectionStats({4, 100, false});
+    lookupStage->injectMongoProcessInterface(mongoProcessInterface);
+
+    auto next = lookupStage->getNext();
+    ASSERT(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        Document{fromjson("{_id: 0, fk: 1, as: [{_id: 0, x: 1}, {_id: 1, x: [1, 2]}]}")},
+        next.getDocument());
+
+    // A foreign document matching several local values is returned once.
+    next = lookupStage->getNext();
+    ASSERT(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        Document{fromjson("{_id: 1, fk: [2, 3], as: [{_id: 1, x: [1, 2]}, {_id: 2, x: 3}]}")},
+        next.getDocument());
+
+    next = lookupStage->getNext();
+    ASSERT(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(Document{fromjson("{_id: 2, fk: 4, as: []}")}, next.getDocument());
+
+    ASSERT(lookupStage->getNext().isEOF());
+
+    // The foreign collection was read just once.
+    ASSERT_EQ(mongoProcessInterface->numPipelinesMade(), 1);
+    lookupStage->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, HashJoinShouldQueryForeignCollectionForMissingLocalValue) {
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespace(fromNs, {fromNs, std::vector<BSONObj>{}});
+
+    auto docSource = DocumentSourceLookUp::createFromBson(
+        fromjson("{$lookup: {from: 'foreign', localField: 'fk', foreignField: 'x', as: 'as'}}")
+            .firstElement(),
+        expCtx);
+    auto lookupStage = static_cast<DocumentSourceLookUp*>(docSource.get());
+
+    auto mockLocalSource = DocumentSourceMock::create(
+        {Document{fromjson("{_id: 0, fk: 1}")}, Document{fromjson("{_id: 1}")}});
+    lookupStage->setSource(mockLocalSource.get());
+
+    deque<DocumentSource::GetNextResult> mockForeignContents{Document{fromjson("{_id: 0, x: 1}")},
+                                                             Document{fromjson("{_id: 1}")}};
+    auto mongoProcessInterface = std::make_shared<MockMongoProcessInterface>(mockForeignContents);
+    mongoProcessInterface->setJoinCollectionStats({2, 100, false});
+    lookupStage->injectMongoProcessInterface(mongoProcessInterface);
+
+    auto next = lookupStage->getNext();
+    ASSERT(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(Document{fromjson("{_id: 0, fk: 1, as: [{_id: 0, x: 1}]}")},
+                       next.getDocument());
+    ASSERT_EQ(mongoProcessInterface->numPipelinesMade(), 1);
+
+    // A missing local value matches foreign documents without the field, which requires a query.
+    next = lookupStage->getNext();
+    ASSERT(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(Document{fromjson("{_id: 1, as: [{_id: 1}]}")}, next.getDocument());
+    ASSERT_EQ(mongoProcessInterface->numPipelinesMade(), 2);
+
+    ASSERT(lookupStage->getNext().isEOF());
+    lookupStage->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldNotHashJoinLargeIndexedForeignCollection) {
+    EnsureLookupBatchSize ensureBatchSize(1);
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespace(fromNs, {fromNs, std::vector<BSONObj>{}});
+
+    auto docSource = DocumentSourceLookUp::createFromBson(
+        fromjson("{$lookup: {from: 'foreign', localField: 'fk', foreignField: 'x', as: 'as'}}")
+            .firstElement(),
+        expCtx);
+    auto lookupStage = static_cast<DocumentSourceLookUp*>(docSource.get());
+
+    auto mockLocalSource = DocumentSourceMock::create(
+        {Document{fromjson("{_id: 0, fk: 1}")}, Document{fromjson("{_id: 1, fk: 2}")}});
+    lookupStage->setSource(mockLocalSource.get());
+
+    deque<DocumentSource::GetNextResult> mockForeignContents{Document{fromjson("{_id: 0, x: 1}")}};
+    auto mongoProcessInterface = std::make_shared<MockMongoProcessInterface>(mockForeignContents);
+    const long long numRecords = internalDocumentSourceLookupHashJoinMaxIndexedDocs.load() + 1;
+    mongoProcessInterface->setJoinCollectionStats({numRecords, 100, true});
+    lookupStage->injectMongoProcessInterface(mongoProcessInterface);
+
+    auto next = lookupStage->getNext();
+    ASSERT(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(Document{fromjson("{_id: 0, fk: 1, as: [{_id: 0, x: 1}]}")},
+                       next.getDocument());
+
+    next = lookupStage->getNext();
+    ASSERT(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(Document{fromjson("{_id: 1, fk: 2, as: []}")}, next.getDocument());
+
+    ASSERT(lookupStage->getNext().isEOF());
+
+    // Each input document was joined by querying the foreign collection.
+    ASSERT_EQ(mongoProcessInterface->numPipelinesMade(), 2);
+    lookupStage->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldJoinBatchOfInputDocumentsWithOneQuery) {
+    EnsureLookupBatchSize ensureBatchSize(3);
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespace(fromNs, {fromNs, std::vector<BSONObj>{}});
+
+    auto docSource = DocumentSourceLookUp::createFromBson(
+        fromjson("{$lookup: {from: 'foreign', localField: 'fk', foreignField: 'x', as: 'as'}}")
+            .firstElement(),
+        expCtx);
+    auto lookupStage = static_cast<DocumentSourceLookUp*>(docSource.get());
+
+    auto mockLocalSource = DocumentSourceMock::create({Document{fromjson("{_id: 0, fk: 1}")},
+                                                       Document{fromjson("{_id: 1, fk: [2, 3]}")},
+                                                       Document{fromjson("{_id: 2, fk: null}")},
+                                                       Document{fromjson("{_id: 3, fk: 2}")}});
+    lookupStage->setSource(mockLocalSource.get());
+
+    deque<DocumentSource::GetNextResult> mockForeignContents{
+        Document{fromjson("{_id: 0, x: 1}")},
+        Document{fromjson("{_id: 1, x: [1, 2]}")},
+        Document{fromjson("{_id: 2, x: 3}")},
+        Document{fromjson("{_id: 3, x: null}")}};
+    auto mongoProcessInterface = std::make_shared<MockMongoProcessInterface>(mockForeignContents);
+    lookupStage->injectMongoProcessInterface(mongoProcessInterface);
+
+    auto next = lookupStage->getNext();
+    ASSERT(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        Document{fromjson("{_id: 0, fk: 1, as: [{_id: 0, x: 1}, {_id: 1, x: [1, 2]}]}")},
+        next.getDocument());
+
+    // The first three input documents were read as a batch, and all but the one with a null local
+    // value were joined by a single query.
+    ASSERT_EQ(mongoProcessInterface->numPipelinesMade(), 1);
+
+    next = lookupStage->getNext();
+    ASSERT(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        Document{fromjson("{_id: 1, fk: [2, 3], as: [{_id: 1, x: [1, 2]}, {_id: 2, x: 3}]}")},
+        next.getDocument());
+
+    next = lookupStage->getNext();
+    ASSERT(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(Document{fromjson("{_id: 2, fk: null, as: [{_id: 3, x: null}]}")},
+                       next.getDocument());
+    ASSERT_EQ(mongoProcessInterface->numPipelinesMade(), 2);
+
+    next = lookupStage->getNext();
+    ASSERT(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(Document{fromjson("{_id: 3, fk: 2, as: [{_id: 1, x: [1, 2]}]}")},
+                       next.getDocument());
+    ASSERT_EQ(mongoProcessInterface->numPipelinesMade(), 3);
+
+    ASSERT(lookupStage->getNext().isEOF());
+    lookupStage->dispose();
+}
+
+Value explainJoinStrategy(DocumentSourceLookUp* lookupStage) {
+    std::vector<Value> explain;
+    lookupStage->serializeToArray(explain, kExplain);
+    ASSERT_EQ(explain.size(), 1U);
+    return explain[0].getDocument()["$lookup"]["joinStrategy"];
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldNotReadForeignCollectionBeforeFirstInput) {
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespace(fromNs, {fromNs, std::vector<BSONObj>{}});
+
+    auto docSource = DocumentSourceLookUp::createFromBson(
+        fromjson("{$lookup: {from: 'foreign', localField: 'fk', foreignField: 'x', as: 'as'}}")
+            .firstElement(),
+        expCtx);
+    auto lookupStage = static_cast<DocumentSourceLookUp*>(docSource.get());
+
+    auto mockLocalSource =
+        DocumentSourceMock::create({DocumentSource::GetNextResult::makePauseExecution()});
+    lookupStage->setSource(mockLocalSource.get());
+
+    deque<DocumentSource::GetNextResult> mockForeignContents{Document{fromjson("{_id: 0, x: 1}")}};
+    auto mongoProcessInterface = std::make_shared<MockMongoProcessInterface>(mockForeignContents);
+    mongoProcessInterface->setJoinCollectionStats({1, 100, false});
+    lookupStage->injectMongoProcessInterface(mongoProcessInterface);
+
+    // Explain reports the strategy the statistics point to without reading anything.
+    ASSERT_VALUE_EQ(explainJoinStrategy(lookupStage), Value("hashJoin"_sd));
+
+    ASSERT_TRUE(lookupStage->getNext().isPaused());
+    ASSERT_TRUE(lookupStage->getNext().isEOF());
+    ASSERT_EQ(mongoProcessInterface->numPipelinesMade(), 0);
+    lookupStage->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldQueryForeignCollectionIfHashTableOutgrowsLimit) {
+    EnsureLookupBatchSize ensureBatchSize(1);
+    EnsureLookupHashJoinMaxBytes ensureMaxBytes(1);
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespace(fromNs, {fromNs, std::vector<BSONObj>{}});
+
+    auto docSource = DocumentSourceLookUp::createFromBson(
+        fromjson("{$lookup: {from: 'foreign', localField: 'fk', foreignField: 'x', as: 'as'}}")
+            .firstElement(),
+        expCtx);
+    auto lookupStage = static_cast<DocumentSourceLookUp*>(docSource.get());
+
+    auto mockLocalSource = DocumentSourceMock::create(
+        {Document{fromjson("{_id: 0, fk: 1}")}, Document{fromjson("{_id: 1, fk: 2}")}});
+    lookupStage->setSource(mockLocalSource.get());
+
+    // The statistics claim the collection fits, but its documents and keys do not.
+    deque<DocumentSource::GetNextResult> mockForeignContents{Document{fromjson("{_id: 0, x: 1}")}};
+    auto mongoProcessInterface = std::make_shared<MockMongoProcessInterface>(mockForeignContents);
+    mongoProcessInterface->setJoinCollectionStats({1, 1, false});
+    lookupStage->injectMongoProcessInterface(mongoProcessInterface);
+    ASSERT_VALUE_EQ(explainJoinStrategy(lookupStage), Value("hashJoin"_sd));
+
+    auto next = lookupStage->getNext();
+    ASSERT(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(Document{fromjson("{_id: 0, fk: 1, as: [{_id: 0, x: 1}]}")},
+                       next.getDocument());
+    ASSERT_VALUE_EQ(explainJoinStrategy(lookupStage), Value("queryPerInput"_sd));
+
+    next = lookupStage->getNext();
+    ASSERT(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(Document{fromjson("{_id: 1, fk: 2, as: []}")}, next.getDocument());
+
+    ASSERT(lookupStage->getNext().isEOF());
+
+    // One pipeline to try building the table, then one query per input document.
+    ASSERT_EQ(mongoProcessInterface->numPipelinesMade(), 3);
+    lookupStage->dispose();
+}
+
 }  // namespace
 }  // namespace mongo
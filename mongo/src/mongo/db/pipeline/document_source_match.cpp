@@ -40,6 +40,7 @@
 #include "mongo/db/pipeline/document_path_support.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/lite_parsed_document_source.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/stringutils.h"
 
@@ -84,6 +85,13 @@ DocumentSource::GetNextResult DocumentSourceMatch::getNext() {
     // The user facing error should have been generated earlier.
     massert(17309, "Should never call getNext on a $match stage with $text clause", !_isTextQuery);
 
+    if (!_triedToCompile) {
+        _triedToCompile = true;
+        if (internalQueryExecCompileConjunctions.load()) {
+            _compiledExpression = CompiledConjunction::compile(_expression.get());
+        }
+    }
+
     auto nextInput = pSource->getNext();
     for (; nextInput.isAdvanced(); nextInput = pSource->getNext()) {
         // MatchExpression only takes BSON documents, so we have to make one. As an optimization,
@@ -93,7 +101,9 @@ DocumentSource::GetNextResult DocumentSourceMatch::getNext() {
             : document_path_support::documentToBsonWithPaths(nextInput.getDocument(),
                                                              _dependencies.fields);
 
-        if (_expression->matchesBSON(toMatch)) {
+        const bool matches = _compiledExpression ? _compiledExpression->matches(toMatch)
+                                                 : _expression->matchesBSON(toMatch);
+        if (matches) {
             return nextInput;
         }
 
@@ -32,6 +32,7 @@
 #include <utility>
 
 #include "mongo/client/connpool.h"
+#include "mongo/db/matcher/compiled_conjunction.h"
 #include "mongo/db/matcher/matcher.h"
 #include "mongo/db/pipeline/document_source.h"
 
@@ -161,6 +162,11 @@ protected:
 private:
     std::unique_ptr<MatchExpression> _expression;
 
+    // Evaluates '_expression' in a single pass over each document, if it is a simple conjunction.
+    // Built on the first call to getNext(), once the pipeline has been optimized.
+    std::unique_ptr<CompiledConjunction> _compiledExpression;
+    bool _triedToCompile = false;
+
     BSONObj _predicate;
     const bool _isTextQuery;
 
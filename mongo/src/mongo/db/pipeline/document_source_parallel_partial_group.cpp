@@ -0,0 +1,557 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/document_source_parallel_partial_group.h"
+
+#include <algorithm>
+#include <deque>
+#include <set>
+
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/client.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/exec/fetch.h"
+#include "mongo/db/exec/multi_iterator.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/matcher/extensions_callback_real.h"
+#include "mongo/db/pipeline/document_source_cursor.h"
+#include "mongo/db/pipeline/document_source_group.h"
+#include "mongo/db/pipeline/pipeline.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/collation/collator_interface.h"
+#include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/service_context.h"
+#include "mongo/db/storage/record_store.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/log.h"
+
+namespace mongo {
+
+using boost::intrusive_ptr;
+using std::unique_ptr;
+
+namespace {
+
+// The number of records sampled per range when choosing where the ranges start and end.
+const size_t kSamplesPerRange = 16;
+
+// The number of partial groups each worker may have waiting to be merged before it stops.
+const size_t kMaxBufferedResultsPerWorker = 1000;
+
+/**
+ * Accumulators whose partial results can be merged without knowing which part of the input each
+ * was computed from. $first, $last and $push depend on the order of their input, so a $group using
+ * them is only run on one thread.
+ */
+const std::set<StringData> kOrderInsensitiveAccumulators{
+    "$addToSet"_sd, "$avg"_sd, "$max"_sd, "$min"_sd, "$stdDevPop"_sd, "$stdDevSamp"_sd, "$sum"_sd};
+
+// The number of worker threads reserved by the parallel $groups on this server.
+stdx::mutex reservedWorkersMutex;
+size_t reservedWorkers = 0;
+
+/**
+ * A forward cursor over the records of a collection up to and including 'end', or up to the end
+ * of the collection if 'end' is not set.
+ */
+class RangeRecordCursor final : public RecordCursor {
+public:
+    RangeRecordCursor(unique_ptr<SeekableRecordCursor> cursor, boost::optional<RecordId> end)
+        : _cursor(std::move(cursor)), _end(std::move(end)) {}
+
+    boost::optional<Record> next() final {
+        if (_exhausted) {
+            return boost::none;
+        }
+
+        auto record = _cursor->next();
+        if (!record || (_end && record->id > *_end)) {
+            _exhausted = true;
+            return boost::none;
+        }
+        return record;
+    }
+
+    void save() final {
+        _cursor->save();
+    }
+
+    bool restore() final {
+        return _cursor->restore();
+    }
+
+    void detachFromOperationContext() final {
+        _cursor->detachFromOperationContext();
+    }
+
+    void reattachToOperationContext(OperationContext* opCtx) final {
+        _cursor->reattachToOperationContext(opCtx);
+    }
+
+    void invalidate(OperationContext* opCtx, const RecordId& id) final {
+        _cursor->invalidate(opCtx, id);
+    }
+
+    unique_ptr<RecordFetcher> fetcherForNext() const final {
+        return _exhausted ? nullptr : _cursor->fetcherForNext();
+    }
+
+private:
+    unique_ptr<SeekableRecordCursor> _cursor;
+    const boost::optional<RecordId> _end;
+    bool _exhausted = false;
+};
+
+/**
+ * Picks up to 'numRanges' - 1 RecordIds, in increasing order, which divide 'collection' into
+ * ranges of roughly equal size. Returns no boundaries if the storage engine cannot sample records.
+ */
+std::vector<RecordId> sampleRangeBoundaries(OperationContext* opCtx,
+                                            const Collection* collection,
+                                            size_t numRanges) {
+    std::vector<RecordId> samples;
+    if (auto cursor = collection->getRecordStore()->getRandomCursor(opCtx)) {
+        while (samples.size() < numRanges * kSamplesPerRange) {
+            auto record = cursor->next();
+            if (!record) {
+                break;
+            }
+            samples.push_back(record->id);
+        }
+    }
+    std::sort(samples.begin(), samples.end());
+    samples.erase(std::unique(samples.begin(), samples.end()), samples.end());
+
+    std::vector<RecordId> boundaries;
+    for (size_t i = 1; i < numRanges && !samples.empty(); ++i) {
+        const RecordId& boundary = samples[i * samples.size() / numRanges];
+        if (boundaries.empty() || boundaries.back() < boundary) {
+            boundaries.push_back(boundary);
+        }
+    }
+    return boundaries;
+}
+
+/**
+ * Returns cursors over disjoint ranges of RecordIds which between them cover all of 'collection',
+ * each saved and detached so that it can be restored on another thread's OperationContext.
+ *
+ * The cursors do not share a snapshot: each is restored on its worker's recovery unit, and yields
+ * on its own. What keeps a record from being seen twice, or missed where two ranges meet, is that
+ * each range starts just after the boundary where the previous one stops, and that a record keeps
+ * its RecordId for its whole life, which only holds on storage engines with document-level
+ * locking. A record inserted or deleted during the scan may or may not be seen, as with any
+ * yielding collection scan.
+ */
+std::vector<unique_ptr<RecordCursor>> makeRangeCursors(OperationContext* opCtx,
+                                                       const Collection* collection,
+                                                       size_t numRanges) {
+    std::vector<unique_ptr<RecordCursor>> cursors;
+    auto cursor = collection->getCursor(opCtx);
+    for (auto&& boundary : sampleRangeBoundaries(opCtx, collection, numRanges)) {
+        // A cursor restored after seeking to a record goes on to the record after it.
+        auto nextCursor = collection->getCursor(opCtx);
+        if (!nextCursor->seekExact(boundary)) {
+            continue;
+        }
+        cursors.push_back(stdx::make_unique<RangeRecordCursor>(std::move(cursor), boundary));
+        cursor = std::move(nextCursor);
+    }
+    cursors.push_back(stdx::make_unique<RangeRecordCursor>(std::move(cursor), boost::none));
+
+    for (auto&& rangeCursor : cursors) {
+        rangeCursor->save();
+        rangeCursor->detachFromOperationContext();
+    }
+    return cursors;
+}
+
+}  // namespace
+
+struct DocumentSourceParallelPartialGroup::SharedState {
+    SharedState(NamespaceString nss,
+                boost::optional<UUID> uuid,
+                BSONObj query,
+                std::vector<BSONObj> stages)
+        : nss(std::move(nss)),
+          uuid(std::move(uuid)),
+          query(std::move(query)),
+          stages(std::move(stages)) {}
+
+    /**
+     * Interrupts every running worker, and wakes any waiting to add a result so that it exits.
+     */
+    void cancel_inlock() {
+        cancelled = true;
+        for (auto&& opCtx : workerOpCtxs) {
+            stdx::lock_guard<Client> clientLock(*opCtx->getClient());
+            opCtx->getServiceContext()->killOperation(opCtx);
+        }
+        cv.notify_all();
+    }
+
+    const NamespaceString nss;
+    const boost::optional<UUID> uuid;
+    const BSONObj query;
+    const std::vector<BSONObj> stages;
+
+    // Set before the first worker starts.
+    Date_t deadline = Date_t::max();
+    size_t maxBufferedResults = 0;
+
+    // Protects everything below.
+    stdx::mutex mutex;
+
+    // Signalled when a result is added or removed, a worker exits, or the workers are cancelled.
+    stdx::condition_variable cv;
+
+    std::deque<Document> results;
+    std::set<OperationContext*> workerOpCtxs;
+    size_t numRunning = 0;
+    Status status = Status::OK();
+    bool cancelled = false;
+};
+
+struct DocumentSourceParallelPartialGroup::Worker {
+    intrusive_ptr<ExpressionContext> expCtx;
+    unique_ptr<RecordCursor> cursor;
+};
+
+DocumentSourceParallelPartialGroup::DocumentSourceParallelPartialGroup(
+    const intrusive_ptr<ExpressionContext>& expCtx,
+    unique_ptr<SharedState> state,
+    size_t numWorkers)
+    : DocumentSource(expCtx), _numWorkers(numWorkers), _state(std::move(state)) {}
+
+DocumentSourceParallelPartialGroup::~DocumentSourceParallelPartialGroup() {
+    stopWorkers();
+    releaseWorkers(_numWorkers);
+}
+
+// static
+size_t DocumentSourceParallelPartialGroup::reserveWorkers(size_t numWorkers) {
+    const size_t maxTotalWorkers = static_cast<size_t>(
+        std::max(0, internalDocumentSourceGroupParallelMaxTotalWorkers.load()));
+
+    stdx::lock_guard<stdx::mutex> lk(reservedWorkersMutex);
+    const size_t available =
+        maxTotalWorkers > reservedWorkers ? maxTotalWorkers - reservedWorkers : 0;
+    const size_t numReserved = std::min(numWorkers, available);
+    if (numReserved < 2U) {
+        return 0;
+    }
+    reservedWorkers += numReserved;
+    return numReserved;
+}
+
+// static
+void DocumentSourceParallelPartialGroup::releaseWorkers(size_t numWorkers) {
+    stdx::lock_guard<stdx::mutex> lk(reservedWorkersMutex);
+    invariant(reservedWorkers >= numWorkers);
+    reservedWorkers -= numWorkers;
+}
+
+// static
+bool DocumentSourceParallelPartialGroup::canRunInParallel(const DocumentSourceGroup& group) {
+    // The input is an unordered collection scan, so the $group never streams.
+    const Document spec = group.serialize().getDocument()[group.getSourceName()].getDocument();
+    for (auto it = spec.fieldIterator(); it.more();) {
+        auto field = it.next();
+        if (field.first == "_id") {
+            continue;
+        }
+
+        // A merging $group has a "$doingMerge" field, which is not an object.
+        if (field.second.getType() != BSONType::Object) {
+            return false;
+        }
+        auto accumulator = field.second.getDocument().fieldIterator();
+        if (!accumulator.more() || !kOrderInsensitiveAccumulators.count(accumulator.next().first)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// static
+intrusive_ptr<DocumentSourceParallelPartialGroup> DocumentSourceParallelPartialGroup::create(
+    const intrusive_ptr<ExpressionContext>& expCtx,
+    const Collection* collection,
+    const BSONObj& query,
+    const Pipeline::SourceContainer& stages,
+    size_t numWorkers) {
+    invariant(collection);
+    invariant(numWorkers > 1U);
+
+    std::vector<Value> serializedStages;
+    for (auto&& stage : stages) {
+        stage->serializeToArray(serializedStages);
+    }
+    std::vector<BSONObj> rawStages;
+    for (auto&& stage : serializedStages) {
+        rawStages.push_back(stage.getDocument().toBson());
+    }
+
+    auto state = stdx::make_unique<SharedState>(
+        collection->ns(), collection->uuid(), query.getOwned(), std::move(rawStages));
+    return new DocumentSourceParallelPartialGroup(expCtx, std::move(state), numWorkers);
+}
+
+const char* DocumentSourceParallelPartialGroup::getSourceName() const {
+    return "$_internalParallelPartialGroup";
+}
+
+Value DocumentSourceParallelPartialGroup::serialize(
+    boost::optional<ExplainOptions::Verbosity> explain) const {
+    // Like a DocumentSourceCursor, this stage only appears in explain output.
+    if (!explain) {
+        return Value();
+    }
+
+    std::vector<Value> stages;
+    for (auto&& stage : _state->stages) {
+        stages.emplace_back(stage);
+    }
+    return Value(DOC(getSourceName() << DOC("workers" << static_cast<long long>(_numWorkers)
+                                               << "query"
+                                               << _state->query
+                                               << "pipeline"
+                                               << Value(std::move(stages)))));
+}
+
+DocumentSource::GetNextResult DocumentSourceParallelPartialGroup::getNext() {
+    pExpCtx->checkForInterrupt();
+
+    if (!_started) {
+        _started = true;
+        startWorkers();
+    }
+
+    {
+        stdx::unique_lock<stdx::mutex> lk(_state->mutex);
+        try {
+            while (_state->results.empty() && _state->numRunning > 0 && _state->status.isOK()) {
+                pExpCtx->opCtx->waitForConditionOrInterrupt(_state->cv, lk);
+            }
+            uassertStatusOK(_state->status);
+        } catch (const DBException&) {
+            // We hold the lock again by now. Nobody will ask for the rest of the results.
+            _state->cancel_inlock();
+            throw;
+        }
+
+        if (!_state->results.empty()) {
+            Document result = std::move(_state->results.front());
+            _state->results.pop_front();
+            _state->cv.notify_all();
+            return std::move(result);
+        }
+    }
+
+    // Every worker has finished its range.
+    stopWorkers();
+    return GetNextResult::makeEOF();
+}
+
+void DocumentSourceParallelPartialGroup::startWorkers() {
+    auto opCtx = pExpCtx->opCtx;
+
+    std::vector<unique_ptr<RecordCursor>> cursors;
+    {
+        AutoGetCollectionForRead autoColl(opCtx, _state->nss);
+        const Collection* collection = autoColl.getCollection();
+        uassert(ErrorCodes::QueryPlanKilled,
+                str::stream() << "collection " << _state->nss.ns()
+                              << " was dropped before a parallel $group could scan it",
+                collection && collection->uuid() == _state->uuid);
+        cursors = makeRangeCursors(opCtx, collection, _numWorkers);
+    }
+    LOG(1) << "Running the first half of a $group over " << _state->nss.ns() << " on "
+           << cursors.size() << " threads";
+
+    _state->deadline = opCtx->getDeadline();
+    _state->maxBufferedResults = cursors.size() * kMaxBufferedResultsPerWorker;
+
+    ThreadPool::Options options;
+    options.poolName = "ParallelPartialGroup";
+    options.minThreads = cursors.size();
+    options.maxThreads = cursors.size();
+    options.onCreateThread = [](const std::string& threadName) { Client::initThread(threadName); };
+    _pool = stdx::make_unique<ThreadPool>(options);
+    _pool->startup();
+
+    for (auto&& cursor : cursors) {
+        // Each worker parses the stages with its own collator, since it evaluates them on its own
+        // thread, and its $group produces partial results for the merging $group to combine.
+        auto worker = std::make_shared<Worker>();
+        worker->expCtx = pExpCtx->copyWith(
+            _state->nss,
+            _state->uuid,
+            pExpCtx->getCollator() ? pExpCtx->getCollator()->clone() : nullptr);
+        worker->expCtx->needsMerge = true;
+        worker->cursor = std::move(cursor);
+
+        stdx::lock_guard<stdx::mutex> lk(_state->mutex);
+        SharedState* state = _state.get();
+        Status status = _pool->schedule([state, worker] { runWorker(state, worker.get()); });
+        if (!status.isOK()) {
+            _state->cancel_inlock();
+            uassertStatusOK(status);
+        }
+        ++_state->numRunning;
+    }
+}
+
+void DocumentSourceParallelPartialGroup::stopWorkers() {
+    if (!_pool) {
+        return;
+    }
+
+    {
+        stdx::lock_guard<stdx::mutex> lk(_state->mutex);
+        _state->cancel_inlock();
+    }
+    _pool->shutdown();
+    _pool->join();
+    _pool.reset();
+}
+
+void DocumentSourceParallelPartialGroup::doDispose() {
+    stopWorkers();
+}
+
+// static
+void DocumentSourceParallelPartialGroup::runWorker(SharedState* state, Worker* worker) {
+    auto opCtxHolder = cc().makeOperationContext();
+    OperationContext* opCtx = opCtxHolder.get();
+    {
+        stdx::lock_guard<stdx::mutex> lk(state->mutex);
+        state->workerOpCtxs.insert(opCtx);
+        if (state->cancelled) {
+            stdx::lock_guard<Client> clientLock(*opCtx->getClient());
+            opCtx->getServiceContext()->killOperation(opCtx);
+        }
+    }
+
+    Status status = Status::OK();
+    try {
+        if (state->deadline != Date_t::max()) {
+            opCtx->setDeadlineByDate(state->deadline);
+        }
+
+        auto expCtx = worker->expCtx;
+        expCtx->opCtx = opCtx;
+        auto pipeline = uassertStatusOK(Pipeline::parse(state->stages, expCtx));
+
+        {
+            AutoGetCollectionForRead autoColl(opCtx, state->nss);
+            Collection* collection = autoColl.getCollection();
+            uassert(ErrorCodes::QueryPlanKilled,
+                    str::stream() << "collection " << state->nss.ns()
+                                  << " was dropped during a parallel $group",
+                    collection && collection->uuid() == state->uuid);
+
+            unique_ptr<RecordCursor> cursor = std::move(worker->cursor);
+            cursor->reattachToOperationContext(opCtx);
+            uassert(ErrorCodes::QueryPlanKilled,
+                    str::stream() << "lost the position of a parallel $group scan of "
+                                  << state->nss.ns(),
+                    cursor->restore());
+
+            auto qr = stdx::make_unique<QueryRequest>(state->nss);
+            qr->setFilter(state->query);
+            qr->setCollation(expCtx->getCollator() ? expCtx->getCollator()->getSpec().toBSON()
+                                                   : expCtx->collation);
+            const ExtensionsCallbackReal extensionsCallback(opCtx, &state->nss);
+            auto cq = uassertStatusOK(
+                CanonicalQuery::canonicalize(opCtx,
+                                             std::move(qr),
+                                             expCtx,
+                                             extensionsCallback,
+                                             Pipeline::kAllowedMatcherFeatures));
+
+            auto ws = stdx::make_unique<WorkingSet>();
+            auto iterator = stdx::make_unique<MultiIteratorStage>(opCtx, ws.get(), collection);
+            iterator->addIterator(std::move(cursor));
+            const MatchExpression* filter = state->query.isEmpty() ? nullptr : cq->root();
+            auto root = stdx::make_unique<FetchStage>(
+                opCtx, ws.get(), iterator.release(), filter, collection);
+            auto exec = uassertStatusOK(PlanExecutor::make(opCtx,
+                                                           std::move(ws),
+                                                           std::move(root),
+                                                           std::move(cq),
+                                                           collection,
+                                                           PlanExecutor::YIELD_AUTO));
+
+            // DocumentSourceCursor expects a yielding PlanExecutor that has had its state saved.
+            exec->saveState();
+            auto source = DocumentSourceCursor::create(collection, std::move(exec), expCtx);
+            source->setQuery(state->query);
+            DepsTracker deps =
+                pipeline->getDependencies(DepsTracker::MetadataAvailable::kNoMetadata);
+            if (deps.hasNoRequirements()) {
+                source->shouldProduceEmptyDocs();
+            }
+            source->setProjection(deps.toProjection(), deps.toParsedDeps());
+            pipeline->addInitialSource(source);
+        }
+
+        while (auto next = pipeline->getNext()) {
+            stdx::unique_lock<stdx::mutex> lk(state->mutex);
+            state->cv.wait(lk, [state] {
+                return state->cancelled || state->results.size() < state->maxBufferedResults;
+            });
+            if (state->cancelled) {
+                break;
+            }
+            state->results.push_back(std::move(*next));
+            state->cv.notify_all();
+        }
+    } catch (const DBException& ex) {
+        status = ex.toStatus();
+    }
+
+    stdx::lock_guard<stdx::mutex> lk(state->mutex);
+    state->workerOpCtxs.erase(opCtx);
+    if (!status.isOK() && !state->cancelled) {
+        state->status = status;
+        state->cancel_inlock();
+    }
+    --state->numRunning;
+    state->cv.notify_all();
+}
+
+}  // namespace mongo
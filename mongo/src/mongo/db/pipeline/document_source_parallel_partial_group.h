@@ -0,0 +1,149 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include "mongo/db/pipeline/document_source.h"
+
+namespace mongo {
+
+class Collection;
+class DocumentSourceGroup;
+class ThreadPool;
+
+/**
+ * This class is not a registered stage. It replaces the stages which feed a $group, and the first
+ * half of the $group itself, when the $group's input is a scan of a whole collection.
+ *
+ * The collection is split into ranges of RecordIds, and each range is scanned on its own thread by
+ * a pipeline made of the replaced stages, whose $group produces partial results as it would on a
+ * shard. This stage returns those partial results, in no particular order, for the merging half of
+ * the $group (see DocumentSourceGroup::getMergeSources()) to combine.
+ */
+class DocumentSourceParallelPartialGroup final : public DocumentSource {
+public:
+    ~DocumentSourceParallelPartialGroup();
+
+    GetNextResult getNext() final;
+    const char* getSourceName() const final;
+    Value serialize(boost::optional<ExplainOptions::Verbosity> explain = boost::none) const final;
+
+    StageConstraints constraints(Pipeline::SplitState pipeState) const final {
+        StageConstraints constraints(StreamType::kBlocking,
+                                     PositionRequirement::kFirst,
+                                     HostTypeRequirement::kAnyShard,
+                                     DiskUseRequirement::kWritesTmpData,
+                                     FacetRequirement::kNotAllowed);
+
+        constraints.requiresInputDocSource = false;
+        return constraints;
+    }
+
+    /**
+     * Returns true if 'group' computes the same result however its input is divided among the
+     * threads: it must not be a merging $group, and each of its accumulators must be insensitive
+     * to the order of its input.
+     */
+    static bool canRunInParallel(const DocumentSourceGroup& group);
+
+    /**
+     * Reserves up to 'numWorkers' of the threads internalDocumentSourceGroupParallelMaxTotalWorkers
+     * allows across the server, and returns how many were reserved. Reserves nothing, and returns
+     * 0, if fewer than two are available.
+     */
+    static size_t reserveWorkers(size_t numWorkers);
+
+    /**
+     * Creates a stage which runs 'stages' over the documents of 'collection' that match 'query',
+     * split across 'numWorkers' threads. The last of 'stages' must be a $group for which
+     * canRunInParallel() is true, and each of the others must process every document on its own.
+     * The stage takes over 'numWorkers' threads reserved by reserveWorkers(), and releases them
+     * when it is destroyed.
+     */
+    static boost::intrusive_ptr<DocumentSourceParallelPartialGroup> create(
+        const boost::intrusive_ptr<ExpressionContext>& expCtx,
+        const Collection* collection,
+        const BSONObj& query,
+        const Pipeline::SourceContainer& stages,
+        size_t numWorkers);
+
+protected:
+    void doDispose() final;
+
+private:
+    /**
+     * The description of the scan, and the results and status of the workers.
+     */
+    struct SharedState;
+
+    /**
+     * The part of the collection a single worker scans, and the context it parses its stages in.
+     */
+    struct Worker;
+
+    DocumentSourceParallelPartialGroup(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                                       std::unique_ptr<SharedState> state,
+                                       size_t numWorkers);
+
+    /**
+     * Divides the collection into ranges of RecordIds and starts a worker scanning each of them.
+     */
+    void startWorkers();
+
+    /**
+     * Cancels any workers still running and waits for them to exit.
+     */
+    void stopWorkers();
+
+    /**
+     * Runs the stages over the range of 'worker' on the calling thread, adding the results to
+     * 'state'. Never throws: an error is recorded in 'state' and cancels the other workers.
+     */
+    static void runWorker(SharedState* state, Worker* worker);
+
+    /**
+     * Returns 'numWorkers' threads reserved by reserveWorkers().
+     */
+    static void releaseWorkers(size_t numWorkers);
+
+    const size_t _numWorkers;
+
+    // Must outlive the workers, which is why the pool is stopped before this stage is destroyed.
+    const std::unique_ptr<SharedState> _state;
+
+    // A pool of its own rather than one shared by the process, so that every range is scanned as
+    // soon as this stage starts, and stopping the workers never waits behind another operation.
+    // Its size is bounded by the threads this stage reserved.
+    std::unique_ptr<ThreadPool> _pool;
+
+    bool _started = false;
+};
+
+}  // namespace mongo
@@ -40,6 +40,7 @@
 #include "mongo/db/catalog/database_holder.h"
 #include "mongo/db/catalog/document_validation.h"
 #include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/catalog/index_catalog_entry.h"
 #include "mongo/db/concurrency/d_concurrency.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/db_raii.h"
@@ -50,22 +51,30 @@
 #include "mongo/db/exec/shard_filter.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/index/index_access_method.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/index_names.h"
 #include "mongo/db/matcher/extensions_callback_real.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/document_source_change_stream.h"
 #include "mongo/db/pipeline/document_source_cursor.h"
+#include "mongo/db/pipeline/document_source_group.h"
 #include "mongo/db/pipeline/document_source_match.h"
 #include "mongo/db/pipeline/document_source_merge_cursors.h"
+#include "mongo/db/pipeline/document_source_parallel_partial_group.h"
 #include "mongo/db/pipeline/document_source_sample.h"
 #include "mongo/db/pipeline/document_source_sample_from_random_cursor.h"
 #include "mongo/db/pipeline/document_source_single_document_transformation.h"
 #include "mongo/db/pipeline/document_source_sort.h"
+#include "mongo/db/pipeline/document_source_unwind.h"
 #include "mongo/db/pipeline/pipeline.h"
 #include "mongo/db/query/collation/collator_interface.h"
+#include "mongo/db/query/explain.h"
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/plan_summary_stats.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
+#include "mongo/db/repl/read_concern_args.h"
 #include "mongo/db/s/collection_metadata.h"
 #include "mongo/db/s/collection_sharding_state.h"
 #include "mongo/db/s/metadata_manager.h"
@@ -160,6 +169,47 @@ public:
         return appendCollectionRecordCount(_ctx->opCtx, nss, builder);
     }
 
+    boost::optional<JoinCollectionStats> getJoinCollectionStats(
+        const NamespaceString& nss,
+        const FieldPath& joinField,
+        const CollatorInterface* collator) final {
+        AutoGetCollectionForReadCommand autoColl(_ctx->opCtx, nss);
+        Collection* collection = autoColl.getCollection();
+        if (!collection) {
+            return boost::none;
+        }
+
+        // This shard only holds some of a sharded collection's documents. Detected as in
+        // isSharded().
+        auto css = CollectionShardingState::get(_ctx->opCtx, nss);
+        if (css->getMetadata()) {
+            return boost::none;
+        }
+
+        JoinCollectionStats stats;
+        stats.numRecords = collection->numRecords(_ctx->opCtx);
+        stats.dataSizeBytes = collection->dataSize(_ctx->opCtx);
+
+        const IndexCatalog* indexCatalog = collection->getIndexCatalog();
+        IndexCatalog::IndexIterator ii = indexCatalog->getIndexIterator(_ctx->opCtx, false);
+        while (ii.more()) {
+            const IndexDescriptor* desc = ii.next();
+            if (desc->isPartial() ||
+                IndexNames::findPluginName(desc->keyPattern()) != IndexNames::BTREE ||
+                desc->keyPattern().firstElementFieldName() != joinField.fullPath()) {
+                continue;
+            }
+
+            if (CollatorInterface::collatorsMatch(ii.catalogEntry(desc)->getCollator(),
+                                                  collator)) {
+                stats.hasJoinFieldIndex = true;
+                break;
+            }
+        }
+
+        return stats;
+    }
+
     BSONObj getCollectionOptions(const NamespaceString& nss) final {
         const auto infos =
             _client.getCollectionInfos(nss.db().toString(), BSON("name" << nss.coll()));
@@ -577,6 +627,81 @@ BSONObj removeSortKeyMetaProjection(BSONObj projectionObj) {
     }
     return projectionObj.removeField(Document::metaFieldSortKey);
 }
+
+/**
+ * If 'exec' scans all of 'collection', and 'sources' begins with stages which process each
+ * document on its own followed by a $group, replaces those stages and the $group with a
+ * DocumentSourceParallelPartialGroup, which runs them on several threads, and the stages which
+ * merge its partial groups. Returns true if it did so, in which case 'exec' is no longer needed.
+ */
+bool attemptToParallelizeGroup(Collection* collection,
+                               const intrusive_ptr<ExpressionContext>& expCtx,
+                               const AggregationRequest* aggRequest,
+                               const BSONObj& queryObj,
+                               const PlanExecutor* exec,
+                               Pipeline::SourceContainer* sources) {
+    const int maxWorkers = internalDocumentSourceGroupParallelWorkers.load();
+    auto opCtx = expCtx->opCtx;
+
+    // Only a top-level aggregation over a local, unsharded collection. The workers scan disjoint
+    // ranges of RecordIds, which needs records that never move, as with document-level locking.
+    if (maxWorkers <= 1 || !collection || !aggRequest || collection->isCapped() ||
+        expCtx->tailableMode != TailableMode::kNormal || !supportsDocLocking() ||
+        repl::ReadConcernArgs::get(opCtx).getLevel() !=
+            repl::ReadConcernLevel::kLocalReadConcern ||
+        ShardingState::get(opCtx)->needCollectionMetadata(opCtx, collection->ns().ns()) ||
+        DocumentSourceMatch::isTextQuery(queryObj)) {
+        return false;
+    }
+
+    const std::string planSummary = Explain::getPlanSummary(exec);
+    if (planSummary != "COLLSCAN" && planSummary != "PARALLEL_COLLSCAN") {
+        return false;
+    }
+
+    auto groupIt = sources->begin();
+    for (; groupIt != sources->end(); ++groupIt) {
+        auto stage = groupIt->get();
+        if (dynamic_cast<DocumentSourceGroup*>(stage)) {
+            break;
+        }
+        if (!dynamic_cast<DocumentSourceMatch*>(stage) &&
+            !dynamic_cast<DocumentSourceSingleDocumentTransformation*>(stage) &&
+            !dynamic_cast<DocumentSourceUnwind*>(stage)) {
+            return false;
+        }
+    }
+    if (groupIt == sources->end()) {
+        return false;
+    }
+    auto group = static_cast<DocumentSourceGroup*>(groupIt->get());
+    if (!DocumentSourceParallelPartialGroup::canRunInParallel(*group)) {
+        return false;
+    }
+
+    const long long minRecordsPerWorker =
+        std::max(1, internalDocumentSourceGroupParallelMinRecordsPerWorker.load());
+    const long long numRecords = static_cast<long long>(collection->numRecords(opCtx));
+    const long long numWorkers =
+        std::min(static_cast<long long>(maxWorkers), numRecords / minRecordsPerWorker);
+    if (numWorkers <= 1) {
+        return false;
+    }
+    const size_t numReserved =
+        DocumentSourceParallelPartialGroup::reserveWorkers(static_cast<size_t>(numWorkers));
+    if (0U == numReserved) {
+        return false;
+    }
+
+    const auto groupEnd = std::next(groupIt);
+    Pipeline::SourceContainer partialStages(sources->begin(), groupEnd);
+    auto mergeSources = group->getMergeSources();
+    sources->erase(sources->begin(), groupEnd);
+    sources->splice(sources->begin(), mergeSources);
+    sources->push_front(DocumentSourceParallelPartialGroup::create(
+        expCtx, collection, queryObj, partialStages, numReserved));
+    return true;
+}
 }  // namespace
 
 void PipelineD::injectMongodInterface(Pipeline* pipeline) {
@@ -688,6 +813,9 @@ void PipelineD::prepareCursorSource(Collection* collection,
                                                 &sortObj,
                                                 &projForQuery));
 
+    if (attemptToParallelizeGroup(collection, expCtx, aggRequest, queryObj, exec.get(), &sources)) {
+        return;
+    }
 
     if (!projForQuery.isEmpty() && !sources.empty()) {
         // Check for redundant $project in query with the same specification as the inclusion
@@ -80,6 +80,13 @@ public:
         MONGO_UNREACHABLE;
     }
 
+    boost::optional<JoinCollectionStats> getJoinCollectionStats(
+        const NamespaceString& nss,
+        const FieldPath& joinField,
+        const CollatorInterface* collator) override {
+        MONGO_UNREACHABLE;
+    }
+
     BSONObj getCollectionOptions(const NamespaceString& nss) override {
         MONGO_UNREACHABLE;
     }
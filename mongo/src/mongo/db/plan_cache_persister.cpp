@@ -0,0 +1,262 @@
+// plan_cache_persister.cpp
+
+/**
+*    Copyright (C) 2017 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/plan_cache_persister.h"
+
+#include "mongo/base/counter.h"
+#include "mongo/client/dbclientcursor.h"
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands/plan_cache_commands.h"
+#include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/dbdirectclient.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/db/query/plan_cache.h"
+#include "mongo/db/repl/replication_coordinator_global.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage/storage_engine.h"
+#include "mongo/util/background.h"
+#include "mongo/util/concurrency/idle_thread_block.h"
+#include "mongo/util/exit.h"
+#include "mongo/util/log.h"
+
+namespace mongo {
+
+Counter64 planCacheSnapshotPasses;
+Counter64 planCacheSnapshotEntriesRestored;
+
+ServerStatusMetricField<Counter64> planCacheSnapshotPassesDisplay("query.planCache.snapshot.passes",
+                                                                  &planCacheSnapshotPasses);
+ServerStatusMetricField<Counter64> planCacheSnapshotEntriesRestoredDisplay(
+    "query.planCache.snapshot.entriesRestored", &planCacheSnapshotEntriesRestored);
+
+MONGO_EXPORT_SERVER_PARAMETER(planCacheSnapshotEnabled, bool, false);
+MONGO_EXPORT_SERVER_PARAMETER(planCacheSnapshotIntervalSecs, int, 300);
+
+namespace {
+
+const NamespaceString kPlanCacheSnapshotNamespace("local.planCacheSnapshot");
+
+/**
+ * Snapshots are written to the unreplicated 'local' database, so every member keeps its own copy.
+ * A member reloads its snapshot the first time it is able to serve reads after startup, and
+ * again whenever it becomes primary.
+ */
+class PlanCachePersister : public BackgroundJob {
+public:
+    std::string name() const override {
+        return "PlanCachePersister";
+    }
+
+    void run() override {
+        Client::initThread(name().c_str());
+        AuthorizationSession::get(cc())->grantInternalAuthorization();
+
+        bool restoredSinceStartup = false;
+        bool wasPrimary = false;
+        Date_t lastSnapshot = Date_t::now();
+
+        while (!globalInShutdownDeprecated()) {
+            {
+                MONGO_IDLE_THREAD_BLOCK;
+                sleepsecs(1);
+            }
+
+            if (!planCacheSnapshotEnabled.load()) {
+                continue;
+            }
+
+            auto replCoord = repl::getGlobalReplicationCoordinator();
+            const bool isReplSet =
+                replCoord->getReplicationMode() == repl::ReplicationCoordinator::modeReplSet;
+            const repl::MemberState memberState = replCoord->getMemberState();
+            if (isReplSet && !memberState.readable()) {
+                wasPrimary = false;
+                continue;
+            }
+            const bool isPrimary = !isReplSet || memberState.primary();
+
+            try {
+                if (!restoredSinceStartup || (isPrimary && !wasPrimary)) {
+                    restoredSinceStartup = true;
+                    doRestorePass();
+                } else if (isPrimary &&
+                           Date_t::now() - lastSnapshot >=
+                               Seconds(planCacheSnapshotIntervalSecs.load())) {
+                    lastSnapshot = Date_t::now();
+                    doSnapshotPass();
+                }
+            } catch (const DBException& ex) {
+                warning() << "plan cache snapshot pass failed: " << redact(ex);
+            }
+            wasPrimary = isPrimary;
+        }
+    }
+
+private:
+    /**
+     * Replaces the snapshot of every collection's plan cache. Collections are visited one at a
+     * time under an intent lock so that the pass never blocks writers for long.
+     *
+     * Only a writable primary or a standalone takes snapshots. A secondary's cache, usually
+     * empty, would otherwise replace the snapshot it saved as primary, leaving nothing to restore
+     * when it steps up again. For the same reason a collection whose cache is empty keeps its
+     * previous snapshot, whose stale entries are skipped when it is restored.
+     */
+    void doSnapshotPass() {
+        const ServiceContext::UniqueOperationContext opCtxPtr = cc().makeOperationContext();
+        OperationContext* opCtx = opCtxPtr.get();
+
+        if (!repl::getGlobalReplicationCoordinator()->canAcceptWritesForDatabase_UNSAFE(
+                opCtx, NamespaceString::kAdminDb)) {
+            return;
+        }
+
+        std::vector<std::string> dbNames;
+        getGlobalServiceContext()->getGlobalStorageEngine()->listDatabases(&dbNames);
+
+        planCacheSnapshotPasses.increment();
+
+        for (const std::string& dbName : dbNames) {
+            if (dbName == NamespaceString::kLocalDb) {
+                continue;
+            }
+
+            std::vector<NamespaceString> collectionNames;
+            {
+                AutoGetDb autoDb(opCtx, dbName, MODE_IS);
+                if (!autoDb.getDb()) {
+                    continue;
+                }
+                for (auto&& collection : *autoDb.getDb()) {
+                    collectionNames.push_back(collection->ns());
+                }
+            }
+
+            for (const NamespaceString& nss : collectionNames) {
+                std::vector<BSONObj> docs;
+                {
+                    AutoGetCollection autoColl(opCtx, nss, MODE_IS);
+                    Collection* collection = autoColl.getCollection();
+                    if (!collection) {
+                        continue;
+                    }
+                    PlanCache* planCache = collection->infoCache()->getPlanCache();
+                    for (PlanCacheEntry* rawEntry : planCache->getAllEntries()) {
+                        std::unique_ptr<PlanCacheEntry> entry(rawEntry);
+                        BSONObjBuilder bob;
+                        bob.append("ns", nss.ns());
+                        entry->serialize(&bob);
+                        docs.push_back(bob.obj());
+                    }
+                }
+
+                if (docs.empty()) {
+                    continue;
+                }
+
+                DBDirectClient client(opCtx);
+                client.remove(kPlanCacheSnapshotNamespace.ns(), BSON("ns" << nss.ns()));
+                std::string error = client.getLastError();
+                if (error.empty()) {
+                    client.insert(kPlanCacheSnapshotNamespace.ns(), docs);
+                    error = client.getLastError();
+                }
+                if (!error.empty()) {
+                    warning() << "failed to snapshot the plan cache of " << nss << ": " << error;
+                }
+            }
+        }
+    }
+
+    /**
+     * Reloads the snapshot into the plan caches. Each entry is re-validated against the current
+     * index catalog by PlanCache::addFromSnapshot(); stale entries are skipped.
+     */
+    void doRestorePass() {
+        const ServiceContext::UniqueOperationContext opCtxPtr = cc().makeOperationContext();
+        OperationContext* opCtx = opCtxPtr.get();
+
+        std::vector<BSONObj> docs;
+        {
+            DBDirectClient client(opCtx);
+            auto cursor = client.query(kPlanCacheSnapshotNamespace.ns(), Query());
+            while (cursor && cursor->more()) {
+                docs.push_back(cursor->nextSafe().getOwned());
+            }
+        }
+
+        size_t restored = 0;
+        for (const BSONObj& doc : docs) {
+            const NamespaceString nss(doc["ns"].str());
+            AutoGetCollection autoColl(opCtx, nss, MODE_IS);
+            Collection* collection = autoColl.getCollection();
+            if (!collection) {
+                continue;
+            }
+
+            auto statusWithCQ = PlanCacheCommand::canonicalize(opCtx, nss.ns(), doc);
+            if (!statusWithCQ.isOK()) {
+                LOG(1) << "skipping plan cache snapshot entry " << redact(doc) << ": "
+                       << statusWithCQ.getStatus();
+                continue;
+            }
+
+            PlanCache* planCache = collection->infoCache()->getPlanCache();
+            Status status = planCache->addFromSnapshot(*statusWithCQ.getValue(), doc);
+            if (!status.isOK()) {
+                LOG(1) << "skipping plan cache snapshot entry " << redact(doc) << ": " << status;
+                continue;
+            }
+            ++restored;
+        }
+
+        planCacheSnapshotEntriesRestored.increment(restored);
+        LOG(1) << "restored " << restored << " of " << docs.size()
+               << " plan cache snapshot entries";
+    }
+};
+
+}  // namespace
+
+void startPlanCachePersisterBackgroundJob() {
+    PlanCachePersister* persister = new PlanCachePersister();
+    persister->go();
+}
+
+}  // namespace mongo
@@ -324,6 +324,25 @@ void CanonicalQuery::setCollator(std::unique_ptr<CollatorInterface> collator) {
     _root->setCollator(_collator.get());
 }
 
+namespace {
+
+/**
+ * Returns true if matching _id against 'elt' is an exact lookup of one key in the _id index.
+ */
+bool isExactIdValue(const BSONElement& elt) {
+    if (elt.type() == Object) {
+        // If the value is an object, it can't have a query operator
+        // (must be a literal object match).
+        return elt.Obj().firstElementFieldName()[0] != '$';
+    }
+
+    // The _id fild cannot be something like { _id : { $gt : ...
+    // But it can be BinData.
+    return Indexability::isExactBoundsGenerating(elt);
+}
+
+}  // namespace
+
 // static
 bool CanonicalQuery::isSimpleIdQuery(const BSONObj& query) {
     bool hasID = false;
@@ -335,15 +354,7 @@ bool CanonicalQuery::isSimpleIdQuery(const BSONObj& query) {
             // Verify that the query on _id is a simple equality.
             hasID = true;
 
-            if (elt.type() == Object) {
-                // If the value is an object, it can't have a query operator
-                // (must be a literal object match).
-                if (elt.Obj().firstElementFieldName()[0] == '$') {
-                    return false;
-                }
-            } else if (!Indexability::isExactBoundsGenerating(elt)) {
-                // The _id fild cannot be something like { _id : { $gt : ...
-                // But it can be BinData.
+            if (!isExactIdValue(elt)) {
                 return false;
             }
         } else if (elt.fieldName()[0] == '$' && (str::equals("$isolated", elt.fieldName()) ||
@@ -358,6 +369,40 @@ bool CanonicalQuery::isSimpleIdQuery(const BSONObj& query) {
     return hasID;
 }
 
+// static
+bool CanonicalQuery::isSimpleIdInQuery(const BSONObj& query, size_t maxValues) {
+    bool hasIn = false;
+
+    for (auto&& elt : query) {
+        if (str::equals("_id", elt.fieldName())) {
+            // The query on _id must be exactly {$in: [<values>]}.
+            if (elt.type() != Object) {
+                return false;
+            }
+            BSONObj inObj = elt.Obj();
+            if (inObj.nFields() != 1 || !str::equals("$in", inObj.firstElementFieldName()) ||
+                inObj.firstElement().type() != Array) {
+                return false;
+            }
+
+            size_t nValues = 0;
+            for (auto&& value : inObj.firstElement().Obj()) {
+                if (++nValues > maxValues || !isExactIdValue(value)) {
+                    return false;
+                }
+            }
+            hasIn = true;
+        } else if (elt.fieldName()[0] == '$' && (str::equals("$isolated", elt.fieldName()) ||
+                                                 str::equals("$atomic", elt.fieldName()))) {
+            // ok, passthrough
+        } else {
+            return false;
+        }
+    }
+
+    return hasIn;
+}
+
 
 //CanonicalQuery::canonicalize->MatchExpressionParser::parseɲѯfilterвԭʼtree
 //CanonicalQuery::canonicalize->CanonicalQuery::init->MatchExpression::optimizeԭʼtreeеһŻ(AND OR NORŻӦListOfMatchExpression::getOptimizer())
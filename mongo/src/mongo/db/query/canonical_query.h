@@ -108,6 +108,12 @@ public:
      */
     static bool isSimpleIdQuery(const BSONObj& query);
 
+    /**
+     * Returns true if "query" is an $in over at most 'maxValues' values on _id, each of which
+     * would be accepted by isSimpleIdQuery(), possibly with the $isolated/$atomic modifier.
+     */
+    static bool isSimpleIdInQuery(const BSONObj& query, size_t maxValues);
+
     const NamespaceString& nss() const {
         return _qr->nss();
     }
@@ -421,5 +421,26 @@ TEST(CanonicalQueryTest, NorWithOneChildNormalizedAfterNormalizingChild) {
     ASSERT_EQ(MatchExpression::EQ, root->getChild(0)->matchType());
 }
 
+TEST(CanonicalQueryTest, IsSimpleIdInQuery) {
+    ASSERT_TRUE(CanonicalQuery::isSimpleIdInQuery(fromjson("{_id: {$in: [1, 'a', {b: 1}]}}"), 3));
+    ASSERT_TRUE(CanonicalQuery::isSimpleIdInQuery(fromjson("{_id: {$in: []}}"), 3));
+    ASSERT_TRUE(CanonicalQuery::isSimpleIdInQuery(fromjson("{_id: {$in: [1]}, $isolated: 1}"), 3));
+
+    // Too many values.
+    ASSERT_FALSE(CanonicalQuery::isSimpleIdInQuery(fromjson("{_id: {$in: [1, 2, 3, 4]}}"), 3));
+
+    // Values that are not exact lookups in the _id index.
+    ASSERT_FALSE(CanonicalQuery::isSimpleIdInQuery(fromjson("{_id: {$in: [1, null]}}"), 3));
+    ASSERT_FALSE(CanonicalQuery::isSimpleIdInQuery(fromjson("{_id: {$in: [1, /a/]}}"), 3));
+    ASSERT_FALSE(CanonicalQuery::isSimpleIdInQuery(fromjson("{_id: {$in: [[1, 2]]}}"), 3));
+
+    // Not just an $in on _id.
+    ASSERT_FALSE(CanonicalQuery::isSimpleIdInQuery(fromjson("{_id: 1}"), 3));
+    ASSERT_FALSE(CanonicalQuery::isSimpleIdInQuery(fromjson("{_id: {$in: [1], $ne: 2}}"), 3));
+    ASSERT_FALSE(CanonicalQuery::isSimpleIdInQuery(fromjson("{_id: {$nin: [1]}}"), 3));
+    ASSERT_FALSE(CanonicalQuery::isSimpleIdInQuery(fromjson("{_id: {$in: [1]}, a: 1}"), 3));
+    ASSERT_FALSE(CanonicalQuery::isSimpleIdInQuery(fromjson("{a: {$in: [1]}}"), 3));
+}
+
 }  // namespace
 }  // namespace mongo
@@ -151,7 +151,7 @@ size_t getKeysExamined(StageType type, const SpecificStats* specific) {
  * (in which case this gets called from Explain::getSummaryStats()).
  */
 size_t getDocsExamined(StageType type, const SpecificStats* specific) {
-    if (STAGE_COLLSCAN == type) {
+    if (STAGE_COLLSCAN == type || STAGE_PARALLEL_COLLSCAN == type) {
         const CollectionScanStats* spec = static_cast<const CollectionScanStats*>(specific);
         return spec->docsTested;
     } else if (STAGE_FETCH == type) {
@@ -352,6 +352,12 @@ void Explain::statsToBSON(const PlanStageStats& stats,
         bob->appendNumber("restoreState", stats.common.unyields);
         bob->appendNumber("isEOF", stats.common.isEOF);
         bob->appendNumber("invalidates", stats.common.invalidates);
+        if (stats.common.batches > 0) {
+            bob->appendNumber("batches", stats.common.batches);
+            bob->append("avgBatchSize",
+                        static_cast<double>(stats.common.batchedResults) /
+                            stats.common.batches);
+        }
     }
 
     // Stage-specific stats
@@ -362,6 +368,7 @@ void Explain::statsToBSON(const PlanStageStats& stats,
             bob->appendNumber("memUsage", spec->memUsage);
             bob->appendNumber("memLimit", spec->memLimit);
 
+            bob->appendBool("recordIdsOnly", spec->recordIdsOnly);
             bob->appendNumber("flaggedButPassed", spec->flaggedButPassed);
             bob->appendNumber("flaggedInProgress", spec->flaggedInProgress);
             for (size_t i = 0; i < spec->mapAfterChild.size(); ++i) {
@@ -378,14 +385,20 @@ void Explain::statsToBSON(const PlanStageStats& stats,
                 bob->appendNumber(string(stream() << "failedAnd_" << i), spec->failedAnd[i]);
             }
         }
-    } else if (STAGE_COLLSCAN == stats.stageType) {
+    } else if (STAGE_COLLSCAN == stats.stageType || STAGE_PARALLEL_COLLSCAN == stats.stageType) {
         CollectionScanStats* spec = static_cast<CollectionScanStats*>(stats.specific.get());
         bob->append("direction", spec->direction > 0 ? "forward" : "backward");
         if (spec->maxTs) {
             bob->append("maxTs", *(spec->maxTs));
         }
+        if (STAGE_PARALLEL_COLLSCAN == stats.stageType) {
+            bob->appendNumber("parallelism", spec->parallelism);
+        }
         if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
             bob->appendNumber("docsExamined", spec->docsTested);
+            if (STAGE_PARALLEL_COLLSCAN == stats.stageType) {
+                bob->appendNumber("partitions", spec->partitions);
+            }
         }
     } else if (STAGE_COUNT == stats.stageType) {
         CountStats* spec = static_cast<CountStats*>(stats.specific.get());
@@ -415,12 +428,20 @@ void Explain::statsToBSON(const PlanStageStats& stats,
         bob->appendBool("isPartial", spec->isPartial);
         bob->append("indexVersion", spec->indexVersion);
 
-        BSONObjBuilder indexBoundsBob;
-        indexBoundsBob.append("startKey", spec->startKey);
-        indexBoundsBob.append("startKeyInclusive", spec->startKeyInclusive);
-        indexBoundsBob.append("endKey", spec->endKey);
-        indexBoundsBob.append("endKeyInclusive", spec->endKeyInclusive);
-        bob->append("indexBounds", indexBoundsBob.obj());
+        if (!spec->indexBounds.isEmpty()) {
+            if ((topLevelBob->len() + spec->indexBounds.objsize()) > kMaxStatsBSONSize) {
+                bob->append("warning", "index bounds omitted due to BSON size limit");
+            } else {
+                bob->append("indexBounds", spec->indexBounds);
+            }
+        } else {
+            BSONObjBuilder indexBoundsBob;
+            indexBoundsBob.append("startKey", spec->startKey);
+            indexBoundsBob.append("startKeyInclusive", spec->startKeyInclusive);
+            indexBoundsBob.append("endKey", spec->endKey);
+            indexBoundsBob.append("endKeyInclusive", spec->endKeyInclusive);
+            bob->append("indexBounds", indexBoundsBob.obj());
+        }
     } else if (STAGE_DELETE == stats.stageType) {
         DeleteStats* spec = static_cast<DeleteStats*>(stats.specific.get());
 
@@ -466,6 +487,10 @@ void Explain::statsToBSON(const PlanStageStats& stats,
         if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
             bob->appendNumber("docsExamined", spec->docsExamined);
             bob->appendNumber("alreadyHasObj", spec->alreadyHasObj);
+            if (spec->windowSize > 0) {
+                bob->appendNumber("windowSize", spec->windowSize);
+                bob->appendNumber("windows", spec->windows);
+            }
         }
     } else if (STAGE_GEO_NEAR_2D == stats.stageType || STAGE_GEO_NEAR_2DSPHERE == stats.stageType) {
         NearStats* spec = static_cast<NearStats*>(stats.specific.get());
@@ -487,6 +512,11 @@ void Explain::statsToBSON(const PlanStageStats& stats,
                 intervalBob.appendNumber("nReturned", it->numResultsReturned);
             }
             intervalsBob.doneFast();
+
+            if (spec->cellsVisited > 0) {
+                bob->appendNumber("cellsVisited", spec->cellsVisited);
+                bob->appendNumber("cellsScanned", spec->cellsScanned);
+            }
         }
     } else if (STAGE_GROUP == stats.stageType) {
         GroupStats* spec = static_cast<GroupStats*>(stats.specific.get());
@@ -560,6 +590,11 @@ void Explain::statsToBSON(const PlanStageStats& stats,
         if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
             bob->appendNumber("memUsage", spec->memUsage);
             bob->appendNumber("memLimit", spec->memLimit);
+            if (spec->usedDisk) {
+                bob->appendBool("usedDisk", true);
+                bob->appendNumber("spills", spec->spills);
+            }
+            bob->appendBool("normalizedKeys", spec->normalizedKeys);
         }
 
         if (spec->limit > 0) {
@@ -589,6 +624,10 @@ void Explain::statsToBSON(const PlanStageStats& stats,
     } else if (STAGE_TEXT_OR == stats.stageType) {
         TextOrStats* spec = static_cast<TextOrStats*>(stats.specific.get());
 
+        if (spec->topK > 0) {
+            bob->appendNumber("topK", spec->topK);
+        }
+
         if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
             bob->appendNumber("docsExamined", spec->fetches);
         }
@@ -844,6 +883,19 @@ void Explain::explainStages(PlanExecutor* exec,
             durationCount<Milliseconds>(CurOp::get(opCtx)->elapsedTimeTotal());
         generateExecStats(winningStats.get(), verbosity, &execBob, totalTimeMillis);
 
+        // Report how the executor's working set obtained its members. The working set is shared
+        // by all candidate plans, so this includes any work done during the trial period.
+        const WorkingSet::Stats& wsStats = exec->getWorkingSet()->getStats();
+        BSONObjBuilder wsBob(execBob.subobjStart("workingSet"));
+        wsBob.appendNumber("allocations", wsStats.allocations);
+        wsBob.appendNumber("recycled", wsStats.recycled);
+        wsBob.appendNumber("membersCreated", wsStats.membersCreated);
+        wsBob.appendNumber("slabs", wsStats.slabs);
+        // Members reused from the free list never needed the heap, slabs or not, so only count
+        // the members a slab saved from being allocated one by one.
+        wsBob.appendNumber("heapAllocationsAvoided", wsStats.membersCreated - wsStats.slabs);
+        wsBob.doneFast();
+
         // Also generate exec stats for all plans, if the verbosity level is high enough.
         // These stats reflect what happened during the trial period that ranked the plans.
         if (verbosity >= ExplainOptions::Verbosity::kExecAllPlans) {
@@ -59,4 +59,8 @@ extern AtomicInt32 internalQueryS2GeoCoarsestLevel;
 // What is the maximum cell count that we want? (advisory, not a hard threshold)
 extern AtomicInt32 internalQueryS2GeoMaxCells;
 
+// Should spherical $near queries on a 2dsphere index search cells best-first, in order of their
+// distance from the search point, rather than in expanding annuli?
+extern AtomicBool internalQueryS2GeoNearBestFirst;
+
 }  // namespace mongo
@@ -117,13 +117,6 @@ void filterAllowedIndexEntries(const AllowedIndicesFilter& allowedIndicesFilter,
     temp.swap(*indexEntries);
 }
 
-namespace {
-// The body is below in the "count hack" section but getExecutor calls it.
-bool turnIxscanIntoCount(QuerySolution* soln);
-
-}  // namespace
-
-
 //ȡcollectionӦQueryPlannerParamsϢ
 //ȡcollection϶ӦϢ洢indicesУͬʱԲʼֵ
 void fillOutPlannerParams(OperationContext* opCtx,
@@ -147,6 +140,8 @@ void fillOutPlannerParams(OperationContext* opCtx,
                                                     ice->getFilterExpression(),
                                                     desc->infoObj(),
                                                     ice->getCollator()));
+        plannerParams->indices.back().statistics =
+            collection->infoCache()->getIndexStatistics(desc->indexName());
     }
 
     // If query supports index filters, filter params.indices by indices in query settings.
@@ -573,8 +568,13 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>>
 	//ִQuerySolutionPlanStage. Ϣն뵽PrepareExecutionResultṹ
 
 	//ɺѡquerySolutionӦPlanStage
+	// Every caller of getExecutor() only reads, so its collection scans may run in parallel.
 	StatusWith<PrepareExecutionResult> executionResult =
-        prepareExecution(opCtx, collection, ws.get(), std::move(canonicalQuery), plannerOptions);
+        prepareExecution(opCtx,
+                         collection,
+                         ws.get(),
+                         std::move(canonicalQuery),
+                         plannerOptions | QueryPlannerParams::ALLOW_PARALLEL_COLLSCAN);
 	
     if (!executionResult.isOK()) {
         return executionResult.getStatus();
@@ -1200,14 +1200,6 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getExecutorGroup(
 // Count hack
 //
 
-namespace {
-
-/**
- * Returns 'true' if the provided solution 'soln' can be rewritten to use
- * a fast counting stage.  Mutates the tree in 'soln->root'.
- *
- * Otherwise, returns 'false'.
- */
 bool turnIxscanIntoCount(QuerySolution* soln) {
     QuerySolutionNode* root = soln->root.get();
 
@@ -1230,36 +1222,47 @@ bool turnIxscanIntoCount(QuerySolution* soln) {
         ? static_cast<IndexScanNode*>(root->children[0])
         : static_cast<IndexScanNode*>(root);
 
-    // No filters allowed and side-stepping isSimpleRange for now.  TODO: do we ever see
-    // isSimpleRange here?  because we could well use it.  I just don't think we ever do see
-    // it.
-
-    if (NULL != isn->filter.get() || isn->bounds.isSimpleRange) {
+    // Side-stepping isSimpleRange for now.  TODO: do we ever see isSimpleRange here?  because
+    // we could well use it.  I just don't think we ever do see it.
+    if (isn->bounds.isSimpleRange) {
         return false;
     }
 
-    // Make sure the bounds are OK.
     BSONObj startKey;
     bool startKeyInclusive;
     BSONObj endKey;
     bool endKeyInclusive;
 
-    if (!IndexBoundsBuilder::isSingleInterval(
+    if (NULL == isn->filter.get() &&
+        IndexBoundsBuilder::isSingleInterval(
             isn->bounds, &startKey, &startKeyInclusive, &endKey, &endKeyInclusive)) {
+        // Make the count node that we replace the fetch + ixscan with.
+        CountScanNode* csn = new CountScanNode(isn->index);
+        csn->startKey = startKey;
+        csn->startKeyInclusive = startKeyInclusive;
+        csn->endKey = endKey;
+        csn->endKeyInclusive = endKeyInclusive;
+        // Takes ownership of 'cn' and deletes the old root.
+        soln->root.reset(csn);
+        return true;
+    }
+
+    // Otherwise count over the full bounds, evaluating the ixscan's filter (if any) against the
+    // index keys.  The count scan only walks the index forwards and has no notion of maxScan.
+    if (1 != isn->direction || isn->maxScan > 0) {
         return false;
     }
 
-    // Make the count node that we replace the fetch + ixscan with.
     CountScanNode* csn = new CountScanNode(isn->index);
-    csn->startKey = startKey;
-    csn->startKeyInclusive = startKeyInclusive;
-    csn->endKey = endKey;
-    csn->endKeyInclusive = endKeyInclusive;
+    csn->bounds = isn->bounds;
+    csn->filter = std::move(isn->filter);
     // Takes ownership of 'cn' and deletes the old root.
     soln->root.reset(csn);
     return true;
 }
 
+namespace {
+
 /**
  * Returns true if indices contains an index that can be used with DistinctNode (the "fast distinct
  * hack" node, which can be used only if there is an empty query predicate).  Sets indexOut to the
@@ -1441,7 +1444,8 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getExecutorCount(
             opCtx, std::move(ws), std::move(root), request.getNs(), yieldPolicy);
     }
 
-    const size_t plannerOptions = QueryPlannerParams::IS_COUNT;
+    const size_t plannerOptions =
+        QueryPlannerParams::IS_COUNT | QueryPlannerParams::ALLOW_PARALLEL_COLLSCAN;
     StatusWith<PrepareExecutionResult> executionResult =
         prepareExecution(opCtx, collection, ws.get(), std::move(cq), plannerOptions);
     if (!executionResult.isOK()) {
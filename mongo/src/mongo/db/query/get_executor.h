@@ -63,6 +63,16 @@ void fillOutPlannerParams(OperationContext* opCtx,
                           CanonicalQuery* canonicalQuery,
                           QueryPlannerParams* plannerParams);
 
+/**
+ * Returns true if the solution 'soln' can be rewritten to use a fast counting stage, and rewrites
+ * 'soln->root' into a COUNT_SCAN. That is the case when it is an index scan, possibly under a
+ * fetch without a filter. The count scan keeps the index scan's bounds and any residual filter
+ * on its keys. Otherwise, returns false and leaves 'soln' unchanged.
+ *
+ * Exposed for testing.
+ */
+bool turnIxscanIntoCount(QuerySolution* soln);
+
 /**
  * Get a plan executor for a query.
  *
@@ -37,6 +37,7 @@
 
 #include "mongo/bson/simple_bsonobj_comparator.h"
 #include "mongo/db/json.h"
+#include "mongo/db/query/query_planner.h"
 #include "mongo/db/query/query_settings.h"
 #include "mongo/db/query/query_test_service_context.h"
 #include "mongo/stdx/unordered_set.h"
@@ -167,4 +168,67 @@ TEST(GetExecutorTest, GetAllowedIndicesMatchesMultipleIndexesByKey) {
         {"a_1", "a_1:en"});
 }
 
+//
+// turnIxscanIntoCount
+//
+
+/**
+ * Plans a count of the documents matching 'queryStr' over the single index 'index', and returns
+ * the only solution after passing it to turnIxscanIntoCount(). Sets '*converted' to what
+ * turnIxscanIntoCount() returned.
+ */
+unique_ptr<QuerySolution> planCount(const char* queryStr,
+                                    const IndexEntry& index,
+                                    bool* converted) {
+    unique_ptr<CanonicalQuery> cq(canonicalize(queryStr, "{}", "{}"));
+    QueryPlannerParams params;
+    params.options = QueryPlannerParams::IS_COUNT | QueryPlannerParams::NO_TABLE_SCAN;
+    params.indices.push_back(index);
+
+    std::vector<QuerySolution*> solutions;
+    ASSERT_OK(QueryPlanner::plan(*cq, params, &solutions));
+    ASSERT_EQ(solutions.size(), 1U);
+    unique_ptr<QuerySolution> soln(solutions[0]);
+    *converted = turnIxscanIntoCount(soln.get());
+    return soln;
+}
+
+// An index scan with several intervals and a residual filter on its keys becomes a count scan
+// over the same bounds, which applies the filter.
+TEST(GetExecutorTest, CountScanKeepsBoundsAndCoveredFilterOfIndexScan) {
+    bool converted = false;
+    auto soln = planCount("{a: {$in: [1, 5]}, b: /foo/}",
+                          IndexEntry(fromjson("{a: 1, b: 1}"), "a_1_b_1"),
+                          &converted);
+    ASSERT_TRUE(converted);
+    ASSERT_EQ(STAGE_COUNT_SCAN, soln->root->getType());
+
+    const CountScanNode* csn = static_cast<const CountScanNode*>(soln->root.get());
+    ASSERT_TRUE(csn->bounds);
+    ASSERT_EQ(csn->bounds->fields.size(), 2U);
+    ASSERT_EQ(csn->bounds->fields[0].intervals.size(), 2U);
+    ASSERT_TRUE(csn->filter);
+    ASSERT_TRUE(csn->filter->matchesBSON(fromjson("{b: 'xfooy'}")));
+    ASSERT_FALSE(csn->filter->matchesBSON(fromjson("{b: 'bar'}")));
+}
+
+// A filter on a field that is not in the index needs the documents, so the fetch stays.
+TEST(GetExecutorTest, CountScanRequiresFilterCoveredByIndex) {
+    bool converted = true;
+    auto soln = planCount(
+        "{a: {$in: [1, 5]}, c: 1}", IndexEntry(fromjson("{a: 1, b: 1}"), "a_1_b_1"), &converted);
+    ASSERT_FALSE(converted);
+    ASSERT_EQ(STAGE_FETCH, soln->root->getType());
+}
+
+// The keys of a multikey index cannot answer the filter, which must be applied to the documents.
+TEST(GetExecutorTest, CountScanRequiresNonMultikeyIndexForFilter) {
+    IndexEntry index(fromjson("{a: 1, b: 1}"), "a_1_b_1");
+    index.multikey = true;
+    bool converted = true;
+    auto soln = planCount("{a: {$in: [1, 5]}, b: /foo/}", index, &converted);
+    ASSERT_FALSE(converted);
+    ASSERT_EQ(STAGE_FETCH, soln->root->getType());
+}
+
 }  // namespace
@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 
 #include "mongo/db/index/multikey_paths.h"
@@ -38,6 +39,7 @@
 namespace mongo {
 
 class CollatorInterface;
+class IndexStatistics;
 class MatchExpression;
 
 /**
@@ -143,6 +145,9 @@ struct IndexEntry { //IndexEntry
     // Null if this index orders strings according to the simple binary compare. If non-null,
     // represents the collator used to generate index keys for indexed strings.
     const CollatorInterface* collator = nullptr;
+
+    // Null until the index statistics sampler has sampled this index. Used by PlanCostModel.
+    std::shared_ptr<const IndexStatistics> statistics;
 };
 
 }  // namespace mongo
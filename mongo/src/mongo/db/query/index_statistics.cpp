@@ -0,0 +1,196 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/index_statistics.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "mongo/db/query/index_bounds.h"
+#include "mongo/db/query/interval.h"
+
+namespace mongo {
+
+namespace {
+
+int compareValues(const BSONElement& lhs, const BSONElement& rhs) {
+    return lhs.woCompare(rhs, false);
+}
+
+}  // namespace
+
+IndexStatistics::Builder::Builder(size_t numBuckets)
+    : _numBuckets(std::max(size_t(1), numBuckets)) {}
+
+void IndexStatistics::Builder::addSampledDocument(const BSONObjSet& keys) {
+    ++_numSampledDocs;
+    for (auto&& key : keys) {
+        BSONObjBuilder bob;
+        bob.appendAs(key.firstElement(), "");
+        _sampledValues.push_back(bob.obj());
+    }
+}
+
+std::shared_ptr<const IndexStatistics> IndexStatistics::Builder::build(long long numRecords) {
+    std::shared_ptr<IndexStatistics> stats(new IndexStatistics());
+    stats->_numRecords = numRecords;
+
+    const size_t numSampledKeys = _sampledValues.size();
+    if (0 == numSampledKeys) {
+        return stats;
+    }
+
+    std::sort(_sampledValues.begin(),
+              _sampledValues.end(),
+              [](const BSONObj& lhs, const BSONObj& rhs) {
+                  return compareValues(lhs.firstElement(), rhs.firstElement()) < 0;
+              });
+
+    // Group equal values so that no value straddles two buckets.
+    std::vector<std::pair<size_t, size_t>> groups;  // (index of first occurrence, count)
+    for (size_t i = 0; i < numSampledKeys; ++i) {
+        if (!groups.empty() &&
+            0 == compareValues(_sampledValues[groups.back().first].firstElement(),
+                               _sampledValues[i].firstElement())) {
+            ++groups.back().second;
+        } else {
+            groups.emplace_back(i, 1);
+        }
+    }
+
+    stats->_numKeys = static_cast<double>(std::max(numRecords, 0LL)) * numSampledKeys /
+        std::max(size_t(1), _numSampledDocs);
+    const double keyScale = stats->_numKeys / numSampledKeys;
+
+    // Guaranteed-error estimator: values seen once in the sample stand for sqrt(N/n) values in
+    // the collection, values seen more than once are assumed to have been fully discovered.
+    size_t numSingletons = 0;
+    for (auto&& group : groups) {
+        if (1 == group.second) {
+            ++numSingletons;
+        }
+    }
+    const double sampleFraction = std::max(1.0, stats->_numKeys / numSampledKeys);
+    stats->_numDistinctValues = std::sqrt(sampleFraction) * numSingletons +
+        static_cast<double>(groups.size() - numSingletons);
+    stats->_numDistinctValues = std::max(static_cast<double>(groups.size()),
+                                         std::min(stats->_numDistinctValues, stats->_numKeys));
+    const double distinctScale = stats->_numDistinctValues / groups.size();
+
+    stats->_lowerBound = _sampledValues.front();
+
+    const size_t keysPerBucket = (numSampledKeys + _numBuckets - 1) / _numBuckets;
+    size_t bucketKeys = 0;
+    size_t bucketGroups = 0;
+    for (size_t i = 0; i < groups.size(); ++i) {
+        bucketKeys += groups[i].second;
+        ++bucketGroups;
+        if (bucketKeys >= keysPerBucket || i + 1 == groups.size()) {
+            stats->_buckets.push_back({_sampledValues[groups[i].first],
+                                       bucketKeys * keyScale,
+                                       bucketGroups * distinctScale});
+            bucketKeys = 0;
+            bucketGroups = 0;
+        }
+    }
+
+    _sampledValues.clear();
+    return stats;
+}
+
+double IndexStatistics::estimateKeys(const OrderedIntervalList& oil) const {
+    if (_buckets.empty()) {
+        return 0;
+    }
+
+    double estimate = 0;
+    for (auto&& interval : oil.intervals) {
+        BSONElement low = interval.start;
+        BSONElement high = interval.end;
+        bool lowInclusive = interval.startInclusive;
+        bool highInclusive = interval.endInclusive;
+        if (compareValues(low, high) > 0) {
+            std::swap(low, high);
+            std::swap(lowInclusive, highInclusive);
+        }
+
+        if (interval.isPoint()) {
+            if (compareValues(low, _lowerBound.firstElement()) < 0) {
+                continue;
+            }
+            for (auto&& bucket : _buckets) {
+                if (compareValues(low, bucket.upperBound.firstElement()) <= 0) {
+                    estimate += bucket.numKeys / std::max(1.0, bucket.numDistinctValues);
+                    break;
+                }
+            }
+            continue;
+        }
+
+        BSONElement bucketLow = _lowerBound.firstElement();
+        for (auto&& bucket : _buckets) {
+            BSONElement bucketHigh = bucket.upperBound.firstElement();
+            const int lowVsBucketHigh = compareValues(low, bucketHigh);
+            const int highVsBucketLow = compareValues(high, bucketLow);
+            const bool overlaps = (lowVsBucketHigh < 0 || (0 == lowVsBucketHigh && lowInclusive)) &&
+                highVsBucketLow >= 0;
+            if (overlaps) {
+                const bool covers = compareValues(low, bucketLow) <= 0 &&
+                    compareValues(high, bucketHigh) >= 0;
+                estimate += covers ? bucket.numKeys : bucket.numKeys / 2;
+            }
+            bucketLow = bucketHigh;
+        }
+    }
+
+    // The sample may well have missed the values being looked for; never claim a scan is free.
+    return std::min(_numKeys, std::max(1.0, estimate));
+}
+
+BSONObj IndexStatistics::toBSON() const {
+    BSONObjBuilder bob;
+    bob.append("numRecords", _numRecords);
+    bob.append("numKeys", _numKeys);
+    bob.append("numDistinctValues", _numDistinctValues);
+    if (!_buckets.empty()) {
+        bob.appendAs(_lowerBound.firstElement(), "lowerBound");
+    }
+    BSONArrayBuilder histogramBuilder(bob.subarrayStart("histogram"));
+    for (auto&& bucket : _buckets) {
+        BSONObjBuilder bucketBuilder(histogramBuilder.subobjStart());
+        bucketBuilder.appendAs(bucket.upperBound.firstElement(), "upperBound");
+        bucketBuilder.append("numKeys", bucket.numKeys);
+        bucketBuilder.append("numDistinctValues", bucket.numDistinctValues);
+    }
+    histogramBuilder.doneFast();
+    return bob.obj();
+}
+
+}  // namespace mongo
@@ -0,0 +1,124 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "mongo/bson/bsonobj_comparator_interface.h"
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+struct OrderedIntervalList;
+
+/**
+ * Statistics about the keys of a single index, built from a random sample of the collection's
+ * documents by the index statistics sampler and consumed by PlanCostModel.
+ *
+ * Only the leading field of the key pattern is described: an equi-depth histogram over its values
+ * and an estimate of its number of distinct values. All counts are scaled up from the sample to
+ * the collection size observed when the sample was taken.
+ *
+ * Instances are immutable once built and are shared between the CollectionInfoCache and any
+ * IndexEntry handed to the planner.
+ */
+class IndexStatistics {
+public:
+    /**
+     * Accumulates the index keys of sampled documents and produces the statistics.
+     */
+    class Builder {
+    public:
+        explicit Builder(size_t numBuckets);
+
+        /**
+         * Adds the keys generated for one sampled document. 'keys' may be empty (e.g. for a
+         * sparse index) or hold several keys (for a multikey index).
+         */
+        void addSampledDocument(const BSONObjSet& keys);
+
+        /**
+         * Builds statistics for a collection holding 'numRecords' documents.
+         */
+        std::shared_ptr<const IndexStatistics> build(long long numRecords);
+
+    private:
+        const size_t _numBuckets;
+        size_t _numSampledDocs = 0;
+
+        // The leading key element of every sampled key, each as a single-field object.
+        std::vector<BSONObj> _sampledValues;
+    };
+
+    long long getNumRecords() const {
+        return _numRecords;
+    }
+
+    double getNumKeys() const {
+        return _numKeys;
+    }
+
+    double getNumDistinctValues() const {
+        return _numDistinctValues;
+    }
+
+    size_t getNumBuckets() const {
+        return _buckets.size();
+    }
+
+    /**
+     * Estimates how many index keys have a leading field falling within 'oil'. The intervals may
+     * be oriented in either direction.
+     */
+    double estimateKeys(const OrderedIntervalList& oil) const;
+
+    BSONObj toBSON() const;
+
+private:
+    struct Bucket {
+        // Inclusive upper bound, as a single-field object. The lower bound is exclusive and is
+        // the upper bound of the previous bucket, or '_lowerBound' for the first bucket.
+        BSONObj upperBound;
+        double numKeys;
+        double numDistinctValues;
+    };
+
+    IndexStatistics() = default;
+
+    long long _numRecords = 0;
+    double _numKeys = 0;
+    double _numDistinctValues = 0;
+
+    // The smallest sampled value, as a single-field object.
+    BSONObj _lowerBound;
+    std::vector<Bucket> _buckets;
+};
+
+}  // namespace mongo
@@ -0,0 +1,117 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/index_statistics.h"
+
+#include "mongo/bson/simple_bsonobj_comparator.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/query/index_bounds.h"
+#include "mongo/unittest/unittest.h"
+
+namespace {
+
+using namespace mongo;
+
+void addSampledValue(IndexStatistics::Builder* builder, int value) {
+    BSONObjSet keys = SimpleBSONObjComparator::kInstance.makeBSONObjSet();
+    keys.insert(BSON("" << value));
+    builder->addSampledDocument(keys);
+}
+
+OrderedIntervalList makeOil(const BSONObj& bounds, bool startInclusive, bool endInclusive) {
+    OrderedIntervalList oil;
+    oil.intervals.push_back(Interval(bounds, startInclusive, endInclusive));
+    return oil;
+}
+
+/**
+ * Samples 100 of 1000 documents holding the values 0 through 9 ten times each.
+ */
+std::shared_ptr<const IndexStatistics> buildUniformStatistics() {
+    IndexStatistics::Builder builder(4U);
+    for (int i = 0; i < 100; ++i) {
+        addSampledValue(&builder, i % 10);
+    }
+    return builder.build(1000);
+}
+
+TEST(IndexStatisticsTest, ScalesSampleToCollectionSize) {
+    auto stats = buildUniformStatistics();
+    ASSERT_EQUALS(stats->getNumRecords(), 1000);
+    ASSERT_EQUALS(stats->getNumKeys(), 1000.0);
+    ASSERT_EQUALS(stats->getNumDistinctValues(), 10.0);
+    ASSERT_EQUALS(stats->getNumBuckets(), 4U);
+}
+
+TEST(IndexStatisticsTest, EstimatesPointIntervalFromBucketDensity) {
+    auto stats = buildUniformStatistics();
+    ASSERT_EQUALS(stats->estimateKeys(makeOil(BSON("" << 3 << "" << 3), true, true)), 100.0);
+}
+
+TEST(IndexStatisticsTest, EstimatesRangeFromCoveredBuckets) {
+    auto stats = buildUniformStatistics();
+    ASSERT_EQUALS(stats->estimateKeys(makeOil(BSON("" << 0 << "" << 9), true, true)), 1000.0);
+    ASSERT_EQUALS(stats->estimateKeys(makeOil(BSON("" << MINKEY << "" << MAXKEY), true, true)),
+                  1000.0);
+
+    // Only the bucket holding 6 through 8 overlaps, and only partially.
+    ASSERT_EQUALS(stats->estimateKeys(makeOil(BSON("" << 5 << "" << 7), false, true)), 150.0);
+}
+
+TEST(IndexStatisticsTest, EstimatesDescendingIntervals) {
+    auto stats = buildUniformStatistics();
+    ASSERT_EQUALS(stats->estimateKeys(makeOil(BSON("" << 9 << "" << 0), true, true)), 1000.0);
+}
+
+TEST(IndexStatisticsTest, UnsampledValueIsNeverFree) {
+    auto stats = buildUniformStatistics();
+    ASSERT_EQUALS(stats->estimateKeys(makeOil(BSON("" << 42 << "" << 42), true, true)), 1.0);
+}
+
+TEST(IndexStatisticsTest, ExtrapolatesDistinctValuesSeenOnce) {
+    IndexStatistics::Builder builder(32U);
+    for (int i = 0; i < 100; ++i) {
+        addSampledValue(&builder, i);
+    }
+    auto stats = builder.build(10000);
+    ASSERT_EQUALS(stats->getNumKeys(), 10000.0);
+    ASSERT_EQUALS(stats->getNumDistinctValues(), 1000.0);
+}
+
+TEST(IndexStatisticsTest, EmptySample) {
+    IndexStatistics::Builder builder(32U);
+    builder.addSampledDocument(SimpleBSONObjComparator::kInstance.makeBSONObjSet());
+    auto stats = builder.build(50);
+    ASSERT_EQUALS(stats->getNumKeys(), 0.0);
+    ASSERT_EQUALS(stats->getNumBuckets(), 0U);
+    ASSERT_EQUALS(stats->estimateKeys(makeOil(BSON("" << 1 << "" << 1), true, true)), 0.0);
+}
+
+}  // namespace
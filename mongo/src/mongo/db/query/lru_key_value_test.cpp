@@ -194,4 +194,29 @@ TEST(LRUKeyValueTest, IterationTest) {
     ASSERT(i == cache.end());
 }
 
+/**
+ * Test that removeLeastRecentlyUsed() evicts entries in LRU order
+ * and hands ownership of them to the caller.
+ */
+TEST(LRUKeyValueTest, RemoveLeastRecentlyUsedTest) {
+    LRUKeyValue<int, int> cache(10);
+    ASSERT_FALSE(cache.removeLeastRecentlyUsed());
+
+    cache.add(1, new int(1));
+    cache.add(2, new int(2));
+    cache.add(3, new int(3));
+
+    // Promote 1 so that 2 becomes the least recently used entry.
+    int* entry;
+    ASSERT_OK(cache.get(1, &entry));
+
+    std::unique_ptr<int> evicted = cache.removeLeastRecentlyUsed();
+    ASSERT(evicted);
+    ASSERT_EQUALS(*evicted, 2);
+    ASSERT_EQUALS(cache.size(), 2U);
+    assertNotInKVStore(cache, 2);
+    assertInKVStore(cache, 1, 1);
+    assertInKVStore(cache, 3, 3);
+}
+
 }  // namespace
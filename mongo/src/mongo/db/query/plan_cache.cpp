@@ -33,15 +33,22 @@
 #include "mongo/db/query/plan_cache.h"
 
 #include <algorithm>
+#include <iterator>
 #include <math.h>
 #include <memory>
 #include <vector>
 
 #include "mongo/base/owned_pointer_vector.h"
+#include "mongo/bson/simple_bsonobj_comparator.h"
+#include "mongo/bson/util/bson_extract.h"
 #include "mongo/client/dbclientinterface.h"  // For QueryOption_foobar
+#include "mongo/db/index_names.h"
 #include "mongo/db/matcher/expression_array.h"
 #include "mongo/db/matcher/expression_geo.h"
+#include "mongo/db/matcher/expression_leaf.h"
 #include "mongo/db/query/collation/collator_interface.h"
+#include "mongo/db/query/index_bounds_builder.h"
+#include "mongo/db/query/index_statistics.h"
 #include "mongo/db/query/plan_ranker.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_solution.h"
@@ -62,6 +69,7 @@ const char kEncodeChildrenSeparator = ',';
 const char kEncodeSortSection = '~';
 const char kEncodeProjectionSection = '|';
 const char kEncodeCollationSection = '#';
+const char kEncodeSelectivityBucketSection = '%';
 
 /**
  * Encode user-provided string. Cache key delimiters seen in the
@@ -79,6 +87,7 @@ void encodeUserString(StringData s, StringBuilder* keyBuilder) {
             case kEncodeSortSection:
             case kEncodeProjectionSection:
             case kEncodeCollationSection:
+            case kEncodeSelectivityBucketSection:
             case '\\':
                 *keyBuilder << '\\';
             // Fall through to default case.
@@ -305,8 +314,73 @@ void encodeGeoNearMatchExpression(const GeoNearMatchExpression* tree, StringBuil
     }
 }
 
+size_t estimateIndexTreeSize(const PlanCacheIndexTree* tree) {
+    size_t size = sizeof(PlanCacheIndexTree);
+    if (tree->entry) {
+        size += sizeof(IndexEntry) + tree->entry->keyPattern.objsize() +
+            tree->entry->infoObj.objsize() + tree->entry->name.size();
+    }
+    for (auto&& orPushdown : tree->orPushdowns) {
+        size += sizeof(orPushdown) + orPushdown.indexName.size() +
+            orPushdown.route.size() * sizeof(size_t);
+    }
+    for (auto&& child : tree->children) {
+        size += estimateIndexTreeSize(child);
+    }
+    return size;
+}
+
+size_t estimateStatsTreeSize(const PlanStageStats* stats) {
+    size_t size = sizeof(PlanStageStats);
+    if (STAGE_IXSCAN == stats->stageType && stats->specific) {
+        const IndexScanStats* ixStats = static_cast<const IndexScanStats*>(stats->specific.get());
+        size += sizeof(IndexScanStats) + ixStats->keyPattern.objsize() +
+            ixStats->collation.objsize() + ixStats->indexBounds.objsize();
+    } else if (stats->specific) {
+        // Other specific stats are mostly fixed-size; charge a nominal amount for them.
+        size += sizeof(IndexScanStats);
+    }
+    for (auto&& child : stats->children) {
+        size += estimateStatsTreeSize(child.get());
+    }
+    return size;
+}
+
+// Stage name reported for the ranking statistics of entries restored from a snapshot. Only the
+// summary counters of the winning plans are persisted, not their full stats trees.
+const char kSnapshotStatsStageName[] = "SNAPSHOT";
+
+size_t estimateTrialStatsSizeBytes(const PlanCacheKey& shapeKey) {
+    return sizeof(PlanTrialStats) + shapeKey.size();
+}
+
+/**
+ * Returns whether the index bounds of 'expr' can be translated to estimate how many keys of an
+ * index on its path it matches.
+ */
+bool canEstimateSelectivity(const MatchExpression* expr) {
+    switch (expr->matchType()) {
+        case MatchExpression::EQ:
+        case MatchExpression::LT:
+        case MatchExpression::LTE:
+        case MatchExpression::GT:
+        case MatchExpression::GTE:
+            return true;
+        case MatchExpression::MATCH_IN:
+            return static_cast<const InMatchExpression*>(expr)->getRegexes().empty();
+        default:
+            return false;
+    }
+}
+
+// The number of plan caches in existence, among which the memory budget is shared.
+AtomicInt64 numPlanCaches;
+
 }  // namespace
 
+Counter64 planCacheTotalSizeEstimateBytes;
+Counter64 planCacheMemoryEvictions;
+
 //
 // Cache-related functions for CanonicalQuery
 //
@@ -434,6 +508,8 @@ PlanCacheEntry* PlanCacheEntry::clone() const {
     entry->projection = projection.getOwned();
     entry->collation = collation.getOwned();
     entry->timeOfCreation = timeOfCreation;
+    entry->selectivityBucket = selectivityBucket;
+    entry->estimatedEntrySizeBytes = estimatedEntrySizeBytes;
 
     // Copy performance stats.
     for (size_t i = 0; i < feedback.size(); ++i) {
@@ -445,6 +521,61 @@ PlanCacheEntry* PlanCacheEntry::clone() const {
     return entry;
 }
 
+size_t PlanCacheEntry::estimateObjectSizeInBytes() const {
+    size_t size = sizeof(PlanCacheEntry) + query.objsize() + sort.objsize() +
+        projection.objsize() + collation.objsize();
+
+    for (auto&& scd : plannerData) {
+        size += sizeof(SolutionCacheData);
+        if (scd->tree) {
+            size += estimateIndexTreeSize(scd->tree.get());
+        }
+    }
+
+    if (decision) {
+        size += sizeof(PlanRankingDecision) + decision->scores.size() * sizeof(double) +
+            decision->candidateOrder.size() * sizeof(size_t);
+        for (auto&& stats : decision->stats) {
+            size += estimateStatsTreeSize(stats.get());
+        }
+    }
+
+    for (auto&& fb : feedback) {
+        size += sizeof(PlanCacheEntryFeedback);
+        if (fb->stats) {
+            size += estimateStatsTreeSize(fb->stats.get());
+        }
+    }
+    return size;
+}
+
+void PlanCacheEntry::serialize(BSONObjBuilder* builder) const {
+    builder->append("query", query);
+    builder->append("sort", sort);
+    builder->append("projection", projection);
+    if (!collation.isEmpty()) {
+        builder->append("collation", collation);
+    }
+    builder->append("timeOfCreation", timeOfCreation);
+    if (selectivityBucket) {
+        builder->append("selectivityBucket", *selectivityBucket);
+    }
+
+    BSONArrayBuilder plansBuilder(builder->subarrayStart("plans"));
+    for (size_t i = 0; i < plannerData.size(); ++i) {
+        BSONObjBuilder planBuilder(plansBuilder.subobjStart());
+        BSONObjBuilder solutionBuilder(planBuilder.subobjStart("solution"));
+        plannerData[i]->serialize(&solutionBuilder);
+        solutionBuilder.doneFast();
+
+        const CommonStats& common = decision->stats[i]->common;
+        planBuilder.append("score", decision->scores[i]);
+        planBuilder.append("works", static_cast<long long>(common.works));
+        planBuilder.append("advanced", static_cast<long long>(common.advanced));
+        planBuilder.append("isEOF", common.isEOF);
+    }
+}
+
 std::string PlanCacheEntry::toString() const {
     return str::stream() << "(query: " << query.toString() << ";sort: " << sort.toString()
                          << ";projection: " << projection.toString()
@@ -552,19 +683,220 @@ std::string SolutionCacheData::toString() const {
             verify(this->tree.get());
             return str::stream() << "(index-tagged expression tree: "
                                  << "tree=" << this->tree->toString() << ")";
+        case SKIP_SCAN_SOLN:
+            verify(this->tree.get());
+            return str::stream() << "(skip scan solution: "
+                                 << "tree=" << this->tree->toString() << ")";
     }
     MONGO_UNREACHABLE;
 }
 
+void PlanCacheIndexTree::serialize(BSONObjBuilder* builder) const {
+    if (entry) {
+        builder->append("index", entry->name);
+        builder->append("keyPattern", entry->keyPattern);
+        builder->append("pos", static_cast<long long>(index_pos));
+        builder->append("canCombineBounds", canCombineBounds);
+    }
+
+    if (!orPushdowns.empty()) {
+        BSONArrayBuilder orPushdownsBuilder(builder->subarrayStart("orPushdowns"));
+        for (auto&& orPushdown : orPushdowns) {
+            BSONObjBuilder orPushdownBuilder(orPushdownsBuilder.subobjStart());
+            orPushdownBuilder.append("index", orPushdown.indexName);
+            orPushdownBuilder.append("pos", static_cast<long long>(orPushdown.position));
+            orPushdownBuilder.append("canCombineBounds", orPushdown.canCombineBounds);
+            BSONArrayBuilder routeBuilder(orPushdownBuilder.subarrayStart("route"));
+            for (auto position : orPushdown.route) {
+                routeBuilder.append(static_cast<long long>(position));
+            }
+        }
+    }
+
+    if (!children.empty()) {
+        BSONArrayBuilder childrenBuilder(builder->subarrayStart("children"));
+        for (auto&& child : children) {
+            BSONObjBuilder childBuilder(childrenBuilder.subobjStart());
+            child->serialize(&childBuilder);
+        }
+    }
+}
+
+StatusWith<std::unique_ptr<PlanCacheIndexTree>> PlanCacheIndexTree::parse(
+    const BSONObj& obj, const std::vector<IndexEntry>& indexEntries) {
+    auto findIndex = [&indexEntries](StringData name) -> const IndexEntry* {
+        for (auto&& indexEntry : indexEntries) {
+            if (indexEntry.name == name) {
+                return &indexEntry;
+            }
+        }
+        return nullptr;
+    };
+
+    auto tree = stdx::make_unique<PlanCacheIndexTree>();
+
+    if (obj.hasField("index")) {
+        std::string indexName;
+        Status status = bsonExtractStringField(obj, "index", &indexName);
+        if (!status.isOK()) {
+            return status;
+        }
+        BSONElement keyPatternElt;
+        status = bsonExtractTypedField(obj, "keyPattern", BSONType::Object, &keyPatternElt);
+        if (!status.isOK()) {
+            return status;
+        }
+        const IndexEntry* indexEntry = findIndex(indexName);
+        if (!indexEntry ||
+            SimpleBSONObjComparator::kInstance.evaluate(indexEntry->keyPattern !=
+                                                        keyPatternElt.Obj())) {
+            return Status(ErrorCodes::IndexNotFound,
+                          str::stream() << "index " << indexName << " with key pattern "
+                                        << keyPatternElt.Obj()
+                                        << " no longer exists");
+        }
+        tree->setIndexEntry(*indexEntry);
+
+        long long pos;
+        status = bsonExtractIntegerField(obj, "pos", &pos);
+        if (!status.isOK()) {
+            return status;
+        }
+        tree->index_pos = static_cast<size_t>(pos);
+        status = bsonExtractBooleanField(obj, "canCombineBounds", &tree->canCombineBounds);
+        if (!status.isOK()) {
+            return status;
+        }
+    }
+
+    for (auto&& orPushdownElt : obj.getObjectField("orPushdowns")) {
+        if (!orPushdownElt.isABSONObj()) {
+            return Status(ErrorCodes::BadValue, "orPushdowns must contain objects");
+        }
+        BSONObj orPushdownObj = orPushdownElt.Obj();
+        OrPushdown orPushdown;
+        Status status = bsonExtractStringField(orPushdownObj, "index", &orPushdown.indexName);
+        if (!status.isOK()) {
+            return status;
+        }
+        if (!findIndex(orPushdown.indexName)) {
+            return Status(ErrorCodes::IndexNotFound,
+                          str::stream() << "index " << orPushdown.indexName
+                                        << " no longer exists");
+        }
+        long long pos;
+        status = bsonExtractIntegerField(orPushdownObj, "pos", &pos);
+        if (!status.isOK()) {
+            return status;
+        }
+        orPushdown.position = static_cast<size_t>(pos);
+        status = bsonExtractBooleanField(
+            orPushdownObj, "canCombineBounds", &orPushdown.canCombineBounds);
+        if (!status.isOK()) {
+            return status;
+        }
+        for (auto&& positionElt : orPushdownObj.getObjectField("route")) {
+            if (!positionElt.isNumber()) {
+                return Status(ErrorCodes::BadValue, "orPushdown route must contain numbers");
+            }
+            orPushdown.route.push_back(static_cast<size_t>(positionElt.numberLong()));
+        }
+        tree->orPushdowns.push_back(std::move(orPushdown));
+    }
+
+    for (auto&& childElt : obj.getObjectField("children")) {
+        if (!childElt.isABSONObj()) {
+            return Status(ErrorCodes::BadValue, "children must contain objects");
+        }
+        auto swChild = parse(childElt.Obj(), indexEntries);
+        if (!swChild.isOK()) {
+            return swChild.getStatus();
+        }
+        tree->children.push_back(swChild.getValue().release());
+    }
+
+    return {std::move(tree)};
+}
+
+void SolutionCacheData::serialize(BSONObjBuilder* builder) const {
+    builder->append("solnType", static_cast<int>(solnType));
+    builder->append("wholeIXSolnDir", wholeIXSolnDir);
+    builder->append("indexFilterApplied", indexFilterApplied);
+    if (tree) {
+        BSONObjBuilder treeBuilder(builder->subobjStart("tree"));
+        tree->serialize(&treeBuilder);
+    }
+}
+
+StatusWith<std::unique_ptr<SolutionCacheData>> SolutionCacheData::parse(
+    const BSONObj& obj, const std::vector<IndexEntry>& indexEntries) {
+    auto scd = stdx::make_unique<SolutionCacheData>();
+
+    long long solnType;
+    Status status = bsonExtractIntegerField(obj, "solnType", &solnType);
+    if (!status.isOK()) {
+        return status;
+    }
+    if (solnType < WHOLE_IXSCAN_SOLN || solnType > SKIP_SCAN_SOLN) {
+        return Status(ErrorCodes::BadValue,
+                      str::stream() << "invalid solution type " << solnType);
+    }
+    scd->solnType = static_cast<SolutionType>(solnType);
+
+    long long wholeIXSolnDir;
+    status = bsonExtractIntegerField(obj, "wholeIXSolnDir", &wholeIXSolnDir);
+    if (!status.isOK()) {
+        return status;
+    }
+    scd->wholeIXSolnDir = static_cast<int>(wholeIXSolnDir);
+
+    status = bsonExtractBooleanField(obj, "indexFilterApplied", &scd->indexFilterApplied);
+    if (!status.isOK()) {
+        return status;
+    }
+
+    BSONElement treeElt = obj["tree"];
+    if (!treeElt.eoo()) {
+        if (!treeElt.isABSONObj()) {
+            return Status(ErrorCodes::BadValue, "tree must be an object");
+        }
+        auto swTree = PlanCacheIndexTree::parse(treeElt.Obj(), indexEntries);
+        if (!swTree.isOK()) {
+            return swTree.getStatus();
+        }
+        scd->tree = std::move(swTree.getValue());
+    } else if (scd->solnType != COLLSCAN_SOLN) {
+        return Status(ErrorCodes::BadValue, "index solutions require a tree");
+    }
+
+    return {std::move(scd)};
+}
+
 //
 // PlanCache
 //
 
-PlanCache::PlanCache() : _cache(internalQueryCacheSize.load()) {}
+PlanCache::PlanCache() : PlanCache("") {}
+
+PlanCache::PlanCache(const std::string& ns) : _ns(ns) {
+    numPlanCaches.fetchAndAdd(1);
 
-PlanCache::PlanCache(const std::string& ns) : _cache(internalQueryCacheSize.load()), _ns(ns) {}
+    const size_t numPartitions =
+        static_cast<size_t>(std::max(1, internalQueryCacheNumPartitions.load()));
+    const size_t maxEntries = static_cast<size_t>(std::max(1, internalQueryCacheSize.load()));
+
+    // The entry count limit is spread over the partitions, rounding up so that the cache as a
+    // whole never holds fewer entries than internalQueryCacheSize.
+    const size_t maxEntriesPerPartition = (maxEntries + numPartitions - 1) / numPartitions;
+    for (size_t i = 0; i < numPartitions; ++i) {
+        _partitions.push_back(stdx::make_unique<Partition>(maxEntriesPerPartition));
+    }
+}
 
-PlanCache::~PlanCache() {}
+PlanCache::~PlanCache() {
+    clear();
+    numPlanCaches.fetchAndSubtract(1);
+}
 
 /**
  * Traverses expression tree pre-order.
@@ -698,6 +1030,205 @@ void PlanCache::encodeKeyForProj(const BSONObj& projObj, StringBuilder* keyBuild
     }
 }
 
+boost::optional<int> PlanCache::estimateSelectivityBucket(const CanonicalQuery& cq) const {
+    std::vector<const MatchExpression*> predicates;
+    if (MatchExpression::AND == cq.root()->matchType()) {
+        for (size_t i = 0; i < cq.root()->numChildren(); ++i) {
+            predicates.push_back(cq.root()->getChild(i));
+        }
+    } else {
+        predicates.push_back(cq.root());
+    }
+
+    // The most selective predicate bounds the number of results, so it decides the bucket. Its
+    // estimated number of matching keys is spread over the buckets on a log scale relative to
+    // the size of the index.
+    boost::optional<double> position;
+    stdx::lock_guard<stdx::mutex> statsLock(_indexStatisticsMutex);
+    for (auto&& index : _indexEntries) {
+        auto statsIt = _indexStatistics.find(index.name);
+        if (statsIt == _indexStatistics.end() || index.type != INDEX_BTREE || index.filterExpr ||
+            !CollatorInterface::collatorsMatch(index.collator, cq.getCollator())) {
+            continue;
+        }
+        const IndexStatistics& stats = *statsIt->second;
+        const BSONElement leadingField = index.keyPattern.firstElement();
+        for (auto&& predicate : predicates) {
+            if (!canEstimateSelectivity(predicate) ||
+                predicate->path() != leadingField.fieldNameStringData()) {
+                continue;
+            }
+            OrderedIntervalList oil;
+            IndexBoundsBuilder::BoundsTightness tightness;
+            IndexBoundsBuilder::translate(predicate, leadingField, index, &oil, &tightness);
+
+            const double numKeys = std::max(1.0, stats.getNumKeys());
+            const double estimate = std::min(numKeys, std::max(0.0, stats.estimateKeys(oil)));
+            const double predicatePosition = std::log2(1.0 + estimate) / std::log2(1.0 + numKeys);
+            position = position ? std::min(*position, predicatePosition) : predicatePosition;
+        }
+    }
+    if (!position) {
+        return boost::none;
+    }
+
+    const int numBuckets = std::max(1, internalQueryCacheSelectivityBuckets.load());
+    const int bucket = static_cast<int>(*position * numBuckets);
+    return std::min(std::max(bucket, 0), numBuckets - 1);
+}
+
+void PlanCache::notifyOfIndexStatistics(StringData indexName,
+                                        std::shared_ptr<const IndexStatistics> stats) {
+    stdx::lock_guard<stdx::mutex> statsLock(_indexStatisticsMutex);
+    if (stats) {
+        _indexStatistics[indexName] = std::move(stats);
+    } else {
+        _indexStatistics.erase(indexName);
+    }
+}
+
+PlanCache::Partition& PlanCache::getPartition(const PlanCacheKey& shapeKey) const {
+    return *_partitions[std::hash<PlanCacheKey>()(shapeKey) % _partitions.size()];
+}
+
+PlanCacheKey PlanCache::computeEntryKey(const CanonicalQuery& cq,
+                                        const PlanCacheKey& shapeKey) const {
+    if (!internalQueryCacheEnableParameterizedPlans.load()) {
+        return shapeKey;
+    }
+    return makeEntryKey(shapeKey, estimateSelectivityBucket(cq));
+}
+
+PlanCacheKey PlanCache::makeEntryKey(const PlanCacheKey& shapeKey, boost::optional<int> bucket) {
+    if (!bucket) {
+        return shapeKey;
+    }
+    StringBuilder keyBuilder;
+    keyBuilder << shapeKey << kEncodeSelectivityBucketSection << *bucket;
+    return keyBuilder.str();
+}
+
+void PlanCache::addEntry(Partition* partition, const PlanCacheKey& key, PlanCacheEntry* entry) {
+    // Replacing an existing entry frees it, so stop charging for it first.
+    removeEntry(partition, key).transitional_ignore();
+
+    entry->estimatedEntrySizeBytes = entry->estimateObjectSizeInBytes();
+    partition->sizeBytes += entry->estimatedEntrySizeBytes;
+    planCacheTotalSizeEstimateBytes.increment(entry->estimatedEntrySizeBytes);
+
+    std::unique_ptr<PlanCacheEntry> evictedEntry = partition->cache.add(key, entry);
+    if (evictedEntry) {
+        partition->sizeBytes -= evictedEntry->estimatedEntrySizeBytes;
+        planCacheTotalSizeEstimateBytes.decrement(evictedEntry->estimatedEntrySizeBytes);
+        LOG(1) << _ns << ": plan cache maximum size exceeded - "
+               << "removed least recently used entry " << redact(evictedEntry->toString());
+    }
+}
+
+void PlanCache::enforceMemoryBudget(const PlanCacheKey& keepKey) {
+    const long long maxSizeBytes = internalQueryCacheMaxSizeBytes.load();
+    const long long fairShareBytes = maxSizeBytes / std::max(1LL, numPlanCaches.load());
+    while (planCacheTotalSizeEstimateBytes.get() > maxSizeBytes) {
+        // A cache within its share of the budget leaves the excess to be trimmed by the caches
+        // which are over theirs, so that a busy collection cannot starve the others.
+        if (static_cast<long long>(getSizeEstimateBytes()) <= fairShareBytes) {
+            return;
+        }
+
+        // Partition locks are taken one at a time, so the sizes may be slightly stale by the time
+        // an entry is evicted. That only affects which partition gives up an entry.
+        Partition* largest = nullptr;
+        size_t largestSizeBytes = 0;
+        for (auto&& partition : _partitions) {
+            stdx::lock_guard<stdx::mutex> partitionLock(partition->mutex);
+            const bool onlyHoldsKeepKey = partition->trialStats.size() == 0 &&
+                partition->cache.size() == 1 && partition->cache.hasKey(keepKey);
+            if (partition->sizeBytes > largestSizeBytes && !onlyHoldsKeepKey) {
+                largest = partition.get();
+                largestSizeBytes = partition->sizeBytes;
+            }
+        }
+        if (!largest) {
+            return;
+        }
+
+        stdx::lock_guard<stdx::mutex> partitionLock(largest->mutex);
+        boost::optional<PlanCacheKey> evictedKey;
+        for (auto it = largest->cache.end(); it != largest->cache.begin();) {
+            --it;
+            if (it->first != keepKey) {
+                evictedKey = it->first;
+                break;
+            }
+        }
+        if (!evictedKey) {
+            // Once a partition has no other plans left, give up the trial stats it holds.
+            if (removeLeastRecentlyUsedTrialStats(largest)) {
+                planCacheMemoryEvictions.increment();
+            }
+            continue;
+        }
+        removeEntry(largest, *evictedKey).transitional_ignore();
+        planCacheMemoryEvictions.increment();
+        LOG(1) << _ns << ": plan cache memory budget of " << maxSizeBytes << " bytes exceeded - "
+               << "removed least recently used entry " << redact(*evictedKey);
+    }
+}
+
+Status PlanCache::removeEntry(Partition* partition, const PlanCacheKey& key) {
+    PlanCacheEntry* entry;
+    Status status = partition->cache.get(key, &entry);
+    if (!status.isOK()) {
+        return status;
+    }
+    partition->sizeBytes -= entry->estimatedEntrySizeBytes;
+    planCacheTotalSizeEstimateBytes.decrement(entry->estimatedEntrySizeBytes);
+    return partition->cache.remove(key);
+}
+
+void PlanCache::addTrialStats(Partition* partition,
+                              const PlanCacheKey& shapeKey,
+                              PlanTrialStats* stats) {
+    // The least recently used stats are the ones add() evicts if the store is full.
+    const size_t lruSizeBytes = partition->trialStats.size() == 0
+        ? 0
+        : estimateTrialStatsSizeBytes(std::prev(partition->trialStats.end())->first);
+
+    const size_t sizeBytes = estimateTrialStatsSizeBytes(shapeKey);
+    partition->sizeBytes += sizeBytes;
+    planCacheTotalSizeEstimateBytes.increment(sizeBytes);
+
+    if (partition->trialStats.add(shapeKey, stats)) {
+        partition->sizeBytes -= lruSizeBytes;
+        planCacheTotalSizeEstimateBytes.decrement(lruSizeBytes);
+    }
+}
+
+void PlanCache::removeTrialStats(Partition* partition, const PlanCacheKey& shapeKey) {
+    if (partition->trialStats.remove(shapeKey).isOK()) {
+        const size_t sizeBytes = estimateTrialStatsSizeBytes(shapeKey);
+        partition->sizeBytes -= sizeBytes;
+        planCacheTotalSizeEstimateBytes.decrement(sizeBytes);
+    }
+}
+
+bool PlanCache::removeLeastRecentlyUsedTrialStats(Partition* partition) {
+    if (partition->trialStats.size() == 0) {
+        return false;
+    }
+    // Copy the key, since removing the stats frees it.
+    const PlanCacheKey shapeKey = std::prev(partition->trialStats.end())->first;
+    removeTrialStats(partition, shapeKey);
+    return true;
+}
+
+void PlanCache::clearPartition(Partition* partition) {
+    planCacheTotalSizeEstimateBytes.decrement(partition->sizeBytes);
+    partition->sizeBytes = 0;
+    partition->cache.clear();
+    partition->trialStats.clear();
+}
+
 //PlanCache::addӣPlanCache::getȡ
 
 //MultiPlanStage::pickBestPlanаѵ÷ָߵĺѡӵplancache
@@ -745,14 +1276,17 @@ Status PlanCache::add(const CanonicalQuery& query,
     }
     entry->projection = projBuilder.obj();
 
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    std::unique_ptr<PlanCacheEntry> evictedEntry = _cache.add(computeKey(query), entry);
-
-    if (NULL != evictedEntry.get()) {
-        LOG(1) << _ns << ": plan cache maximum size exceeded - "
-               << "removed least recently used entry " << redact(evictedEntry->toString());
+    const PlanCacheKey shapeKey = computeKey(query);
+    if (internalQueryCacheEnableParameterizedPlans.load()) {
+        entry->selectivityBucket = estimateSelectivityBucket(query);
     }
+    const PlanCacheKey key = makeEntryKey(shapeKey, entry->selectivityBucket);
+    Partition& partition = getPartition(shapeKey);
+    stdx::unique_lock<stdx::mutex> partitionLock(partition.mutex);
+    addEntry(&partition, key, entry);
+    partitionLock.unlock();
 
+    enforceMemoryBudget(key);
     return Status::OK();
 }
 
@@ -761,13 +1295,15 @@ Status PlanCache::add(const CanonicalQuery& query,
 //ԲοSubplanStage::planSubqueries    prepareExecutionеĵ÷ʽ
 //queryҶӦPlanCacheEntry PlanCache::addӣPlanCache::getȡ
 Status PlanCache::get(const CanonicalQuery& query, CachedSolution** crOut) const {
-    PlanCacheKey key = computeKey(query);
     verify(crOut);
 
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
+    const PlanCacheKey shapeKey = computeKey(query);
+    const PlanCacheKey key = computeEntryKey(query, shapeKey);
+    Partition& partition = getPartition(shapeKey);
+    stdx::lock_guard<stdx::mutex> partitionLock(partition.mutex);
     PlanCacheEntry* entry;
 	//_cacheӸkeyȡPlanCacheEntry
-    Status cacheStatus = _cache.get(key, &entry);
+    Status cacheStatus = partition.cache.get(key, &entry);
     if (!cacheStatus.isOK()) {
         return cacheStatus;
     }
@@ -877,11 +1413,13 @@ Status PlanCache::feedback(const CanonicalQuery& cq, PlanCacheEntryFeedback* fee
         return Status(ErrorCodes::BadValue, "feedback is NULL");
     }
     std::unique_ptr<PlanCacheEntryFeedback> autoFeedback(feedback);
-    PlanCacheKey ck = computeKey(cq);
 
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
+    const PlanCacheKey shapeKey = computeKey(cq);
+    const PlanCacheKey ck = computeEntryKey(cq, shapeKey);
+    Partition& partition = getPartition(shapeKey);
+    stdx::lock_guard<stdx::mutex> partitionLock(partition.mutex);
     PlanCacheEntry* entry;
-    Status cacheStatus = _cache.get(ck, &entry);
+    Status cacheStatus = partition.cache.get(ck, &entry);
     if (!cacheStatus.isOK()) {
         return cacheStatus;
     }
@@ -890,19 +1428,47 @@ Status PlanCache::feedback(const CanonicalQuery& cq, PlanCacheEntryFeedback* fee
     // We store up to a constant number of feedback entries.
     if (entry->feedback.size() < static_cast<size_t>(internalQueryCacheFeedbacksStored.load())) {
         entry->feedback.push_back(autoFeedback.release());
+
+        // Feedback grows the entry, so recharge it against the memory budget.
+        const size_t newSizeBytes = entry->estimateObjectSizeInBytes();
+        partition.sizeBytes += newSizeBytes - entry->estimatedEntrySizeBytes;
+        planCacheTotalSizeEstimateBytes.increment(newSizeBytes - entry->estimatedEntrySizeBytes);
+        entry->estimatedEntrySizeBytes = newSizeBytes;
     }
 
     return Status::OK();
 }
 
 Status PlanCache::remove(const CanonicalQuery& canonicalQuery) {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    return _cache.remove(computeKey(canonicalQuery));
+    const PlanCacheKey shapeKey = computeKey(canonicalQuery);
+    const PlanCacheKey key = computeEntryKey(canonicalQuery, shapeKey);
+    Partition& partition = getPartition(shapeKey);
+    stdx::lock_guard<stdx::mutex> partitionLock(partition.mutex);
+    removeTrialStats(&partition, shapeKey);
+    return removeEntry(&partition, key);
+}
+
+Status PlanCache::removeQueryShape(const CanonicalQuery& canonicalQuery) {
+    const PlanCacheKey shapeKey = computeKey(canonicalQuery);
+    Partition& partition = getPartition(shapeKey);
+    stdx::lock_guard<stdx::mutex> partitionLock(partition.mutex);
+    removeTrialStats(&partition, shapeKey);
+    Status status = removeEntry(&partition, shapeKey);
+
+    const int numBuckets = std::max(1, internalQueryCacheSelectivityBuckets.load());
+    for (int bucket = 0; bucket < numBuckets; ++bucket) {
+        if (removeEntry(&partition, makeEntryKey(shapeKey, bucket)).isOK()) {
+            status = Status::OK();
+        }
+    }
+    return status;
 }
 
 void PlanCache::clear() {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    _cache.clear();
+    for (auto&& partition : _partitions) {
+        stdx::lock_guard<stdx::mutex> partitionLock(partition->mutex);
+        clearPartition(partition.get());
+    }
 }
 
 //computeKey(cq)ΪgetPlansByQueryеĲѯdb.xx.getPlanCache().getPlansByQuery({"query" : {"create_time" : { "$gte" : "2020-12-27 00:00:00","$lte" : "2021-01-26 23:59:59"}},"sort" : { },"projection" : {}})
@@ -916,12 +1482,14 @@ PlanCacheKey PlanCache::computeKey(const CanonicalQuery& cq) const {
 }
 
 Status PlanCache::getEntry(const CanonicalQuery& query, PlanCacheEntry** entryOut) const {
-    PlanCacheKey key = computeKey(query);
     verify(entryOut);
 
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
+    const PlanCacheKey shapeKey = computeKey(query);
+    const PlanCacheKey key = computeEntryKey(query, shapeKey);
+    Partition& partition = getPartition(shapeKey);
+    stdx::lock_guard<stdx::mutex> partitionLock(partition.mutex);
     PlanCacheEntry* entry;
-    Status cacheStatus = _cache.get(key, &entry);
+    Status cacheStatus = partition.cache.get(key, &entry);
     if (!cacheStatus.isOK()) {
         return cacheStatus;
     }
@@ -934,12 +1502,14 @@ Status PlanCache::getEntry(const CanonicalQuery& query, PlanCacheEntry** entryOu
 
 //ȡеPlanCacheEntryϢ
 std::vector<PlanCacheEntry*> PlanCache::getAllEntries() const {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
     std::vector<PlanCacheEntry*> entries;
     typedef std::list<std::pair<PlanCacheKey, PlanCacheEntry*>>::const_iterator ConstIterator;
-    for (ConstIterator i = _cache.begin(); i != _cache.end(); i++) {
-        PlanCacheEntry* entry = i->second;
-        entries.push_back(entry->clone());
+    for (auto&& partition : _partitions) {
+        stdx::lock_guard<stdx::mutex> partitionLock(partition->mutex);
+        for (ConstIterator i = partition->cache.begin(); i != partition->cache.end(); i++) {
+            PlanCacheEntry* entry = i->second;
+            entries.push_back(entry->clone());
+        }
     }
 
     return entries;
@@ -948,19 +1518,168 @@ std::vector<PlanCacheEntry*> PlanCache::getAllEntries() const {
 //computeKey(cq)ΪgetPlansByQueryеĲѯdb.xx.getPlanCache().getPlansByQuery({"query" : {"create_time" : { "$gte" : "2020-12-27 00:00:00","$lte" : "2021-01-26 23:59:59"}},"sort" : { },"projection" : {}})
 //鿴planǷcqPlanCacheListPlans::listе
 bool PlanCache::contains(const CanonicalQuery& cq) const {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    return _cache.hasKey(computeKey(cq));
+    const PlanCacheKey shapeKey = computeKey(cq);
+    const PlanCacheKey key = computeEntryKey(cq, shapeKey);
+    Partition& partition = getPartition(shapeKey);
+    stdx::lock_guard<stdx::mutex> partitionLock(partition.mutex);
+    return partition.cache.hasKey(key);
 }
 
 size_t PlanCache::size() const {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    return _cache.size();
+    size_t size = 0;
+    for (auto&& partition : _partitions) {
+        stdx::lock_guard<stdx::mutex> partitionLock(partition->mutex);
+        size += partition->cache.size();
+    }
+    return size;
+}
+
+void PlanTrialStats::serialize(BSONObjBuilder* builder) const {
+    builder->append("trials", trials);
+    builder->append("candidates", candidates);
+    builder->append("candidatesEliminated", candidatesEliminated);
+    builder->append("works", works);
+    builder->append("micros", micros);
+}
+
+void PlanCache::recordTrial(const CanonicalQuery& query, const PlanTrialStats& trial) {
+    const PlanCacheKey shapeKey = computeKey(query);
+    Partition& partition = getPartition(shapeKey);
+    stdx::unique_lock<stdx::mutex> partitionLock(partition.mutex);
+
+    PlanTrialStats* stats;
+    if (!partition.trialStats.get(shapeKey, &stats).isOK()) {
+        stats = new PlanTrialStats();
+        addTrialStats(&partition, shapeKey, stats);
+    }
+    stats->trials += trial.trials;
+    stats->candidates += trial.candidates;
+    stats->candidatesEliminated += trial.candidatesEliminated;
+    stats->works += trial.works;
+    stats->micros += trial.micros;
+    partitionLock.unlock();
+
+    enforceMemoryBudget(PlanCacheKey());
+}
+
+boost::optional<PlanTrialStats> PlanCache::getTrialStats(const CanonicalQuery& query) const {
+    const PlanCacheKey shapeKey = computeKey(query);
+    Partition& partition = getPartition(shapeKey);
+    stdx::lock_guard<stdx::mutex> partitionLock(partition.mutex);
+
+    PlanTrialStats* stats;
+    if (!partition.trialStats.get(shapeKey, &stats).isOK()) {
+        return boost::none;
+    }
+    return *stats;
+}
+
+size_t PlanCache::getSizeEstimateBytes() const {
+    size_t sizeBytes = 0;
+    for (auto&& partition : _partitions) {
+        stdx::lock_guard<stdx::mutex> partitionLock(partition->mutex);
+        sizeBytes += partition->sizeBytes;
+    }
+    return sizeBytes;
 }
 
 //CollectionInfoCacheImpl::updatePlanCacheIndexEntriesеã
 //CollectionInfoCacheImpl::updatePlanCacheIndexEntriesIndexEntryIndexDescriptorת
 void PlanCache::notifyOfIndexEntries(const std::vector<IndexEntry>& indexEntries) {
     _indexabilityState.updateDiscriminators(indexEntries);
+    _indexEntries = indexEntries;
+}
+
+Status PlanCache::addFromSnapshot(const CanonicalQuery& query, const BSONObj& snapshot) {
+    std::vector<std::unique_ptr<QuerySolution>> solutions;
+    auto decision = stdx::make_unique<PlanRankingDecision>();
+
+    for (auto&& planElt : snapshot.getObjectField("plans")) {
+        if (!planElt.isABSONObj()) {
+            return Status(ErrorCodes::BadValue, "plans must contain objects");
+        }
+        BSONObj planObj = planElt.Obj();
+
+        BSONElement solutionElt;
+        Status status = bsonExtractTypedField(planObj, "solution", BSONType::Object, &solutionElt);
+        if (!status.isOK()) {
+            return status;
+        }
+        auto swCacheData = SolutionCacheData::parse(solutionElt.Obj(), _indexEntries);
+        if (!swCacheData.isOK()) {
+            return swCacheData.getStatus();
+        }
+        auto qs = stdx::make_unique<QuerySolution>();
+        qs->cacheData = std::move(swCacheData.getValue());
+
+        double score;
+        long long works;
+        long long advanced;
+        bool isEOF;
+        status = bsonExtractDoubleField(planObj, "score", &score);
+        if (status.isOK()) {
+            status = bsonExtractIntegerField(planObj, "works", &works);
+        }
+        if (status.isOK()) {
+            status = bsonExtractIntegerField(planObj, "advanced", &advanced);
+        }
+        if (status.isOK()) {
+            status = bsonExtractBooleanField(planObj, "isEOF", &isEOF);
+        }
+        if (!status.isOK()) {
+            return status;
+        }
+
+        CommonStats common(kSnapshotStatsStageName);
+        common.works = static_cast<size_t>(works);
+        common.advanced = static_cast<size_t>(advanced);
+        common.isEOF = isEOF;
+        decision->stats.push_back(stdx::make_unique<PlanStageStats>(common, STAGE_UNKNOWN));
+        decision->scores.push_back(score);
+        decision->candidateOrder.push_back(solutions.size());
+        solutions.push_back(std::move(qs));
+    }
+
+    if (solutions.empty()) {
+        return Status(ErrorCodes::BadValue, "no solutions in plan cache snapshot");
+    }
+
+    auto entry = stdx::make_unique<PlanCacheEntry>(
+        transitional_tools_do_not_use::unspool_vector(solutions), decision.release());
+    const QueryRequest& qr = query.getQueryRequest();
+    entry->query = qr.getFilter().getOwned();
+    entry->sort = qr.getSort().getOwned();
+    entry->projection = snapshot["projection"].isABSONObj()
+        ? snapshot["projection"].Obj().getOwned()
+        : BSONObj();
+    if (query.getCollator()) {
+        entry->collation = query.getCollator()->getSpec().toBSON();
+    }
+    if (snapshot["timeOfCreation"].type() == BSONType::Date) {
+        entry->timeOfCreation = snapshot["timeOfCreation"].date();
+    }
+
+    // Index statistics are usually not sampled yet when the cache is warmed, so the entry keeps
+    // the selectivity bucket it was snapshotted with.
+    long long bucket;
+    if (internalQueryCacheEnableParameterizedPlans.load() &&
+        bsonExtractIntegerField(snapshot, "selectivityBucket", &bucket).isOK()) {
+        entry->selectivityBucket = static_cast<int>(bucket);
+    }
+    const PlanCacheKey shapeKey = computeKey(query);
+    const PlanCacheKey key = makeEntryKey(shapeKey, entry->selectivityBucket);
+    Partition& partition = getPartition(shapeKey);
+    stdx::unique_lock<stdx::mutex> partitionLock(partition.mutex);
+
+    // Plans chosen since startup reflect the current data better than the snapshot does.
+    if (partition.cache.hasKey(key)) {
+        return Status::OK();
+    }
+    addEntry(&partition, key, entry.release());
+    partitionLock.unlock();
+
+    enforceMemoryBudget(key);
+    return Status::OK();
 }
 
 }  // namespace mongo
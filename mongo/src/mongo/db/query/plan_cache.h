@@ -31,6 +31,7 @@
 #include <boost/optional/optional.hpp>
 #include <set>
 
+#include "mongo/base/counter.h"
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/query/canonical_query.h"
 #include "mongo/db/query/index_tag.h"
@@ -39,6 +40,7 @@
 #include "mongo/db/query/query_planner_params.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/stdx/mutex.h"
+#include "mongo/util/string_map.h"
 
 namespace mongo {
 
@@ -48,6 +50,12 @@ namespace mongo {
 //οPlanCache::contains
 typedef std::string PlanCacheKey;
 
+// Server-wide plan cache memory accounting, summed over the plan caches of all collections.
+// Reported in serverStatus under metrics.query.planCache.
+extern Counter64 planCacheTotalSizeEstimateBytes;
+extern Counter64 planCacheMemoryEvictions;
+
+class IndexStatistics;
 struct PlanRankingDecision;
 struct QuerySolution;
 struct QuerySolutionNode;
@@ -133,6 +141,19 @@ struct PlanCacheIndexTree {
      */
     std::string toString(int indents = 0) const;
 
+    /**
+     * Serializes this tree for a plan cache snapshot. Indexes are recorded by name and key
+     * pattern rather than as full IndexEntry objects.
+     */
+    void serialize(BSONObjBuilder* builder) const;
+
+    /**
+     * Rebuilds a tree written by serialize(), resolving index names against 'indexEntries'.
+     * Fails if a referenced index no longer exists or now has a different key pattern.
+     */
+    static StatusWith<std::unique_ptr<PlanCacheIndexTree>> parse(
+        const BSONObj& obj, const std::vector<IndexEntry>& indexEntries);
+
     // Children owned here.
     //treeͨchildren
     std::vector<PlanCacheIndexTree*> children;
@@ -179,6 +200,12 @@ struct SolutionCacheData {
     // For debugging.
     std::string toString() const;
 
+    // Serialization for plan cache snapshots. See PlanCacheIndexTree::serialize() and
+    // PlanCacheIndexTree::parse().
+    void serialize(BSONObjBuilder* builder) const;
+    static StatusWith<std::unique_ptr<SolutionCacheData>> parse(
+        const BSONObj& obj, const std::vector<IndexEntry>& indexEntries);
+
     // Owned here. If 'wholeIXSoln' is false, then 'tree'
     // can be used to tag an isomorphic match expression. If 'wholeIXSoln'
     // is true, then 'tree' is used to store the relevant IndexEntry.
@@ -205,7 +232,12 @@ struct SolutionCacheData {
         // to tag the match expression.
         //ߺѡSolutionCacheDataʹõĬֵ
         //ֻSubplanStageʹãsolnType != USE_INDEX_TAGS_SOLN˵ûкʵĺѡοtagOrChildAccordingToCache
-        USE_INDEX_TAGS_SOLN
+        USE_INDEX_TAGS_SOLN,
+
+        // The cached plan is a skip scan, an index scan over every value of the leading field
+        // of the index stored in 'tree' and over bounds on its later fields. Added last so that
+        // the values persisted in plan cache snapshots keep their meaning.
+        SKIP_SCAN_SOLN
     } solnType; //ĬUSE_INDEX_TAGS_SOLN
 
     // The direction of the index scan used as
@@ -483,6 +515,18 @@ public:
     // For debugging.
     std::string toString() const;
 
+    /**
+     * Returns an estimate of the memory consumed by this entry, including its planner data,
+     * ranking decision and feedback.
+     */
+    size_t estimateObjectSizeInBytes() const;
+
+    /**
+     * Serializes the shape, planner data and ranking scores of this entry so that it can be
+     * reloaded with PlanCache::addFromSnapshot() after a restart.
+     */
+    void serialize(BSONObjBuilder* builder) const;
+
     //
     // Planner data
     //
@@ -503,6 +547,15 @@ public:
     BSONObj collation;
     Date_t timeOfCreation;
 
+    // When the cache runs in parameterized mode, entries for the same query shape are kept in
+    // a family keyed by the selectivity bucket estimated for the literal values that produced
+    // them. Unset when parameterized caching is disabled, or when no index statistics covered
+    // the query.
+    boost::optional<int> selectivityBucket;
+
+    // The size of this entry as currently charged against the plan cache memory budget.
+    size_t estimatedEntrySizeBytes = 0;
+
     //
     // Performance stats
     //
@@ -520,6 +573,28 @@ public:
     std::vector<PlanCacheEntryFeedback*> feedback;
 };
 
+/**
+ * The cost of the multi-planning trial periods run for one query shape, summed over trials.
+ */
+struct PlanTrialStats {
+    void serialize(BSONObjBuilder* builder) const;
+
+    // How many trial periods were run.
+    long long trials = 0;
+
+    // Candidate plans entered into the trial periods.
+    long long candidates = 0;
+
+    // Candidate plans dropped by successive halving before the end of a trial period.
+    long long candidatesEliminated = 0;
+
+    // Calls to work() on candidate plans.
+    long long works = 0;
+
+    // Time spent in the trial periods.
+    long long micros = 0;
+};
+
 /**
  * Caches the best solution to a query.  Aside from the (CanonicalQuery -> QuerySolution)
  * mapping, the cache contains information on why that mapping was made and statistics on the
@@ -651,9 +726,19 @@ public:
     /**
      * Remove the entry corresponding to 'ck' from the cache.  Returns Status::OK() if the plan
      * was present and removed and an error status otherwise.
+     *
+     * With parameterized caching, only the entry for the selectivity bucket of the literals in
+     * 'canonicalQuery' is removed; the rest of the shape's family is left in place.
      */
     Status remove(const CanonicalQuery& canonicalQuery);
 
+    /**
+     * Remove every entry stored for the shape of 'canonicalQuery', including all of its
+     * parameterized family members.  Returns Status::OK() if at least one entry was removed and
+     * an error status otherwise.
+     */
+    Status removeQueryShape(const CanonicalQuery& canonicalQuery);
+
     /**
      * Remove *all* cached plans.  Does not clear index information.
      */
@@ -701,6 +786,11 @@ public:
      */
     size_t size() const;
 
+    /**
+     * Returns the estimated memory footprint, in bytes, of the entries in this cache.
+     */
+    size_t getSizeEstimateBytes() const;
+
     /**
      * Updates internal state kept about the collection's indexes.  Must be called when the set
      * of indexes on the associated collection have changed.
@@ -709,18 +799,119 @@ public:
      */
     void notifyOfIndexEntries(const std::vector<IndexEntry>& indexEntries);
 
+    /**
+     * Adds an entry written by PlanCacheEntry::serialize() under the key of 'query', unless the
+     * cache already holds an entry for it. Index references are validated against the index
+     * entries last passed to notifyOfIndexEntries(); an error is returned if any of them is
+     * stale. Used to warm the cache after a restart or failover.
+     *
+     * Callers must hold the collection lock when calling this method.
+     */
+    Status addFromSnapshot(const CanonicalQuery& query, const BSONObj& snapshot);
+
+    /**
+     * Adds the cost of a multi-planning trial period for 'query' to the statistics kept for its
+     * shape. Statistics are kept whether or not the winning plan was cached, and are only dropped
+     * when the cache is cleared or the shape is evicted by newer shapes.
+     */
+    void recordTrial(const CanonicalQuery& query, const PlanTrialStats& trial);
+
+    /**
+     * Returns the trial statistics kept for the shape of 'query', if any.
+     */
+    boost::optional<PlanTrialStats> getTrialStats(const CanonicalQuery& query) const;
+
+    /**
+     * Records the statistics sampled for the index named 'indexName', or forgets them if 'stats'
+     * is null. In parameterized mode they are used to estimate the selectivity of queries.
+     */
+    void notifyOfIndexStatistics(StringData indexName,
+                                 std::shared_ptr<const IndexStatistics> stats);
+
+    /**
+     * Estimates how many documents the top-level comparison and $in predicates of 'cq' match,
+     * from the statistics of the indexes whose leading field they constrain, and maps the most
+     * selective of them to a bucket in the range [0, internalQueryCacheSelectivityBuckets). Low
+     * buckets correspond to selective literal values, high buckets to values which match much of
+     * the collection. Returns boost::none if no statistics cover any predicate of 'cq'.
+     *
+     * Callers must hold the collection lock.
+     */
+    boost::optional<int> estimateSelectivityBucket(const CanonicalQuery& cq) const;
+
 private:
     void encodeKeyForMatch(const MatchExpression* tree, StringBuilder* keyBuilder) const;
     void encodeKeyForSort(const BSONObj& sortObj, StringBuilder* keyBuilder) const;
     void encodeKeyForProj(const BSONObj& projObj, StringBuilder* keyBuilder) const;
+
+    /**
+     * A hash partition of the cache. A query shape always maps to the same partition, so the
+     * whole parameterized family of a shape is guarded by a single mutex while unrelated shapes
+     * do not contend with each other.
+     */
+    struct Partition {
+        explicit Partition(size_t maxEntries) : cache(maxEntries), trialStats(maxEntries) {}
+
+        LRUKeyValue<PlanCacheKey, PlanCacheEntry> cache;
+
+        // Trial period costs, keyed by query shape.
+        LRUKeyValue<PlanCacheKey, PlanTrialStats> trialStats;
+
+        // Sum of PlanCacheEntry::estimatedEntrySizeBytes over the entries in 'cache', plus the
+        // estimated size of each entry in 'trialStats'.
+        size_t sizeBytes = 0;
+
+        // Protects all of the above.
+        stdx::mutex mutex;
+    };
+
+    Partition& getPartition(const PlanCacheKey& shapeKey) const;
+
+    /**
+     * Returns the key under which the entry for 'cq' is stored. This is 'shapeKey' unless
+     * parameterized caching is enabled and a selectivity bucket can be estimated for 'cq', in
+     * which case the bucket is appended.
+     */
+    PlanCacheKey computeEntryKey(const CanonicalQuery& cq, const PlanCacheKey& shapeKey) const;
+
+    /**
+     * Returns the key of the entry for 'bucket' in the family of 'shapeKey', or 'shapeKey' itself
+     * if there is no bucket.
+     */
+    static PlanCacheKey makeEntryKey(const PlanCacheKey& shapeKey, boost::optional<int> bucket);
+
+    /**
+     * Helpers which keep the partition and server-wide memory accounting in sync with the
+     * contents of 'partition->cache'. Callers must hold the partition mutex.
+     */
+    void addEntry(Partition* partition, const PlanCacheKey& key, PlanCacheEntry* entry);
+    Status removeEntry(Partition* partition, const PlanCacheKey& key);
+
+    /**
+     * The same for the contents of 'partition->trialStats'. removeLeastRecentlyUsedTrialStats()
+     * returns false if 'partition' holds no trial stats.
+     */
+    void addTrialStats(Partition* partition, const PlanCacheKey& shapeKey, PlanTrialStats* stats);
+    void removeTrialStats(Partition* partition, const PlanCacheKey& shapeKey);
+    bool removeLeastRecentlyUsedTrialStats(Partition* partition);
+    void clearPartition(Partition* partition);
+
+    /**
+     * Evicts least recently used entries, each from whichever partition of this cache is
+     * largest, until the server-wide memory estimate is within internalQueryCacheMaxSizeBytes or
+     * this cache is within its share of that budget, split evenly among all plan caches. The
+     * entry stored under 'keepKey', which the caller has just added, is never evicted. Callers
+     * must not hold any partition mutex.
+     */
+    void enforceMemoryBudget(const PlanCacheKey& keepKey);
     
     //PlanCacheEntryPlanCacheKey浽֧LRU
     //ĳPlanCacheEntry, οPlanCache::get  PlanCache::getAllEntries()
     ////MultiPlanStage::pickBestPlanаѵ÷ָߵĺѡӵplancache
-    LRUKeyValue<PlanCacheKey, PlanCacheEntry> _cache;
-
-    // Protects _cache.
-    mutable stdx::mutex _cacheMutex;
+    //
+    // The cache is split into internalQueryCacheNumPartitions partitions, each with its own LRU
+    // list and mutex.
+    std::vector<std::unique_ptr<Partition>> _partitions;
 
     // Full namespace of collection.
     std::string _ns;
@@ -731,6 +922,16 @@ private:
     // Concurrent access is synchronized by the collection lock.  Multiple concurrent readers
     // are allowed.
     PlanCacheIndexabilityState _indexabilityState;
+
+    // The indexes of the collection as of the last call to notifyOfIndexEntries(). Used to
+    // resolve index names when restoring entries from a snapshot. Synchronized like
+    // '_indexabilityState'.
+    std::vector<IndexEntry> _indexEntries;
+
+    // The statistics last sampled for each index of the collection, by index name. They may be
+    // replaced at any time by the sampler, so they have a mutex of their own.
+    StringMap<std::shared_ptr<const IndexStatistics>> _indexStatistics;
+    mutable stdx::mutex _indexStatisticsMutex;
 };
 
 }  // namespace mongo
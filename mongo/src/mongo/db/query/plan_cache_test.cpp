@@ -41,6 +41,7 @@
 #include "mongo/db/matcher/extensions_callback_noop.h"
 #include "mongo/db/pipeline/expression_context_for_test.h"
 #include "mongo/db/query/collation/collator_interface_mock.h"
+#include "mongo/db/query/index_statistics.h"
 #include "mongo/db/query/plan_ranker.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
@@ -449,6 +450,306 @@ TEST(PlanCacheTest, AddValidSolution) {
     ASSERT_EQUALS(planCache.size(), 1U);
 }
 
+TEST(PlanCacheTest, RecordTrialAccumulatesPerShape) {
+    PlanCache planCache;
+    unique_ptr<CanonicalQuery> cqA(canonicalize("{a: 1}"));
+    unique_ptr<CanonicalQuery> cqB(canonicalize("{a: 2}"));
+    unique_ptr<CanonicalQuery> cqOther(canonicalize("{b: 1}"));
+    ASSERT_FALSE(planCache.getTrialStats(*cqA));
+
+    PlanTrialStats trial;
+    trial.trials = 1;
+    trial.candidates = 16;
+    trial.candidatesEliminated = 12;
+    trial.works = 400;
+    trial.micros = 50;
+    planCache.recordTrial(*cqA, trial);
+    planCache.recordTrial(*cqB, trial);
+
+    // Both queries have the same shape, so their trials are accumulated together.
+    auto stats = planCache.getTrialStats(*cqA);
+    ASSERT_TRUE(stats);
+    ASSERT_EQUALS(stats->trials, 2LL);
+    ASSERT_EQUALS(stats->candidates, 32LL);
+    ASSERT_EQUALS(stats->candidatesEliminated, 24LL);
+    ASSERT_EQUALS(stats->works, 800LL);
+    ASSERT_EQUALS(stats->micros, 100LL);
+    ASSERT_FALSE(planCache.getTrialStats(*cqOther));
+
+    // Trial statistics count towards the size of the cache.
+    ASSERT_GREATER_THAN(planCache.getSizeEstimateBytes(), 0U);
+
+    // Removing a shape drops its trial statistics.
+    planCache.recordTrial(*cqOther, trial);
+    planCache.remove(*cqA).transitional_ignore();
+    ASSERT_FALSE(planCache.getTrialStats(*cqA));
+    ASSERT_TRUE(planCache.getTrialStats(*cqOther));
+
+    // Trial statistics are dropped along with the cache entries.
+    planCache.clear();
+    ASSERT_FALSE(planCache.getTrialStats(*cqOther));
+    ASSERT_EQUALS(planCache.getSizeEstimateBytes(), 0U);
+}
+
+TEST(PlanCacheTest, EvictsLeastRecentlyUsedEntriesOverMemoryBudget) {
+    const int oldNumPartitions = internalQueryCacheNumPartitions.load();
+    const long long oldMaxSizeBytes = internalQueryCacheMaxSizeBytes.load();
+    ON_BLOCK_EXIT([oldNumPartitions, oldMaxSizeBytes] {
+        internalQueryCacheNumPartitions.store(oldNumPartitions);
+        internalQueryCacheMaxSizeBytes.store(oldMaxSizeBytes);
+    });
+    internalQueryCacheNumPartitions.store(1);
+
+    PlanCache planCache;
+    QuerySolution qs;
+    qs.cacheData.reset(new SolutionCacheData());
+    qs.cacheData->tree.reset(new PlanCacheIndexTree());
+    std::vector<QuerySolution*> solns;
+    solns.push_back(&qs);
+    QueryTestServiceContext serviceContext;
+
+    unique_ptr<CanonicalQuery> cqA(canonicalize("{a: 1}"));
+    ASSERT_OK(planCache.add(*cqA, solns, createDecision(1U), Date_t{}));
+    const size_t entrySizeBytes = planCache.getSizeEstimateBytes();
+    ASSERT_GT(entrySizeBytes, 0U);
+    ASSERT_EQUALS(planCacheTotalSizeEstimateBytes.get(), static_cast<long long>(entrySizeBytes));
+
+    // Leave room for two entries of this size.
+    internalQueryCacheMaxSizeBytes.store(entrySizeBytes * 2 + entrySizeBytes / 2);
+    unique_ptr<CanonicalQuery> cqB(canonicalize("{b: 1}"));
+    unique_ptr<CanonicalQuery> cqC(canonicalize("{c: 1}"));
+    ASSERT_OK(planCache.add(*cqB, solns, createDecision(1U), Date_t{}));
+    ASSERT_OK(planCache.add(*cqC, solns, createDecision(1U), Date_t{}));
+
+    ASSERT_EQUALS(planCache.size(), 2U);
+    ASSERT_FALSE(planCache.contains(*cqA));
+    ASSERT_TRUE(planCache.contains(*cqB));
+    ASSERT_TRUE(planCache.contains(*cqC));
+    ASSERT_EQUALS(planCache.getSizeEstimateBytes(), entrySizeBytes * 2);
+
+    // Removing entries releases their memory from the server-wide total.
+    ASSERT_OK(planCache.remove(*cqB));
+    ASSERT_EQUALS(planCache.getSizeEstimateBytes(), entrySizeBytes);
+    planCache.clear();
+    ASSERT_EQUALS(planCache.getSizeEstimateBytes(), 0U);
+    ASSERT_EQUALS(planCacheTotalSizeEstimateBytes.get(), 0LL);
+}
+
+TEST(PlanCacheTest, MemoryBudgetEvictsAcrossPartitions) {
+    const int oldNumPartitions = internalQueryCacheNumPartitions.load();
+    const long long oldMaxSizeBytes = internalQueryCacheMaxSizeBytes.load();
+    ON_BLOCK_EXIT([oldNumPartitions, oldMaxSizeBytes] {
+        internalQueryCacheNumPartitions.store(oldNumPartitions);
+        internalQueryCacheMaxSizeBytes.store(oldMaxSizeBytes);
+    });
+    internalQueryCacheNumPartitions.store(4);
+
+    PlanCache planCache;
+    QuerySolution qs;
+    qs.cacheData.reset(new SolutionCacheData());
+    qs.cacheData->tree.reset(new PlanCacheIndexTree());
+    std::vector<QuerySolution*> solns;
+    solns.push_back(&qs);
+    QueryTestServiceContext serviceContext;
+
+    unique_ptr<CanonicalQuery> cqA(canonicalize("{a: 1}"));
+    ASSERT_OK(planCache.add(*cqA, solns, createDecision(1U), Date_t{}));
+    const size_t entrySizeBytes = planCache.getSizeEstimateBytes();
+
+    // Partitions holding a single entry still give it up when the budget is exceeded, whichever
+    // partition the new entries land in.
+    internalQueryCacheMaxSizeBytes.store(entrySizeBytes * 2 + entrySizeBytes / 2);
+    for (auto&& filter : {"{b: 1}", "{c: 1}", "{d: 1}", "{e: 1}", "{f: 1}", "{g: 1}"}) {
+        unique_ptr<CanonicalQuery> cq(canonicalize(filter));
+        ASSERT_OK(planCache.add(*cq, solns, createDecision(1U), Date_t{}));
+        ASSERT_LTE(planCache.getSizeEstimateBytes(), entrySizeBytes * 2);
+    }
+    ASSERT_EQUALS(planCache.size(), 2U);
+    ASSERT_EQUALS(planCacheTotalSizeEstimateBytes.get(),
+                  static_cast<long long>(planCache.getSizeEstimateBytes()));
+
+    planCache.clear();
+    ASSERT_EQUALS(planCacheTotalSizeEstimateBytes.get(), 0LL);
+}
+
+TEST(PlanCacheTest, MemoryBudgetIsSharedBetweenCaches) {
+    const int oldNumPartitions = internalQueryCacheNumPartitions.load();
+    const long long oldMaxSizeBytes = internalQueryCacheMaxSizeBytes.load();
+    ON_BLOCK_EXIT([oldNumPartitions, oldMaxSizeBytes] {
+        internalQueryCacheNumPartitions.store(oldNumPartitions);
+        internalQueryCacheMaxSizeBytes.store(oldMaxSizeBytes);
+    });
+    internalQueryCacheNumPartitions.store(1);
+
+    PlanCache busyCache;
+    PlanCache quietCache;
+    QuerySolution qs;
+    qs.cacheData.reset(new SolutionCacheData());
+    qs.cacheData->tree.reset(new PlanCacheIndexTree());
+    std::vector<QuerySolution*> solns;
+    solns.push_back(&qs);
+    QueryTestServiceContext serviceContext;
+
+    unique_ptr<CanonicalQuery> cqA(canonicalize("{a: 1}"));
+    ASSERT_OK(busyCache.add(*cqA, solns, createDecision(1U), Date_t{}));
+    const size_t entrySizeBytes = busyCache.getSizeEstimateBytes();
+
+    // Leave room for four entries, two for each cache.
+    internalQueryCacheMaxSizeBytes.store(entrySizeBytes * 4 + entrySizeBytes / 2);
+    for (auto&& filter : {"{b: 1}", "{c: 1}", "{d: 1}"}) {
+        unique_ptr<CanonicalQuery> cq(canonicalize(filter));
+        ASSERT_OK(busyCache.add(*cq, solns, createDecision(1U), Date_t{}));
+    }
+    ASSERT_EQUALS(busyCache.size(), 4U);
+
+    // The quiet cache is within its share, so it keeps its entry even though the budget is
+    // exceeded.
+    unique_ptr<CanonicalQuery> cqX(canonicalize("{x: 1}"));
+    ASSERT_OK(quietCache.add(*cqX, solns, createDecision(1U), Date_t{}));
+    ASSERT_TRUE(quietCache.contains(*cqX));
+
+    // The busy cache gives up its least recently used entries instead, never the one it just
+    // added, until the budget is met again.
+    unique_ptr<CanonicalQuery> cqE(canonicalize("{e: 1}"));
+    ASSERT_OK(busyCache.add(*cqE, solns, createDecision(1U), Date_t{}));
+    ASSERT_EQUALS(busyCache.size(), 3U);
+    ASSERT_FALSE(busyCache.contains(*cqA));
+    ASSERT_TRUE(busyCache.contains(*cqE));
+    ASSERT_LTE(planCacheTotalSizeEstimateBytes.get(),
+               internalQueryCacheMaxSizeBytes.load());
+
+    unique_ptr<CanonicalQuery> cqY(canonicalize("{y: 1}"));
+    ASSERT_OK(quietCache.add(*cqY, solns, createDecision(1U), Date_t{}));
+    ASSERT_EQUALS(quietCache.size(), 2U);
+
+    // Even with a budget too small for a single entry, the entry just added is kept.
+    internalQueryCacheMaxSizeBytes.store(entrySizeBytes / 2);
+    unique_ptr<CanonicalQuery> cqF(canonicalize("{f: 1}"));
+    ASSERT_OK(busyCache.add(*cqF, solns, createDecision(1U), Date_t{}));
+    ASSERT_EQUALS(busyCache.size(), 1U);
+    ASSERT_TRUE(busyCache.contains(*cqF));
+
+    busyCache.clear();
+    quietCache.clear();
+    ASSERT_EQUALS(planCacheTotalSizeEstimateBytes.get(), 0LL);
+}
+
+TEST(PlanCacheTest, ParameterizedPlansAreBucketedBySelectivity) {
+    bool oldEnableParameterizedPlans = internalQueryCacheEnableParameterizedPlans.load();
+    ON_BLOCK_EXIT([oldEnableParameterizedPlans] {
+        internalQueryCacheEnableParameterizedPlans.store(oldEnableParameterizedPlans);
+    });
+    internalQueryCacheEnableParameterizedPlans.store(true);
+
+    PlanCache planCache;
+    unique_ptr<CanonicalQuery> rareCq(canonicalize("{a: 5}"));
+    unique_ptr<CanonicalQuery> otherRareCq(canonicalize("{a: 7}"));
+    unique_ptr<CanonicalQuery> commonCq(canonicalize("{a: 1000}"));
+    QuerySolution qs;
+    qs.cacheData.reset(new SolutionCacheData());
+    qs.cacheData->tree.reset(new PlanCacheIndexTree());
+    std::vector<QuerySolution*> solns;
+    solns.push_back(&qs);
+
+    // All three queries share a shape, so index filters and explain still see a single key.
+    ASSERT_EQUALS(planCache.computeKey(*rareCq), planCache.computeKey(*commonCq));
+
+    // Without index statistics, there is nothing to estimate the selectivity from.
+    planCache.notifyOfIndexEntries(
+        {IndexEntry(BSON("a" << 1), false, false, false, "a_1", NULL, BSONObj())});
+    ASSERT_FALSE(planCache.estimateSelectivityBucket(*rareCq));
+
+    // Values 1 to 50 are each rare, while 1000 makes up half of the sample.
+    IndexStatistics::Builder builder(32U);
+    for (int i = 0; i < 100; ++i) {
+        BSONObjSet keys = SimpleBSONObjComparator::kInstance.makeBSONObjSet();
+        keys.insert(BSON("" << (i < 50 ? i + 1 : 1000)));
+        builder.addSampledDocument(keys);
+    }
+    planCache.notifyOfIndexStatistics("a_1", builder.build(100000));
+
+    auto rareBucket = planCache.estimateSelectivityBucket(*rareCq);
+    auto commonBucket = planCache.estimateSelectivityBucket(*commonCq);
+    ASSERT_TRUE(rareBucket);
+    ASSERT_TRUE(commonBucket);
+    ASSERT_LT(*rareBucket, *commonBucket);
+    ASSERT_EQUALS(*rareBucket, *planCache.estimateSelectivityBucket(*otherRareCq));
+
+    // A literal which has never been planned is served the plan cached for another literal in
+    // the same bucket, but not one cached for a literal in another bucket.
+    QueryTestServiceContext serviceContext;
+    ASSERT_OK(planCache.add(*rareCq, solns, createDecision(1U), Date_t{}));
+    ASSERT_TRUE(planCache.contains(*otherRareCq));
+    ASSERT_FALSE(planCache.contains(*commonCq));
+
+    PlanCacheEntry* rawEntry;
+    ASSERT_OK(planCache.getEntry(*otherRareCq, &rawEntry));
+    unique_ptr<PlanCacheEntry> rareEntry(rawEntry);
+    ASSERT_EQUALS(*rareEntry->selectivityBucket, *rareBucket);
+
+    ASSERT_OK(planCache.add(*commonCq, solns, createDecision(1U), Date_t{}));
+    ASSERT_EQUALS(planCache.size(), 2U);
+
+    // Removing the entry used by one literal, as a replan does, leaves the rest of the family.
+    ASSERT_OK(planCache.remove(*otherRareCq));
+    ASSERT_EQUALS(planCache.size(), 1U);
+    ASSERT_FALSE(planCache.contains(*rareCq));
+    ASSERT_TRUE(planCache.contains(*commonCq));
+
+    // Removing the shape drops the whole family, whichever literal names it.
+    ASSERT_OK(planCache.add(*rareCq, solns, createDecision(1U), Date_t{}));
+    ASSERT_EQUALS(planCache.size(), 2U);
+    ASSERT_OK(planCache.removeQueryShape(*otherRareCq));
+    ASSERT_EQUALS(planCache.size(), 0U);
+    ASSERT_NOT_OK(planCache.removeQueryShape(*otherRareCq));
+
+    // Once the statistics are dropped, the shape has a single entry again.
+    planCache.notifyOfIndexStatistics("a_1", nullptr);
+    ASSERT_FALSE(planCache.estimateSelectivityBucket(*rareCq));
+    ASSERT_OK(planCache.add(*rareCq, solns, createDecision(1U), Date_t{}));
+    ASSERT_TRUE(planCache.contains(*commonCq));
+}
+
+TEST(PlanCacheTest, RestoresEntryFromSnapshotOnlyIfIndexStillExists) {
+    const IndexEntry index(BSON("a" << 1), false, false, false, "a_1", NULL, BSONObj());
+    unique_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+
+    QuerySolution qs;
+    qs.cacheData.reset(new SolutionCacheData());
+    qs.cacheData->solnType = SolutionCacheData::USE_INDEX_TAGS_SOLN;
+    qs.cacheData->tree.reset(new PlanCacheIndexTree());
+    qs.cacheData->tree->setIndexEntry(index);
+    std::vector<QuerySolution*> solns;
+    solns.push_back(&qs);
+
+    QueryTestServiceContext serviceContext;
+    PlanCache planCache;
+    ASSERT_OK(planCache.add(*cq, solns, createDecision(1U), Date_t{}));
+    PlanCacheEntry* rawEntry;
+    ASSERT_OK(planCache.getEntry(*cq, &rawEntry));
+    unique_ptr<PlanCacheEntry> entry(rawEntry);
+    BSONObjBuilder bob;
+    entry->serialize(&bob);
+    const BSONObj snapshot = bob.obj();
+
+    // The index still exists, so the entry is restored as it was snapshotted.
+    PlanCache restoredCache;
+    restoredCache.notifyOfIndexEntries({index});
+    ASSERT_OK(restoredCache.addFromSnapshot(*cq, snapshot));
+    ASSERT_TRUE(restoredCache.contains(*cq));
+    ASSERT_OK(restoredCache.getEntry(*cq, &rawEntry));
+    unique_ptr<PlanCacheEntry> restoredEntry(rawEntry);
+    ASSERT_EQUALS(restoredEntry->plannerData.size(), 1U);
+    ASSERT_EQUALS(restoredEntry->plannerData[0]->tree->entry->name, "a_1");
+
+    // The index was rebuilt with a different key pattern, so the entry is stale.
+    PlanCache staleCache;
+    staleCache.notifyOfIndexEntries(
+        {IndexEntry(BSON("a" << -1), false, false, false, "a_1", NULL, BSONObj())});
+    ASSERT_EQUALS(staleCache.addFromSnapshot(*cq, snapshot), ErrorCodes::IndexNotFound);
+    ASSERT_FALSE(staleCache.contains(*cq));
+}
+
 /**
  * Each test in the CachePlanSelectionTest suite goes through
  * the following flow:
@@ -1357,6 +1658,41 @@ TEST_F(CachePlanSelectionTest, ContainedOrAndIntersection) {
         "]}}}}");
 }
 
+//
+// Skip scan
+//
+
+TEST_F(CachePlanSelectionTest, SkipScanIsRebuiltWithTheBoundsOfTheCachedQuery) {
+    bool oldEnableSkipScan = internalQueryPlannerEnableSkipScan.load();
+    internalQueryPlannerEnableSkipScan.store(true);
+    ON_BLOCK_EXIT(
+        [oldEnableSkipScan] { internalQueryPlannerEnableSkipScan.store(oldEnableSkipScan); });
+
+    addIndex(BSON("a" << 1 << "b" << 1), "a_1_b_1");
+    IndexStatistics::Builder builder(32U);
+    for (int value : {1, 2, 3, 1, 2, 3}) {
+        BSONObjSet keys = SimpleBSONObjComparator::kInstance.makeBSONObjSet();
+        keys.insert(BSON("" << value));
+        builder.addSampledDocument(keys);
+    }
+    params.indices.back().statistics = builder.build(1000);
+
+    runQuery(fromjson("{b: {$gte: 5, $lt: 10}}"));
+    const string skipScanSoln =
+        "{fetch: {node: {ixscan: {pattern: {a: 1, b: 1}, "
+        "bounds: {a: [['MinKey','MaxKey',true,true]], b: [[5,10,true,false]]}}}}}";
+    assertPlanCacheRecoversSolution(fromjson("{b: {$gte: 5, $lt: 10}}"), skipScanSoln);
+
+    // A query of the same shape with other literals gets a skip scan over its own bounds.
+    QuerySolution* planSoln = planQueryFromCache(fromjson("{b: {$gte: 20, $lt: 30}}"),
+                                                 *firstMatchingSolution(skipScanSoln));
+    assertSolutionMatches(
+        planSoln,
+        "{fetch: {node: {ixscan: {pattern: {a: 1, b: 1}, "
+        "bounds: {a: [['MinKey','MaxKey',true,true]], b: [[20,30,true,false]]}}}}}");
+    delete planSoln;
+}
+
 /**
  * Test functions for computeKey.  Cache keys are intentionally obfuscated and are
  * meaningful only within the current lifetime of the server process. Users should treat plan
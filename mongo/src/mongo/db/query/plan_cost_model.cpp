@@ -0,0 +1,291 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/plan_cost_model.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "mongo/db/query/index_statistics.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/util/log.h"
+
+namespace mongo {
+
+namespace {
+
+// Relative costs of the basic units of work, normalized to examining one index key.
+const double kFetchCost = 10.0;
+const double kCollScanDocCost = 2.0;
+const double kSortComparisonCost = 0.5;
+const double kSeekCost = 5.0;
+
+// Fractions of the keys assumed to match the bounds on a field without statistics of its own.
+const double kPointSelectivity = 0.05;
+const double kRangeSelectivity = 0.3;
+
+/**
+ * Guesses the fraction of keys matching 'oil', for an index field that has not been sampled.
+ */
+double guessSelectivity(const OrderedIntervalList& oil) {
+    if (oil.intervals.size() == 1U) {
+        const Interval& interval = oil.intervals[0];
+        const BSONType low = std::min(interval.start.type(), interval.end.type());
+        const BSONType high = std::max(interval.start.type(), interval.end.type());
+        if (MinKey == low && MaxKey == high) {
+            return 1.0;
+        }
+    }
+
+    double selectivity = 0.0;
+    for (auto&& interval : oil.intervals) {
+        selectivity += interval.isPoint() ? kPointSelectivity : kRangeSelectivity;
+    }
+    return std::min(selectivity, 1.0);
+}
+
+/**
+ * Estimates the keys examined by an index scan from the bounds on the leading index field.
+ */
+boost::optional<double> estimateKeysExamined(const IndexScanNode* ixscan) {
+    const IndexStatistics* stats = ixscan->index.statistics.get();
+    if (!stats) {
+        return boost::none;
+    }
+
+    const IndexBounds& bounds = ixscan->bounds;
+    if (bounds.isSimpleRange) {
+        OrderedIntervalList oil;
+        BSONObjBuilder bob;
+        bob.appendAs(bounds.startKey.firstElement(), "");
+        bob.appendAs(bounds.endKey.firstElement(), "");
+        oil.intervals.push_back(Interval(bob.obj(), true, true));
+        return stats->estimateKeys(oil);
+    }
+    if (bounds.fields.empty()) {
+        return boost::none;
+    }
+    return stats->estimateKeys(bounds.fields[0]);
+}
+
+/**
+ * Returns whether the tree rooted at 'node' contains a stage which consumes all of its input
+ * before producing its first result.
+ */
+bool hasBlockingStage(const QuerySolutionNode* node) {
+    if (STAGE_SORT == node->getType() || STAGE_AND_HASH == node->getType()) {
+        return true;
+    }
+    for (auto&& child : node->children) {
+        if (hasBlockingStage(child)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Returns whether the tree rooted at 'node' sorts its results with a blocking SORT stage.
+ */
+bool hasBlockingSort(const QuerySolutionNode* node) {
+    if (STAGE_SORT == node->getType()) {
+        return true;
+    }
+    for (auto&& child : node->children) {
+        if (hasBlockingSort(child)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+boost::optional<PlanCostModel::Estimate> PlanCostModel::estimate(
+    const QuerySolutionNode* node, boost::optional<long long> numRecords) {
+    std::vector<Estimate> children;
+    for (auto&& child : node->children) {
+        auto childEstimate = estimate(child, numRecords);
+        if (!childEstimate) {
+            return boost::none;
+        }
+        children.push_back(*childEstimate);
+    }
+
+    switch (node->getType()) {
+        case STAGE_COLLSCAN: {
+            if (!numRecords) {
+                return boost::none;
+            }
+            const double docs = static_cast<double>(*numRecords);
+            return Estimate{docs * kCollScanDocCost, docs};
+        }
+        case STAGE_IXSCAN: {
+            const IndexScanNode* ixscan = static_cast<const IndexScanNode*>(node);
+            auto keys = estimateKeysExamined(ixscan);
+            if (!keys) {
+                return boost::none;
+            }
+            Estimate result{*keys, *keys};
+
+            // The statistics only describe the leading field. When it is scanned in full but
+            // later fields are bounded, the bounds checker seeks from each distinct leading value
+            // to the next interval on the later fields, and only the keys within those intervals
+            // are examined.
+            const IndexBounds& bounds = ixscan->bounds;
+            const IndexStatistics* stats = ixscan->index.statistics.get();
+            if (bounds.isSimpleRange || bounds.fields.size() < 2U ||
+                guessSelectivity(bounds.fields[0]) < 1.0 || stats->getNumDistinctValues() < 1) {
+                return result;
+            }
+            double selectivity = 1.0;
+            double intervalsPerValue = 1.0;
+            for (size_t i = 1; i < bounds.fields.size(); ++i) {
+                selectivity *= guessSelectivity(bounds.fields[i]);
+                intervalsPerValue *= std::max<size_t>(1U, bounds.fields[i].intervals.size());
+            }
+            if (selectivity < 1.0) {
+                const double seeks = stats->getNumDistinctValues() * intervalsPerValue;
+                result.cardinality = *keys * selectivity;
+                result.cost = std::min(result.cost, seeks * kSeekCost + result.cardinality);
+            }
+            return result;
+        }
+        case STAGE_FETCH: {
+            invariant(children.size() == 1U);
+            return Estimate{children[0].cost + children[0].cardinality * kFetchCost,
+                            children[0].cardinality};
+        }
+        case STAGE_SORT: {
+            // A sort with a limit only keeps the top 'limit' results, so each comparison is
+            // against a smaller set and fewer results come out.
+            invariant(children.size() == 1U);
+            const SortNode* sort = static_cast<const SortNode*>(node);
+            const double n = std::max(1.0, children[0].cardinality);
+            const double kept = sort->limit ? std::min(n, static_cast<double>(sort->limit)) : n;
+            return Estimate{children[0].cost + n * std::log2(kept + 1) * kSortComparisonCost,
+                            std::min(children[0].cardinality, kept)};
+        }
+        case STAGE_LIMIT: {
+            // A plan without blocking stages stops as soon as it has produced 'limit' results, so
+            // it only does the share of its work needed to produce them.
+            invariant(children.size() == 1U);
+            const double limit = static_cast<double>(static_cast<const LimitNode*>(node)->limit);
+            Estimate result = children[0];
+            if (!hasBlockingStage(node->children[0]) && result.cardinality > limit) {
+                result.cost *= limit / result.cardinality;
+            }
+            result.cardinality = std::min(result.cardinality, limit);
+            return result;
+        }
+        case STAGE_AND_HASH:
+        case STAGE_AND_SORTED: {
+            Estimate result{0, std::numeric_limits<double>::max()};
+            for (auto&& child : children) {
+                result.cost += child.cost;
+                result.cardinality = std::min(result.cardinality, child.cardinality);
+            }
+            return result;
+        }
+        case STAGE_OR:
+        case STAGE_SORT_MERGE: {
+            Estimate result{0, 0};
+            for (auto&& child : children) {
+                result.cost += child.cost;
+                result.cardinality += child.cardinality;
+            }
+            return result;
+        }
+        case STAGE_KEEP_MUTATIONS:
+        case STAGE_PROJECTION:
+        case STAGE_SHARDING_FILTER:
+        case STAGE_SKIP:
+        case STAGE_SORT_KEY_GENERATOR: {
+            invariant(children.size() == 1U);
+            return children[0];
+        }
+        default:
+            return boost::none;
+    }
+}
+
+void PlanCostModel::rankAndPrune(const QueryPlannerParams& params,
+                                 std::vector<QuerySolution*>* solutions) {
+    if (solutions->size() < 2U) {
+        return;
+    }
+
+    boost::optional<long long> numRecords;
+    for (auto&& index : params.indices) {
+        if (index.statistics) {
+            numRecords = std::max(numRecords.value_or(0), index.statistics->getNumRecords());
+        }
+    }
+
+    std::vector<std::pair<double, QuerySolution*>> costed;
+    bool anyBlockingSort = false;
+    for (auto&& soln : *solutions) {
+        auto solnEstimate = estimate(soln->root.get(), numRecords);
+        if (!solnEstimate) {
+            return;
+        }
+        costed.emplace_back(solnEstimate->cost, soln);
+        anyBlockingSort = anyBlockingSort || hasBlockingSort(soln->root.get());
+    }
+
+    std::stable_sort(costed.begin(),
+                     costed.end(),
+                     [](const std::pair<double, QuerySolution*>& lhs,
+                        const std::pair<double, QuerySolution*>& rhs) {
+                         return lhs.first < rhs.first;
+                     });
+
+    const double maxCost =
+        costed.front().first * std::max(1.0, internalQueryPlannerCostPruningRatio.load());
+    solutions->clear();
+    for (auto&& candidate : costed) {
+        // The model does not know how soon a plan which provides the sort order finds enough
+        // results to satisfy a limit, so such plans are always left to the trial period.
+        const bool providesSort = anyBlockingSort && !hasBlockingSort(candidate.second->root.get());
+        if (candidate.first <= maxCost || providesSort) {
+            solutions->push_back(candidate.second);
+        } else {
+            LOG(2) << "Planner: pruning solution with estimated cost " << candidate.first
+                   << ", cheapest is " << costed.front().first << ":" << std::endl
+                   << redact(candidate.second->toString());
+            delete candidate.second;
+        }
+    }
+}
+
+}  // namespace mongo
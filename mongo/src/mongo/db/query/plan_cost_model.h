@@ -0,0 +1,71 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <vector>
+
+#include "mongo/db/query/query_planner_params.h"
+#include "mongo/db/query/query_solution.h"
+
+namespace mongo {
+
+/**
+ * Estimates the cost of executing a QuerySolution from the IndexStatistics attached to the
+ * IndexEntry objects it scans. The unit of cost is one index key examined.
+ */
+class PlanCostModel {
+public:
+    struct Estimate {
+        double cost;
+        // Estimated number of results produced.
+        double cardinality;
+    };
+
+    /**
+     * Returns the estimated cost of the solution tree rooted at 'node', or boost::none if it
+     * contains a stage the model does not understand or scans an index without statistics.
+     *
+     * 'numRecords' is the collection size used to cost collection scans.
+     */
+    static boost::optional<Estimate> estimate(const QuerySolutionNode* node,
+                                              boost::optional<long long> numRecords);
+
+    /**
+     * Orders 'solutions' from cheapest to most expensive and deletes those costing more than
+     * internalQueryPlannerCostPruningRatio times the cheapest one, so that fewer candidates take
+     * part in the multi-planner trial period. Does nothing unless every solution can be costed.
+     * When some solutions sort with a blocking SORT stage, those which obtain the sort order from
+     * an index are never deleted.
+     */
+    static void rankAndPrune(const QueryPlannerParams& params,
+                             std::vector<QuerySolution*>* solutions);
+};
+
+}  // namespace mongo
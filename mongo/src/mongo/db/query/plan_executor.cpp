@@ -38,6 +38,7 @@
 #include "mongo/db/catalog/database_holder.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/curop.h"
+#include "mongo/db/exec/batched_child_results.h"
 #include "mongo/db/exec/cached_plan.h"
 #include "mongo/db/exec/collection_scan.h"
 #include "mongo/db/exec/multi_plan.h"
@@ -49,6 +50,7 @@
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/query/mock_yield_policies.h"
 #include "mongo/db/query/plan_yield_policy.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/storage/record_fetcher.h"
@@ -232,7 +234,9 @@ PlanExecutor::PlanExecutor(OperationContext* opCtx,
       _root(std::move(rt)),
       _nss(std::move(nss)),
       // There's no point in yielding if the collection doesn't exist.
-      _yieldPolicy(makeYieldPolicy(this, collection ? yieldPolicy : NO_YIELD)) {
+      _yieldPolicy(makeYieldPolicy(this, collection ? yieldPolicy : NO_YIELD)),
+      _workBatchSize(static_cast<size_t>(std::max(0, internalQueryExecWorkBatchSize.load()))),
+      _rootResults(stdx::make_unique<BatchedChildResults>()) {
     // We may still need to initialize _nss from either collection or _cq.
     if (!_nss.isEmpty()) {
         return;  // We already have an _nss set, so there's nothing more to do.
@@ -415,6 +419,16 @@ void PlanExecutor::reattachToOperationContext(OperationContext* opCtx) {
 void PlanExecutor::invalidate(OperationContext* opCtx, const RecordId& dl, InvalidationType type) {
     if (!isMarkedAsKilled()) {
         _root->invalidate(opCtx, dl, type);
+
+        // The root no longer knows about the results we have buffered, so keep them valid here.
+        for (auto id : _rootResults->buffered()) {
+            WorkingSetMember* member = _workingSet->get(id);
+            if (member->hasRecordId() && member->hasObj() && member->recordId == dl) {
+                member->obj.setValue(member->obj.value().getOwned());
+                member->recordId = RecordId();
+                member->transitionToOwnedObj();
+            }
+        }
     }
 }
 
@@ -626,7 +640,10 @@ PlanExecutor::ExecState PlanExecutor::getNextImpl(Snapshotted<BSONObj>* objOut,
 		//PlanStage::work
 		//жһִMultiPlanStage::doWork
 		//ֻһһFetchStage::doWork
-        PlanStage::StageState code = _root->work(&id); //PlanStage::work  ִвѯƻ
+        if (_workBatchSize > 1U) {
+            _rootResults->startBatch(_workBatchSize);
+        }
+        PlanStage::StageState code = _rootResults->next(_root.get(), &id);
 
         if (code != PlanStage::NEED_YIELD)
             writeConflictsInARow = 0;
@@ -716,7 +733,8 @@ PlanExecutor::ExecState PlanExecutor::getNextImpl(Snapshotted<BSONObj>* objOut,
 
 bool PlanExecutor::isEOF() {
     invariant(_currentState == kUsable);
-    return isMarkedAsKilled() || (_stash.empty() && _root->isEOF());
+    return isMarkedAsKilled() ||
+        (_stash.empty() && !_rootResults->hasBuffered() && _root->isEOF());
 }
 
 void PlanExecutor::markAsKilled(string reason) {
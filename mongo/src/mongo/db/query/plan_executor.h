@@ -40,6 +40,7 @@
 
 namespace mongo {
 
+class BatchedChildResults;
 class BSONObj;
 class CappedInsertNotifier;
 struct CappedInsertNotifierData;
@@ -583,6 +584,11 @@ private:
     // stages.
     std::queue<BSONObj> _stash;
 
+    // If greater than one, '_root' is worked in batches of this many units of work, and
+    // '_rootResults' holds the results of the current batch not yet returned. Never NULL.
+    const size_t _workBatchSize;
+    const std::unique_ptr<BatchedChildResults> _rootResults;
+
     //planִ״̬Ϣ
     enum { kUsable, kSaved, kDetached, kDisposed } _currentState = kUsable;
 
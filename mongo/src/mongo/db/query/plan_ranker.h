@@ -49,7 +49,8 @@ struct PlanRankingDecision;
 class PlanRanker {
 public:
     /**
-     * Returns index in 'candidates' of which plan is best.
+     * Returns index in 'candidates' of which plan is best. Eliminated candidates are not ranked,
+     * and at least one candidate must not be eliminated.
      * Populates 'why' with information relevant to how each plan fared in the ranking process.
      * Caller owns pointers in 'why'.
      * 'candidateOrder' holds indices into candidates ordered by score (winner in first element).
@@ -83,6 +84,11 @@ struct CandidatePlan { //
     std::list<WorkingSetID> results;
 
     bool failed;
+
+    // Set when a successive-halving trial period drops this plan before the end of the trial.
+    // Eliminated plans are not ranked, and serve as the backup plan only when no plan which
+    // survived the trial can.
+    bool eliminated = false;
 };
 
 /**
@@ -41,10 +41,12 @@
 #include "mongo/db/bson/dotted_path_support.h"
 #include "mongo/db/matcher/expression_array.h"
 #include "mongo/db/matcher/expression_geo.h"
+#include "mongo/db/matcher/expression_leaf.h"
 #include "mongo/db/matcher/expression_text.h"
 #include "mongo/db/query/index_bounds_builder.h"
 #include "mongo/db/query/index_tag.h"
 #include "mongo/db/query/indexability.h"
+#include "mongo/db/query/planner_analysis.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/query/query_planner_common.h"
@@ -156,6 +158,7 @@ std::unique_ptr<QuerySolutionNode> QueryPlannerAccess::makeCollectionScan(
     csn->maxScan = query.getQueryRequest().getMaxScan();
     csn->shouldTrackLatestOplogTimestamp =
         params.options & QueryPlannerParams::TRACK_LATEST_OPLOG_TS;
+    csn->allowParallel = params.options & QueryPlannerParams::ALLOW_PARALLEL_COLLSCAN;
 
     // If the hint is {$natural: +-1} this changes the direction of the collection scan.
     if (!query.getQueryRequest().getHint().isEmpty()) {
@@ -1335,6 +1338,81 @@ QuerySolutionNode* QueryPlannerAccess::scanWholeIndex(const IndexEntry& index,
     return solnRoot;
 }
 
+// static
+std::unique_ptr<QuerySolutionNode> QueryPlannerAccess::makeSkipScan(const IndexEntry& index,
+                                                                    const CanonicalQuery& query) {
+    std::vector<const MatchExpression*> predicates;
+    const MatchExpression* root = query.root();
+    if (MatchExpression::AND == root->matchType()) {
+        for (size_t i = 0; i < root->numChildren(); ++i) {
+            predicates.push_back(root->getChild(i));
+        }
+    } else {
+        predicates.push_back(root);
+    }
+
+    const BSONElement leadingField = index.keyPattern.firstElement();
+    for (auto&& predicate : predicates) {
+        if (predicate->path() == leadingField.fieldNameStringData()) {
+            return nullptr;
+        }
+    }
+
+    // The index scan's bounds checker already seeks past the keys of each leading value that
+    // fall outside the bounds on the later fields, so bounding those fields is all it takes.
+    auto isn = stdx::make_unique<IndexScanNode>(index);
+    isn->maxScan = query.getQueryRequest().getMaxScan();
+    isn->addKeyMetadata = query.getQueryRequest().returnKey();
+    isn->queryCollator = query.getCollator();
+    bool hasBounds = false;
+    BSONObjIterator it(index.keyPattern);
+    while (it.more()) {
+        const BSONElement keyElt = it.next();
+        OrderedIntervalList oil(keyElt.fieldName());
+        bool fieldHasBounds = false;
+
+        // The leading field is always scanned in full.
+        if (keyElt.fieldNameStringData() != leadingField.fieldNameStringData()) {
+            for (auto&& predicate : predicates) {
+                if (predicate->path() != keyElt.fieldNameStringData()) {
+                    continue;
+                }
+                if (!ComparisonMatchExpression::isComparisonMatchExpression(predicate) &&
+                    MatchExpression::MATCH_IN != predicate->matchType()) {
+                    continue;
+                }
+
+                IndexBoundsBuilder::BoundsTightness tightness;
+                if (fieldHasBounds) {
+                    IndexBoundsBuilder::translateAndIntersect(
+                        predicate, keyElt, index, &oil, &tightness);
+                } else {
+                    IndexBoundsBuilder::translate(predicate, keyElt, index, &oil, &tightness);
+                    fieldHasBounds = true;
+                }
+            }
+        }
+
+        if (!fieldHasBounds) {
+            IndexBoundsBuilder::allValuesForField(keyElt, &oil);
+        }
+        hasBounds = hasBounds || fieldHasBounds;
+        isn->bounds.fields.push_back(oil);
+    }
+
+    if (!hasBounds) {
+        return nullptr;
+    }
+
+    IndexBoundsBuilder::alignBounds(&isn->bounds, index.keyPattern);
+
+    // The bounds may be inexact, so the whole query is applied to the fetched documents.
+    auto fetch = stdx::make_unique<FetchNode>();
+    fetch->filter = query.root()->shallowClone();
+    fetch->children.push_back(isn.release());
+    return std::move(fetch);
+}
+
 // static
 void QueryPlannerAccess::addFilterToSolutionNode(QuerySolutionNode* node,
                                                  MatchExpression* match,
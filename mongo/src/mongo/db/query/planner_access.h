@@ -204,6 +204,18 @@ public:
                                              const QueryPlannerParams& params,
                                              int direction = 1);
 
+    /**
+     * Return a plan that skip-scans 'index', whose leading field 'query' does not constrain: an
+     * index scan over all values of the leading field, with bounds on the later fields built from
+     * the top-level predicates of 'query'. The whole query is applied as a filter on the fetched
+     * documents.
+     *
+     * Returns NULL if no predicate of 'query' bounds a field of 'index' other than the leading
+     * one, or if a predicate constrains the leading field.
+     */
+    static std::unique_ptr<QuerySolutionNode> makeSkipScan(const IndexEntry& index,
+                                                           const CanonicalQuery& query);
+
     /**
      * Return a plan that scans the provided index from [startKey to endKey).
      */ //scanWholeIndexstartKeyendkey
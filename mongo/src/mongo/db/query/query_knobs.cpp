@@ -39,12 +39,24 @@ MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanEvaluationCollFraction, double, 0
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanEvaluationMaxResults, int, 101);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanEvaluationSuccessiveHalving, bool, true);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanEvaluationHalvingMinCandidates, int, 8);
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheSize, int, 5000);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheNumPartitions, int, 16);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheMaxSizeBytes, long long, 100 * 1024 * 1024);
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheFeedbacksStored, int, 20);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheEvictionRatio, double, 10.0);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheEnableParameterizedPlans, bool, false);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheSelectivityBuckets, int, 4);
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerMaxIndexedSolutions, int, 64);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryEnumerationMaxOrSolutions, int, 10);
@@ -63,10 +75,34 @@ MONGO_EXPORT_SERVER_PARAMETER(internalQueryMaxScansToExplode, int, 200);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecMaxBlockingSortBytes, int, 32 * 1024 * 1024);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecBlockingSortAllowDiskUse, bool, false);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecSortUseNormalizedKeys, bool, true);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecAndHashRecordIdsOnly, bool, true);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecFetchWindowSize, int, 0);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecMultiWriteBatchSize, int, 16);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecTextTopK, bool, true);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecIdHackMaxInValues, int, 10000);
+
 // Yield every 128 cycles or 10ms.
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecYieldIterations, int, 128);
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecYieldPeriodMS, int, 10);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecWorkBatchSize, int, 0);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecCompileConjunctions, bool, true);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecCollScanDefaultParallelism, int, 1);
+
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(internalQueryExecCollScanMaxParallelism, int, 4);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecCollScanPartitionSize, int, 1024);
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryFacetBufferSizeBytes, int, 100 * 1024 * 1024);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalInsertMaxBatchSize,
@@ -77,8 +113,40 @@ MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceCursorBatchSizeBytes, int, 4
 
 MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceLookupCacheSizeBytes, int, 100 * 1024 * 1024);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceLookupHashJoin, bool, true);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceLookupHashJoinMaxBytes,
+                              int,
+                              100 * 1024 * 1024);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceLookupHashJoinMaxIndexedDocs, int, 1000);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceLookupBatchSize, int, 64);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceGraphLookupFrontierBatchSize, int, 10000);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceGroupStreaming, bool, true);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceGroupParallelWorkers, int, 1);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceGroupParallelMinRecordsPerWorker, int, 100000);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceGroupParallelMaxTotalWorkers, int, 16);
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerGenerateCoveredWholeIndexScans, bool, false);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerEnableCostBasedPruning, bool, false);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerCostPruningRatio, double, 10.0);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerEnableSkipScan, bool, false);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerSkipScanMaxDistinctValues, int, 64);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryStatsSampleSize, int, 1000);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryStatsHistogramBuckets, int, 32);
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryIgnoreUnknownJSONSchemaKeywords, bool, false);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryProhibitBlockingMergeOnMongoS, bool, false);
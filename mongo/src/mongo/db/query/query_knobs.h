@@ -49,6 +49,11 @@ extern AtomicDouble internalQueryPlanEvaluationCollFraction;
 //Ĭ101
 extern AtomicInt32 internalQueryPlanEvaluationMaxResults;
 
+// When there are at least internalQueryPlanEvaluationHalvingMinCandidates candidate plans, run
+// the trial period in rounds and drop the lower-scoring half of the candidates after each round.
+extern AtomicBool internalQueryPlanEvaluationSuccessiveHalving;
+extern AtomicInt32 internalQueryPlanEvaluationHalvingMinCandidates;
+
 // Do we give a big ranking bonus to intersection plans?
 extern AtomicBool internalQueryForceIntersectionPlans;
 
@@ -65,6 +70,12 @@ extern AtomicBool internalQueryPlannerEnableHashIntersection;
 // How many entries in the cache?
 extern AtomicInt32 internalQueryCacheSize;
 
+// How many lock-striped partitions is each collection's plan cache split into?
+extern AtomicInt32 internalQueryCacheNumPartitions;
+
+// How many bytes may the plan caches of all collections use in total before entries are evicted?
+extern AtomicInt64 internalQueryCacheMaxSizeBytes;
+
 // How many feedback entries do we collect before possibly evicting from the cache based on bad
 // performance?
 extern AtomicInt32 internalQueryCacheFeedbacksStored;
@@ -73,6 +84,14 @@ extern AtomicInt32 internalQueryCacheFeedbacksStored;
 // and replanning?
 extern AtomicDouble internalQueryCacheEvictionRatio;
 
+// Do we keep a family of cached plans per query shape, selected by the selectivity of the
+// query's literal values as estimated from sampled index statistics, instead of a single plan per
+// shape?
+extern AtomicBool internalQueryCacheEnableParameterizedPlans;
+
+// How many selectivity buckets does a parameterized plan cache family have?
+extern AtomicInt32 internalQueryCacheSelectivityBuckets;
+
 //
 // Planning and enumeration.
 //
@@ -97,6 +116,28 @@ extern AtomicInt32 internalQueryMaxScansToExplode;
 // Allow the planner to generate covered whole index scans, rather than falling back to a COLLSCAN.
 extern AtomicBool internalQueryPlannerGenerateCoveredWholeIndexScans;
 
+// Do we rank indexed solutions by their estimated cost, and drop the expensive ones before the
+// trial period, when every index involved has statistics?
+extern AtomicBool internalQueryPlannerEnableCostBasedPruning;
+
+// Solutions whose estimated cost exceeds the cheapest solution's by more than this factor are
+// pruned.
+extern AtomicDouble internalQueryPlannerCostPruningRatio;
+
+// Do we consider skip scans over compound indexes whose leading field is not constrained by the
+// query?
+extern AtomicBool internalQueryPlannerEnableSkipScan;
+
+// A skip scan is only considered when the sampled leading field of the index has at most this
+// many distinct values.
+extern AtomicInt32 internalQueryPlannerSkipScanMaxDistinctValues;
+
+// How many documents does the index statistics sampler read from each collection?
+extern AtomicInt32 internalQueryStatsSampleSize;
+
+// How many buckets does each index statistics histogram have?
+extern AtomicInt32 internalQueryStatsHistogramBuckets;
+
 // Ignore unknown JSON Schema keywords.
 extern AtomicBool internalQueryIgnoreUnknownJSONSchemaKeywords;
 
@@ -106,6 +147,32 @@ extern AtomicBool internalQueryIgnoreUnknownJSONSchemaKeywords;
 
 extern AtomicInt32 internalQueryExecMaxBlockingSortBytes;
 
+// Whether a blocking sort may spill to disk even when the query did not set allowDiskUse.
+extern AtomicBool internalQueryExecBlockingSortAllowDiskUse;
+
+// Whether blocking sorts compare KeyString-encoded sort keys instead of BSON sort keys.
+extern AtomicBool internalQueryExecSortUseNormalizedKeys;
+
+// Whether a hashed AND whose results are fetched intersects bare RecordIds rather than
+// WorkingSetMembers.
+extern AtomicBool internalQueryExecAndHashRecordIdsOnly;
+
+// How many RecordIds a FETCH reads from its child before fetching them in RecordId order. Zero
+// or less fetches each record as soon as its RecordId is produced.
+extern AtomicInt32 internalQueryExecFetchWindowSize;
+
+// How many matching documents a multi-document update or delete writes in one WriteUnitOfWork.
+// One or less writes each document in its own.
+extern AtomicInt32 internalQueryExecMultiWriteBatchSize;
+
+// Should a $text query sorted by text score with a limit stop reading the text index once its top
+// documents are known?
+extern AtomicBool internalQueryExecTextTopK;
+
+// The longest list of values in {_id: {$in: [...]}} answered by an IDHACK rather than a planned
+// index scan. Zero disables the IDHACK for $in.
+extern AtomicInt32 internalQueryExecIdHackMaxInValues;
+
 // Yield after this many "should yield?" checks.
 //ۻֵ yieldĬΪ 128ϷӳǴ߱ϻȡ
 //˶ݺ yieldyield ֮ۻ㡣
@@ -117,6 +184,26 @@ extern AtomicInt32 internalQueryExecYieldIterations;
 //Ϸӳǵǰ̻߳ȡݵΪ˶Ҫ yield
 extern AtomicInt32 internalQueryExecYieldPeriodMS;
 
+// If greater than one, PlanExecutor asks the root stage for batches of up to this many units of
+// work at a time instead of calling work() once per result.
+extern AtomicInt32 internalQueryExecWorkBatchSize;
+
+// If true, COLLSCAN and $match evaluate conjunctions of comparisons on top-level fields with a
+// CompiledConjunction rather than walking the document once per predicate.
+extern AtomicBool internalQueryExecCompileConjunctions;
+
+// How many partitions of a filtered collection scan may be filtered concurrently, unless the query
+// asks for a different parallelism. 1 disables parallel collection scans by default.
+extern AtomicInt32 internalQueryExecCollScanDefaultParallelism;
+
+// Upper bound on the parallelism of any collection scan, and on the number of threads filtering
+// collection scan partitions across the server. Only settable at startup, since it sizes the
+// worker pool.
+extern int internalQueryExecCollScanMaxParallelism;
+
+// How many records a parallel collection scan reads into each partition.
+extern AtomicInt32 internalQueryExecCollScanPartitionSize;
+
 // Limit the size that we write without yielding to 16MB / 64 (max expected number of indexes)
 const int64_t insertVectorMaxBytes = 256 * 1024;
 
@@ -129,5 +216,39 @@ extern AtomicInt32 internalDocumentSourceCursorBatchSizeBytes;
 
 extern AtomicInt32 internalDocumentSourceLookupCacheSizeBytes;
 
+// Whether a localField/foreignField $lookup may read the foreign collection once into a hash table
+// rather than querying it once per input document.
+extern AtomicBool internalDocumentSourceLookupHashJoin;
+
+// The most memory, in bytes, that a $lookup hash join may hold, counting both the foreign documents
+// and the table indexing them. A foreign collection larger than this is joined by querying it.
+extern AtomicInt32 internalDocumentSourceLookupHashJoinMaxBytes;
+
+// A foreign collection indexed on the join field is hash joined only if it holds at most this many
+// documents; larger ones are cheaper to probe through the index.
+extern AtomicInt32 internalDocumentSourceLookupHashJoinMaxIndexedDocs;
+
+// How many input documents a localField/foreignField $lookup which does not hash join gathers into
+// one $in query on the foreign collection. 1 queries the foreign collection per input document.
+extern AtomicInt32 internalDocumentSourceLookupBatchSize;
+
+// The most frontier values a $graphLookup searches for with one query on the 'from' collection.
+extern AtomicInt32 internalDocumentSourceGraphLookupFrontierBatchSize;
+
+// Whether a $group whose input is already ordered by its _id fields returns each group as soon as
+// the input moves past it, rather than after consuming its entire input.
+extern AtomicBool internalDocumentSourceGroupStreaming;
+
+// The number of threads across which a $group over a collection scan splits its input, computing
+// a partial group per range of RecordIds and merging them. A value of 1 or less disables this.
+extern AtomicInt32 internalDocumentSourceGroupParallelWorkers;
+
+// The fewest records each of those threads must have to scan for the $group to be split at all.
+extern AtomicInt32 internalDocumentSourceGroupParallelMinRecordsPerWorker;
+
+// The most threads that all the parallel $groups running on the server may use between them. A
+// $group which cannot reserve at least two of them runs on the query thread.
+extern AtomicInt32 internalDocumentSourceGroupParallelMaxTotalWorkers;
+
 extern AtomicBool internalQueryProhibitBlockingMergeOnMongoS;
 }  // namespace mongo
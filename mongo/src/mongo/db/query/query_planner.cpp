@@ -45,11 +45,14 @@
 #include "mongo/db/query/canonical_query.h"
 #include "mongo/db/query/collation/collation_index_key.h"
 #include "mongo/db/query/collation/collator_interface.h"
+#include "mongo/db/query/index_statistics.h"
 #include "mongo/db/query/plan_cache.h"
+#include "mongo/db/query/plan_cost_model.h"
 #include "mongo/db/query/plan_enumerator.h"
 #include "mongo/db/query/planner_access.h"
 #include "mongo/db/query/planner_analysis.h"
 #include "mongo/db/query/planner_ixselect.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner_common.h"
 #include "mongo/db/query/query_solution.h"
 #include "mongo/util/log.h"
@@ -519,6 +522,19 @@ Status QueryPlanner::planFromCache(const CanonicalQuery& query,
             *out = soln;
             return Status::OK();
         }
+    } else if (SolutionCacheData::SKIP_SCAN_SOLN == winnerCacheData.solnType) {
+        // The bounds on the later index fields come from the literals of this query.
+        std::unique_ptr<QuerySolutionNode> root =
+            QueryPlannerAccess::makeSkipScan(*winnerCacheData.tree->entry, query);
+        QuerySolution* soln = root
+            ? QueryPlannerAnalysis::analyzeDataAccess(query, params, std::move(root))
+            : nullptr;
+        if (soln == NULL) {
+            return Status(ErrorCodes::BadValue, "plan cache error: skip scan soln");
+        } else {
+            *out = soln;
+            return Status::OK();
+        }
     }
 
     // SolutionCacheData::USE_TAGS_SOLN == cacheData->solnType
@@ -1325,6 +1341,50 @@ Status QueryPlanner::plan(const CanonicalQuery& query,
         }
     }
 
+    // A compound index whose leading field the query leaves unconstrained can still be useful
+    // if that field has few distinct values: an index scan over all of them, bounded on the later
+    // fields, visits each of them once and seeks straight to the bounds on the later fields. We
+    // only know the number of distinct values once the index has been sampled.
+    if (internalQueryPlannerEnableSkipScan.load() && possibleToCollscan && !isTailable) {
+        for (auto&& index : params.indices) {
+            if (INDEX_BTREE != index.type || index.keyPattern.nFields() < 2 || index.multikey ||
+                index.sparse || index.filterExpr || !index.statistics ||
+                !CollatorInterface::collatorsMatch(query.getCollator(), index.collator)) {
+                continue;
+            }
+            if (index.statistics->getNumDistinctValues() >
+                internalQueryPlannerSkipScanMaxDistinctValues.load()) {
+                continue;
+            }
+
+            std::unique_ptr<QuerySolutionNode> root =
+                QueryPlannerAccess::makeSkipScan(index, query);
+            if (!root) {
+                continue;
+            }
+
+            QuerySolution* soln =
+                QueryPlannerAnalysis::analyzeDataAccess(query, params, std::move(root));
+            if (soln) {
+                // A cached skip scan is rebuilt over the same index. If the statistics which
+                // made it look cheap go stale, the cached plan's replanning catches it.
+                PlanCacheIndexTree* indexTree = new PlanCacheIndexTree();
+                indexTree->setIndexEntry(index);
+                SolutionCacheData* scd = new SolutionCacheData();
+                scd->tree.reset(indexTree);
+                scd->solnType = SolutionCacheData::SKIP_SCAN_SOLN;
+                soln->cacheData.reset(scd);
+
+                LOG(2) << "Planner: outputting a skip scan:" << endl << redact(soln->toString());
+                out->push_back(soln);
+            }
+        }
+    }
+
+    if (internalQueryPlannerEnableCostBasedPruning.load()) {
+        PlanCostModel::rankAndPrune(params, out);
+    }
+
     return Status::OK();
 }
 
@@ -111,6 +111,11 @@ struct QueryPlannerParams {
 
         // Set this to track the most recent timestamp seen by this cursor while scanning the oplog.
         TRACK_LATEST_OPLOG_TS = 1 << 12,
+
+        // Set this to let a filtered collection scan evaluate its filter on several threads. Only
+        // read-only callers set it: update and delete stages need each document's RecordId to be
+        // reported in the order they read it, and must not race their own writes.
+        ALLOW_PARALLEL_COLLSCAN = 1 << 13,
     };
 
     // See Options enum above.
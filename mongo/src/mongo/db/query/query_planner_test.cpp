@@ -32,12 +32,16 @@
 #include <string>
 #include <vector>
 
+#include "mongo/bson/simple_bsonobj_comparator.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/json.h"
 #include "mongo/db/matcher/expression_always_boolean.h"
 #include "mongo/db/query/collation/collator_interface_mock.h"
+#include "mongo/db/query/index_statistics.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/query/query_planner_test_fixture.h"
+#include "mongo/util/scopeguard.h"
 
 namespace {
 
@@ -3437,6 +3441,189 @@ TEST_F(QueryPlannerTest, IntersectDisableAndHash) {
     internalQueryPlannerEnableHashIntersection.store(oldEnableHashIntersection);
 }
 
+std::shared_ptr<const IndexStatistics> buildIndexStatistics(const std::vector<int>& values,
+                                                            long long numRecords) {
+    IndexStatistics::Builder builder(32U);
+    for (int value : values) {
+        BSONObjSet keys = SimpleBSONObjComparator::kInstance.makeBSONObjSet();
+        keys.insert(BSON("" << value));
+        builder.addSampledDocument(keys);
+    }
+    return builder.build(numRecords);
+}
+
+// Ensure that solutions estimated to be far more expensive than the cheapest are pruned.
+TEST_F(QueryPlannerTest, CostBasedPruningDropsExpensiveSolutions) {
+    bool oldEnableCostBasedPruning = internalQueryPlannerEnableCostBasedPruning.load();
+    internalQueryPlannerEnableCostBasedPruning.store(true);
+    ON_BLOCK_EXIT([oldEnableCostBasedPruning] {
+        internalQueryPlannerEnableCostBasedPruning.store(oldEnableCostBasedPruning);
+    });
+
+    // Every document has a distinct value of 'a', but the same value of 'b'.
+    std::vector<int> distinctValues;
+    for (int i = 0; i < 100; ++i) {
+        distinctValues.push_back(i);
+    }
+    addIndex(BSON("a" << 1));
+    params.indices.back().statistics = buildIndexStatistics(distinctValues, 1000);
+    addIndex(BSON("b" << 1));
+    params.indices.back().statistics =
+        buildIndexStatistics(std::vector<int>(distinctValues.size(), 1), 1000);
+
+    runQuery(fromjson("{a: 1, b: 1}"));
+
+    // Both the scan of {b: 1} and the collection scan are pruned.
+    assertNumSolutions(1U);
+    assertSolutionExists("{fetch: {filter: {b: 1}, node: {ixscan: {pattern: {a: 1}}}}}");
+}
+
+// Ensure that nothing is pruned unless every solution can be costed.
+TEST_F(QueryPlannerTest, CostBasedPruningRequiresStatisticsForEveryIndex) {
+    bool oldEnableCostBasedPruning = internalQueryPlannerEnableCostBasedPruning.load();
+    internalQueryPlannerEnableCostBasedPruning.store(true);
+    ON_BLOCK_EXIT([oldEnableCostBasedPruning] {
+        internalQueryPlannerEnableCostBasedPruning.store(oldEnableCostBasedPruning);
+    });
+
+    std::vector<int> distinctValues;
+    for (int i = 0; i < 100; ++i) {
+        distinctValues.push_back(i);
+    }
+    addIndex(BSON("a" << 1));
+    params.indices.back().statistics = buildIndexStatistics(distinctValues, 1000);
+    addIndex(BSON("b" << 1));
+
+    runQuery(fromjson("{a: 1, b: 1}"));
+
+    assertNumSolutions(3U);
+}
+
+// Ensure that a plan which provides the requested sort order is not pruned in favour of a plan
+// which examines far fewer keys but has to sort, since it may stop as soon as the limit is met.
+TEST_F(QueryPlannerTest, CostBasedPruningKeepsSolutionsProvidingSortForLimit) {
+    bool oldEnableCostBasedPruning = internalQueryPlannerEnableCostBasedPruning.load();
+    internalQueryPlannerEnableCostBasedPruning.store(true);
+    ON_BLOCK_EXIT([oldEnableCostBasedPruning] {
+        internalQueryPlannerEnableCostBasedPruning.store(oldEnableCostBasedPruning);
+    });
+
+    // No sampled document has a positive value of 'a', while every value of 'b' is distinct.
+    std::vector<int> distinctValues;
+    for (int i = 0; i < 100; ++i) {
+        distinctValues.push_back(i);
+    }
+    addIndex(BSON("a" << 1));
+    params.indices.back().statistics =
+        buildIndexStatistics(std::vector<int>(distinctValues.size(), -1), 1000);
+    addIndex(BSON("b" << 1));
+    params.indices.back().statistics = buildIndexStatistics(distinctValues, 1000);
+
+    runQueryAsCommand(
+        fromjson("{find: 'testns', filter: {a: {$gt: 0}}, sort: {b: 1}, limit: 1}"));
+
+    assertNumSolutions(2U);
+    assertSolutionExists(
+        "{limit: {n: 1, node: {fetch: {filter: {a: {$gt: 0}}, node: "
+        "{ixscan: {filter: null, pattern: {b: 1}}}}}}}");
+    assertSolutionExists(
+        "{sort: {pattern: {b: 1}, limit: 1, node: {sortKeyGen: {node: {fetch: {filter: null,"
+        "node: {ixscan: {pattern: {a: 1}}}}}}}}}");
+}
+
+// Ensure that a compound index whose leading field has few distinct values is skip-scanned when
+// the query constrains only a later field.
+TEST_F(QueryPlannerTest, SkipScanOverLowCardinalityLeadingField) {
+    bool oldEnableSkipScan = internalQueryPlannerEnableSkipScan.load();
+    internalQueryPlannerEnableSkipScan.store(true);
+    ON_BLOCK_EXIT(
+        [oldEnableSkipScan] { internalQueryPlannerEnableSkipScan.store(oldEnableSkipScan); });
+
+    addIndex(BSON("a" << 1 << "b" << 1));
+    params.indices.back().statistics = buildIndexStatistics({1, 2, 3, 1, 2, 3}, 1000);
+
+    runQuery(fromjson("{b: {$gte: 5, $lt: 10}}"));
+
+    assertNumSolutions(2U);
+    assertSolutionExists("{cscan: {dir: 1}}");
+    assertSolutionExists(
+        "{fetch: {filter: {b: {$gte: 5, $lt: 10}}, node: {ixscan: {pattern: {a: 1, b: 1}, "
+        "bounds: {a: [['MinKey','MaxKey',true,true]], b: [[5,10,true,false]]}}}}}");
+}
+
+// Ensure that a skip scan is only generated when it is enabled.
+TEST_F(QueryPlannerTest, SkipScanIsDisabledByDefault) {
+    addIndex(BSON("a" << 1 << "b" << 1));
+    params.indices.back().statistics = buildIndexStatistics({1, 2, 3, 1, 2, 3}, 1000);
+
+    runQuery(fromjson("{b: {$gte: 5, $lt: 10}}"));
+
+    assertNumSolutions(1U);
+    assertSolutionExists("{cscan: {dir: 1}}");
+}
+
+// Ensure that the cost model prefers a skip scan to a scan of the whole index which provides the
+// same sort, as the skip scan only examines the keys within the bounds on the later field.
+TEST_F(QueryPlannerTest, CostBasedPruningPrefersSkipScanToWholeIndexScan) {
+    bool oldEnableSkipScan = internalQueryPlannerEnableSkipScan.load();
+    internalQueryPlannerEnableSkipScan.store(true);
+    ON_BLOCK_EXIT(
+        [oldEnableSkipScan] { internalQueryPlannerEnableSkipScan.store(oldEnableSkipScan); });
+
+    addIndex(BSON("a" << 1 << "b" << 1));
+    params.indices.back().statistics = buildIndexStatistics({1, 2, 3, 1, 2, 3}, 1000);
+
+    const std::string wholeIndexScan =
+        "{fetch: {filter: {b: 5}, node: {ixscan: {pattern: {a: 1, b: 1}, "
+        "bounds: {a: [['MinKey','MaxKey',true,true]], b: [['MinKey','MaxKey',true,true]]}}}}}";
+    const std::string skipScan =
+        "{fetch: {filter: {b: 5}, node: {ixscan: {pattern: {a: 1, b: 1}, "
+        "bounds: {a: [['MinKey','MaxKey',true,true]], b: [[5,5,true,true]]}}}}}";
+
+    runQueryAsCommand(fromjson("{find: 'testns', filter: {b: 5}, sort: {a: 1}}"));
+    assertNumSolutions(2U);
+    assertSolutionExists(wholeIndexScan);
+    assertSolutionExists(skipScan);
+
+    bool oldEnableCostBasedPruning = internalQueryPlannerEnableCostBasedPruning.load();
+    internalQueryPlannerEnableCostBasedPruning.store(true);
+    ON_BLOCK_EXIT([oldEnableCostBasedPruning] {
+        internalQueryPlannerEnableCostBasedPruning.store(oldEnableCostBasedPruning);
+    });
+
+    runQueryAsCommand(fromjson("{find: 'testns', filter: {b: 5}, sort: {a: 1}}"));
+    assertNumSolutions(1U);
+    assertSolutionExists(skipScan);
+}
+
+// Ensure that no skip scan is generated without statistics, for a high-cardinality leading field,
+// or when the query constrains the leading field.
+TEST_F(QueryPlannerTest, SkipScanRequiresUnconstrainedLowCardinalityLeadingField) {
+    bool oldEnableSkipScan = internalQueryPlannerEnableSkipScan.load();
+    internalQueryPlannerEnableSkipScan.store(true);
+    ON_BLOCK_EXIT(
+        [oldEnableSkipScan] { internalQueryPlannerEnableSkipScan.store(oldEnableSkipScan); });
+
+    addIndex(BSON("a" << 1 << "b" << 1));
+    runQuery(fromjson("{b: 5}"));
+    assertNumSolutions(1U);
+    assertSolutionExists("{cscan: {dir: 1}}");
+
+    std::vector<int> distinctValues;
+    for (int i = 0; i < 1000; ++i) {
+        distinctValues.push_back(i);
+    }
+    params.indices.back().statistics = buildIndexStatistics(distinctValues, 1000);
+    runQuery(fromjson("{b: 5}"));
+    assertNumSolutions(1U);
+    assertSolutionExists("{cscan: {dir: 1}}");
+
+    params.indices.back().statistics = buildIndexStatistics({1, 2, 3}, 1000);
+    runQuery(fromjson("{a: 1, b: 5}"));
+    assertNumSolutions(1U);
+    assertSolutionExists("{fetch: {filter: null, node: {ixscan: {pattern: {a: 1, b: 1}}}}}");
+}
+
 //
 // Index intersection cases for SERVER-12825: make sure that
 // we don't generate an ixisect plan if a compound index is
@@ -4092,6 +4279,7 @@ TEST_F(QueryPlannerTest, UniqueIndexLookup) {
 
     runQuery(fromjson("{a: 1, b: 1}"));
 
+    // Both the scan of {b: 1} and the collection scan are pruned.
     assertNumSolutions(1U);
     assertSolutionExists(
         "{fetch: {filter: {a: 1}, node: "
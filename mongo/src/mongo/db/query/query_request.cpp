@@ -90,6 +90,8 @@ const char kNToReturnField[] = "ntoreturn";
 const char kSingleBatchField[] = "singleBatch";
 const char kCommentField[] = "comment";
 const char kMaxScanField[] = "maxScan";
+const char kParallelismField[] = "parallelism";
+const char kAllowDiskUseField[] = "allowDiskUse";
 const char kMaxField[] = "max";
 const char kMinField[] = "min";
 const char kReturnKeyField[] = "returnKey";
@@ -277,6 +279,22 @@ StatusWith<unique_ptr<QueryRequest>> QueryRequest::parseFromFindCommand(unique_p
             }
 
             qr->_maxScan = el.numberInt();
+        } else if (fieldName == kParallelismField) {
+            if (!el.isNumber()) {
+                str::stream ss;
+                ss << "Failed to parse: " << cmdObj.toString() << ". "
+                   << "'parallelism' field must be numeric.";
+                return Status(ErrorCodes::FailedToParse, ss);
+            }
+
+            qr->_parallelism = el.numberInt();
+        } else if (fieldName == kAllowDiskUseField) {
+            Status status = checkFieldType(el, Bool);
+            if (!status.isOK()) {
+                return status;
+            }
+
+            qr->_allowDiskUse = el.boolean();
         } else if (fieldName == cmdOptionMaxTimeMS) {
             StatusWith<int> maxTimeMS = parseMaxTimeMS(el);
             if (!maxTimeMS.isOK()) {
@@ -490,6 +508,14 @@ void QueryRequest::asFindCommand(BSONObjBuilder* cmdBuilder) const {
         cmdBuilder->append(kMaxScanField, _maxScan);
     }
 
+    if (_parallelism > 0) {
+        cmdBuilder->append(kParallelismField, _parallelism);
+    }
+
+    if (_allowDiskUse) {
+        cmdBuilder->append(kAllowDiskUseField, true);
+    }
+
     if (_maxTimeMS > 0) {
         cmdBuilder->append(cmdOptionMaxTimeMS, _maxTimeMS);
     }
@@ -647,6 +673,12 @@ Status QueryRequest::validate() const {
                                     << _maxScan);
     }
 
+    if (_parallelism < 0) {
+        return Status(ErrorCodes::BadValue,
+                      str::stream() << "Parallelism value must be non-negative, but received: "
+                                    << _parallelism);
+    }
+
     if (_maxTimeMS < 0) {
         return Status(ErrorCodes::BadValue,
                       str::stream() << "MaxTimeMS value must be non-negative, but received: "
@@ -1029,6 +1061,11 @@ StatusWith<BSONObj> QueryRequest::asAggregationCommand() const {
         return {ErrorCodes::InvalidPipelineOperator,
                 str::stream() << "Option " << kMaxScanField << " not supported in aggregation."};
     }
+    if (_parallelism != 0) {
+        return {ErrorCodes::InvalidPipelineOperator,
+                str::stream() << "Option " << kParallelismField
+                              << " not supported in aggregation."};
+    }
     if (_returnKey) {
         return {ErrorCodes::InvalidPipelineOperator,
                 str::stream() << "Option " << kReturnKeyField << " not supported in aggregation."};
@@ -1125,6 +1162,9 @@ StatusWith<BSONObj> QueryRequest::asAggregationCommand() const {
     if (!_hint.isEmpty()) {
         aggregationBuilder.append("hint", _hint);
     }
+    if (_allowDiskUse) {
+        aggregationBuilder.append(kAllowDiskUseField, true);
+    }
     if (!_comment.empty()) {
         aggregationBuilder.append("comment", _comment);
     }
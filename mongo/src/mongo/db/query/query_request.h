@@ -223,6 +223,8 @@ db.runCommand(
       "singleBatch": <bool>,
       "comment": <string>,
       "maxScan": <int>,
+      "parallelism": <int>,
+      "allowDiskUse": <bool>,
       "maxTimeMS": <int>,
       "readConcern": <document>,
       "max": <document>,
@@ -476,6 +478,22 @@ public:
         _maxScan = maxScan;
     }
 
+    int getParallelism() const {
+        return _parallelism;
+    }
+
+    void setParallelism(int parallelism) {
+        _parallelism = parallelism;
+    }
+
+    bool allowDiskUse() const {
+        return _allowDiskUse;
+    }
+
+    void setAllowDiskUse(bool allowDiskUse) {
+        _allowDiskUse = allowDiskUse;
+    }
+
     int getMaxTimeMS() const {
         return _maxTimeMS;
     }
@@ -707,6 +725,14 @@ private:
 
     int _maxScan = 0;
 
+    // How many partitions of a collection scan may be filtered concurrently, or '0' to use the
+    // server default. Capped by internalQueryExecCollScanMaxParallelism.
+    int _parallelism = 0;
+
+    // Whether a blocking sort which exceeds internalQueryExecMaxBlockingSortBytes may spill to
+    // temporary files rather than fail.
+    bool _allowDiskUse = false;
+
     // A user-specified maxTimeMS limit, or a value of '0' if not specified.
     int _maxTimeMS = 0;
 
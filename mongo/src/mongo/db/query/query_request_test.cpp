@@ -154,6 +154,12 @@ TEST(QueryRequestTest, PositiveMaxScan) {
     ASSERT_OK(qr.validate());
 }
 
+TEST(QueryRequestTest, NegativeParallelism) {
+    QueryRequest qr(testns);
+    qr.setParallelism(-1);
+    ASSERT_NOT_OK(qr.validate());
+}
+
 TEST(QueryRequestTest, NegativeMaxTimeMS) {
     QueryRequest qr(testns);
     qr.setMaxTimeMS(-1);
@@ -656,6 +662,60 @@ TEST(QueryRequestTest, ParseFromCommandMaxScanWrongType) {
     ASSERT_NOT_OK(result.getStatus());
 }
 
+TEST(QueryRequestTest, ParseFromCommandParallelism) {
+    BSONObj cmdObj = fromjson(
+        "{find: 'testns',"
+        "filter:  {a: 1},"
+        "parallelism: 4}");
+    const NamespaceString nss("test.testns");
+    bool isExplain = false;
+    unique_ptr<QueryRequest> qr(
+        assertGet(QueryRequest::makeFromFindCommand(nss, cmdObj, isExplain)));
+    ASSERT_EQUALS(4, qr->getParallelism());
+
+    BSONObjBuilder bob;
+    qr->asFindCommand(&bob);
+    ASSERT_EQUALS(4, bob.obj()["parallelism"].numberInt());
+}
+
+TEST(QueryRequestTest, ParseFromCommandParallelismWrongType) {
+    BSONObj cmdObj = fromjson(
+        "{find: 'testns',"
+        "filter:  {a: 1},"
+        "parallelism: true}");
+    const NamespaceString nss("test.testns");
+    bool isExplain = false;
+    auto result = QueryRequest::makeFromFindCommand(nss, cmdObj, isExplain);
+    ASSERT_NOT_OK(result.getStatus());
+}
+
+TEST(QueryRequestTest, ParseFromCommandAllowDiskUse) {
+    BSONObj cmdObj = fromjson(
+        "{find: 'testns',"
+        "sort: {a: 1},"
+        "allowDiskUse: true}");
+    const NamespaceString nss("test.testns");
+    bool isExplain = false;
+    unique_ptr<QueryRequest> qr(
+        assertGet(QueryRequest::makeFromFindCommand(nss, cmdObj, isExplain)));
+    ASSERT_TRUE(qr->allowDiskUse());
+
+    BSONObjBuilder bob;
+    qr->asFindCommand(&bob);
+    ASSERT_TRUE(bob.obj()["allowDiskUse"].trueValue());
+}
+
+TEST(QueryRequestTest, ParseFromCommandAllowDiskUseWrongType) {
+    BSONObj cmdObj = fromjson(
+        "{find: 'testns',"
+        "sort: {a: 1},"
+        "allowDiskUse: 1}");
+    const NamespaceString nss("test.testns");
+    bool isExplain = false;
+    auto result = QueryRequest::makeFromFindCommand(nss, cmdObj, isExplain);
+    ASSERT_NOT_OK(result.getStatus());
+}
+
 TEST(QueryRequestTest, ParseFromCommandMaxTimeMSWrongType) {
     BSONObj cmdObj = fromjson(
         "{find: 'testns',"
@@ -1154,12 +1214,30 @@ TEST(QueryRequestTest, ConvertToAggregationWithHintSucceeds) {
     ASSERT_BSONOBJ_EQ(qr.getHint(), ar.getValue().getHint());
 }
 
+TEST(QueryRequestTest, ConvertToAggregationWithAllowDiskUseSucceeds) {
+    QueryRequest qr(testns);
+    qr.setSort(fromjson("{a: 1}"));
+    qr.setAllowDiskUse(true);
+    const auto aggCmd = qr.asAggregationCommand();
+    ASSERT_OK(aggCmd);
+
+    auto ar = AggregationRequest::parseFromBSON(testns, aggCmd.getValue());
+    ASSERT_OK(ar.getStatus());
+    ASSERT_TRUE(ar.getValue().shouldAllowDiskUse());
+}
+
 TEST(QueryRequestTest, ConvertToAggregationWithMinFails) {
     QueryRequest qr(testns);
     qr.setMin(fromjson("{a: 1}"));
     ASSERT_NOT_OK(qr.asAggregationCommand());
 }
 
+TEST(QueryRequestTest, ConvertToAggregationWithParallelismFails) {
+    QueryRequest qr(testns);
+    qr.setParallelism(2);
+    ASSERT_NOT_OK(qr.asAggregationCommand());
+}
+
 TEST(QueryRequestTest, ConvertToAggregationWithMaxFails) {
     QueryRequest qr(testns);
     qr.setMax(fromjson("{a: 1}"));
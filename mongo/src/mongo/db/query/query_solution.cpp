@@ -256,6 +256,7 @@ QuerySolutionNode* CollectionScanNode::clone() const {
     copy->direction = this->direction;
     copy->maxScan = this->maxScan;
     copy->shouldTrackLatestOplogTimestamp = this->shouldTrackLatestOplogTimestamp;
+    copy->allowParallel = this->allowParallel;
 
     return copy;
 }
@@ -1169,7 +1170,15 @@ void CountScanNode::appendToString(mongoutils::str::stream* ss, int indent) cons
     *ss << "name = " << index.name << '\n';
     addIndent(ss, indent + 1);
     *ss << "keyPattern = " << index.keyPattern << '\n';
+    if (NULL != filter) {
+        addIndent(ss, indent + 1);
+        *ss << " filter = " << filter->toString() << '\n';
+    }
     addIndent(ss, indent + 1);
+    if (bounds) {
+        *ss << "bounds = " << bounds->toString() << '\n';
+        return;
+    }
     *ss << "startKey = " << startKey << '\n';
     addIndent(ss, indent + 1);
     *ss << "endKey = " << endKey << '\n';
@@ -1184,6 +1193,7 @@ QuerySolutionNode* CountScanNode::clone() const {
     copy->startKeyInclusive = this->startKeyInclusive;
     copy->endKey = this->endKey;
     copy->endKeyInclusive = this->endKeyInclusive;
+    copy->bounds = this->bounds;
 
     return copy;
 }
@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <boost/optional.hpp>
 #include <memory>
 
 #include "mongo/bson/bsonobj_comparator_interface.h"
@@ -329,6 +330,9 @@ struct CollectionScanNode : public QuerySolutionNode {
     // across a sharded cluster.
     bool shouldTrackLatestOplogTimestamp = false;
 
+    // May this scan be replaced by a ParallelCollectionScan? Only set for read-only plans.
+    bool allowParallel = false;
+
     // Ǽ
     int direction;
 
@@ -1049,6 +1053,10 @@ struct CountScanNode : public QuerySolutionNode {
 
     BSONObj endKey;
     bool endKeyInclusive;
+
+    // If set, the keys within these bounds are counted instead of those between 'startKey' and
+    // 'endKey'. Any filter on this node is then evaluated against the index keys.
+    boost::optional<IndexBounds> bounds;
 };
 
 /**
@@ -49,6 +49,7 @@
 #include "mongo/db/exec/limit.h"
 #include "mongo/db/exec/merge_sort.h"
 #include "mongo/db/exec/or.h"
+#include "mongo/db/exec/parallel_collection_scan.h"
 #include "mongo/db/exec/projection.h"
 #include "mongo/db/exec/shard_filter.h"
 #include "mongo/db/exec/skip.h"
@@ -57,7 +58,10 @@
 #include "mongo/db/exec/text.h"
 #include "mongo/db/index/fts_access_method.h"
 #include "mongo/db/matcher/extensions_callback_real.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/s/collection_sharding_state.h"
+#include "mongo/db/service_context.h"
+#include "mongo/db/storage/storage_options.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/log.h"
 
@@ -65,6 +69,60 @@ namespace mongo {
 
 using std::unique_ptr;
 using stdx::make_unique;
+
+namespace {
+
+/**
+ * Returns how many of the highest scoring documents the text stage for 'textNode' has to produce,
+ * or zero if it has to produce all of them. Only a query that is nothing but a $text search, sorted
+ * on the text score with a limit, can stop early, and only if no stage between the text stage and
+ * the root of 'qsol' can drop a document.
+ */
+size_t getTextTopK(const CanonicalQuery& cq,
+                   const QuerySolution& qsol,
+                   const TextNode* textNode,
+                   const FTSQueryImpl& ftsQuery) {
+    const QueryRequest& qr = cq.getQueryRequest();
+    if (!internalQueryExecTextTopK.load() || !qr.getLimit() || !supportsDocLocking() ||
+        MatchExpression::TEXT != cq.root()->matchType()) {
+        return 0;
+    }
+
+    // TEXT_MATCH has to drop documents if the query has phrases, negations, or is case or
+    // diacritic sensitive.
+    if (!ftsQuery.getPositivePhr().empty() || !ftsQuery.getNegatedTerms().empty() ||
+        !ftsQuery.getNegatedPhr().empty() || ftsQuery.getCaseSensitive() ||
+        ftsQuery.getDiacriticSensitive()) {
+        return 0;
+    }
+
+    const BSONObj& sort = qr.getSort();
+    if (sort.nFields() != 1 || !QueryRequest::isTextScoreMeta(sort.firstElement())) {
+        return 0;
+    }
+
+    for (const QuerySolutionNode* node = qsol.root.get(); node != textNode;
+         node = node->children[0]) {
+        switch (node->getType()) {
+            case STAGE_LIMIT:
+            case STAGE_PROJECTION:
+            case STAGE_SKIP:
+            case STAGE_SORT:
+            case STAGE_SORT_KEY_GENERATOR:
+                break;
+            default:
+                return 0;
+        }
+        if (node->filter || node->children.size() != 1) {
+            return 0;
+        }
+    }
+
+    return static_cast<size_t>(qr.getSkip().value_or(0) + *qr.getLimit());
+}
+
+}  // namespace
+
 //prepareExecution->StageBuilder::build  prepareExecutionĶ
 //עbuildStagesеݹãͿ԰QuerySolutionchild QuerySolutionһ
 PlanStage* buildStages(OperationContext* opCtx,     //úڵݹ
@@ -83,6 +141,20 @@ PlanStage* buildStages(OperationContext* opCtx,     //
             params.direction = (csn->direction == 1) ? CollectionScanParams::FORWARD
                                                      : CollectionScanParams::BACKWARD;
             params.maxScan = csn->maxScan;
+
+            // A query may ask for more or less parallelism than the server default, but never
+            // for more than the server-wide cap.
+            int parallelism = cq.getQueryRequest().getParallelism();
+            if (0 == parallelism) {
+                parallelism = internalQueryExecCollScanDefaultParallelism.load();
+            }
+            parallelism = std::min(parallelism, internalQueryExecCollScanMaxParallelism);
+            if (csn->allowParallel && parallelism > 1 &&
+                ParallelCollectionScan::canRunInParallel(
+                    params, csn->filter.get(), cq.getCollator())) {
+                return new ParallelCollectionScan(
+                    opCtx, params, static_cast<size_t>(parallelism), ws, csn->filter.get());
+            }
             return new CollectionScan(opCtx, params, ws, csn->filter.get());
         }
         case STAGE_IXSCAN: {
@@ -112,7 +184,24 @@ PlanStage* buildStages(OperationContext* opCtx,     //
             if (nullptr == childStage) {
                 return nullptr;
             }
-            return new FetchStage(opCtx, ws, childStage, fn->filter.get(), collection);
+            // The fetch only needs the RecordIds of a hashed AND, not the index keys it merges.
+            if (STAGE_AND_HASH == childStage->stageType() &&
+                internalQueryExecAndHashRecordIdsOnly.load() && supportsDocLocking() &&
+                !cq.getQueryRequest().returnKey()) {
+                static_cast<AndHashStage*>(childStage)->setRecordIdsOnly();
+            }
+            auto fetch = new FetchStage(opCtx, ws, childStage, fn->filter.get(), collection);
+            // Storage engines that page in records through fetchers get them one at a time.
+            long long windowSize = internalQueryExecFetchWindowSize.load();
+            if (windowSize > 1 && supportsDocLocking()) {
+                // Don't read ahead past what a limited query can return.
+                const QueryRequest& qr = cq.getQueryRequest();
+                if (qr.getLimit()) {
+                    windowSize = std::min(windowSize, qr.getSkip().value_or(0) + *qr.getLimit());
+                }
+                fetch->setWindowSize(windowSize);
+            }
+            return fetch;
         }
         case STAGE_SORT: {
             const SortNode* sn = static_cast<const SortNode*>(root);
@@ -125,6 +214,12 @@ PlanStage* buildStages(OperationContext* opCtx,     //
             params.collection = collection;
             params.pattern = sn->pattern;
             params.limit = sn->limit;
+            // Spilled results are no longer invalidated, so their RecordIds are only safe to
+            // return where a deleted record's RecordId is never reused.
+            params.allowDiskUse = (cq.getQueryRequest().allowDiskUse() ||
+                                   internalQueryExecBlockingSortAllowDiskUse.load()) &&
+                supportsDocLocking();
+            params.tempDir = storageGlobalParams.dbpath + "/_tmp";
             return new SortStage(opCtx, params, ws, childStage);
         }
         case STAGE_SORT_KEY_GENERATOR: {
@@ -293,6 +388,9 @@ PlanStage* buildStages(OperationContext* opCtx,     //
             // fail in this case (this improvement is being tracked by SERVER-21510).
             params.query = static_cast<FTSQueryImpl&>(*node->ftsQuery);
             params.wantTextScore = (cq.getProj() && cq.getProj()->wantTextScore());
+            if (params.wantTextScore) {
+                params.topK = getTextTopK(cq, qsol, node, params.query);
+            }
             return new TextStage(opCtx, params, ws, node->filter.get());
         }
         case STAGE_SHARDING_FILTER: {
@@ -352,8 +450,9 @@ PlanStage* buildStages(OperationContext* opCtx,     //
             params.startKeyInclusive = csn->startKeyInclusive;
             params.endKey = csn->endKey;
             params.endKeyInclusive = csn->endKeyInclusive;
+            params.bounds = csn->bounds;
 
-            return new CountScan(opCtx, params, ws);
+            return new CountScan(opCtx, params, ws, csn->filter.get());
         }
         case STAGE_ENSURE_SORTED: {
             const EnsureSortedNode* esn = static_cast<const EnsureSortedNode*>(root);
@@ -102,6 +102,9 @@ enum StageType { //
     STAGE_OPLOG_START,
     //ӦQuerySolutionNodeΪOrNodeӦstageΪOrStage
     STAGE_OR,
+
+    // A COLLSCAN whose filter is evaluated on a pool of worker threads.
+    STAGE_PARALLEL_COLLSCAN,
     //ӦQuerySolutionNodeΪProjectionNode,ӦstageΪProjectionStage
     STAGE_PROJECTION,
 
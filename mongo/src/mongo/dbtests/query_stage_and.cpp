@@ -461,6 +461,90 @@ public:
     }
 };
 
+// An AND with three children intersecting bare RecordIds.
+// With the same large keys and buffer limit which make QueryStageAndHashTwoLeafFirstChildLargeKeys
+// fail, only the RecordIds are buffered, so the stage stays well within its limit. A RecordId
+// invalidated by a deletion while the first child is read is not returned.
+class QueryStageAndHashRecordIdsOnly : public QueryStageAndBase {
+public:
+    void run() {
+        OldClientWriteContext ctx(&_opCtx, ns());
+        Database* db = ctx.db();
+        Collection* coll = ctx.getCollection();
+        if (!coll) {
+            WriteUnitOfWork wuow(&_opCtx);
+            coll = db->createCollection(&_opCtx, ns());
+            wuow.commit();
+        }
+
+        std::string big(512, 'a');
+        for (int i = 0; i < 50; ++i) {
+            insert(BSON("foo" << i << "bar" << i << "baz" << i << "big" << big));
+        }
+
+        addIndex(BSON("foo" << 1 << "big" << 1));
+        addIndex(BSON("bar" << 1));
+        addIndex(BSON("baz" << 1));
+
+        WorkingSet ws;
+        auto ah = make_unique<AndHashStage>(&_opCtx, &ws, coll, 20 * big.size());
+        ah->setRecordIdsOnly();
+
+        // Foo <= 20
+        IndexScanParams params;
+        params.descriptor = getIndex(BSON("foo" << 1 << "big" << 1), coll);
+        params.bounds.isSimpleRange = true;
+        params.bounds.startKey = BSON("" << 20 << "" << big);
+        params.bounds.endKey = BSONObj();
+        params.bounds.boundInclusion = BoundInclusion::kIncludeBothStartAndEndKeys;
+        params.direction = -1;
+        ah->addChild(new IndexScan(&_opCtx, params, &ws, NULL));
+
+        // Bar >= 10
+        params.descriptor = getIndex(BSON("bar" << 1), coll);
+        params.bounds.startKey = BSON("" << 10);
+        params.bounds.endKey = BSONObj();
+        params.bounds.boundInclusion = BoundInclusion::kIncludeBothStartAndEndKeys;
+        params.direction = 1;
+        ah->addChild(new IndexScan(&_opCtx, params, &ws, NULL));
+
+        // 5 <= baz <= 15
+        params.descriptor = getIndex(BSON("baz" << 1), coll);
+        params.bounds.startKey = BSON("" << 5);
+        params.bounds.endKey = BSON("" << 15);
+        params.bounds.boundInclusion = BoundInclusion::kIncludeBothStartAndEndKeys;
+        params.direction = 1;
+        ah->addChild(new IndexScan(&_opCtx, params, &ws, NULL));
+
+        // Read part of the first child, then invalidate foo == 12 as if it had been deleted.
+        for (int i = 0; i < 10; ++i) {
+            WorkingSetID out;
+            ASSERT_EQUALS(PlanStage::NEED_TIME, ah->work(&out));
+        }
+        ah->saveState();
+        set<RecordId> data;
+        getRecordIds(&data, coll);
+        for (set<RecordId>::const_iterator it = data.begin(); it != data.end(); ++it) {
+            if (coll->docFor(&_opCtx, *it).value()["foo"].numberInt() == 12) {
+                // The document is left in place, so that only the invalidation can keep it out
+                // of the results.
+                ah->invalidate(&_opCtx, *it, INVALIDATION_DELETION);
+                break;
+            }
+        }
+        ah->restoreState();
+
+        // foo == bar == baz, and foo <= 20, bar >= 10, 5 <= baz <= 15, so our values are
+        // 10, 11, 13, 14, 15.
+        ASSERT_EQUALS(5, countResults(ah.get()));
+        ASSERT_LESS_THAN(ah->getMemUsage(), 20 * big.size());
+        ASSERT_EQUALS(0U, ws.getFlagged().size());
+
+        auto stats = static_cast<const AndHashStats*>(ah->getSpecificStats());
+        ASSERT_TRUE(stats->recordIdsOnly);
+    }
+};
+
 // An AND with three children.
 // Add large keys (512 bytes) to index of last child to verify that
 // keys in last child are not buffered
@@ -1456,6 +1540,7 @@ public:
         add<QueryStageAndHashInvalidation>();
         add<QueryStageAndHashTwoLeaf>();
         add<QueryStageAndHashTwoLeafFirstChildLargeKeys>();
+        add<QueryStageAndHashRecordIdsOnly>();
         add<QueryStageAndHashTwoLeafLastChildLargeKeys>();
         add<QueryStageAndHashThreeLeaf>();
         add<QueryStageAndHashThreeLeafMiddleChildLargeKeys>();
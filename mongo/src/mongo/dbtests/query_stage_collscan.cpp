@@ -39,15 +39,19 @@
 #include "mongo/db/db_raii.h"
 #include "mongo/db/dbdirectclient.h"
 #include "mongo/db/exec/collection_scan.h"
+#include "mongo/db/exec/parallel_collection_scan.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/json.h"
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/db/query/collation/collator_interface_mock.h"
 #include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/storage/record_store.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/fail_point_service.h"
+#include "mongo/util/scopeguard.h"
 
 namespace QueryStageCollectionScan {
 
@@ -400,6 +404,173 @@ public:
     }
 };
 
+//
+// Filter partitions of the collection on several threads, and expect the matches in scan order.
+//
+
+class QueryStageCollscanParallelMatchesInOrder : public QueryStageCollectionScanBase {
+public:
+    void run() {
+        const int oldPartitionSize = internalQueryExecCollScanPartitionSize.load();
+        internalQueryExecCollScanPartitionSize.store(7);
+        ON_BLOCK_EXIT([oldPartitionSize] {
+            internalQueryExecCollScanPartitionSize.store(oldPartitionSize);
+        });
+
+        checkDirection(CollectionScanParams::FORWARD);
+        checkDirection(CollectionScanParams::BACKWARD);
+    }
+
+private:
+    void checkDirection(CollectionScanParams::Direction direction) {
+        AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+
+        CollectionScanParams params;
+        params.collection = ctx.getCollection();
+        params.direction = direction;
+
+        const boost::intrusive_ptr<ExpressionContext> expCtx(
+            new ExpressionContext(&_opCtx, nullptr));
+        StatusWithMatchExpression statusWithMatcher =
+            MatchExpressionParser::parse(fromjson("{foo: {$mod: [2, 0]}}"), expCtx);
+        ASSERT_OK(statusWithMatcher.getStatus());
+        unique_ptr<MatchExpression> filterExpr = std::move(statusWithMatcher.getValue());
+        ASSERT(ParallelCollectionScan::canRunInParallel(params, filterExpr.get(), nullptr));
+
+        WorkingSet ws;
+        ParallelCollectionScan scan(&_opCtx, params, 3, &ws, filterExpr.get());
+
+        vector<int> results;
+        while (!scan.isEOF()) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            PlanStage::StageState state = scan.work(&id);
+            ASSERT_NE(PlanStage::FAILURE, state);
+            if (PlanStage::ADVANCED == state) {
+                WorkingSetMember* member = ws.get(id);
+                ASSERT(member->hasRecordId());
+                results.push_back(member->obj.value()["foo"].numberInt());
+            }
+        }
+
+        ASSERT_EQUALS(static_cast<size_t>(numObj() / 2), results.size());
+        for (size_t i = 0; i < results.size(); ++i) {
+            const int expected = CollectionScanParams::FORWARD == direction
+                ? static_cast<int>(2 * i)
+                : numObj() - 2 - static_cast<int>(2 * i);
+            ASSERT_EQUALS(expected, results[i]);
+        }
+
+        const CollectionScanStats* stats =
+            static_cast<const CollectionScanStats*>(scan.getSpecificStats());
+        ASSERT_EQUALS(static_cast<size_t>(numObj()), stats->docsTested);
+        ASSERT_EQUALS(static_cast<size_t>((numObj() + 6) / 7), stats->partitions);
+    }
+};
+
+//
+// Only filters which read nothing but the document may be evaluated on several threads.
+//
+
+class QueryStageCollscanParallelRefusesUnsafeFilters : public QueryStageCollectionScanBase {
+public:
+    void run() {
+        AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+
+        CollectionScanParams params;
+        params.collection = ctx.getCollection();
+
+        ASSERT(canRunInParallel(params, "{foo: {$gt: 2}, bar: {$in: [1, 'a']}}", nullptr));
+        ASSERT_FALSE(canRunInParallel(params, "{foo: /a/}", nullptr));
+        ASSERT_FALSE(canRunInParallel(params, "{foo: {$in: [1, /a/]}}", nullptr));
+        ASSERT_FALSE(canRunInParallel(params, "{$or: [{foo: 1}, {bar: /a/}]}", nullptr));
+        ASSERT_FALSE(canRunInParallel(params, "{$expr: {$eq: ['$foo', 1]}}", nullptr));
+
+        CollatorInterfaceMock collator(CollatorInterfaceMock::MockType::kReverseString);
+        ASSERT_FALSE(canRunInParallel(params, "{foo: {$gt: 2}}", &collator));
+
+        // A scan which must stop at its first match stays on the query thread.
+        params.stopApplyingFilterAfterFirstMatch = true;
+        ASSERT_FALSE(canRunInParallel(params, "{foo: {$gt: 2}}", nullptr));
+    }
+
+private:
+    bool canRunInParallel(const CollectionScanParams& params,
+                          const char* filter,
+                          const CollatorInterface* collator) {
+        const boost::intrusive_ptr<ExpressionContext> expCtx(
+            new ExpressionContext(&_opCtx, collator));
+        StatusWithMatchExpression statusWithMatcher =
+            MatchExpressionParser::parse(fromjson(filter), expCtx);
+        ASSERT_OK(statusWithMatcher.getStatus());
+        return ParallelCollectionScan::canRunInParallel(
+            params, statusWithMatcher.getValue().get(), collator);
+    }
+};
+
+//
+// Scan in batches after a few plain calls to work(), and expect the same results in the same
+// order. Only the results returned through workBatch() count as batched.
+//
+class QueryStageCollscanWorkBatch : public QueryStageCollectionScanBase {
+public:
+    void run() {
+        AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+        Collection* coll = ctx.getCollection();
+
+        vector<RecordId> recordIds;
+        getRecordIds(coll, CollectionScanParams::FORWARD, &recordIds);
+
+        CollectionScanParams params;
+        params.collection = coll;
+        params.direction = CollectionScanParams::FORWARD;
+        params.tailable = false;
+
+        // Only keep the objects with an even 'foo'.
+        BSONObj filterObj = fromjson("{foo: {$mod: [2, 0]}}");
+        const CollatorInterface* collator = nullptr;
+        const boost::intrusive_ptr<ExpressionContext> expCtx(
+            new ExpressionContext(&_opCtx, collator));
+        StatusWithMatchExpression statusWithMatcher =
+            MatchExpressionParser::parse(filterObj, expCtx);
+        verify(statusWithMatcher.isOK());
+        unique_ptr<MatchExpression> filterExpr = std::move(statusWithMatcher.getValue());
+
+        WorkingSet ws;
+        unique_ptr<CollectionScan> scan(
+            new CollectionScan(&_opCtx, params, &ws, filterExpr.get()));
+
+        vector<WorkingSetID> results;
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        while (results.size() < 2U) {
+            if (PlanStage::ADVANCED == scan->work(&id)) {
+                results.push_back(id);
+            }
+        }
+        PlanStage::StageState state = PlanStage::NEED_TIME;
+        while (PlanStage::IS_EOF != state) {
+            state = scan->workBatch(8, &results, &id);
+            ASSERT_NOT_EQUALS(PlanStage::FAILURE, state);
+            ASSERT_NOT_EQUALS(PlanStage::DEAD, state);
+        }
+
+        ASSERT_EQUALS(static_cast<size_t>(numObj() / 2), results.size());
+        for (size_t i = 0; i < results.size(); ++i) {
+            WorkingSetMember* member = ws.get(results[i]);
+            ASSERT_EQUALS(recordIds[2 * i], member->recordId);
+
+            // The scan moved on after each result, so the result must own its document.
+            ASSERT_TRUE(member->obj.value().isOwned());
+            ASSERT_EQUALS(static_cast<int>(2 * i), member->obj.value()["foo"].numberInt());
+        }
+
+        const CommonStats* stats = scan->getCommonStats();
+        ASSERT_EQUALS(results.size(), stats->advanced);
+        ASSERT_EQUALS(results.size() - 2U, stats->batchedResults);
+        ASSERT_GREATER_THAN(stats->batches, size_t(1));
+        ASSERT_LESS_THAN(stats->batches, stats->works);
+    }
+};
+
 class All : public Suite {
 public:
     All() : Suite("QueryStageCollectionScan") {}
@@ -414,6 +585,9 @@ public:
         add<QueryStageCollscanObjectsInOrderBackward>();
         add<QueryStageCollscanInvalidateUpcomingObject>();
         add<QueryStageCollscanInvalidateUpcomingObjectBackward>();
+        add<QueryStageCollscanParallelMatchesInOrder>();
+        add<QueryStageCollscanParallelRefusesUnsafeFilters>();
+        add<QueryStageCollscanWorkBatch>();
     }
 };
 
@@ -42,6 +42,8 @@
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/json.h"
 #include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/pipeline/expression_context.h"
+#include "mongo/db/query/index_bounds_builder.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/util/fail_point.h"
 #include "mongo/util/fail_point_registry.h"
@@ -641,6 +643,89 @@ public:
     }
 };
 
+//
+// Keys within arbitrary index bounds are counted, skipping the gaps between intervals
+//
+class QueryStageCountScanMultipleIntervals : public CountBase {
+public:
+    void run() {
+        OldClientWriteContext ctx(&_opCtx, ns());
+
+        for (int i = 0; i < 10; ++i) {
+            for (int j = 0; j < 10; ++j) {
+                insert(BSON("a" << i << "b" << j));
+            }
+        }
+        addIndex(BSON("a" << 1 << "b" << 1));
+
+        // Count {a: {$in: [2, 5]}, b: {$gte: 3, $lt: 7}}.
+        IndexBounds bounds;
+        OrderedIntervalList aOil("a");
+        aOil.intervals.push_back(Interval(BSON("" << 2 << "" << 2), true, true));
+        aOil.intervals.push_back(Interval(BSON("" << 5 << "" << 5), true, true));
+        bounds.fields.push_back(aOil);
+        OrderedIntervalList bOil("b");
+        bOil.intervals.push_back(Interval(BSON("" << 3 << "" << 7), true, false));
+        bounds.fields.push_back(bOil);
+
+        CountScanParams params;
+        params.descriptor = getIndex(ctx.db(), BSON("a" << 1 << "b" << 1));
+        params.bounds = bounds;
+
+        WorkingSet ws;
+        CountScan count(&_opCtx, params, &ws);
+
+        int numCounted = runCount(&count);
+        ASSERT_EQUALS(8, numCounted);
+        const CountScanStats* stats =
+            static_cast<const CountScanStats*>(count.getSpecificStats());
+        ASSERT_LESS_THAN(stats->keysExamined, 20U);
+    }
+};
+
+//
+// A filter is evaluated against the index keys, and multikey documents are still counted once
+//
+class QueryStageCountScanFilterOnKeys : public CountBase {
+public:
+    void run() {
+        OldClientWriteContext ctx(&_opCtx, ns());
+
+        for (int i = 0; i < 10; ++i) {
+            insert(BSON("a" << 1 << "b" << i));
+        }
+        insert(BSON("a" << 1 << "b" << BSON_ARRAY(1 << 20 << 30)));
+        addIndex(BSON("a" << 1 << "b" << 1));
+
+        IndexBounds bounds;
+        OrderedIntervalList aOil("a");
+        aOil.intervals.push_back(Interval(BSON("" << 1 << "" << 1), true, true));
+        bounds.fields.push_back(aOil);
+        OrderedIntervalList bOil("b");
+        bOil.intervals.push_back(IndexBoundsBuilder::allValues());
+        bounds.fields.push_back(bOil);
+
+        CountScanParams params;
+        params.descriptor = getIndex(ctx.db(), BSON("a" << 1 << "b" << 1));
+        params.bounds = bounds;
+
+        const CollatorInterface* collator = nullptr;
+        const boost::intrusive_ptr<ExpressionContext> expCtx(
+            new ExpressionContext(&_opCtx, collator));
+        StatusWithMatchExpression statusWithMatcher =
+            MatchExpressionParser::parse(fromjson("{b: {$mod: [2, 0]}}"), expCtx);
+        ASSERT_OK(statusWithMatcher.getStatus());
+        std::unique_ptr<MatchExpression> filterExpr = std::move(statusWithMatcher.getValue());
+
+        WorkingSet ws;
+        CountScan count(&_opCtx, params, &ws, filterExpr.get());
+
+        // b is one of 0, 2, 4, 6, 8, plus the array document through its keys 20 and 30.
+        int numCounted = runCount(&count);
+        ASSERT_EQUALS(6, numCounted);
+    }
+};
+
 class All : public Suite {
 public:
     All() : Suite("query_stage_count_scan") {}
@@ -657,6 +742,8 @@ public:
         add<QueryStageCountScanInsertNewDocsDuringYield>();
         add<QueryStageCountScanBecomesMultiKeyDuringYield>();
         add<QueryStageCountScanUnusedKeys>();
+        add<QueryStageCountScanMultipleIntervals>();
+        add<QueryStageCountScanFilterOnKeys>();
     }
 };
 
@@ -42,6 +42,7 @@
 #include "mongo/db/exec/delete.h"
 #include "mongo/db/exec/queued_data_stage.h"
 #include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/service_context.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/stdx/memory.h"
@@ -60,7 +61,8 @@ static const NamespaceString nss("unittests.QueryStageDelete");
 
 class QueryStageDeleteBase {
 public:
-    QueryStageDeleteBase() : _client(&_opCtx) {
+    QueryStageDeleteBase()
+        : _writeBatchSize(internalQueryExecMultiWriteBatchSize.load()), _client(&_opCtx) {
         OldClientWriteContext ctx(&_opCtx, nss.ns());
 
         for (size_t i = 0; i < numObj(); ++i) {
@@ -72,6 +74,7 @@ public:
     }
 
     virtual ~QueryStageDeleteBase() {
+        internalQueryExecMultiWriteBatchSize.store(_writeBatchSize);
         OldClientWriteContext ctx(&_opCtx, nss.ns());
         _client.dropCollection(nss.ns());
     }
@@ -119,6 +122,7 @@ protected:
     OperationContext& _opCtx = *_txnPtr;
 
 private:
+    const int _writeBatchSize;
     DBDirectClient _client;
 };
 
@@ -148,6 +152,9 @@ public:
         DeleteStageParams deleteStageParams;
         deleteStageParams.isMulti = true;
 
+        // Delete one document at a time so that the target is still ahead of the stage.
+        internalQueryExecMultiWriteBatchSize.store(1);
+
         WorkingSet ws;
         DeleteStage deleteStage(&_opCtx,
                                 deleteStageParams,
@@ -188,6 +195,63 @@ public:
     }
 };
 
+/**
+ * Test that a multi delete buffers documents from its child and deletes a full batch at a time, and
+ * deletes whatever is left over once the child is out of results.
+ */
+class QueryStageDeleteMultiInBatches : public QueryStageDeleteBase {
+public:
+    void run() {
+        if (!supportsDocLocking()) {
+            // Batching needs document-level locking.
+            return;
+        }
+
+        OldClientWriteContext ctx(&_opCtx, nss.ns());
+        Collection* coll = ctx.getCollection();
+
+        CollectionScanParams collScanParams;
+        collScanParams.collection = coll;
+        collScanParams.direction = CollectionScanParams::FORWARD;
+        collScanParams.tailable = false;
+
+        DeleteStageParams deleteStageParams;
+        deleteStageParams.isMulti = true;
+
+        const size_t batchSize = 8;
+        internalQueryExecMultiWriteBatchSize.store(static_cast<int>(batchSize));
+
+        WorkingSet ws;
+        DeleteStage deleteStage(&_opCtx,
+                                deleteStageParams,
+                                &ws,
+                                coll,
+                                new CollectionScan(&_opCtx, collScanParams, &ws, NULL));
+        const DeleteStats* stats = static_cast<const DeleteStats*>(deleteStage.getSpecificStats());
+
+        // Nothing is deleted until the first batch is full.
+        for (size_t i = 0; i < batchSize - 1; ++i) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            ASSERT_EQUALS(PlanStage::NEED_TIME, deleteStage.work(&id));
+            ASSERT_EQUALS(0U, stats->docsDeleted);
+        }
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        ASSERT_EQUALS(PlanStage::NEED_TIME, deleteStage.work(&id));
+        ASSERT_EQUALS(batchSize, stats->docsDeleted);
+
+        while (!deleteStage.isEOF()) {
+            id = WorkingSet::INVALID_ID;
+            PlanStage::StageState state = deleteStage.work(&id);
+            ASSERT(PlanStage::NEED_TIME == state || PlanStage::IS_EOF == state);
+        }
+
+        // numObj() is not a multiple of the batch size, so the last batch was partial.
+        ASSERT_NOT_EQUALS(0U, numObj() % batchSize);
+        ASSERT_EQUALS(numObj(), stats->docsDeleted);
+        ASSERT_EQUALS(0, coll->numRecords(&_opCtx));
+    }
+};
+
 /**
  * Test that the delete stage returns an owned copy of the original document if returnDeleted is
  * specified.
@@ -312,6 +376,7 @@ public:
     void setupTests() {
         // Stage-specific tests below.
         add<QueryStageDeleteInvalidateUpcomingObject>();
+        add<QueryStageDeleteMultiInBatches>();
         add<QueryStageDeleteReturnOldDoc>();
         add<QueryStageDeleteSkipOwnedObjects>();
     }
@@ -35,14 +35,17 @@
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
+#include "mongo/db/catalog/index_catalog.h"
 #include "mongo/db/client.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/dbdirectclient.h"
 #include "mongo/db/exec/fetch.h"
+#include "mongo/db/exec/index_scan.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/queued_data_stage.h"
 #include "mongo/db/json.h"
 #include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/query/index_bounds_builder.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/stdx/memory.h"
 
@@ -76,6 +79,29 @@ public:
         _client.remove(ns(), obj);
     }
 
+    /**
+     * Returns a scan over every key of the {foo: 1} index, which it creates if needed.
+     */
+    IndexScan* makeFooIndexScan(Collection* coll, WorkingSet* ws) {
+        const BSONObj keyPattern = BSON("foo" << 1);
+        std::vector<IndexDescriptor*> indexes;
+        coll->getIndexCatalog()->findIndexesByKeyPattern(&_opCtx, keyPattern, false, &indexes);
+        if (indexes.empty()) {
+            ASSERT_OK(dbtests::createIndex(&_opCtx, ns(), keyPattern));
+            coll->getIndexCatalog()->findIndexesByKeyPattern(
+                &_opCtx, keyPattern, false, &indexes);
+        }
+        ASSERT_EQUALS(size_t(1), indexes.size());
+
+        IndexScanParams params;
+        params.descriptor = indexes[0];
+        params.direction = 1;
+        OrderedIntervalList oil("foo");
+        IndexBoundsBuilder::allValuesForField(keyPattern.firstElement(), &oil);
+        params.bounds.fields.push_back(oil);
+        return new IndexScan(&_opCtx, params, ws, nullptr);
+    }
+
     static const char* ns() {
         return "unittests.QueryStageFetch";
     }
@@ -219,6 +245,214 @@ public:
     }
 };
 
+//
+// Test that a windowed fetch returns results in the order the child produced them.
+//
+class FetchStageWindowPreservesChildOrder : public QueryStageFetchBase {
+public:
+    void run() {
+        OldClientWriteContext ctx(&_opCtx, ns());
+        Database* db = ctx.db();
+        Collection* coll = db->getCollection(&_opCtx, ns());
+        if (!coll) {
+            WriteUnitOfWork wuow(&_opCtx);
+            coll = db->createCollection(&_opCtx, ns());
+            wuow.commit();
+        }
+
+        WorkingSet ws;
+
+        for (int i = 0; i < 10; ++i) {
+            insert(BSON("foo" << i));
+        }
+        set<RecordId> recordIds;
+        getRecordIds(&recordIds, coll);
+        ASSERT_EQUALS(size_t(10), recordIds.size());
+
+        // Hand the RecordIds to the fetch in descending order, as an index on a field that
+        // decreases with insertion order would.
+        auto mockStage = make_unique<QueuedDataStage>(&_opCtx, &ws);
+        for (auto it = recordIds.rbegin(); it != recordIds.rend(); ++it) {
+            WorkingSetID id = ws.allocate();
+            WorkingSetMember* mockMember = ws.get(id);
+            mockMember->recordId = *it;
+            ws.transitionToRecordIdAndIdx(id);
+            mockStage->pushBack(id);
+        }
+
+        BSONObj filterObj = fromjson("{foo: {$ne: 3}}");
+        const CollatorInterface* collator = nullptr;
+        const boost::intrusive_ptr<ExpressionContext> expCtx(
+            new ExpressionContext(&_opCtx, collator));
+        StatusWithMatchExpression statusWithMatcher =
+            MatchExpressionParser::parse(filterObj, expCtx);
+        verify(statusWithMatcher.isOK());
+        unique_ptr<MatchExpression> filterExpr = std::move(statusWithMatcher.getValue());
+
+        unique_ptr<FetchStage> fetchStage(
+            new FetchStage(&_opCtx, &ws, mockStage.release(), filterExpr.get(), coll));
+        fetchStage->setWindowSize(4);
+
+        std::vector<int> results;
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        PlanStage::StageState state = PlanStage::NEED_TIME;
+        while (PlanStage::IS_EOF != state) {
+            state = fetchStage->work(&id);
+            ASSERT_NOT_EQUALS(PlanStage::FAILURE, state);
+            if (PlanStage::ADVANCED == state) {
+                WorkingSetMember* member = ws.get(id);
+                ASSERT_TRUE(member->hasObj());
+                ASSERT_TRUE(member->obj.value().isOwned());
+                results.push_back(member->obj.value()["foo"].numberInt());
+                ws.free(id);
+            }
+        }
+
+        const std::vector<int> expected = {9, 8, 7, 6, 5, 4, 2, 1, 0};
+        ASSERT_TRUE(expected == results);
+
+        const FetchStats* stats = static_cast<const FetchStats*>(fetchStage->getSpecificStats());
+        ASSERT_EQUALS(size_t(4), stats->windowSize);
+        ASSERT_EQUALS(size_t(3), stats->windows);
+        ASSERT_EQUALS(size_t(10), stats->docsExamined);
+    }
+};
+
+//
+// Test that a fetch working in batches pulls its child's results in batches, and that its stats
+// only count the results it returned through workBatch() as batched.
+//
+class FetchStageWorkBatch : public QueryStageFetchBase {
+public:
+    void run() {
+        OldClientWriteContext ctx(&_opCtx, ns());
+        Database* db = ctx.db();
+        Collection* coll = db->getCollection(&_opCtx, ns());
+        if (!coll) {
+            WriteUnitOfWork wuow(&_opCtx);
+            coll = db->createCollection(&_opCtx, ns());
+            wuow.commit();
+        }
+
+        for (int i = 0; i < 10; ++i) {
+            insert(BSON("foo" << i));
+        }
+
+        WorkingSet ws;
+        BSONObj filterObj = fromjson("{foo: {$ne: 3}}");
+        const CollatorInterface* collator = nullptr;
+        const boost::intrusive_ptr<ExpressionContext> expCtx(
+            new ExpressionContext(&_opCtx, collator));
+        StatusWithMatchExpression statusWithMatcher =
+            MatchExpressionParser::parse(filterObj, expCtx);
+        verify(statusWithMatcher.isOK());
+        unique_ptr<MatchExpression> filterExpr = std::move(statusWithMatcher.getValue());
+
+        unique_ptr<FetchStage> fetchStage(new FetchStage(
+            &_opCtx, &ws, makeFooIndexScan(coll, &ws), filterExpr.get(), coll));
+
+        // Return the first result through work(), and the rest in batches.
+        std::vector<WorkingSetID> results;
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        PlanStage::StageState state = PlanStage::NEED_TIME;
+        while (PlanStage::ADVANCED != state) {
+            state = fetchStage->work(&id);
+            ASSERT_TRUE(PlanStage::NEED_TIME == state || PlanStage::ADVANCED == state);
+        }
+        results.push_back(id);
+        while (PlanStage::IS_EOF != state) {
+            state = fetchStage->workBatch(4, &results, &id);
+            ASSERT_NOT_EQUALS(PlanStage::FAILURE, state);
+            ASSERT_NOT_EQUALS(PlanStage::DEAD, state);
+        }
+
+        const std::vector<int> expected = {0, 1, 2, 4, 5, 6, 7, 8, 9};
+        ASSERT_EQUALS(expected.size(), results.size());
+        for (size_t i = 0; i < results.size(); ++i) {
+            WorkingSetMember* member = ws.get(results[i]);
+            ASSERT_TRUE(member->hasObj());
+            ASSERT_TRUE(member->obj.value().isOwned());
+            ASSERT_EQUALS(expected[i], member->obj.value()["foo"].numberInt());
+        }
+
+        const CommonStats* stats = fetchStage->getCommonStats();
+        ASSERT_EQUALS(size_t(9), stats->advanced);
+        ASSERT_EQUALS(size_t(8), stats->batchedResults);
+        ASSERT_GREATER_THAN(stats->batches, size_t(0));
+
+        // The index scan produced its keys in batches as well.
+        const CommonStats* childStats = fetchStage->getChildren()[0]->getCommonStats();
+        ASSERT_GREATER_THAN(childStats->batches, size_t(0));
+        ASSERT_EQUALS(size_t(10), childStats->advanced);
+    }
+};
+
+//
+// Test that results a windowed fetch has buffered from its child, but not yet fetched, survive
+// an invalidation, and are dropped if their document is deleted.
+//
+class FetchStageWorkBatchBufferedResultsInvalidated : public QueryStageFetchBase {
+public:
+    void run() {
+        OldClientWriteContext ctx(&_opCtx, ns());
+        Database* db = ctx.db();
+        Collection* coll = db->getCollection(&_opCtx, ns());
+        if (!coll) {
+            WriteUnitOfWork wuow(&_opCtx);
+            coll = db->createCollection(&_opCtx, ns());
+            wuow.commit();
+        }
+
+        for (int i = 0; i < 10; ++i) {
+            insert(BSON("foo" << i));
+        }
+        std::map<int, RecordId> recordIds;
+        auto cursor = coll->getCursor(&_opCtx);
+        while (auto record = cursor->next()) {
+            recordIds[record->data.toBson()["foo"].numberInt()] = record->id;
+        }
+        cursor.reset();
+
+        WorkingSet ws;
+        unique_ptr<FetchStage> fetchStage(
+            new FetchStage(&_opCtx, &ws, makeFooIndexScan(coll, &ws), nullptr, coll));
+        fetchStage->setWindowSize(4);
+
+        // The first batch fills and fetches a window of four, and returns its first result. The
+        // index scan's batch was larger, so the keys of foo: 4 onwards are left buffered.
+        std::vector<WorkingSetID> results;
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        ASSERT_EQUALS(PlanStage::ADVANCED, fetchStage->workBatch(10, &results, &id));
+        ASSERT_EQUALS(size_t(1), results.size());
+
+        fetchStage->saveState();
+        {
+            WriteUnitOfWork wunit(&_opCtx);
+            fetchStage->invalidate(&_opCtx, recordIds[5], INVALIDATION_DELETION);
+            wunit.commit();  // to avoid rollback of the invalidate
+        }
+        remove(BSON("foo" << 5));
+        remove(BSON("foo" << 6));
+        fetchStage->restoreState();
+
+        PlanStage::StageState state = PlanStage::NEED_TIME;
+        while (PlanStage::IS_EOF != state) {
+            state = fetchStage->workBatch(10, &results, &id);
+            ASSERT_NOT_EQUALS(PlanStage::FAILURE, state);
+            ASSERT_NOT_EQUALS(PlanStage::DEAD, state);
+        }
+
+        // The invalidation fetched foo: 5 before it was deleted. Nothing kept foo: 6.
+        std::vector<int> foos;
+        for (auto resultId : results) {
+            foos.push_back(ws.get(resultId)->obj.value()["foo"].numberInt());
+        }
+        const std::vector<int> expected = {0, 1, 2, 3, 4, 5, 7, 8, 9};
+        ASSERT_TRUE(expected == foos);
+        ASSERT_FALSE(ws.get(results[5])->hasRecordId());
+    }
+};
+
 class All : public Suite {
 public:
     All() : Suite("query_stage_fetch") {}
@@ -226,6 +460,9 @@ public:
     void setupTests() {
         add<FetchStageAlreadyFetched>();
         add<FetchStageFilter>();
+        add<FetchStageWindowPreservesChildOrder>();
+        add<FetchStageWorkBatch>();
+        add<FetchStageWorkBatchBufferedResultsInvalidated>();
     }
 };
 
@@ -0,0 +1,196 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+/**
+ * This file tests db/exec/idhack.cpp looking up a list of _id values.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/client.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/dbdirectclient.h"
+#include "mongo/db/exec/idhack.h"
+#include "mongo/db/json.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/dbtests/dbtests.h"
+
+namespace QueryStageIDHack {
+
+using std::unique_ptr;
+
+class QueryStageIDHackBase {
+public:
+    QueryStageIDHackBase() : _client(&_opCtx) {}
+
+    virtual ~QueryStageIDHackBase() {
+        OldClientWriteContext ctx(&_opCtx, ns());
+        _client.dropCollection(ns());
+    }
+
+    void insert(const BSONObj& obj) {
+        _client.insert(ns(), obj);
+    }
+
+    unique_ptr<CanonicalQuery> canonicalize(const char* filter, const BSONObj& collation) {
+        auto qr = stdx::make_unique<QueryRequest>(NamespaceString(ns()));
+        qr->setFilter(fromjson(filter));
+        qr->setCollation(collation);
+        return uassertStatusOK(CanonicalQuery::canonicalize(&_opCtx, std::move(qr)));
+    }
+
+    /**
+     * Runs an IDHackStage for 'filter' over a collection holding the _ids 1 to 5 and returns the
+     * _ids of the documents it returns, in order.
+     */
+    BSONArray runIDHack(const char* filter, IDHackStats* statsOut) {
+        OldClientWriteContext ctx(&_opCtx, ns());
+        Collection* coll = ctx.getCollection();
+        auto cq = canonicalize(filter, BSONObj());
+        ASSERT_TRUE(IDHackStage::supportsQuery(coll, *cq));
+
+        WorkingSet ws;
+        IndexDescriptor* idIndex = coll->getIndexCatalog()->findIdIndex(&_opCtx);
+        ASSERT(idIndex);
+        IDHackStage idhack(&_opCtx, coll, cq.get(), &ws, idIndex);
+
+        BSONArrayBuilder ids;
+        PlanStage::StageState state = PlanStage::NEED_TIME;
+        while (PlanStage::IS_EOF != state) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            state = idhack.work(&id);
+            ASSERT_NOT_EQUALS(PlanStage::FAILURE, state);
+            ASSERT_NOT_EQUALS(PlanStage::DEAD, state);
+            if (PlanStage::ADVANCED == state) {
+                ids.append(ws.get(id)->obj.value()["_id"]);
+            }
+        }
+
+        ASSERT_TRUE(idhack.isEOF());
+        *statsOut = *static_cast<const IDHackStats*>(idhack.getSpecificStats());
+        return ids.arr();
+    }
+
+    void insertIds() {
+        for (int i = 1; i <= 5; ++i) {
+            insert(BSON("_id" << i << "a" << i));
+        }
+    }
+
+    static const char* ns() {
+        return "unittests.QueryStageIDHack";
+    }
+
+protected:
+    const ServiceContext::UniqueOperationContext _opCtxPtr = cc().makeOperationContext();
+    OperationContext& _opCtx = *_opCtxPtr;
+    DBDirectClient _client;
+};
+
+//
+// Values of an $in with no matching document are skipped without ending the lookup.
+//
+class IDHackInSkipsMissingKeys : public QueryStageIDHackBase {
+public:
+    void run() {
+        insertIds();
+
+        IDHackStats stats;
+        ASSERT_BSONOBJ_EQ(BSON_ARRAY(2 << 4), runIDHack("{_id: {$in: [20, 4, 10, 2]}}", &stats));
+        ASSERT_EQUALS(size_t(2), stats.keysExamined);
+        ASSERT_EQUALS(size_t(2), stats.docsExamined);
+
+        // The lookup also ends once the last value turns out to have no match.
+        ASSERT_BSONOBJ_EQ(BSONArray(), runIDHack("{_id: {$in: [0, 6, 7]}}", &stats));
+        ASSERT_EQUALS(size_t(0), stats.keysExamined);
+        ASSERT_EQUALS(size_t(0), stats.docsExamined);
+    }
+};
+
+//
+// A value repeated in an $in is looked up, and its document returned, only once.
+//
+class IDHackInReturnsDuplicateKeysOnce : public QueryStageIDHackBase {
+public:
+    void run() {
+        insertIds();
+
+        IDHackStats stats;
+        ASSERT_BSONOBJ_EQ(BSON_ARRAY(1 << 3), runIDHack("{_id: {$in: [3, 1, 3, 1, 3]}}", &stats));
+        ASSERT_EQUALS(size_t(2), stats.keysExamined);
+        ASSERT_EQUALS(size_t(2), stats.docsExamined);
+    }
+};
+
+//
+// The _id index only answers an $in under the collection's default collation, so a query with a
+// different collation must not use the ID hack.
+//
+class IDHackInRequiresCollectionCollation : public QueryStageIDHackBase {
+public:
+    void run() {
+        insert(BSON("_id"
+                    << "a"));
+        insert(BSON("_id"
+                    << "B"));
+
+        OldClientWriteContext ctx(&_opCtx, ns());
+        Collection* coll = ctx.getCollection();
+        ASSERT_FALSE(coll->getDefaultCollator());
+
+        const char* filter = "{_id: {$in: ['A', 'b']}}";
+        auto cq = canonicalize(filter, BSONObj());
+        ASSERT_TRUE(IDHackStage::supportsQuery(coll, *cq));
+
+        cq = canonicalize(filter,
+                          BSON("locale"
+                               << "en_US"
+                               << "strength"
+                               << 2));
+        ASSERT_TRUE(cq->getCollator());
+        ASSERT_FALSE(IDHackStage::supportsQuery(coll, *cq));
+    }
+};
+
+class All : public Suite {
+public:
+    All() : Suite("query_stage_idhack") {}
+
+    void setupTests() {
+        add<IDHackInSkipsMissingKeys>();
+        add<IDHackInReturnsDuplicateKeysOnce>();
+        add<IDHackInRequiresCollectionCollation>();
+    }
+};
+
+SuiteInstance<All> queryStageIDHackAll;
+
+}  // namespace QueryStageIDHack
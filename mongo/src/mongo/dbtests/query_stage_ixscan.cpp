@@ -37,6 +37,7 @@
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/json.h"
+#include "mongo/db/query/index_bounds_builder.h"
 #include "mongo/dbtests/dbtests.h"
 
 namespace QueryStageIxscan {
@@ -314,6 +315,124 @@ public:
     }
 };
 
+// Scanning in batches returns the keys within the bounds in order, each in its own member.
+class QueryStageIxscanWorkBatch : public IndexScanTest {
+public:
+    void run() {
+        setup();
+
+        for (int i = 0; i < 20; ++i) {
+            insert(BSON("_id" << i << "x" << i));
+        }
+
+        std::unique_ptr<IndexScan> ixscan(
+            createIndexScan(BSON("x" << 5), BSON("x" << 14), true, true));
+
+        std::vector<WorkingSetID> results;
+        WorkingSetID id;
+        PlanStage::StageState state = PlanStage::NEED_TIME;
+        while (PlanStage::IS_EOF != state) {
+            state = ixscan->workBatch(4, &results, &id);
+            ASSERT_NE(PlanStage::DEAD, state);
+            ASSERT_NE(PlanStage::FAILURE, state);
+        }
+
+        ASSERT_EQ(results.size(), 10U);
+        for (size_t i = 0; i < results.size(); ++i) {
+            WorkingSetMember* member = _ws.get(results[i]);
+            ASSERT_EQ(WorkingSetMember::RID_AND_IDX, member->getState());
+            ASSERT_BSONOBJ_EQ(member->keyData[0].keyData, BSON("" << static_cast<int>(5 + i)));
+        }
+
+        const CommonStats* stats = ixscan->getCommonStats();
+        ASSERT_EQ(stats->advanced, 10U);
+        ASSERT_EQ(stats->batchedResults, 10U);
+        ASSERT_GT(stats->batches, 1U);
+    }
+};
+
+// An index scan over every value of the leading field of a compound index, bounded on the second
+// field, seeks from one leading value to the next rather than examining every key. This is the
+// scan the planner generates for a skip scan.
+class QueryStageIxscanSkipsLeadingFieldValues : public IndexScanTest {
+public:
+    void run() {
+        setup();
+
+        const BSONObj keyPattern = BSON("a" << 1 << "b" << 1);
+        {
+            WriteUnitOfWork wunit(&_opCtx);
+            ASSERT_OK(_coll->getIndexCatalog()->createIndexOnEmptyCollection(
+                &_opCtx,
+                BSON("ns" << ns() << "key" << keyPattern << "name"
+                          << DBClientBase::genIndexName(keyPattern)
+                          << "v"
+                          << static_cast<int>(kIndexVersion))));
+            wunit.commit();
+        }
+
+        for (int a = 0; a < 3; ++a) {
+            for (int b = 0; b < 100; ++b) {
+                insert(BSON("a" << a << "b" << b));
+            }
+        }
+
+        OrderedIntervalList bOil("b");
+        bOil.intervals.push_back(Interval(BSON("" << 5 << "" << 5), true, true));
+        const IndexScanStats* skipScanStats = scanToEOF(keyPattern, bOil, 3U);
+
+        // For each leading value, the scan examines at most its first key, before seeking to the
+        // matching key, and the key after that one, before seeking to the next leading value.
+        ASSERT_LTE(skipScanStats->keysExamined, 9U);
+
+        // The same scan without bounds on 'b' examines every key.
+        OrderedIntervalList allValues("b");
+        IndexBoundsBuilder::allValuesForField(BSON("b" << 1).firstElement(), &allValues);
+        const IndexScanStats* fullScanStats = scanToEOF(keyPattern, allValues, 300U);
+        ASSERT_EQ(fullScanStats->keysExamined, 300U);
+    }
+
+private:
+    /**
+     * Scans every value of 'a' in the index with pattern 'keyPattern' and the bounds 'bOil' on
+     * 'b', checks that it returns 'expectedResults' keys, and returns the scan's stats.
+     */
+    const IndexScanStats* scanToEOF(const BSONObj& keyPattern,
+                                    const OrderedIntervalList& bOil,
+                                    size_t expectedResults) {
+        IndexCatalog* catalog = _coll->getIndexCatalog();
+        std::vector<IndexDescriptor*> indexes;
+        catalog->findIndexesByKeyPattern(&_opCtx, keyPattern, false, &indexes);
+        ASSERT_EQ(indexes.size(), 1U);
+
+        IndexScanParams params;
+        params.descriptor = indexes[0];
+        params.direction = 1;
+        OrderedIntervalList aOil("a");
+        IndexBoundsBuilder::allValuesForField(keyPattern.firstElement(), &aOil);
+        params.bounds.fields.push_back(aOil);
+        params.bounds.fields.push_back(bOil);
+
+        _ixscan.reset(new IndexScan(&_opCtx, params, &_ws, nullptr));
+        size_t numResults = 0;
+        WorkingSetID id;
+        PlanStage::StageState state = PlanStage::NEED_TIME;
+        while (PlanStage::IS_EOF != state) {
+            state = _ixscan->work(&id);
+            ASSERT_NE(PlanStage::DEAD, state);
+            ASSERT_NE(PlanStage::FAILURE, state);
+            if (PlanStage::ADVANCED == state) {
+                ++numResults;
+                _ws.free(id);
+            }
+        }
+        ASSERT_EQ(numResults, expectedResults);
+        return static_cast<const IndexScanStats*>(_ixscan->getSpecificStats());
+    }
+
+    std::unique_ptr<IndexScan> _ixscan;
+};
+
 class All : public Suite {
 public:
     All() : Suite("query_stage_ixscan") {}
@@ -324,6 +443,8 @@ public:
         add<QueryStageIxscanInsertDuringSaveExclusive>();
         add<QueryStageIxscanInsertDuringSaveExclusive2>();
         add<QueryStageIxscanInsertDuringSaveReverse>();
+        add<QueryStageIxscanWorkBatch>();
+        add<QueryStageIxscanSkipsLeadingFieldValues>();
     }
 } QueryStageIxscanAll;
 
@@ -54,6 +54,7 @@
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/clock_source_mock.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
@@ -551,5 +552,73 @@ TEST_F(QueryStageMultiPlanTest, ShouldReportErrorIfKilledDuringPlanning) {
               multiPlanStage.pickBestPlan(&alwaysPlanKilledYieldPolicy));
 }
 
+// Test that successive halving stops working the plans it eliminates, and still picks the best
+// plan.
+TEST_F(QueryStageMultiPlanTest, MPSSuccessiveHalvingStopsWorkingEliminatedPlans) {
+    const int oldNumWorks = internalQueryPlanEvaluationWorks.load();
+    const bool oldSuccessiveHalving = internalQueryPlanEvaluationSuccessiveHalving.load();
+    const int oldMinCandidates = internalQueryPlanEvaluationHalvingMinCandidates.load();
+    ON_BLOCK_EXIT([oldNumWorks, oldSuccessiveHalving, oldMinCandidates] {
+        internalQueryPlanEvaluationWorks.store(oldNumWorks);
+        internalQueryPlanEvaluationSuccessiveHalving.store(oldSuccessiveHalving);
+        internalQueryPlanEvaluationHalvingMinCandidates.store(oldMinCandidates);
+    });
+
+    // With 8 plans, the first round of the trial period works each plan 10 times, and no plan
+    // returns enough results to end the trial period early.
+    const size_t numPlans = 8;
+    const size_t firstRoundWorks = 10;
+    internalQueryPlanEvaluationWorks.store(numPlans * firstRoundWorks);
+    internalQueryPlanEvaluationSuccessiveHalving.store(true);
+    internalQueryPlanEvaluationHalvingMinCandidates.store(numPlans);
+
+    // Insert a document to create the collection.
+    insert(BSON("x" << 1));
+
+    AutoGetCollectionForReadCommand ctx(_opCtx.get(), nss);
+
+    auto qr = stdx::make_unique<QueryRequest>(nss);
+    qr->setFilter(BSON("x" << 1));
+    auto cq = uassertStatusOK(CanonicalQuery::canonicalize(opCtx(), std::move(qr)));
+    unique_ptr<MultiPlanStage> mps =
+        make_unique<MultiPlanStage>(_opCtx.get(), ctx.getCollection(), cq.get());
+
+    // Plan 0 returns a result on every call to work(). Plan i returns one on every (i + 1)th call,
+    // so each plan is less productive than the one before it.
+    auto ws = stdx::make_unique<WorkingSet>();
+    for (size_t i = 0; i < numPlans; ++i) {
+        auto plan = stdx::make_unique<QueuedDataStage>(_opCtx.get(), ws.get());
+        for (int j = 0; j < 100; ++j) {
+            for (size_t k = 0; k < i; ++k) {
+                plan->pushBack(PlanStage::NEED_TIME);
+            }
+            addMember(plan.get(), ws.get(), BSON("x" << 1));
+        }
+        mps->addPlan(createQuerySolution(), plan.release(), ws.get());
+    }
+
+    PlanYieldPolicy yieldPolicy(PlanExecutor::NO_YIELD, _clock);
+    ASSERT_OK(mps->pickBestPlan(&yieldPolicy));
+    ASSERT_TRUE(mps->bestPlanChosen());
+    ASSERT_EQ(0, mps->bestPlanIdx());
+
+    auto specificStats = static_cast<const MultiPlanStats*>(mps->getSpecificStats());
+    ASSERT_GT(specificStats->trialRounds, 1U);
+    ASSERT_EQ(numPlans - 1, specificStats->candidatesEliminated);
+
+    // Every other plan was dropped before the end of the trial period, and the least productive
+    // ones were not worked again after the first round.
+    auto stats = mps->getStats();
+    ASSERT_EQ(numPlans, stats->children.size());
+    const size_t winnerWorks = stats->children[0]->common.works;
+    size_t totalWorks = winnerWorks;
+    for (size_t i = 1; i < numPlans; ++i) {
+        ASSERT_LT(stats->children[i]->common.works, winnerWorks);
+        totalWorks += stats->children[i]->common.works;
+    }
+    ASSERT_EQ(firstRoundWorks, stats->children[numPlans - 1]->common.works);
+    ASSERT_EQ(specificStats->trialWorks, totalWorks);
+}
+
 }  // namespace
 }  // namespace mongo
@@ -0,0 +1,151 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+/**
+ * This file tests db/exec/projection.cpp working in batches over stages that read from disk.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/client.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/dbdirectclient.h"
+#include "mongo/db/exec/fetch.h"
+#include "mongo/db/exec/index_scan.h"
+#include "mongo/db/exec/projection.h"
+#include "mongo/db/query/index_bounds_builder.h"
+#include "mongo/dbtests/dbtests.h"
+
+namespace QueryStageProjection {
+
+using std::unique_ptr;
+
+class QueryStageProjectionBase {
+public:
+    QueryStageProjectionBase() : _client(&_opCtx) {}
+
+    virtual ~QueryStageProjectionBase() {
+        OldClientWriteContext ctx(&_opCtx, ns());
+        _client.dropCollection(ns());
+    }
+
+    void insert(const BSONObj& obj) {
+        _client.insert(ns(), obj);
+    }
+
+    static const char* ns() {
+        return "unittests.QueryStageProjection";
+    }
+
+protected:
+    const ServiceContext::UniqueOperationContext _opCtxPtr = cc().makeOperationContext();
+    OperationContext& _opCtx = *_opCtxPtr;
+    DBDirectClient _client;
+};
+
+//
+// Test that a projection over a fetch over an index scan, working in batches, returns every
+// projected document in index order, with each stage producing its results in batches.
+//
+class ProjectionStageWorkBatch : public QueryStageProjectionBase {
+public:
+    void run() {
+        OldClientWriteContext ctx(&_opCtx, ns());
+        Database* db = ctx.db();
+        Collection* coll = db->getCollection(&_opCtx, ns());
+        if (!coll) {
+            WriteUnitOfWork wuow(&_opCtx);
+            coll = db->createCollection(&_opCtx, ns());
+            wuow.commit();
+        }
+
+        const BSONObj keyPattern = BSON("foo" << 1);
+        ASSERT_OK(dbtests::createIndex(&_opCtx, ns(), keyPattern));
+        for (int i = 9; i >= 0; --i) {
+            insert(BSON("foo" << i << "bar" << -i));
+        }
+
+        std::vector<IndexDescriptor*> indexes;
+        coll->getIndexCatalog()->findIndexesByKeyPattern(&_opCtx, keyPattern, false, &indexes);
+        ASSERT_EQUALS(size_t(1), indexes.size());
+
+        WorkingSet ws;
+        IndexScanParams ixParams;
+        ixParams.descriptor = indexes[0];
+        ixParams.direction = 1;
+        OrderedIntervalList oil("foo");
+        IndexBoundsBuilder::allValuesForField(keyPattern.firstElement(), &oil);
+        ixParams.bounds.fields.push_back(oil);
+        IndexScan* ixscan = new IndexScan(&_opCtx, ixParams, &ws, nullptr);
+        FetchStage* fetch = new FetchStage(&_opCtx, &ws, ixscan, nullptr, coll);
+
+        ProjectionStageParams params;
+        params.projImpl = ProjectionStageParams::SIMPLE_DOC;
+        params.projObj = BSON("_id" << 0 << "foo" << 1);
+        unique_ptr<ProjectionStage> projection(
+            new ProjectionStage(&_opCtx, params, &ws, fetch));
+
+        std::vector<WorkingSetID> results;
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        PlanStage::StageState state = PlanStage::NEED_TIME;
+        while (PlanStage::IS_EOF != state) {
+            state = projection->workBatch(3, &results, &id);
+            ASSERT_NOT_EQUALS(PlanStage::FAILURE, state);
+            ASSERT_NOT_EQUALS(PlanStage::DEAD, state);
+        }
+
+        ASSERT_EQUALS(size_t(10), results.size());
+        for (size_t i = 0; i < results.size(); ++i) {
+            WorkingSetMember* member = ws.get(results[i]);
+            ASSERT_EQUALS(WorkingSetMember::OWNED_OBJ, member->getState());
+            ASSERT_BSONOBJ_EQ(BSON("foo" << static_cast<int>(i)), member->obj.value());
+        }
+
+        const CommonStats* stats = projection->getCommonStats();
+        ASSERT_EQUALS(size_t(10), stats->advanced);
+        ASSERT_EQUALS(size_t(10), stats->batchedResults);
+        ASSERT_GREATER_THAN(fetch->getCommonStats()->batches, size_t(0));
+        ASSERT_GREATER_THAN(ixscan->getCommonStats()->batches, size_t(0));
+    }
+};
+
+class All : public Suite {
+public:
+    All() : Suite("query_stage_projection") {}
+
+    void setupTests() {
+        add<ProjectionStageWorkBatch>();
+    }
+};
+
+SuiteInstance<All> queryStageProjectionAll;
+
+}  // namespace QueryStageProjection
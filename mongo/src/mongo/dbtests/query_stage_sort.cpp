@@ -41,8 +41,11 @@
 #include "mongo/db/exec/sort.h"
 #include "mongo/db/json.h"
 #include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/stdx/memory.h"
+#include "mongo/unittest/temp_dir.h"
+#include "mongo/util/scopeguard.h"
 
 /**
  * This file tests db/exec/sort.cpp
@@ -578,6 +581,200 @@ public:
     }
 };
 
+// A sort which outgrows the memory limit spills to disk when allowed to, and fails otherwise.
+template <int LIMIT>
+class QueryStageSortSpillsToDisk : public QueryStageSortTestBase {
+public:
+    virtual int numObj() {
+        return 2000;
+    }
+
+    virtual int limit() const {
+        return LIMIT;
+    }
+
+    void run() {
+        const int oldMaxBytes = internalQueryExecMaxBlockingSortBytes.load();
+        ON_BLOCK_EXIT([oldMaxBytes] { internalQueryExecMaxBlockingSortBytes.store(oldMaxBytes); });
+        internalQueryExecMaxBlockingSortBytes.store(4 * 1024);
+
+        OldClientWriteContext ctx(&_opCtx, ns());
+        Database* db = ctx.db();
+        Collection* coll = db->getCollection(&_opCtx, ns());
+        if (!coll) {
+            WriteUnitOfWork wuow(&_opCtx);
+            coll = db->createCollection(&_opCtx, ns());
+            wuow.commit();
+        }
+        fillData();
+
+        unittest::TempDir tempDir("QueryStageSortSpillsToDisk");
+        std::vector<BSONObj> results;
+        std::vector<RecordId> recordIds;
+        ASSERT_EQUALS(PlanExecutor::IS_EOF,
+                      runSort(coll, true, tempDir.path(), &results, &recordIds));
+        checkCount(results.size());
+        for (size_t i = 0; i < results.size(); ++i) {
+            ASSERT_EQUALS(numObj() - 1 - static_cast<int>(i), results[i]["foo"].numberInt());
+
+            // Spilled results keep their RecordIds, which updates and deletes need.
+            ASSERT_FALSE(recordIds[i].isNull());
+            ASSERT_BSONOBJ_EQ(results[i], coll->docFor(&_opCtx, recordIds[i]).value());
+        }
+
+        results.clear();
+        recordIds.clear();
+        ASSERT_EQUALS(PlanExecutor::FAILURE, runSort(coll, false, "", &results, &recordIds));
+    }
+
+private:
+    PlanExecutor::ExecState runSort(Collection* coll,
+                                    bool allowDiskUse,
+                                    const std::string& tempDir,
+                                    std::vector<BSONObj>* results,
+                                    std::vector<RecordId>* recordIds) {
+        auto ws = make_unique<WorkingSet>();
+        auto queuedDataStage = make_unique<QueuedDataStage>(&_opCtx, ws.get());
+        insertVarietyOfObjects(ws.get(), queuedDataStage.get(), coll);
+
+        SortStageParams params;
+        params.collection = coll;
+        params.pattern = BSON("foo" << -1);
+        params.limit = limit();
+        params.allowDiskUse = allowDiskUse;
+        params.tempDir = tempDir;
+
+        auto keyGenStage = make_unique<SortKeyGeneratorStage>(
+            &_opCtx, queuedDataStage.release(), ws.get(), params.pattern, nullptr);
+        auto sortStage = make_unique<SortStage>(&_opCtx, params, ws.get(), keyGenStage.release());
+        SortStage* sortStagePtr = sortStage.get();
+
+        auto statusWithPlanExecutor = PlanExecutor::make(
+            &_opCtx, std::move(ws), std::move(sortStage), coll, PlanExecutor::NO_YIELD);
+        ASSERT_OK(statusWithPlanExecutor.getStatus());
+        auto exec = std::move(statusWithPlanExecutor.getValue());
+
+        BSONObj obj;
+        RecordId recordId;
+        PlanExecutor::ExecState state;
+        while (PlanExecutor::ADVANCED == (state = exec->getNext(&obj, &recordId))) {
+            results->push_back(obj.getOwned());
+            recordIds->push_back(recordId);
+        }
+
+        if (PlanExecutor::IS_EOF == state) {
+            auto stats = static_cast<const SortStats*>(sortStagePtr->getSpecificStats());
+            ASSERT_TRUE(stats->usedDisk);
+        }
+        return state;
+    }
+};
+
+// Sorting on normalized keys must produce exactly the order of the BSON comparison of sort keys.
+class QueryStageSortNormalizedKeysMatchBSONOrder : public QueryStageSortTestBase {
+public:
+    virtual int numObj() {
+        return 300;
+    }
+
+    void run() {
+        OldClientWriteContext ctx(&_opCtx, ns());
+        Database* db = ctx.db();
+        Collection* coll = db->getCollection(&_opCtx, ns());
+        if (!coll) {
+            WriteUnitOfWork wuow(&_opCtx);
+            coll = db->createCollection(&_opCtx, ns());
+            wuow.commit();
+        }
+
+        const bool oldUseNormalizedKeys = internalQueryExecSortUseNormalizedKeys.load();
+        ON_BLOCK_EXIT([oldUseNormalizedKeys] {
+            internalQueryExecSortUseNormalizedKeys.store(oldUseNormalizedKeys);
+        });
+
+        internalQueryExecSortUseNormalizedKeys.store(false);
+        std::vector<BSONObj> expected = runSort(coll, false);
+        internalQueryExecSortUseNormalizedKeys.store(true);
+        std::vector<BSONObj> actual = runSort(coll, true);
+
+        ASSERT_EQUALS(expected.size(), static_cast<size_t>(numObj()));
+        ASSERT_EQUALS(expected.size(), actual.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT_BSONOBJ_EQ(expected[i], actual[i]);
+        }
+    }
+
+private:
+    // Values of different types and numeric representations, so that the sort crosses type
+    // brackets and compares numbers of different types.
+    BSONObj makeDoc(int i) {
+        BSONObjBuilder bob;
+        switch (i % 6) {
+            case 0:
+                bob.append("a", i % 7);
+                break;
+            case 1:
+                bob.append("a", static_cast<long long>(i % 5));
+                break;
+            case 2:
+                bob.append("a", (i % 9) / 2.0);
+                break;
+            case 3:
+                bob.append("a", std::string("str") + std::to_string(i % 4));
+                break;
+            case 4:
+                bob.appendNull("a");
+                break;
+            default:
+                bob.append("a", BSON("x" << i % 3));
+                break;
+        }
+        bob.append("b", i % 4);
+        bob.append("c", i);
+        return bob.obj();
+    }
+
+    std::vector<BSONObj> runSort(Collection* coll, bool expectNormalizedKeys) {
+        auto ws = make_unique<WorkingSet>();
+        auto queuedDataStage = make_unique<QueuedDataStage>(&_opCtx, ws.get());
+        for (int i = 0; i < numObj(); ++i) {
+            WorkingSetID id = ws->allocate();
+            WorkingSetMember* member = ws->get(id);
+            member->obj = Snapshotted<BSONObj>(SnapshotId(), makeDoc(i));
+            member->transitionToOwnedObj();
+            queuedDataStage->pushBack(id);
+        }
+
+        SortStageParams params;
+        params.collection = coll;
+        params.pattern = BSON("a" << 1 << "b" << -1 << "c" << 1);
+        params.limit = 0;
+
+        auto keyGenStage = make_unique<SortKeyGeneratorStage>(
+            &_opCtx, queuedDataStage.release(), ws.get(), params.pattern, nullptr);
+        auto sortStage = make_unique<SortStage>(&_opCtx, params, ws.get(), keyGenStage.release());
+        SortStage* sortStagePtr = sortStage.get();
+
+        auto statusWithPlanExecutor = PlanExecutor::make(
+            &_opCtx, std::move(ws), std::move(sortStage), coll, PlanExecutor::NO_YIELD);
+        ASSERT_OK(statusWithPlanExecutor.getStatus());
+        auto exec = std::move(statusWithPlanExecutor.getValue());
+
+        std::vector<BSONObj> results;
+        BSONObj obj;
+        PlanExecutor::ExecState state;
+        while (PlanExecutor::ADVANCED == (state = exec->getNext(&obj, NULL))) {
+            results.push_back(obj.getOwned());
+        }
+        ASSERT_EQUALS(PlanExecutor::IS_EOF, state);
+
+        std::unique_ptr<PlanStageStats> stats = sortStagePtr->getStats();
+        auto sortStats = static_cast<const SortStats*>(stats->specific.get());
+        ASSERT_EQUALS(expectNormalizedKeys, sortStats->normalizedKeys);
+        return results;
+    }
+};
+
 class All : public Suite {
 public:
     All() : Suite("query_stage_sort") {}
@@ -595,6 +792,9 @@ public:
         add<QueryStageSortDeletionInvalidationWithLimit<10>>();
         add<QueryStageSortDeletionInvalidationWithLimit<1>>();
         add<QueryStageSortParallelArrays>();
+        add<QueryStageSortSpillsToDisk<0>>();
+        add<QueryStageSortSpillsToDisk<1000>>();
+        add<QueryStageSortNormalizedKeysMatchBSONOrder>();
     }
 };
 
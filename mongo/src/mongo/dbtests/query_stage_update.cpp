@@ -49,6 +49,7 @@
 #include "mongo/db/ops/update_lifecycle_impl.h"
 #include "mongo/db/ops/update_request.h"
 #include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/update/update_driver.h"
 #include "mongo/dbtests/dbtests.h"
@@ -64,13 +65,15 @@ static const NamespaceString nss("unittests.QueryStageUpdate");
 
 class QueryStageUpdateBase {
 public:
-    QueryStageUpdateBase() : _client(&_opCtx) {
+    QueryStageUpdateBase()
+        : _writeBatchSize(internalQueryExecMultiWriteBatchSize.load()), _client(&_opCtx) {
         OldClientWriteContext ctx(&_opCtx, nss.ns());
         _client.dropCollection(nss.ns());
         _client.createCollection(nss.ns());
     }
 
     virtual ~QueryStageUpdateBase() {
+        internalQueryExecMultiWriteBatchSize.store(_writeBatchSize);
         OldClientWriteContext ctx(&_opCtx, nss.ns());
         _client.dropCollection(nss.ns());
     }
@@ -175,6 +178,7 @@ protected:
     OperationContext& _opCtx = *_txnPtr;
 
 private:
+    const int _writeBatchSize;
     DBDirectClient _client;
 };
 
@@ -300,6 +304,8 @@ public:
             auto ws = make_unique<WorkingSet>();
             auto cs = make_unique<CollectionScan>(&_opCtx, collScanParams, ws.get(), cq->root());
 
+            // Update one document at a time so that the target is still ahead of the stage.
+            internalQueryExecMultiWriteBatchSize.store(1);
             auto updateStage =
                 make_unique<UpdateStage>(&_opCtx, updateParams, ws.get(), coll, cs.release());
 
@@ -135,6 +135,13 @@ public:
         MONGO_UNREACHABLE;
     }
 
+    boost::optional<JoinCollectionStats> getJoinCollectionStats(
+        const NamespaceString& nss,
+        const FieldPath& joinField,
+        const CollatorInterface* collator) final {
+        return boost::none;
+    }
+
     BSONObj getCollectionOptions(const NamespaceString& nss) final {
         MONGO_UNREACHABLE;
     }
@@ -1721,16 +1721,27 @@ PlanCache.prototype._parseQueryShape = function(query, projection, sort, collati
     // 'collation'. 'collation' must be non-empty if present.
     if (typeof(query) == 'object' && projection == undefined && sort == undefined &&
         collation == undefined) {
-        var keysSorted = Object.keys(query).sort();
+        // Shapes returned by listQueryShapes() also carry statistics about their cache entries,
+        // which are not part of the shape.
+        var keysSorted = Object.keys(query)
+                             .filter(function(key) {
+                                 return key !== 'estimatedSizeBytes' && key !== 'selectivityBucket';
+                             })
+                             .sort();
         // Expected keys must be sorted for the comparison to work.
         if (bsonWoCompare(keysSorted, ['projection', 'query', 'sort']) == 0) {
-            return query;
+            return {query: query.query, projection: query.projection, sort: query.sort};
         }
         if (bsonWoCompare(keysSorted, ['collation', 'projection', 'query', 'sort']) == 0) {
             if (Object.keys(query.collation).length === 0) {
                 throw new Error("collation object must not be empty");
             }
-            return query;
+            return {
+                query: query.query,
+                projection: query.projection,
+                sort: query.sort,
+                collation: query.collation
+            };
         }
     }
 